@@ -0,0 +1,244 @@
+/*
+ *  libnet
+ *  bench.c - microbenchmarks, JSON results
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  libnet-bench times packet building, assembly, checksums and the random
+ *  number generators per operation, on a LIBNET_NONE context so nothing
+ *  is sent, or on a shared memory ring it empties itself where frames have
+ *  to go somewhere.  It prints the results as JSON for tracking regressions
+ *  from one release to the next.  Each benchmark is calibrated to run for
+ *  at least the minimum time, then repeated; the median and the fastest
+ *  run are reported.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/utsname.h>
+
+#include "bench.h"
+
+#define BENCH_REPS_MAX 99
+
+static FILE *out;
+static const char *filter;
+static uint64_t min_ns = 100000000;     /* per run */
+static int reps = 5;
+static int count, failed, list;
+
+static volatile uint64_t sink;
+
+uint64_t
+bench_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+void
+bench_sink(uint64_t v)
+{
+    sink += v;
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a, y = *(const double *)b;
+
+    return ((x > y) - (x < y));
+}
+
+void
+bench_run(const struct bench *b)
+{
+    double ns_op[BENCH_REPS_MAX];
+    uint64_t n, t;
+    int i;
+
+    if (filter && strstr(b->name, filter) == NULL)
+    {
+        return;
+    }
+    if (list)
+    {
+        printf("%s\n", b->name);
+        return;
+    }
+
+    fprintf(out, "%s\n    {\"name\": \"%s\"", count++ ? "," : "", b->name);
+
+    /* scale n up until a run takes the minimum time */
+    for (n = 1; ; )
+    {
+        t = b->fn(b->arg, n);
+        if (t == UINT64_MAX)
+        {
+            goto fail;
+        }
+        if (t >= min_ns)
+        {
+            break;
+        }
+        n = t < min_ns / 100 ? n * 100 : n * min_ns / t * 11 / 10 + 1;
+    }
+
+    for (i = 0; i < reps; i++)
+    {
+        t = b->fn(b->arg, n);
+        if (t == UINT64_MAX)
+        {
+            goto fail;
+        }
+        ns_op[i] = (double)t / (double)n;
+    }
+    qsort(ns_op, reps, sizeof (ns_op[0]), cmp_double);
+
+    fprintf(out, ", \"bytes\": %u, \"iterations\": %llu, "
+            "\"ns_per_op\": %.2f, \"ns_per_op_min\": %.2f",
+            b->bytes, (unsigned long long)n, ns_op[reps / 2], ns_op[0]);
+    if (b->bytes)
+    {
+        fprintf(out, ", \"mb_per_s\": %.1f", b->bytes * 1e3 / ns_op[reps / 2]);
+    }
+    fprintf(out, "}");
+    fflush(out);
+    return;
+
+fail:
+    fprintf(out, ", \"error\": \"failed\"}");
+    failed++;
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-l] [-f filter] [-o file] [-r reps] [-t ms]\n"
+        "  -f filter  run only benchmarks with filter in their name\n"
+        "  -l         list the benchmarks, don't run them\n"
+        "  -o file    write the JSON results to file (default stdout)\n"
+        "  -r reps    runs per benchmark, the median is reported (default 5)\n"
+        "  -t ms      minimum time per run (default 100)\n",
+        name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *file = NULL;
+    struct utsname u;
+    time_t now;
+    char date[32];
+    int c;
+
+    while ((c = getopt(argc, argv, "f:hlo:r:t:")) != EOF)
+    {
+        switch (c)
+        {
+            case 'f':
+                filter = optarg;
+                break;
+            case 'l':
+                list = 1;
+                break;
+            case 'o':
+                file = optarg;
+                break;
+            case 'r':
+                reps = atoi(optarg);
+                break;
+            case 't':
+                min_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (EXIT_FAILURE);
+        }
+    }
+    if (reps < 1 || reps > BENCH_REPS_MAX || min_ns == 0)
+    {
+        usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    out = stdout;
+    if (file && !list && (out = fopen(file, "w")) == NULL)
+    {
+        perror(file);
+        return (EXIT_FAILURE);
+    }
+
+    if (!list)
+    {
+        now = time(NULL);
+        strftime(date, sizeof (date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+        if (uname(&u) == -1)
+        {
+            strcpy(u.sysname, "unknown");
+            strcpy(u.machine, "unknown");
+        }
+        fprintf(out, "{\n  \"libnet\": \"%s\",\n  \"date\": \"%s\",\n"
+                "  \"system\": \"%s\",\n  \"machine\": \"%s\",\n"
+                "  \"min_time_ms\": %llu,\n  \"reps\": %d,\n"
+                "  \"results\": [",
+                libnet_version(), date, u.sysname, u.machine,
+                (unsigned long long)(min_ns / 1000000), reps);
+    }
+
+    bench_build();
+    bench_packet();
+
+    if (!list)
+    {
+        fprintf(out, "\n  ]\n}\n");
+    }
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return (failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
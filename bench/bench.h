@@ -0,0 +1,73 @@
+/*
+ *  libnet
+ *  bench.h - microbenchmark harness
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef __LIBNET_BENCH_H
+#define __LIBNET_BENCH_H
+
+#include <stdint.h>
+#include <libnet.h>
+
+/*
+ * Runs n operations and returns the time they took in ns.  Benchmarks that
+ * need setup or cleanup around the operations do it untimed, and time the
+ * operations themselves with bench_clock().
+ */
+typedef uint64_t (*bench_fn)(void *arg, uint64_t n);
+
+/* one benchmark, see bench_run() */
+struct bench
+{
+    const char *name;                   /* group.case[.mode], unique */
+    uint32_t bytes;                     /* processed per operation, or 0 */
+    bench_fn fn;
+    void *arg;
+};
+
+/* monotonic time in ns */
+uint64_t bench_clock(void);
+
+/* keeps a result from being optimized away */
+void bench_sink(uint64_t v);
+
+/* runs b if it matches the filter and prints its result */
+void bench_run(const struct bench *b);
+
+/* benchmark groups, in bench_build.c and bench_packet.c */
+void bench_build(void);
+void bench_packet(void);
+
+#endif  /* __LIBNET_BENCH_H */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
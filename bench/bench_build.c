@@ -0,0 +1,361 @@
+/*
+ *  libnet
+ *  bench_build.c - packet builder benchmarks
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+
+#include "bench.h"
+
+#define BUILD_BATCH 64                  /* pblocks created between clears */
+
+static const uint8_t mac1[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t mac2[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+static const uint8_t oui[3]  = { 0x00, 0x00, 0x0c };
+static const uint8_t ip4a[4] = { 192, 168, 0, 1 };
+static const uint8_t ip4b[4] = { 192, 168, 0, 2 };
+static const uint8_t pl[64]  = "libnet benchmark payload, sixty-four bytes of it, more or less.";
+static const uint8_t opts[8] = { 0x02, 0x04, 0x05, 0xb4, 0x01, 0x01, 0x01, 0x00 };
+static const uint8_t marker[LIBNET_BGP4_MARKER_SIZE] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+static const uint8_t cmd[SEBEK_CMD_LENGTH] = "bench";
+static const uint8_t auth[HSRP_AUTHDATA_LENGTH] = "cisco";
+static const uint8_t u32[4] = { 0, 0, 0, 7 };
+static struct libnet_in6_addr ip6a = { { { 0xfe, 0x80, [15] = 1 } } };
+static struct libnet_in6_addr ip6b = { { { 0xfe, 0x80, [15] = 2 } } };
+static const struct libnet_lldp_tlv lldp[3] = {
+    { LIBNET_LLDP_CHASSIS_ID, 4, 0, mac1, 6 },
+    { LIBNET_LLDP_PORT_ID, 1, 0, "eth0", 4 },
+    { LIBNET_LLDP_TTL, 0, 120, NULL, 0 },
+};
+
+/* one builder with fixed arguments, its name is that of the function */
+struct builder
+{
+    const char *name;
+    libnet_ptag_t (*build)(libnet_t *l, libnet_ptag_t ptag);
+};
+
+#define B(name, ...) \
+    static libnet_ptag_t \
+    b_##name(libnet_t *l, libnet_ptag_t t) \
+    { \
+        return (libnet_build_##name(__VA_ARGS__)); \
+    }
+
+B(802_1q, mac1, mac2, 0x8100, 0, 0, 42, 0x0800, pl, 46, l, t)
+B(802_1x, 1, 0, 4, pl, 4, l, t)
+B(802_2, 0x42, 0x42, 0x03, pl, 35, l, t)
+B(802_2snap, 0xaa, 0xaa, 0x03, oui, 0x2000, pl, 32, l, t)
+B(802_3, mac1, mac2, 46, pl, 46, l, t)
+B(ethernet, mac1, mac2, 0x0800, pl, 46, l, t)
+B(fddi, 0x50, mac1, mac2, 0xaa, 0xaa, 0x03, oui, 0x0800, NULL, 0, l, t)
+B(arp, 1, 0x0800, 6, 4, 1, mac1, ip4a, mac2, ip4b, NULL, 0, l, t)
+B(tcp, 1024, 80, 0x01020304, 0, 0x02, 8192, 0, 0, LIBNET_TCP_H + 64, pl,
+  64, l, t)
+B(tcp_options, opts, sizeof (opts), l, t)
+B(udp, 1024, 53, LIBNET_UDP_H + 64, 0, pl, 64, l, t)
+B(cdp, 1, 180, 0, 1, 6, (const uint8_t *)"switch", NULL, 0, l, t)
+B(lldp_chassis, 4, mac1, 6, l, t)
+B(lldp_port, 1, (const uint8_t *)"eth0", 4, l, t)
+B(lldp_ttl, 120, l, t)
+B(lldp_end, l, t)
+B(lldp_org_spec, pl, 16, l, t)
+B(lldp, lldp, 3, l, t)
+B(icmpv4_echo, 8, 0, 0, 0x1234, 1, pl, 56, l, t)
+B(icmpv4_mask, 17, 0, 0, 0x1234, 1, 0xffffff00, NULL, 0, l, t)
+B(icmpv4_unreach, 3, 1, 0, pl, 28, l, t)
+B(icmpv4_redirect, 5, 1, 0, 0xc0a80001, pl, 28, l, t)
+B(icmpv4_timeexceed, 11, 0, 0, pl, 28, l, t)
+B(icmpv4_timestamp, 13, 0, 0, 0x1234, 1, 1000, 0, 0, NULL, 0, l, t)
+B(icmpv6_echo, 128, 0, 0, 0x1234, 1, pl, 56, l, t)
+B(icmpv6_unreach, 1, 4, 0, pl, 48, l, t)
+B(icmpv6_ndp_nsol, 135, 0, 0, ip6b, NULL, 0, l, t)
+B(icmpv6_ndp_nadv, 136, 0, 0, 0x60000000, ip6a, NULL, 0, l, t)
+B(icmpv6_ndp_opt, 1, mac1, 6, l, t)
+B(igmp, 0x16, 0, 0, 0xe0000001, NULL, 0, l, t)
+B(ipv4, LIBNET_IPV4_H + 64, 0, 0x4242, 0, 64, IPPROTO_UDP, 0, 0x0100a8c0,
+  0x0200a8c0, pl, 64, l, t)
+B(ipv4_options, opts, sizeof (opts), l, t)
+B(ipv6, 0, 0, 64, IPPROTO_UDP, 64, ip6a, ip6b, pl, 64, l, t)
+B(ipv6_frag, IPPROTO_UDP, 0, 0, 0x12345678, NULL, 0, l, t)
+B(ipv6_routing, IPPROTO_UDP, 2, 0, 1, pl, 20, l, t)
+B(ipv6_destopts, IPPROTO_UDP, 0, pl, 6, l, t)
+B(ipv6_hbhopts, IPPROTO_UDP, 0, pl, 6, l, t)
+B(isl, mac1, 0, 0, mac2, 64, oui, 42, 1, 0, NULL, 0, l, t)
+B(ipsec_esp_hdr, 0x1000, 1, 0, pl, 32, l, t)
+B(ipsec_esp_ftr, 0, IPPROTO_UDP, (int8_t *)"authauthauth", NULL, 0, l, t)
+B(ipsec_ah, IPPROTO_UDP, 4, 0, 0x1000, 1, 0, NULL, 0, l, t)
+B(dnsv4, LIBNET_UDP_DNSV4_H, 0x1234, 0x0100, 1, 0, 0, 0, pl, 32, l, t)
+B(rip, 2, 2, 0, 2, 0, 0x0000000a, 0x000000ff, 0, 1, NULL, 0, l, t)
+B(rpc_call, 0, 0x1234, 100000, 2, 0, 0, 0, NULL, 0, 0, NULL, NULL, 0, l, t)
+B(stp_conf, 0, 0, 0, 0, mac1, 1, mac2, 0x8001, 0, 20, 2, 15, NULL, 0, l, t)
+B(stp_tcn, 0, 0, 0x80, NULL, 0, l, t)
+B(udld_hdr, 1, 1, 0, 0, NULL, 0, l, t)
+B(udld_device_id, (const uint8_t *)"switch", 6, l, t)
+B(udld_port_id, (const uint8_t *)"Gi0/1", 5, l, t)
+B(udld_echo, pl, 16, l, t)
+B(udld_message_interval, (const uint8_t *)"\x07", l, t)
+B(udld_timeout_interval, (const uint8_t *)"\x05", l, t)
+B(udld_device_name, (const uint8_t *)"switch", 6, l, t)
+B(udld_sequence_number, u32, l, t)
+B(token_ring, 0x10, 0x40, mac1, mac2, 0xaa, 0xaa, 0x03, oui, 0x0800, NULL,
+  0, l, t)
+B(vrrp, 2, 1, 1, 100, 1, 0, 1, 0, ip4a, 4, l, t)
+B(mpls, 16, 0, 1, 64, NULL, 0, l, t)
+B(ntp, 0, 4, 3, 0, 6, 0xec, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, 0,
+  l, t)
+B(ospfv2, LIBNET_OSPF_H + LIBNET_OSPF_HELLO_H, 1, 0x01010101, 0, 0, 0,
+  NULL, 0, l, t)
+B(ospfv2_hello, 0xffffff00, 10, 0, 1, 40, 0, 0, NULL, 0, l, t)
+B(ospfv2_hello_neighbor, 0xffffff00, 10, 0, 1, 40, 0, 0, 0x02020202, NULL,
+  0, l, t)
+B(ospfv2_dbd, 1500, 0, 7, 1, NULL, 0, l, t)
+B(ospfv2_lsr, 1, 0x01010101, 0x01010101, NULL, 0, l, t)
+B(ospfv2_lsu, 1, NULL, 0, l, t)
+B(ospfv2_lsa, 1, 0, 1, 0x01010101, 0x01010101, 0x80000001, 0, 36, NULL, 0,
+  l, t)
+B(ospfv2_lsa_rtr, 0, 1, 0x0a000000, 0xffffff00, 3, 0, 10, NULL, 0, l, t)
+B(ospfv2_lsa_net, 0xffffff00, 0x01010101, NULL, 0, l, t)
+B(ospfv2_lsa_sum, 0xffffff00, 10, 0, NULL, 0, l, t)
+B(ospfv2_lsa_as, 0xffffff00, 10, 0, 0, NULL, 0, l, t)
+B(data, pl, 64, l, t)
+B(dhcpv4, 1, 1, 6, 0, 0x12345678, 0, 0x8000, 0, 0, 0, 0, mac1, NULL, NULL,
+  pl, 16, l, t)
+B(bootpv4, 1, 1, 6, 0, 0x12345678, 0, 0x8000, 0, 0, 0, 0, mac1, NULL, NULL,
+  NULL, 0, l, t)
+B(gre, 0x2000, 0x0800, 0, 0, 42, 0, 0, NULL, 0, l, t)
+B(egre, 0x2000, 0x0800, 0, 0, 42, 0, 0, NULL, 0, l, t)
+B(gre_sre, 0x0800, 0, 4, ip4a, NULL, 0, l, t)
+B(gre_last_sre, l, t)
+B(bgp4_header, (uint8_t *)marker, LIBNET_BGP4_HEADER_H + 4, 4, NULL, 0, l, t)
+B(bgp4_open, 4, 65001, 180, 0x01010101, 0, NULL, 0, l, t)
+B(bgp4_update, 0, NULL, 0, NULL, 4, pl, NULL, 0, l, t)
+B(bgp4_notification, 6, 2, NULL, 0, l, t)
+B(sebek, 0xd0d0d0, 3, 0, 1, 0, 0, 1, 0, 0, cmd, 16, pl, 16, l, t)
+B(hsrp, 0, 0, 16, 3, 10, 100, 1, 0, auth, 0x0100a8c0, NULL, 0, l, t)
+
+#undef B
+
+#define BUILDER(name) { #name, b_##name }
+
+static const struct builder builders[] =
+{
+    BUILDER(802_1q),
+    BUILDER(802_1x),
+    BUILDER(802_2),
+    BUILDER(802_2snap),
+    BUILDER(802_3),
+    BUILDER(ethernet),
+    BUILDER(fddi),
+    BUILDER(arp),
+    BUILDER(tcp),
+    BUILDER(tcp_options),
+    BUILDER(udp),
+    BUILDER(cdp),
+    BUILDER(lldp_chassis),
+    BUILDER(lldp_port),
+    BUILDER(lldp_ttl),
+    BUILDER(lldp_end),
+    BUILDER(lldp_org_spec),
+    BUILDER(lldp),
+    BUILDER(icmpv4_echo),
+    BUILDER(icmpv4_mask),
+    BUILDER(icmpv4_unreach),
+    BUILDER(icmpv4_redirect),
+    BUILDER(icmpv4_timeexceed),
+    BUILDER(icmpv4_timestamp),
+    BUILDER(icmpv6_echo),
+    BUILDER(icmpv6_unreach),
+    BUILDER(icmpv6_ndp_nsol),
+    BUILDER(icmpv6_ndp_nadv),
+    BUILDER(icmpv6_ndp_opt),
+    BUILDER(igmp),
+    BUILDER(ipv4),
+    BUILDER(ipv4_options),
+    BUILDER(ipv6),
+    BUILDER(ipv6_frag),
+    BUILDER(ipv6_routing),
+    BUILDER(ipv6_destopts),
+    BUILDER(ipv6_hbhopts),
+    BUILDER(isl),
+    BUILDER(ipsec_esp_hdr),
+    BUILDER(ipsec_esp_ftr),
+    BUILDER(ipsec_ah),
+    BUILDER(dnsv4),
+    BUILDER(rip),
+    BUILDER(rpc_call),
+    BUILDER(stp_conf),
+    BUILDER(stp_tcn),
+    BUILDER(udld_hdr),
+    BUILDER(udld_device_id),
+    BUILDER(udld_port_id),
+    BUILDER(udld_echo),
+    BUILDER(udld_message_interval),
+    BUILDER(udld_timeout_interval),
+    BUILDER(udld_device_name),
+    BUILDER(udld_sequence_number),
+    BUILDER(token_ring),
+    BUILDER(vrrp),
+    BUILDER(mpls),
+    BUILDER(ntp),
+    BUILDER(ospfv2),
+    BUILDER(ospfv2_hello),
+    BUILDER(ospfv2_hello_neighbor),
+    BUILDER(ospfv2_dbd),
+    BUILDER(ospfv2_lsr),
+    BUILDER(ospfv2_lsu),
+    BUILDER(ospfv2_lsa),
+    BUILDER(ospfv2_lsa_rtr),
+    BUILDER(ospfv2_lsa_net),
+    BUILDER(ospfv2_lsa_sum),
+    BUILDER(ospfv2_lsa_as),
+    BUILDER(data),
+    BUILDER(dhcpv4),
+    BUILDER(bootpv4),
+    BUILDER(gre),
+    BUILDER(egre),
+    BUILDER(gre_sre),
+    BUILDER(gre_last_sre),
+    BUILDER(bgp4_header),
+    BUILDER(bgp4_open),
+    BUILDER(bgp4_update),
+    BUILDER(bgp4_notification),
+    BUILDER(sebek),
+    BUILDER(hsrp),
+};
+
+/* a fresh pblock per call, created in batches, freed untimed */
+static uint64_t
+build_create(void *arg, uint64_t n)
+{
+    const struct builder *b = arg;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t done, i, k, t, ns = 0;
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    for (done = 0; done < n; done += k)
+    {
+        k = n - done < BUILD_BATCH ? n - done : BUILD_BATCH;
+        t = bench_clock();
+        for (i = 0; i < k; i++)
+        {
+            if (b->build(l, LIBNET_PTAG_INITIALIZER) == -1)
+            {
+                fprintf(stderr, "%s: %s\n", b->name, libnet_geterror(l));
+                libnet_destroy(l);
+                return (UINT64_MAX);
+            }
+        }
+        ns += bench_clock() - t;
+        libnet_clear_packet(l);
+    }
+
+    libnet_destroy(l);
+    return (ns);
+}
+
+/* the same pblock rewritten through its ptag */
+static uint64_t
+build_update(void *arg, uint64_t n)
+{
+    const struct builder *b = arg;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t ptag;
+    uint64_t i, t;
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+    ptag = b->build(l, LIBNET_PTAG_INITIALIZER);
+    if (ptag == -1)
+    {
+        fprintf(stderr, "%s: %s\n", b->name, libnet_geterror(l));
+        libnet_destroy(l);
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        if (b->build(l, ptag) == -1)
+        {
+            fprintf(stderr, "%s: %s\n", b->name, libnet_geterror(l));
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+    }
+    t = bench_clock() - t;
+
+    libnet_destroy(l);
+    return (t);
+}
+
+void
+bench_build(void)
+{
+    char name[64];
+    struct bench b;
+    size_t i;
+
+    b.name  = name;
+    b.bytes = 0;
+    for (i = 0; i < sizeof (builders) / sizeof (builders[0]); i++)
+    {
+        b.arg = (void *)&builders[i];
+
+        snprintf(name, sizeof (name), "build.%s.create", builders[i].name);
+        b.fn = build_create;
+        bench_run(&b);
+
+        snprintf(name, sizeof (name), "build.%s.update", builders[i].name);
+        b.fn = build_update;
+        bench_run(&b);
+    }
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
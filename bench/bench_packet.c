@@ -0,0 +1,1020 @@
+/*
+ *  libnet
+ *  bench_packet.c - assembly, checksum and PRNG benchmarks
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "bench.h"
+#ifdef HAVE_SHM_OPEN
+#include "libnet_ring.h"
+#endif
+
+#define DATA_MAX 9000                   /* a jumbo frame */
+
+static const uint8_t mac1[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t mac2[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+static const uint8_t ip4a[4] = { 192, 168, 0, 1 };
+static const uint8_t ip4b[4] = { 192, 168, 0, 2 };
+static struct libnet_in6_addr ip6a = { { { 0xfe, 0x80, [15] = 1 } } };
+static struct libnet_in6_addr ip6b = { { { 0xfe, 0x80, [15] = 2 } } };
+
+static uint16_t data[DATA_MAX / 2];     /* checksummed, 16-bit aligned */
+static uint8_t sink[DATA_MAX];          /* packets are assembled into */
+
+/* a typical protocol stack, built on a fresh context */
+struct stack
+{
+    const char *name;
+    int (*build)(libnet_t *l);
+};
+
+static int
+eth_ipv4_tcp(libnet_t *l)
+{
+    return (libnet_build_tcp(1024, 80, 0x01020304, 0, TH_ACK, 8192, 0, 0,
+                LIBNET_TCP_H + 64, (uint8_t *)data, 64, l, 0) == -1 ||
+            libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_TCP_H + 64, 0, 0x4242,
+                0, 64, IPPROTO_TCP, 0, 0x0100a8c0, 0x0200a8c0, NULL, 0, l,
+                0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l,
+                0) == -1 ? -1 : 1);
+}
+
+static int
+eth_ipv4_udp(libnet_t *l)
+{
+    return (libnet_build_udp(1024, 53, LIBNET_UDP_H + 512, 0,
+                (uint8_t *)data, 512, l, 0) == -1 ||
+            libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + 512, 0, 0x4242,
+                0, 64, IPPROTO_UDP, 0, 0x0100a8c0, 0x0200a8c0, NULL, 0, l,
+                0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l,
+                0) == -1 ? -1 : 1);
+}
+
+static int
+eth_ipv4_icmp(libnet_t *l)
+{
+    return (libnet_build_icmpv4_echo(ICMP_ECHO, 0, 0, 0x1234, 1,
+                (uint8_t *)data, 56, l, 0) == -1 ||
+            libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_ICMPV4_ECHO_H + 56, 0,
+                0x4242, 0, 64, IPPROTO_ICMP, 0, 0x0100a8c0, 0x0200a8c0,
+                NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l,
+                0) == -1 ? -1 : 1);
+}
+
+static int
+eth_ipv6_udp(libnet_t *l)
+{
+    return (libnet_build_udp(1024, 53, LIBNET_UDP_H + 64, 0,
+                (uint8_t *)data, 64, l, 0) == -1 ||
+            libnet_build_ipv6(0, 0, LIBNET_UDP_H + 64, IPPROTO_UDP, 64,
+                ip6a, ip6b, NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IPV6, NULL, 0, l,
+                0) == -1 ? -1 : 1);
+}
+
+static int
+eth_arp(libnet_t *l)
+{
+    return (libnet_build_arp(ARPHRD_ETHER, ETHERTYPE_IP, 6, 4, ARPOP_REQUEST,
+                mac1, ip4a, mac2, ip4b, NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_ARP, NULL, 0, l,
+                0) == -1 ? -1 : 1);
+}
+
+static const struct stack stacks[] =
+{
+    { "eth_ipv4_tcp",  eth_ipv4_tcp },
+    { "eth_ipv4_udp",  eth_ipv4_udp },
+    { "eth_ipv4_icmp", eth_ipv4_icmp },
+    { "eth_ipv6_udp",  eth_ipv6_udp },
+    { "eth_arp",       eth_arp },
+};
+
+static libnet_t *
+stack_context(const struct stack *s, uint32_t *size)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *packet;
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", s->name, errbuf);
+        return (NULL);
+    }
+    if (s->build(l) == -1 || libnet_pblock_coalesce(l, &packet, size) == -1)
+    {
+        fprintf(stderr, "%s: %s\n", s->name, libnet_geterror(l));
+        libnet_destroy(l);
+        return (NULL);
+    }
+    libnet_adv_free_packet(l, packet);
+    return (l);
+}
+
+/* assembly into a packet allocated per call, as libnet_adv_cull_packet() */
+static uint64_t
+coalesce(void *arg, uint64_t n)
+{
+    uint8_t *packet;
+    uint32_t size;
+    uint64_t i, t;
+    libnet_t *l;
+
+    l = stack_context(arg, &size);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        if (libnet_pblock_coalesce(l, &packet, &size) == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+        libnet_adv_free_packet(l, packet);
+    }
+    t = bench_clock() - t;
+
+    libnet_destroy(l);
+    return (t);
+}
+
+/* assembly into the caller's buffer, as libnet_write() and the SHM ring */
+static uint64_t
+coalesce_buf(void *arg, uint64_t n)
+{
+    uint32_t size;
+    uint64_t i, t;
+    libnet_t *l;
+
+    l = stack_context(arg, &size);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        if (libnet_pblock_coalesce_buf(l, sink, sizeof (sink), &size) == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sink[size - 1]);
+    libnet_destroy(l);
+    return (t);
+}
+
+static uint64_t
+in_cksum(void *arg, uint64_t n)
+{
+    const int len = (int)(intptr_t)arg;
+    uint64_t i, t, sum = 0;
+    int c;
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        data[0] = (uint16_t)i;
+        c = libnet_in_cksum(data, len);
+        sum += LIBNET_CKSUM_CARRY(c);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    return (t);
+}
+
+static uint64_t
+compute_crc(void *arg, uint64_t n)
+{
+    const uint32_t len = (uint32_t)(intptr_t)arg;
+    uint64_t i, t, sum = 0;
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        data[0] = (uint16_t)i;
+        sum += libnet_compute_crc((uint8_t *)data, len);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    return (t);
+}
+
+static uint64_t
+ospf_lsa_cksum(void *arg, uint64_t n)
+{
+    const uint32_t len = (uint32_t)(intptr_t)arg;
+    uint8_t *lsa = (uint8_t *)data;
+    uint64_t i, t, sum = 0;
+
+    lsa[18] = (uint8_t)(len >> 8);
+    lsa[19] = (uint8_t)len;
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        lsa[4] = (uint8_t)i;
+        sum += libnet_ospf_lsa_cksum(lsa, len);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    return (t);
+}
+
+/* 25000 LSAs, as in a large area */
+static void
+lsdb_spec(struct libnet_lsdb_spec *spec)
+{
+    memset(spec, 0, sizeof (*spec));
+    spec->routers   = 2000;
+    spec->links     = 4;
+    spec->networks  = 3000;
+    spec->attached  = 3;
+    spec->summaries = 20000;
+    spec->router_id = 0x0a000001;
+    spec->prefix    = 0xac100000;
+}
+
+static uint64_t
+lsdb(void *arg, uint64_t n)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_lsdb_spec spec;
+    const int refresh = arg != NULL;
+    uint64_t i, t, sum = 0;
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    lsdb_spec(&spec);
+    if (refresh && libnet_lsdb_build(l, &spec) == -1)
+    {
+        libnet_destroy(l);
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        sum += refresh ? libnet_lsdb_refresh(l) : libnet_lsdb_build(l, &spec);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    libnet_destroy(l);
+    return (t);
+}
+
+/* a full table: 1M routes over 16 attribute sets, added and packed */
+static uint64_t
+bgp4_pack(void *arg, uint64_t n)
+{
+    uint8_t attrs[18] = { 0x40, 1, 1, 0, 0x40, 2, 4, 2, 1, 0xfc, 0,
+                          0x40, 3, 4, 192, 0, 2, 1 };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t i, t, sum = 0;
+    int sets[16], j;
+    uint32_t k, buf_s;
+    uint8_t *buf;
+    libnet_t *l;
+
+    (void)arg;
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < 16; j++)
+        {
+            attrs[10] = (uint8_t)j;
+            sets[j] = libnet_bgp4_packer_attrs(l, attrs, sizeof (attrs));
+        }
+        for (k = 0; k < 1000000; k++)
+        {
+            libnet_bgp4_packer_add(l, sets[k & 15], htonl(k << 8), 24);
+        }
+        if (libnet_bgp4_packer_pack(l, &buf, &buf_s) == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+        sum += buf_s;
+        libnet_free(buf);
+        libnet_bgp4_packer_free(l);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    libnet_destroy(l);
+    return (t);
+}
+
+/* an SNMPv2c trap with 10 varbinds, rebuilt in place */
+static uint64_t
+snmp_trap(void *arg, uint64_t n)
+{
+    static const uint32_t name[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 10, 1 };
+    struct libnet_snmp_varbind vb[10];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t ptag = 0;
+    uint64_t i, t;
+    libnet_t *l;
+    int j;
+
+    (void)arg;
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    memset(vb, 0, sizeof (vb));
+    for (j = 0; j < 10; j++)
+    {
+        vb[j].name   = name;
+        vb[j].name_n = sizeof (name) / sizeof (name[0]);
+        vb[j].type   = LIBNET_SNMP_COUNTER64;
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        vb[0].num = (int64_t)i;
+        ptag = libnet_build_snmp(LIBNET_SNMP_VERSION_2C,
+                (const uint8_t *)"public", 6, LIBNET_SNMP_TRAP2, (int32_t)i,
+                0, 0, vb, 10, NULL, 0, l, ptag);
+        if (ptag == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+    }
+    t = bench_clock() - t;
+
+    libnet_destroy(l);
+    return (t);
+}
+
+/*
+ *  A referral-sized response encoded from scratch, or with arg, one query
+ *  template rewritten in place by libnet_vary_packet()
+ */
+static uint64_t
+dns(void *arg, uint64_t n)
+{
+    static const char *ns[] = { "a.gtld-servers.net", "b.gtld-servers.net",
+                                "c.gtld-servers.net", "d.gtld-servers.net" };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t i, t, sum = 0;
+    libnet_ptag_t ptag = 0;
+    uint8_t *packet = NULL;
+    uint32_t packet_s, len;
+    libnet_t *l;
+    int j, r = 1;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    if (arg)
+    {
+        if (libnet_dns_question(l, "xxxxxxxxxxxx.example.com",
+                LIBNET_DNS_TYPE_A, LIBNET_DNS_CLASS_IN) == -1 ||
+            libnet_dns_edns0(l, 1232, 0, 0, 0, NULL, 0) == -1 ||
+            (ptag = libnet_build_dns_message(LIBNET_UDP_DNSV4_H, 0, 0x0100,
+                l, 0)) == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+        len = LIBNET_UDP_H + libnet_getpbuf_size(l, ptag);
+        if (libnet_build_udp(40000, 53, len, 0, NULL, 0, l, 0) == -1 ||
+            libnet_build_ipv4(LIBNET_IPV4_H + len, 0, 0x4242, 0, 64,
+                IPPROTO_UDP, 0, 0x0100a8c0, 0x0200a8c0, NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l,
+                0) == -1 ||
+            libnet_dns_template(l, LIBNET_DNS_TEMPLATE_ID |
+                LIBNET_DNS_TEMPLATE_QNAME) == -1 ||
+            libnet_adv_cull_packet(l, &packet, &packet_s) == -1)
+        {
+            libnet_destroy(l);
+            return (UINT64_MAX);
+        }
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n && r == 1; i++)
+    {
+        if (arg)
+        {
+            r = libnet_vary_packet(l, packet, packet_s);
+            sum += packet[LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_UDP_H];
+            continue;
+        }
+        libnet_dns_free(l);
+        r = libnet_dns_question(l, "example.com", LIBNET_DNS_TYPE_A,
+                LIBNET_DNS_CLASS_IN);
+        for (j = 0; j < 4 && r == 1; j++)
+        {
+            r = libnet_dns_rr_name(l, LIBNET_DNS_AUTHORITY, "com",
+                    LIBNET_DNS_TYPE_NS, 172800, ns[j]);
+        }
+        for (j = 0; j < 4 && r == 1; j++)
+        {
+            r = libnet_dns_rr_a(l, LIBNET_DNS_ADDITIONAL, ns[j], 172800,
+                    htonl(0xc0050600 + j));
+        }
+        if (r == 1)
+        {
+            r = libnet_dns_edns0(l, 1232, 0, 0, 0, NULL, 0);
+        }
+        if (r == 1)
+        {
+            ptag = libnet_build_dns_message(LIBNET_UDP_DNSV4_H, (uint16_t)i,
+                    0x8100, l, ptag);
+            r = ptag == -1 ? -1 : 1;
+        }
+    }
+    t = bench_clock() - t;
+
+    if (packet)
+    {
+        libnet_adv_free_packet(l, packet);
+    }
+    bench_sink(sum);
+    libnet_destroy(l);
+    return (r == 1 ? t : UINT64_MAX);
+}
+
+static uint64_t
+get_prand(void *arg, uint64_t n)
+{
+    uint64_t i, t, sum = 0;
+
+    (void)arg;
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        sum += libnet_get_prand(LIBNET_PRu32);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    return (t);
+}
+
+#ifdef HAVE_SHM_OPEN
+/*
+ *  A LIBNET_SHM ring, drained by the benchmark itself, for frames to go to
+ *  at the cost of a copy: a LIBNET_NONE context refuses every write, which
+ *  would time the error path instead
+ */
+struct shm_sink
+{
+    char name[32], path[64];
+    struct libnet_ring *r;
+    struct libnet_ring_reader rd;
+    size_t size;
+};
+
+#define SHM_SINK_DEPTH  4096
+#define SHM_SINK_FRAME  128
+
+static libnet_t *
+shm_sink_open(struct shm_sink *k)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_t *l;
+    int fd;
+
+    snprintf(k->name, sizeof (k->name), "bench-%d", (int)getpid());
+    snprintf(k->path, sizeof (k->path), "%s%s", LIBNET_RING_PREFIX, k->name);
+    k->size = libnet_ring_size(SHM_SINK_DEPTH, SHM_SINK_FRAME);
+
+    fd = shm_open(k->path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+    {
+        return (NULL);
+    }
+    k->r = ftruncate(fd, (off_t)k->size) == -1 ? MAP_FAILED :
+        mmap(NULL, k->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (k->r == MAP_FAILED)
+    {
+        shm_unlink(k->path);
+        return (NULL);
+    }
+    libnet_ring_init(k->r, SHM_SINK_DEPTH, SHM_SINK_FRAME);
+    libnet_ring_reader_init(&k->rd, k->r, k->size, SHM_SINK_DEPTH,
+            SHM_SINK_FRAME);
+
+    l = libnet_init(LIBNET_SHM, k->name, errbuf);
+    if (l == NULL)
+    {
+        munmap(k->r, k->size);
+        shm_unlink(k->path);
+    }
+    return (l);
+}
+
+static void
+shm_sink_close(struct shm_sink *k, libnet_t *l)
+{
+    libnet_destroy(l);
+    munmap(k->r, k->size);
+    shm_unlink(k->path);
+}
+
+/*
+ *  100k streams of OSPF hellos, one a second each with 10% jitter, their
+ *  IP IDs stepped; the clock advances a millisecond per dispatch, and the
+ *  frames of each go to a ring that is emptied after it
+ */
+static uint64_t
+periodic(void *arg, uint64_t n)
+{
+    static const uint8_t hello[24] = { 0 };
+    struct libnet_stats ls;
+    struct shm_sink k;
+    libnet_ptag_t ip = 0, eth = 0;
+    uint64_t t, now, fired = 0;
+    uint32_t i, src;
+    libnet_t *l;
+    int id;
+
+    (void)arg;
+    l = shm_sink_open(&k);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    for (i = 0; i < 100000; i++)
+    {
+        src = htonl(0x0a000000 + i);
+        ip = libnet_build_ipv4(LIBNET_IPV4_H + sizeof (hello), 0xc0, 0, 0, 1,
+                IPPROTO_OSPF, 0, src, htonl(0xe0000005), hello,
+                sizeof (hello), l, ip);
+        eth = libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l, eth);
+        if (ip == -1 || eth == -1 ||
+            (id = libnet_periodic_add(l, 1000, 100, i % 1000)) == -1 ||
+            libnet_periodic_patch(l, id, LIBNET_ETH_H + 4, 2, 1,
+                LIBNET_ETH_H + 10) == -1)
+        {
+            shm_sink_close(&k, l);
+            return (UINT64_MAX);
+        }
+    }
+
+    t = bench_clock();
+    for (now = 0; fired < n; now++)
+    {
+        fired += libnet_periodic_dispatch(l, now);
+        libnet_ring_release(&k.rd, libnet_ring_pending(&k.rd));
+    }
+    t = bench_clock() - t;
+
+    /* every frame has to have gone into the ring */
+    libnet_stats(l, &ls);
+    shm_sink_close(&k, l);
+    return (ls.packet_errors ? UINT64_MAX : t);
+}
+#endif  /* HAVE_SHM_OPEN */
+
+/*
+ *  LLDPDUs of a 48 port x 1000 switch fabric, assembled into a buffer:
+ *  arg NULL rebuilds a pblock per TLV of every frame, otherwise one
+ *  libnet_build_lldp() per switch and a libnet_lldp_patch() per port
+ */
+static uint64_t
+lldp(void *arg, uint64_t n)
+{
+    static const uint8_t org[9] = { 0x00, 0x12, 0x0f, 0x01, 0x03, 0xc0, 0x36, 0x00, 0x10 };
+    struct libnet_lldp_tlv tlv[4];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t chassis = 0, port = 0, ttl = 0, spec = 0, end = 0;
+    libnet_ptag_t pdu = 0, eth = 0;
+    uint8_t id[6], ifname[16];
+    uint32_t size, sw, p;
+    uint64_t i, t;
+    libnet_t *l;
+    int r = 1;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    memset(tlv, 0, sizeof (tlv));
+    tlv[0].type    = LIBNET_LLDP_CHASSIS_ID;
+    tlv[0].subtype = LIBNET_LLDP_CHASSIS_ID_SUBTYPE_MAC;
+    tlv[0].val     = id;
+    tlv[0].val_s   = sizeof (id);
+    tlv[1].type    = LIBNET_LLDP_PORT_ID;
+    tlv[1].subtype = LIBNET_LLDP_PORT_ID_SUBTYPE_IF_NAME;
+    tlv[1].val     = ifname;
+    tlv[2].type    = LIBNET_LLDP_TTL;
+    tlv[2].num     = 120;
+    tlv[3].type    = LIBNET_LLDP_ORG_SPEC;
+    tlv[3].val     = org;
+    tlv[3].val_s   = sizeof (org);
+
+    memcpy(id, mac1, sizeof (id));
+    t = bench_clock();
+    for (i = 0; i < n && r != -1; i++)
+    {
+        sw = (uint32_t)(i / 48 % 1000);
+        p  = (uint32_t)(i % 48);
+        id[4] = (uint8_t)(sw >> 8);
+        id[5] = (uint8_t)sw;
+        tlv[1].val_s = snprintf((char *)ifname, sizeof (ifname),
+                "Ethernet1/%u", p + 1);
+
+        if (arg == NULL)
+        {
+            if ((end = libnet_build_lldp_end(l, end)) == -1 ||
+                (spec = libnet_build_lldp_org_spec(org, sizeof (org), l,
+                    spec)) == -1 ||
+                (ttl = libnet_build_lldp_ttl(htons(120), l, ttl)) == -1 ||
+                (port = libnet_build_lldp_port(tlv[1].subtype, ifname,
+                    tlv[1].val_s, l, port)) == -1 ||
+                (chassis = libnet_build_lldp_chassis(tlv[0].subtype, id,
+                    sizeof (id), l, chassis)) == -1)
+            {
+                r = -1;
+            }
+        }
+        else if (p == 0 || pdu == 0)
+        {
+            pdu = libnet_build_lldp(tlv, 4, l, pdu);
+            r = pdu == -1 ? -1 : 1;
+        }
+        else
+        {
+            r = libnet_lldp_patch(l, pdu, ifname, tlv[1].val_s, 120);
+        }
+
+        if (r == -1 ||
+            (eth = libnet_build_ethernet(mac2, id, LIBNET_LLDP_ETH_TYPE,
+                NULL, 0, l, eth)) == -1 ||
+            libnet_pblock_coalesce_buf(l, sink, sizeof (sink), &size) == -1)
+        {
+            r = -1;
+        }
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sink[0]);
+    libnet_destroy(l);
+    return (r == -1 ? UINT64_MAX : t);
+}
+
+/* a 9000 byte UDP datagram, IPv4 or IPv6, cut up for a 1500 byte MTU */
+static uint64_t
+fragment(void *arg, uint64_t n)
+{
+    static const uint8_t payload[9000 - LIBNET_IPV6_H - LIBNET_UDP_H];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_frame *frames;
+    uint32_t frames_n = 0;
+    uint64_t i, t;
+    libnet_t *l;
+    int r = 1;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+    if (arg == NULL)
+    {
+        if (libnet_build_udp(1024, 53, 9000 - LIBNET_IPV4_H, 0, payload,
+                9000 - LIBNET_IPV4_H - LIBNET_UDP_H, l, 0) == -1 ||
+            libnet_build_ipv4(9000, 0, 1, 0, 64, IPPROTO_UDP, 0,
+                htonl(0x0a000001), htonl(0x0a000002), NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l, 0) == -1)
+        {
+            r = -1;
+        }
+    }
+    else
+    {
+        if (libnet_build_udp(1024, 53, sizeof (payload) + LIBNET_UDP_H, 0,
+                payload, sizeof (payload), l, 0) == -1 ||
+            libnet_build_ipv6(0, 0, sizeof (payload) + LIBNET_UDP_H,
+                IPPROTO_UDP, 64, ip6a, ip6b, NULL, 0, l, 0) == -1 ||
+            libnet_build_ethernet(mac2, mac1, ETHERTYPE_IPV6, NULL, 0, l, 0) == -1)
+        {
+            r = -1;
+        }
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n && r == 1; i++)
+    {
+        r = arg == NULL ?
+            libnet_fragment_ipv4(l, 1500, 0, &frames, &frames_n) :
+            libnet_fragment_ipv6(l, 1500, 0, &frames, &frames_n);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(frames_n);
+    libnet_destroy(l);
+    return (r == 1 ? t : UINT64_MAX);
+}
+
+/*
+ *  64000 bytes of stream data cut into 1448 byte TCP segments, or each
+ *  segment built through the builders and coalesced, the way it is done
+ *  without libnet_segment_tcp()
+ */
+static uint64_t
+segment(void *arg, uint64_t n)
+{
+    static const uint8_t opt[] = { 1, 1, 8, 10, 0, 0, 0, 1, 0, 0, 0, 2 };
+    static const uint32_t mss = 1448;
+    static uint8_t data[64000];
+    static uint8_t sink[LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_TCP_H +
+        sizeof (opt) + 1448];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t tcp = 0, ip = 0;
+    struct libnet_frame *frames;
+    uint32_t frames_n = 0, size, off, seg, len;
+    uint64_t i, t;
+    libnet_t *l;
+    int r = 1;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+    if (libnet_build_tcp_options(opt, sizeof (opt), l, 0) == -1 ||
+        (tcp = libnet_build_tcp(40000, 80, 1, 1, TH_ACK | TH_PUSH, 8192, 0, 0,
+            LIBNET_TCP_H + sizeof (opt), NULL, 0, l, 0)) == -1 ||
+        (ip = libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_TCP_H + sizeof (opt),
+            0, 1, IP_DF, 64, IPPROTO_TCP, 0, htonl(0x0a000001),
+            htonl(0x0a000002), NULL, 0, l, 0)) == -1 ||
+        libnet_build_ethernet(mac2, mac1, ETHERTYPE_IP, NULL, 0, l, 0) == -1)
+    {
+        r = -1;
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n && r == 1; i++)
+    {
+        if (arg == NULL)
+        {
+            r = libnet_segment_tcp(l, data, sizeof (data), mss, &frames,
+                    &frames_n);
+            continue;
+        }
+        for (off = 0; off < sizeof (data) && r == 1; off += seg)
+        {
+            seg = sizeof (data) - off < mss ? sizeof (data) - off : mss;
+            len = LIBNET_TCP_H + sizeof (opt) + seg;
+            if (libnet_build_tcp(40000, 80, 1 + off, 1,
+                    off + seg < sizeof (data) ? TH_ACK : TH_ACK | TH_PUSH,
+                    8192, 0, 0, len, data + off, seg, l, tcp) == -1 ||
+                libnet_build_ipv4(LIBNET_IPV4_H + len, 0, 1 + off / mss,
+                    IP_DF, 64, IPPROTO_TCP, 0, htonl(0x0a000001),
+                    htonl(0x0a000002), NULL, 0, l, ip) == -1 ||
+                libnet_pblock_coalesce_buf(l, sink, sizeof (sink), &size) == -1)
+            {
+                r = -1;
+            }
+            frames_n++;
+        }
+    }
+    t = bench_clock() - t;
+
+    bench_sink(frames_n);
+    libnet_destroy(l);
+    return (r == 1 ? t : UINT64_MAX);
+}
+
+static uint64_t
+get_prand_r(void *arg, uint64_t n)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t i, t, sum = 0;
+    libnet_t *l;
+
+    (void)arg;
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+    {
+        return (UINT64_MAX);
+    }
+
+    t = bench_clock();
+    for (i = 0; i < n; i++)
+    {
+        sum += libnet_get_prand_r(l, LIBNET_PRu32);
+    }
+    t = bench_clock() - t;
+
+    bench_sink(sum);
+    libnet_destroy(l);
+    return (t);
+}
+
+void
+bench_packet(void)
+{
+    static const int sizes[] = { 20, 64, 576, 1500, DATA_MAX };
+    char name[64];
+    struct bench b;
+    uint32_t size;
+    libnet_t *l;
+    size_t i;
+
+    for (i = 0; i < sizeof (data) / sizeof (data[0]); i++)
+    {
+        data[i] = (uint16_t)(i * 40503);
+    }
+
+    b.name = name;
+    for (i = 0; i < sizeof (stacks) / sizeof (stacks[0]); i++)
+    {
+        /* the packet size, for throughput */
+        l = stack_context(&stacks[i], &size);
+        if (l == NULL)
+        {
+            size = 0;
+        }
+        libnet_destroy(l);
+
+        b.bytes = size;
+        b.arg   = (void *)&stacks[i];
+
+        snprintf(name, sizeof (name), "coalesce.%s", stacks[i].name);
+        b.fn = coalesce;
+        bench_run(&b);
+
+        snprintf(name, sizeof (name), "coalesce_buf.%s", stacks[i].name);
+        b.fn = coalesce_buf;
+        bench_run(&b);
+    }
+
+    for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+        b.bytes = sizes[i];
+        b.arg   = (void *)(intptr_t)sizes[i];
+
+        snprintf(name, sizeof (name), "in_cksum.%d", sizes[i]);
+        b.fn = in_cksum;
+        bench_run(&b);
+
+        snprintf(name, sizeof (name), "compute_crc.%d", sizes[i]);
+        b.fn = compute_crc;
+        bench_run(&b);
+
+        snprintf(name, sizeof (name), "ospf_lsa_cksum.%d", sizes[i]);
+        b.fn = ospf_lsa_cksum;
+        bench_run(&b);
+    }
+
+    b.bytes = 0;
+    b.arg   = NULL;
+
+    snprintf(name, sizeof (name), "lsdb.build");
+    b.fn = lsdb;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "lsdb.refresh");
+    b.arg = (void *)1;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "bgp4_pack.1M");
+    b.fn  = bgp4_pack;
+    b.arg = NULL;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "build_snmp.trap2");
+    b.fn = snmp_trap;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "dns.encode");
+    b.fn = dns;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "dns.template");
+    b.arg = (void *)1;
+    bench_run(&b);
+
+#ifdef HAVE_SHM_OPEN
+    snprintf(name, sizeof (name), "periodic.100k");
+    b.fn  = periodic;
+    b.arg = NULL;
+    bench_run(&b);
+#endif
+
+    snprintf(name, sizeof (name), "lldp.tlv_pblocks");
+    b.fn  = lldp;
+    b.arg = NULL;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "lldp.template");
+    b.arg = (void *)1;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "fragment.ipv4_9000");
+    b.fn    = fragment;
+    b.arg   = NULL;
+    b.bytes = 9000;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "fragment.ipv6_9000");
+    b.arg = (void *)1;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "segment.tcp_64000");
+    b.fn    = segment;
+    b.arg   = NULL;
+    b.bytes = 64000;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "segment.rebuild_64000");
+    b.arg = (void *)1;
+    bench_run(&b);
+
+    b.bytes = 0;
+    b.arg   = NULL;
+
+    snprintf(name, sizeof (name), "prand.get_prand");
+    b.fn = get_prand;
+    bench_run(&b);
+
+    snprintf(name, sizeof (name), "prand.get_prand_r");
+    b.fn = get_prand_r;
+    bench_run(&b);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
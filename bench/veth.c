@@ -0,0 +1,551 @@
+/*
+ *  libnet
+ *  veth.c - end-to-end throughput across a veth pair
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  libnet-veth drives LIBNET_LINK, LIBNET_RAW4 and LIBNET_RAW6 senders at
+ *  full speed from 1 to N threads out of one end of a veth pair, and counts
+ *  what arrives at the other end with a PF_PACKET socket.  Per backend and
+ *  thread count it reports packets per second, loss and CPU time per
+ *  packet, as JSON.  Run it through veth.sh, which sets up the pair in a
+ *  private network namespace, see make bench-veth.
+ *
+ *  The counting socket has a filter for the test traffic and is never
+ *  read: the kernel counts frames dropped because its buffer is full as
+ *  received, see PACKET_STATISTICS in packet(7), so the peer costs next
+ *  to nothing.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include <libnet.h>
+
+#define VETH_THREADS_MAX 64
+#define VETH_BATCH       256            /* writes between checks for stop */
+#define VETH_PORT        9              /* discard */
+#define VETH_ETHERTYPE   0x88b5         /* local experimental */
+#define VETH_SETTLE_NS   50000000       /* for frames in flight at the end */
+
+struct config
+{
+    const char *device;                 /* senders */
+    const char *peer;                   /* counter */
+    uint8_t src_mac[6];
+    uint8_t dst_mac[6];
+    uint32_t src4, dst4;
+    struct libnet_in6_addr src6, dst6;
+    uint32_t size;                      /* frame, without FCS */
+};
+
+struct backend
+{
+    const char *name;
+    int injection_type;
+    uint16_t ethertype;                 /* of the counting socket */
+    uint32_t header;                    /* bytes in front of the payload */
+    int (*build)(libnet_t *l, const struct config *cf, uint16_t sport);
+    const struct sock_filter *filter;   /* traffic to count, or NULL */
+    unsigned short filter_n;
+};
+
+struct sender
+{
+    pthread_t thread;
+    libnet_t *l;
+    uint64_t sent;
+    uint64_t errors;
+};
+
+static int go, stop;
+static uint8_t payload[ETH_FRAME_LEN];
+
+/* UDP to VETH_PORT, the IPv4 header is assumed to have no options */
+static const struct sock_filter filter4[] =
+{
+    { BPF_LD  | BPF_B | BPF_ABS, 0, 0, ETH_HLEN + 9 },
+    { BPF_JMP | BPF_JEQ | BPF_K, 0, 3, IPPROTO_UDP },
+    { BPF_LD  | BPF_H | BPF_ABS, 0, 0, ETH_HLEN + LIBNET_IPV4_H + 2 },
+    { BPF_JMP | BPF_JEQ | BPF_K, 0, 1, VETH_PORT },
+    { BPF_RET | BPF_K, 0, 0, 0xffff },
+    { BPF_RET | BPF_K, 0, 0, 0 },
+};
+
+static const struct sock_filter filter6[] =
+{
+    { BPF_LD  | BPF_B | BPF_ABS, 0, 0, ETH_HLEN + 6 },
+    { BPF_JMP | BPF_JEQ | BPF_K, 0, 3, IPPROTO_UDP },
+    { BPF_LD  | BPF_H | BPF_ABS, 0, 0, ETH_HLEN + LIBNET_IPV6_H + 2 },
+    { BPF_JMP | BPF_JEQ | BPF_K, 0, 1, VETH_PORT },
+    { BPF_RET | BPF_K, 0, 0, 0xffff },
+    { BPF_RET | BPF_K, 0, 0, 0 },
+};
+
+static uint32_t
+payload_s(const struct config *cf, uint32_t header)
+{
+    return (cf->size > header ? cf->size - header : 0);
+}
+
+static int
+build_link(libnet_t *l, const struct config *cf, uint16_t sport)
+{
+    const uint32_t n = payload_s(cf, LIBNET_ETH_H);
+
+    (void)sport;
+    return (libnet_build_ethernet(cf->dst_mac, cf->src_mac, VETH_ETHERTYPE,
+                payload, n, l, 0) == -1 ? -1 : 1);
+}
+
+static int
+build_raw4(libnet_t *l, const struct config *cf, uint16_t sport)
+{
+    const uint32_t n = payload_s(cf, LIBNET_ETH_H + LIBNET_IPV4_H +
+            LIBNET_UDP_H);
+
+    return (libnet_build_udp(sport, VETH_PORT, LIBNET_UDP_H + n, 0,
+                payload, n, l, 0) == -1 ||
+            libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + n, 0, 0, 0, 64,
+                IPPROTO_UDP, 0, cf->src4, cf->dst4, NULL, 0, l, 0) == -1 ?
+            -1 : 1);
+}
+
+static int
+build_raw6(libnet_t *l, const struct config *cf, uint16_t sport)
+{
+    const uint32_t n = payload_s(cf, LIBNET_ETH_H + LIBNET_IPV6_H +
+            LIBNET_UDP_H);
+
+    return (libnet_build_udp(sport, VETH_PORT, LIBNET_UDP_H + n, 0,
+                payload, n, l, 0) == -1 ||
+            libnet_build_ipv6(0, 0, LIBNET_UDP_H + n, IPPROTO_UDP, 64,
+                cf->src6, cf->dst6, NULL, 0, l, 0) == -1 ? -1 : 1);
+}
+
+static const struct backend backends[] =
+{
+    { "link", LIBNET_LINK, VETH_ETHERTYPE, LIBNET_ETH_H, build_link,
+      NULL, 0 },
+    { "raw4", LIBNET_RAW4, ETH_P_IP, LIBNET_ETH_H + LIBNET_IPV4_H +
+      LIBNET_UDP_H, build_raw4, filter4, sizeof (filter4) / sizeof (filter4[0]) },
+    { "raw6", LIBNET_RAW6, ETH_P_IPV6, LIBNET_ETH_H + LIBNET_IPV6_H +
+      LIBNET_UDP_H, build_raw6, filter6, sizeof (filter6) / sizeof (filter6[0]) },
+};
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+static uint64_t
+cpu_ns(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ((uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ULL +
+            (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL);
+}
+
+static void *
+sender(void *arg)
+{
+    struct sender *s = arg;
+    int i;
+
+    while (!__atomic_load_n(&go, __ATOMIC_ACQUIRE))
+        ;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED))
+    {
+        for (i = 0; i < VETH_BATCH; i++)
+        {
+            if (libnet_write(s->l) == -1)
+            {
+                s->errors++;
+            }
+            else
+            {
+                s->sent++;
+            }
+        }
+    }
+    return (NULL);
+}
+
+/* a PF_PACKET socket on the peer that counts the test traffic, unread */
+static int
+counter_open(const struct config *cf, const struct backend *b)
+{
+    struct sockaddr_ll sll;
+    struct sock_fprog prog;
+    struct tpacket_stats st;
+    socklen_t len = sizeof (st);
+    int fd;
+
+    fd = socket(PF_PACKET, SOCK_RAW, htons(b->ethertype));
+    if (fd == -1)
+    {
+        fprintf(stderr, "socket(PF_PACKET): %s\n", strerror(errno));
+        return (-1);
+    }
+
+    if (b->filter)
+    {
+        prog.len    = b->filter_n;
+        prog.filter = (struct sock_filter *)b->filter;
+        if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+                sizeof (prog)) == -1)
+        {
+            fprintf(stderr, "SO_ATTACH_FILTER: %s\n", strerror(errno));
+            close(fd);
+            return (-1);
+        }
+    }
+
+    memset(&sll, 0, sizeof (sll));
+    sll.sll_family   = AF_PACKET;
+    sll.sll_protocol = htons(b->ethertype);
+    sll.sll_ifindex  = (int)if_nametoindex(cf->peer);
+    if (sll.sll_ifindex == 0 ||
+        bind(fd, (struct sockaddr *)&sll, sizeof (sll)) == -1)
+    {
+        fprintf(stderr, "%s: %s\n", cf->peer, strerror(errno));
+        close(fd);
+        return (-1);
+    }
+
+    /* the counts are reset on every read */
+    getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &st, &len);
+    return (fd);
+}
+
+static uint64_t
+counter_read(int fd)
+{
+    struct tpacket_stats st;
+    socklen_t len = sizeof (st);
+
+    if (getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == -1)
+    {
+        return (0);
+    }
+    return (st.tp_packets);             /* tp_drops included */
+}
+
+/* one backend with n threads, prints one JSON result */
+static int
+run(FILE *out, const struct config *cf, const struct backend *b, int n,
+        uint64_t duration_ns, int first)
+{
+    struct sender senders[VETH_THREADS_MAX];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t sent = 0, errors = 0, received, t, cpu;
+    struct timespec settle;
+    double secs, loss;
+    int fd, i, rc = -1;
+
+    memset(senders, 0, sizeof (senders));
+    for (i = 0; i < n; i++)
+    {
+        senders[i].l = libnet_init(b->injection_type,
+                b->injection_type == LIBNET_LINK ? cf->device : NULL, errbuf);
+        if (senders[i].l == NULL)
+        {
+            fprintf(stderr, "%s: libnet_init(): %s\n", b->name, errbuf);
+            goto done;
+        }
+        if (b->build(senders[i].l, cf, (uint16_t)(1024 + i)) == -1)
+        {
+            fprintf(stderr, "%s: %s\n", b->name,
+                    libnet_geterror(senders[i].l));
+            goto done;
+        }
+    }
+
+    fd = counter_open(cf, b);
+    if (fd == -1)
+    {
+        goto done;
+    }
+
+    __atomic_store_n(&go, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stop, 0, __ATOMIC_RELAXED);
+    for (i = 0; i < n; i++)
+    {
+        if (pthread_create(&senders[i].thread, NULL, sender,
+                &senders[i]) != 0)
+        {
+            fprintf(stderr, "pthread_create() failed\n");
+            __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+            while (i--)
+            {
+                pthread_join(senders[i].thread, NULL);
+            }
+            close(fd);
+            goto done;
+        }
+    }
+
+    cpu = cpu_ns();
+    t = now_ns();
+    __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+
+    settle.tv_sec  = (time_t)(duration_ns / 1000000000ULL);
+    settle.tv_nsec = (long)(duration_ns % 1000000000ULL);
+    nanosleep(&settle, NULL);
+
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (i = 0; i < n; i++)
+    {
+        pthread_join(senders[i].thread, NULL);
+        sent   += senders[i].sent;
+        errors += senders[i].errors;
+    }
+    t   = now_ns() - t;
+    cpu = cpu_ns() - cpu;
+
+    settle.tv_sec  = 0;
+    settle.tv_nsec = VETH_SETTLE_NS;
+    nanosleep(&settle, NULL);
+    received = counter_read(fd);
+    close(fd);
+
+    secs = (double)t / 1e9;
+    loss = sent ? 1.0 - (double)received / (double)sent : 0.0;
+
+    fprintf(out, "%s\n    {\"name\": \"%s.%d\", \"backend\": \"%s\", "
+            "\"threads\": %d, \"size\": %u, \"sent\": %llu, "
+            "\"errors\": %llu, \"received\": %llu, \"tx_pps\": %.0f, "
+            "\"pps\": %.0f, \"loss\": %.6f, \"cpu_ns_per_pkt\": %.1f}",
+            first ? "" : ",", b->name, n, b->name, n, cf->size,
+            (unsigned long long)sent, (unsigned long long)errors,
+            (unsigned long long)received, sent / secs, received / secs, loss,
+            sent ? (double)cpu / (double)sent : 0.0);
+    fflush(out);
+
+    fprintf(stderr, "%-5s %2d thread%s %10.0f pps %8.4f%% loss %8.1f ns "
+            "CPU/pkt %llu errors\n", b->name, n, n == 1 ? " " : "s",
+            received / secs, loss * 100.0, sent ? (double)cpu / sent : 0.0,
+            (unsigned long long)errors);
+    rc = 1;
+
+done:
+    for (i = 0; i < n; i++)
+    {
+        libnet_destroy(senders[i].l);
+    }
+    return (rc);
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-b backends] [-d ms] [-n threads] [-o file] [-s size]\n"
+        "  -b backends  comma separated, of link, raw4, raw6 (default all)\n"
+        "  -d ms        time per run (default 2000)\n"
+        "  -n threads   run with 1 to threads senders (default: CPUs)\n"
+        "  -o file      write the JSON results to file (default stdout)\n"
+        "  -s size      frame size without FCS (default 60)\n"
+        "\n"
+        "Sends on veth0 to veth1, as set up by veth.sh\n",
+        name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct config cf;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    const char *list = "link,raw4,raw6", *file = NULL;
+    uint64_t duration_ns = 2000000000ULL;
+    struct libnet_ether_addr *mac;
+    long threads;
+    libnet_t *l;
+    FILE *out;
+    size_t i;
+    int c, n, first = 1, failed = 0;
+
+    memset(&cf, 0, sizeof (cf));
+    cf.device = "veth0";
+    cf.peer   = "veth1";
+    cf.size   = ETH_ZLEN;
+    threads   = sysconf(_SC_NPROCESSORS_ONLN);
+
+    while ((c = getopt(argc, argv, "b:d:hn:o:s:")) != EOF)
+    {
+        switch (c)
+        {
+            case 'b':
+                list = optarg;
+                break;
+            case 'd':
+                duration_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+                break;
+            case 'n':
+                threads = strtol(optarg, NULL, 0);
+                break;
+            case 'o':
+                file = optarg;
+                break;
+            case 's':
+                cf.size = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (EXIT_FAILURE);
+        }
+    }
+    if (threads < 1 || threads > VETH_THREADS_MAX || duration_ns == 0 ||
+        cf.size < LIBNET_ETH_H || cf.size > ETH_FRAME_LEN)
+    {
+        usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    /* addresses as set up by veth.sh */
+    l = libnet_init(LIBNET_LINK, cf.peer, errbuf);
+    if (l == NULL)
+    {
+        fprintf(stderr, "libnet_init(): %s, run from veth.sh?\n", errbuf);
+        return (EXIT_FAILURE);
+    }
+    mac = libnet_get_hwaddr(l);
+    if (mac == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", cf.peer, libnet_geterror(l));
+        libnet_destroy(l);
+        return (EXIT_FAILURE);
+    }
+    memcpy(cf.dst_mac, mac->ether_addr_octet, 6);
+    libnet_destroy(l);
+
+    l = libnet_init(LIBNET_LINK, cf.device, errbuf);
+    if (l == NULL)
+    {
+        fprintf(stderr, "libnet_init(): %s\n", errbuf);
+        return (EXIT_FAILURE);
+    }
+    mac = libnet_get_hwaddr(l);
+    if (mac == NULL)
+    {
+        fprintf(stderr, "%s: %s\n", cf.device, libnet_geterror(l));
+        libnet_destroy(l);
+        return (EXIT_FAILURE);
+    }
+    memcpy(cf.src_mac, mac->ether_addr_octet, 6);
+    cf.src4 = libnet_name2addr4(l, "10.1.0.1", LIBNET_DONT_RESOLVE);
+    cf.dst4 = libnet_name2addr4(l, "10.1.0.2", LIBNET_DONT_RESOLVE);
+    cf.src6 = libnet_name2addr6(l, "fd00::1", LIBNET_DONT_RESOLVE);
+    cf.dst6 = libnet_name2addr6(l, "fd00::2", LIBNET_DONT_RESOLVE);
+    libnet_destroy(l);
+
+    for (i = 0; i < sizeof (payload); i++)
+    {
+        payload[i] = (uint8_t)i;
+    }
+
+    out = stdout;
+    if (file && (out = fopen(file, "w")) == NULL)
+    {
+        perror(file);
+        return (EXIT_FAILURE);
+    }
+    fprintf(out, "{\n  \"libnet\": \"%s\",\n  \"duration_ms\": %llu,\n"
+            "  \"results\": [", libnet_version(),
+            (unsigned long long)(duration_ns / 1000000));
+
+    for (i = 0; i < sizeof (backends) / sizeof (backends[0]); i++)
+    {
+        const size_t len = strlen(backends[i].name);
+        const char *p;
+
+        /* in the list, as a whole word */
+        for (p = strstr(list, backends[i].name); p;
+             p = strstr(p + 1, backends[i].name))
+        {
+            if ((p == list || p[-1] == ',') &&
+                (p[len] == ',' || p[len] == '\0'))
+            {
+                break;
+            }
+        }
+        if (p == NULL)
+        {
+            continue;
+        }
+
+        for (n = 1; n <= threads; n++)
+        {
+            if (run(out, &cf, &backends[i], n, duration_ns, first) == -1)
+            {
+                failed++;
+                break;
+            }
+            first = 0;
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return (failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Set up a veth pair in an unshare for libnet-veth to send across:
+#
+#   veth0  02:00:00:00:00:01  10.1.0.1/24  fd00::1/64   senders
+#   veth1  02:00:00:00:00:02  no addresses              counts what arrives
+#
+# veth1 has no addresses, so the peer addresses 10.1.0.2 and fd00::2 are
+# static neighbours of veth0, and raw socket packets leave through veth0
+# instead of being delivered locally.
+#
+# Usage: unshare -mrun veth.sh libnet-veth [options]
+
+set -e
+
+ip link add veth0 address 02:00:00:00:00:01 type veth \
+   peer name veth1 address 02:00:00:00:00:02
+ip link set lo up
+ip link set veth0 up
+ip link set veth1 up
+
+ip addr  add 10.1.0.1/24 dev veth0
+ip -6 addr add fd00::1/64 dev veth0 nodad
+ip neigh add 10.1.0.2 lladdr 02:00:00:00:00:02 dev veth0 nud permanent
+ip -6 neigh add fd00::2 lladdr 02:00:00:00:00:02 dev veth0 nud permanent
+
+exec "$@"
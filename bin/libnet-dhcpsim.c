@@ -0,0 +1,1229 @@
+/*
+ *  libnet
+ *  libnet-dhcpsim.c - simulates many DHCP clients
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  libnet-dhcpsim plays thousands of DHCP clients on one device, each with
+ *  its own MAC address, to load a DHCP server or relay.  Every client goes
+ *  through DISCOVER, REQUEST, renewal and, optionally, RELEASE on its own
+ *  timers, kept in one binary heap.  Frames are patched into a template
+ *  built once with libnet and sent in batches; OFFER and ACK replies come
+ *  in on a PF_PACKET socket and are matched to their client by xid and
+ *  chaddr.  ARP requests for leased addresses are answered, so servers
+ *  that check an address before offering it again see it in use.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include <libnet.h>
+
+#define SIM_BURST           64
+#define SIM_CLIENTS_MAX     (1 << 24)           /* index and seq share the xid */
+#define SIM_SERVERS         16
+#define SIM_REQUEST_TRIES   4
+#define SIM_RTO_MAX         64000               /* ms */
+#define SIM_LEASE_MAX       (1U << 30)          /* ms */
+#define SIM_RX_MAX          2048
+
+/* where the fields patched per frame are */
+#define SIM_IP_OFF          LIBNET_ETH_H
+#define SIM_DHCP_OFF        (LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_UDP_H)
+#define SIM_OPT_OFF         (SIM_DHCP_OFF + LIBNET_DHCPV4_H)
+#define SIM_OPT_S           (LIBNET_BOOTP_MIN_LEN - LIBNET_DHCPV4_H)
+#define SIM_FRAME           (SIM_OPT_OFF + SIM_OPT_S)
+#define SIM_ARP_FRAME       60
+
+#define SIM_BEFORE(a, b)    ((int32_t)((a) - (b)) < 0)
+
+enum
+{
+    SIM_INIT,
+    SIM_SELECTING,
+    SIM_REQUESTING,
+    SIM_BOUND,
+    SIM_RENEWING,
+    SIM_REBINDING
+};
+
+/* 36 bytes per client; its MAC address follows from its index */
+struct sim_client
+{
+    uint32_t deadline;                  /* next timer, ms */
+    uint32_t heap;                      /* position in the timer heap */
+    uint32_t addr;                      /* offered or leased, network order */
+    uint32_t t2;                        /* rebinding time, ms */
+    uint32_t expire;                    /* end of the lease, ms */
+    uint32_t release;                   /* when to give the lease back, ms */
+    uint32_t start;                     /* start of the exchange, ms */
+    uint32_t next;                      /* address hash chain, index + 1 */
+    uint8_t state;
+    uint8_t tries;                      /* transmissions in this state */
+    uint8_t seq;                        /* low byte of the xid */
+    uint8_t srv;                        /* server table slot, or 0xff */
+};
+
+struct sim_server
+{
+    uint32_t id;                        /* server identifier, network order */
+    uint8_t mac[6];                     /* where its replies came from */
+};
+
+struct sim_stats
+{
+    uint64_t tx, tx_errors, rx;
+    uint64_t discovers, offers, requests, acks, naks, releases;
+    uint64_t renewals, timeouts, expired, arp_replies;
+    uint64_t dora_sum;                  /* DISCOVER to ACK, ms */
+    uint32_t dora_n, dora_max;
+    uint32_t bound;
+};
+
+struct sim
+{
+    libnet_t *l;
+    int fd;
+    struct sim_client *c;
+    uint32_t n;
+    uint32_t *heap;
+    uint32_t *bucket;                   /* address hash, index + 1 */
+    uint32_t bucket_mask;
+    struct sim_server srv[SIM_SERVERS];
+    uint32_t srv_n;
+    uint8_t mac[6];                     /* of client 0 */
+    uint32_t salt;
+    uint32_t rto;                       /* initial retransmission timeout */
+    uint32_t renew;                     /* renewal time override, ms */
+    uint32_t hold;                      /* release leases after, ms, or 0 */
+    uint32_t rate;                      /* packets per second, 0 unlimited */
+    double tokens;
+    uint32_t now;
+    struct timespec t0;
+
+    uint8_t template[SIM_FRAME];
+    uint8_t tx[SIM_BURST][SIM_FRAME];
+    struct libnet_frame frames[SIM_BURST];
+    uint32_t tx_n;
+    uint8_t arp[SIM_BURST][SIM_ARP_FRAME];
+    struct libnet_frame arp_frames[SIM_BURST];
+    uint32_t arp_n;
+    uint8_t rx[SIM_BURST][SIM_RX_MAX];
+
+    struct sim_stats st;
+};
+
+static volatile sig_atomic_t running = 1;
+
+static const uint8_t sim_params[] = {
+    LIBNET_DHCP_SUBNETMASK, LIBNET_DHCP_ROUTER, LIBNET_DHCP_DNS,
+    LIBNET_DHCP_DOMAINNAME, LIBNET_DHCP_LEASETIME, LIBNET_DHCP_RENEWTIME,
+    LIBNET_DHCP_REBINDTIME
+};
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-R] [-n clients] [-m mac] [-r rate] [-d seconds]\n"
+        "       [-t ms] [-l seconds] [-L seconds] -i device\n"
+        "  -i device     send and receive on device\n"
+        "  -n clients    number of clients (default 1000)\n"
+        "  -m mac        MAC address of the first client, the others count up\n"
+        "                from it (default 02:4c:4e:00:00:00)\n"
+        "  -r rate       packets per second, 0 for no limit (default 1000)\n"
+        "  -d seconds    run for this long (default until interrupted)\n"
+        "  -t ms         initial retransmission timeout (default 4000)\n"
+        "  -l seconds    renew after this long instead of T1 from the server\n"
+        "  -L seconds    release each lease after holding it this long, and\n"
+        "                start over\n"
+        "  -R            release all leases on exit\n",
+        name);
+}
+
+static void
+on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static uint32_t
+sim_clock(const struct sim *s)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint32_t)((ts.tv_sec - s->t0.tv_sec) * 1000 +
+        (ts.tv_nsec - s->t0.tv_nsec) / 1000000));
+}
+
+/* the MAC address without its first octet, which holds the I/G and U/L bits */
+static uint64_t
+sim_mac_low(const uint8_t *mac)
+{
+    uint64_t low = 0;
+    int k;
+
+    for (k = 1; k < 6; k++)
+    {
+        low = low << 8 | mac[k];
+    }
+    return (low);
+}
+
+/* main() checks that counting up never carries into the first octet */
+static void
+sim_client_mac(const struct sim *s, uint32_t i, uint8_t *mac)
+{
+    uint64_t low = sim_mac_low(s->mac) + i;
+    int k;
+
+    mac[0] = s->mac[0];
+    for (k = 5; k > 0; k--)
+    {
+        mac[k] = (uint8_t)low;
+        low >>= 8;
+    }
+}
+
+/* seconds from the command line, in ms, as long as timers can count */
+static int
+sim_ms(const char *arg, uint32_t *ms)
+{
+    char *end;
+    unsigned long v;
+
+    errno = 0;
+    v = strtoul(arg, &end, 0);
+    if (errno || end == arg || *end || v > SIM_LEASE_MAX / 1000)
+    {
+        fprintf(stderr, "%s: between 0 and %u seconds\n", arg,
+            SIM_LEASE_MAX / 1000);
+        return (-1);
+    }
+    *ms = (uint32_t)v * 1000;
+    return (1);
+}
+
+static uint32_t
+sim_xid(const struct sim *s, uint32_t i)
+{
+    return (((i << 8) | s->c[i].seq) ^ s->salt);
+}
+
+/*
+ *  The timer heap, a binary min-heap of client indices ordered by deadline.
+ *  Every client is in it all the time.
+ */
+static void
+heap_set(struct sim *s, uint32_t pos, uint32_t i)
+{
+    s->heap[pos] = i;
+    s->c[i].heap = pos;
+}
+
+static void
+heap_fix(struct sim *s, uint32_t i)
+{
+    uint32_t pos = s->c[i].heap, child, parent;
+    uint32_t deadline = s->c[i].deadline;
+
+    while (pos > 0)
+    {
+        parent = (pos - 1) / 2;
+        if (!SIM_BEFORE(deadline, s->c[s->heap[parent]].deadline))
+        {
+            break;
+        }
+        heap_set(s, pos, s->heap[parent]);
+        pos = parent;
+    }
+    while ((child = 2 * pos + 1) < s->n)
+    {
+        if (child + 1 < s->n && SIM_BEFORE(s->c[s->heap[child + 1]].deadline,
+                                           s->c[s->heap[child]].deadline))
+        {
+            child++;
+        }
+        if (!SIM_BEFORE(s->c[s->heap[child]].deadline, deadline))
+        {
+            break;
+        }
+        heap_set(s, pos, s->heap[child]);
+        pos = child;
+    }
+    heap_set(s, pos, i);
+}
+
+/* leased addresses, for the ARP responder */
+static uint32_t *
+hash_slot(struct sim *s, uint32_t addr)
+{
+    return (&s->bucket[(addr * 2654435761U >> 8) & s->bucket_mask]);
+}
+
+static void
+hash_add(struct sim *s, uint32_t i)
+{
+    uint32_t *slot = hash_slot(s, s->c[i].addr);
+
+    s->c[i].next = *slot;
+    *slot = i + 1;
+}
+
+static void
+hash_del(struct sim *s, uint32_t i)
+{
+    uint32_t *slot = hash_slot(s, s->c[i].addr);
+
+    while (*slot)
+    {
+        if (*slot == i + 1)
+        {
+            *slot = s->c[i].next;
+            break;
+        }
+        slot = &s->c[*slot - 1].next;
+    }
+    s->c[i].next = 0;
+}
+
+static int64_t
+hash_find(struct sim *s, uint32_t addr)
+{
+    uint32_t i = *hash_slot(s, addr);
+
+    for (; i; i = s->c[i - 1].next)
+    {
+        if (s->c[i - 1].addr == addr)
+        {
+            return (i - 1);
+        }
+    }
+    return (-1);
+}
+
+static uint8_t
+sim_server_slot(struct sim *s, uint32_t id, const uint8_t *mac)
+{
+    uint32_t i;
+
+    for (i = 0; i < s->srv_n; i++)
+    {
+        if (s->srv[i].id == id)
+        {
+            memcpy(s->srv[i].mac, mac, 6);
+            return ((uint8_t)i);
+        }
+    }
+    if (s->srv_n == SIM_SERVERS)
+    {
+        return (0xff);                  /* renewals are broadcast */
+    }
+    s->srv[i].id = id;
+    memcpy(s->srv[i].mac, mac, 6);
+    s->srv_n++;
+    return ((uint8_t)i);
+}
+
+/* hands the batched frames to the device */
+static void
+sim_write(struct sim *s, struct libnet_frame *frames, uint32_t n)
+{
+    uint32_t ok = 0, done;
+
+    while (ok < n)
+    {
+        done = libnet_write_batch(s->l, frames + ok, n - ok);
+        s->st.tx += done;
+        ok += done;
+        if (ok < n)
+        {
+            s->st.tx_errors++;
+            ok++;
+        }
+    }
+}
+
+static void
+sim_flush(struct sim *s)
+{
+    if (s->tx_n)
+    {
+        libnet_checksum_batch(s->l, s->frames, s->tx_n, LIBNET_ETH_H,
+                LIBNET_CSUM_IP | LIBNET_CSUM_L4);
+        sim_write(s, s->frames, s->tx_n);
+        s->tx_n = 0;
+    }
+    if (s->arp_n)
+    {
+        sim_write(s, s->arp_frames, s->arp_n);
+        s->arp_n = 0;
+    }
+}
+
+/*
+ *  Puts a message of client i in the next batch slot.  The address fields
+ *  and the destination follow from its state.
+ */
+static void
+sim_send(struct sim *s, uint32_t i, uint8_t type)
+{
+    static const uint8_t bcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    struct sim_client *c = &s->c[i];
+    struct libnet_dhcp_option opt[6];
+    uint8_t *f = s->tx[s->tx_n];
+    uint8_t cid[7];
+    uint32_t n = 0, src = 0, dst = 0xffffffff, ciaddr = 0, xid;
+    uint16_t secs, flags = 0, id;
+    int unicast;
+
+    memcpy(f, s->template, SIM_FRAME);
+
+    cid[0] = 1;                         /* Ethernet */
+    sim_client_mac(s, i, cid + 1);
+    memcpy(f + 6, cid + 1, 6);
+    memcpy(f + SIM_DHCP_OFF + 28, cid + 1, 6);
+
+    unicast = (c->state == SIM_RENEWING || type == LIBNET_DHCP_MSGRELEASE) &&
+        c->srv != 0xff;
+    if (c->state >= SIM_BOUND)
+    {
+        src = ciaddr = c->addr;
+    }
+    else
+    {
+        flags = htons(0x8000);          /* there is no address to reply to */
+    }
+    if (unicast)
+    {
+        dst = s->srv[c->srv].id;
+        memcpy(f, s->srv[c->srv].mac, 6);
+    }
+    else
+    {
+        memcpy(f, bcast, 6);
+    }
+
+    id = htons((uint16_t)s->st.tx);
+    memcpy(f + SIM_IP_OFF + 4, &id, 2);
+    memcpy(f + SIM_IP_OFF + 12, &src, 4);
+    memcpy(f + SIM_IP_OFF + 16, &dst, 4);
+
+    xid = htonl(sim_xid(s, i));
+    secs = htons((uint16_t)((s->now - c->start) / 1000));
+    memcpy(f + SIM_DHCP_OFF + 4, &xid, 4);
+    memcpy(f + SIM_DHCP_OFF + 8, &secs, 2);
+    memcpy(f + SIM_DHCP_OFF + 10, &flags, 2);
+    memcpy(f + SIM_DHCP_OFF + 12, &ciaddr, 4);
+
+    memset(opt, 0, sizeof (opt));
+    opt[n].code    = LIBNET_DHCP_MESSAGETYPE;
+    opt[n++].num   = type;
+    opt[n].code    = LIBNET_DHCP_CLIENTID;
+    opt[n].val     = cid;
+    opt[n++].val_s = sizeof (cid);
+    if (c->state == SIM_REQUESTING)
+    {
+        opt[n].code  = LIBNET_DHCP_DISCOVERADDR;
+        opt[n++].num = c->addr;
+    }
+    if ((c->state == SIM_REQUESTING || type == LIBNET_DHCP_MSGRELEASE) &&
+        c->srv != 0xff)
+    {
+        opt[n].code  = LIBNET_DHCP_SERVIDENT;
+        opt[n++].num = s->srv[c->srv].id;
+    }
+    if (type != LIBNET_DHCP_MSGRELEASE)
+    {
+        opt[n].code    = LIBNET_DHCP_PARAMREQUEST;
+        opt[n].val     = sim_params;
+        opt[n++].val_s = sizeof (sim_params);
+    }
+    /* these always fit in the BOOTP minimum */
+    libnet_dhcp_options(s->l, opt, n, f + SIM_OPT_OFF, SIM_OPT_S);
+
+    s->frames[s->tx_n].buf = f;
+    s->frames[s->tx_n].len = SIM_FRAME;
+    s->tokens -= 1;
+    if (++s->tx_n == SIM_BURST)
+    {
+        sim_flush(s);
+    }
+}
+
+/* the next retransmission, with backoff and RFC 2131 style jitter */
+static uint32_t
+sim_rto(struct sim *s, struct sim_client *c)
+{
+    uint32_t rto = s->rto;
+
+    if (c->tries < 16)
+    {
+        rto <<= c->tries;
+    }
+    if (rto > SIM_RTO_MAX || rto < s->rto)
+    {
+        rto = SIM_RTO_MAX;
+    }
+    c->tries++;
+    return (rto - rto / 8 + libnet_get_prand_r(s->l, LIBNET_PRu32) % (rto / 4 + 1));
+}
+
+static void
+sim_unbind(struct sim *s, uint32_t i)
+{
+    hash_del(s, i);
+    s->c[i].state = SIM_INIT;
+    s->c[i].deadline = s->now;
+    s->st.bound--;
+}
+
+/* a bound client wakes up for its RELEASE, if not for something earlier */
+static void
+sim_hold(const struct sim *s, struct sim_client *c)
+{
+    if (s->hold && c->state >= SIM_BOUND &&
+        SIM_BEFORE(c->release, c->deadline))
+    {
+        c->deadline = c->release;
+    }
+}
+
+/* runs when the timer of client i fires */
+static void
+sim_timer(struct sim *s, uint32_t i)
+{
+    struct sim_client *c = &s->c[i];
+
+    /* held long enough: give the lease back, start over right away */
+    if (s->hold && c->state >= SIM_BOUND && !SIM_BEFORE(s->now, c->release))
+    {
+        sim_send(s, i, LIBNET_DHCP_MSGRELEASE);
+        s->st.releases++;
+        sim_unbind(s, i);
+        return;
+    }
+
+    switch (c->state)
+    {
+        case SIM_INIT:
+            c->seq++;
+            c->start = s->now;
+            c->tries = 0;
+            c->addr  = 0;
+            c->srv   = 0xff;
+            c->state = SIM_SELECTING;
+            /* FALLTHROUGH */
+        case SIM_SELECTING:
+            if (c->tries)
+            {
+                s->st.timeouts++;
+            }
+            sim_send(s, i, LIBNET_DHCP_MSGDISCOVER);
+            s->st.discovers++;
+            c->deadline = s->now + sim_rto(s, c);
+            break;
+        case SIM_REQUESTING:
+            if (c->tries == SIM_REQUEST_TRIES)
+            {
+                s->st.timeouts++;
+                c->state = SIM_INIT;
+                c->deadline = s->now;
+                break;
+            }
+            sim_send(s, i, LIBNET_DHCP_MSGREQUEST);
+            s->st.requests++;
+            c->deadline = s->now + sim_rto(s, c);
+            break;
+        case SIM_BOUND:
+            c->seq++;
+            c->start = s->now;
+            c->tries = 0;
+            c->state = SIM_RENEWING;
+            s->st.renewals++;
+            /* FALLTHROUGH */
+        case SIM_RENEWING:
+            if (SIM_BEFORE(s->now, c->t2))
+            {
+                if (c->tries)
+                {
+                    s->st.timeouts++;
+                }
+                sim_send(s, i, LIBNET_DHCP_MSGREQUEST);
+                s->st.requests++;
+                c->deadline = s->now + sim_rto(s, c);
+                if (SIM_BEFORE(c->t2, c->deadline))
+                {
+                    c->deadline = c->t2;
+                }
+                break;
+            }
+            c->state = SIM_REBINDING;
+            c->tries = 0;
+            /* FALLTHROUGH */
+        case SIM_REBINDING:
+            if (!SIM_BEFORE(s->now, c->expire))
+            {
+                s->st.expired++;
+                sim_unbind(s, i);
+                break;
+            }
+            if (c->tries)
+            {
+                s->st.timeouts++;
+            }
+            sim_send(s, i, LIBNET_DHCP_MSGREQUEST);
+            s->st.requests++;
+            c->deadline = s->now + sim_rto(s, c);
+            if (SIM_BEFORE(c->expire, c->deadline))
+            {
+                c->deadline = c->expire;
+            }
+            break;
+    }
+    sim_hold(s, c);
+}
+
+/* an OFFER, ACK or NAK, if it is for one of ours */
+static void
+sim_dhcp(struct sim *s, const uint8_t *f, uint32_t len)
+{
+    const uint8_t *d, *o, *end;
+    struct sim_client *c;
+    uint8_t mac[6], type = 0;
+    uint32_t xid, i, yiaddr, server = 0, lease = 0, t1 = 0, t2 = 0, v, ms;
+    uint64_t t1_ms, t2_ms;
+    uint32_t hl = (f[LIBNET_ETH_H] & 0x0f) * 4;
+
+    if (len < LIBNET_ETH_H + hl + LIBNET_UDP_H + LIBNET_DHCPV4_H)
+    {
+        return;
+    }
+    d = f + LIBNET_ETH_H + hl + LIBNET_UDP_H;
+    if (d[0] != LIBNET_DHCP_REPLY || d[1] != 1 || d[2] != 6)
+    {
+        return;
+    }
+
+    memcpy(&xid, d + 4, 4);
+    xid = ntohl(xid) ^ s->salt;
+    i = xid >> 8;
+    if (i >= s->n || s->c[i].seq != (uint8_t)xid)
+    {
+        return;
+    }
+    sim_client_mac(s, i, mac);
+    if (memcmp(d + 28, mac, 6) ||
+        d[236] != 0x63 || d[237] != 0x82 || d[238] != 0x53 || d[239] != 0x63)
+    {
+        return;
+    }
+
+    /* the options we care about, all fixed size */
+    end = f + len;
+    for (o = d + LIBNET_DHCPV4_H; o < end && *o != LIBNET_DHCP_END; )
+    {
+        if (*o == LIBNET_DHCP_PAD)
+        {
+            o++;
+            continue;
+        }
+        if (o + 2 > end || o + 2 + o[1] > end)
+        {
+            return;
+        }
+        if (o[1] == 4)
+        {
+            memcpy(&v, o + 2, 4);
+            switch (o[0])
+            {
+                case LIBNET_DHCP_SERVIDENT:
+                    server = v;
+                    break;
+                case LIBNET_DHCP_LEASETIME:
+                    lease = ntohl(v);
+                    break;
+                case LIBNET_DHCP_RENEWTIME:
+                    t1 = ntohl(v);
+                    break;
+                case LIBNET_DHCP_REBINDTIME:
+                    t2 = ntohl(v);
+                    break;
+            }
+        }
+        else if (o[0] == LIBNET_DHCP_MESSAGETYPE && o[1] == 1)
+        {
+            type = o[2];
+        }
+        o += 2 + o[1];
+    }
+
+    c = &s->c[i];
+    memcpy(&yiaddr, d + 16, 4);
+
+    switch (type)
+    {
+        case LIBNET_DHCP_MSGOFFER:
+            s->st.offers++;
+            if (c->state != SIM_SELECTING || yiaddr == 0)
+            {
+                return;                 /* not the first one */
+            }
+            c->addr  = yiaddr;
+            c->srv   = server ? sim_server_slot(s, server, f + 6) : 0xff;
+            c->state = SIM_REQUESTING;
+            c->tries = 0;
+            c->deadline = s->now;       /* send the REQUEST right away */
+            break;
+        case LIBNET_DHCP_MSGACK:
+            s->st.acks++;
+            if (c->state < SIM_REQUESTING || yiaddr == 0)
+            {
+                return;
+            }
+            if (c->state == SIM_REQUESTING)
+            {
+                ms = s->now - c->start;
+                s->st.dora_sum += ms;
+                s->st.dora_n++;
+                if (ms > s->st.dora_max)
+                {
+                    s->st.dora_max = ms;
+                }
+                s->st.bound++;
+                c->release = s->now + s->hold;
+            }
+            else
+            {
+                hash_del(s, i);
+            }
+            c->addr = yiaddr;
+            hash_add(s, i);
+            if (server)
+            {
+                c->srv = sim_server_slot(s, server, f + 6);
+            }
+
+            /* RFC 2131 defaults, all in ms from now; T1 and T2 are 32-bit */
+            ms = lease > SIM_LEASE_MAX / 1000 ? SIM_LEASE_MAX : lease * 1000;
+            t1_ms = s->renew ? s->renew : t1 ? (uint64_t)t1 * 1000 : ms / 2;
+            t2_ms = t2 ? (uint64_t)t2 * 1000 : ms / 8 * 7;
+            if (t1_ms > ms)
+            {
+                t1_ms = ms;
+            }
+            if (t2_ms < t1_ms || t2_ms > ms)
+            {
+                t2_ms = t1_ms > ms / 8 * 7 ? t1_ms : ms / 8 * 7;
+            }
+            c->expire = s->now + ms;
+            c->t2     = s->now + (uint32_t)t2_ms;
+            c->deadline = s->now + (uint32_t)t1_ms;
+            c->state  = SIM_BOUND;
+            c->tries  = 0;
+            sim_hold(s, c);
+            break;
+        case LIBNET_DHCP_MSGNACK:
+            s->st.naks++;
+            if (c->state == SIM_REQUESTING)
+            {
+                c->state = SIM_INIT;
+                c->deadline = s->now;
+            }
+            else if (c->state > SIM_BOUND)
+            {
+                sim_unbind(s, i);
+            }
+            else
+            {
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+    heap_fix(s, i);
+}
+
+/* an ARP request for an address one of ours has leased */
+static void
+sim_arp(struct sim *s, const uint8_t *f, uint32_t len)
+{
+    const uint8_t *a = f + LIBNET_ETH_H;
+    uint32_t tpa;
+    uint8_t *r;
+    int64_t i;
+
+    if (len < LIBNET_ETH_H + LIBNET_ARP_ETH_IP_H || a[0] != 0 || a[1] != 1 ||
+        a[2] != 0x08 || a[3] != 0x00 || a[7] != ARPOP_REQUEST)
+    {
+        return;
+    }
+    memcpy(&tpa, a + 24, 4);
+    i = hash_find(s, tpa);
+    if (i == -1 || s->c[i].state < SIM_BOUND)
+    {
+        return;
+    }
+
+    r = s->arp[s->arp_n];
+    memset(r, 0, SIM_ARP_FRAME);
+    memcpy(r, a + 8, 6);
+    sim_client_mac(s, (uint32_t)i, r + 6);
+    r[12] = 0x08;
+    r[13] = 0x06;
+    memcpy(r + LIBNET_ETH_H, a, 6);     /* hardware and protocol */
+    r[LIBNET_ETH_H + 7] = ARPOP_REPLY;
+    memcpy(r + LIBNET_ETH_H + 8, r + 6, 6);
+    memcpy(r + LIBNET_ETH_H + 14, &tpa, 4);
+    memcpy(r + LIBNET_ETH_H + 18, a + 8, 10);
+
+    s->arp_frames[s->arp_n].buf = r;
+    s->arp_frames[s->arp_n].len = SIM_ARP_FRAME;
+    s->st.arp_replies++;
+    if (++s->arp_n == SIM_BURST)
+    {
+        sim_flush(s);
+    }
+}
+
+/* takes what the socket has, in batches */
+static void
+sim_rx(struct sim *s)
+{
+    struct mmsghdr msgs[SIM_BURST];
+    struct iovec iov[SIM_BURST];
+    const uint8_t *f;
+    int i, n;
+
+    for (i = 0; i < SIM_BURST; i++)
+    {
+        iov[i].iov_base = s->rx[i];
+        iov[i].iov_len  = SIM_RX_MAX;
+        memset(&msgs[i].msg_hdr, 0, sizeof (msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    do
+    {
+        n = recvmmsg(s->fd, msgs, SIM_BURST, MSG_DONTWAIT, NULL);
+        for (i = 0; i < n; i++)
+        {
+            f = s->rx[i];
+            s->st.rx++;
+            if (msgs[i].msg_len < LIBNET_ETH_H + LIBNET_IPV4_H)
+            {
+                continue;
+            }
+            if (f[12] == 0x08 && f[13] == 0x06)
+            {
+                sim_arp(s, f, msgs[i].msg_len);
+            }
+            else
+            {
+                sim_dhcp(s, f, msgs[i].msg_len);
+            }
+        }
+    } while (n == SIM_BURST);
+
+    sim_flush(s);
+}
+
+/*
+ *  A PF_PACKET socket seeing only ARP and UDP to port 68, in promiscuous
+ *  mode, as replies are sent to the clients' made up MAC addresses.
+ */
+static int
+sim_socket(const char *device)
+{
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD  + BPF_H   + BPF_ABS, 12),
+        BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K,   ETH_P_ARP, 8, 0),
+        BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K,   ETH_P_IP, 0, 8),
+        BPF_STMT(BPF_LD  + BPF_B   + BPF_ABS, 23),
+        BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K,   IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD  + BPF_H   + BPF_ABS, 20),
+        BPF_JUMP(BPF_JMP + BPF_JSET + BPF_K,  0x1fff, 4, 0),
+        BPF_STMT(BPF_LDX + BPF_B   + BPF_MSH, 14),
+        BPF_STMT(BPF_LD  + BPF_H   + BPF_IND, 16),
+        BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K,   68, 0, 1),
+        BPF_STMT(BPF_RET + BPF_K,             SIM_RX_MAX),
+        BPF_STMT(BPF_RET + BPF_K,             0),
+    };
+    struct sock_fprog prog = { sizeof (code) / sizeof (code[0]), code };
+    struct sockaddr_ll sll;
+    struct packet_mreq mr;
+    int fd, ifindex;
+
+    ifindex = (int)if_nametoindex(device);
+    if (ifindex == 0)
+    {
+        fprintf(stderr, "%s: %s\n", device, strerror(errno));
+        return (-1);
+    }
+
+    fd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd == -1)
+    {
+        fprintf(stderr, "socket(): %s\n", strerror(errno));
+        return (-1);
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof (prog)) == -1)
+    {
+        fprintf(stderr, "SO_ATTACH_FILTER: %s\n", strerror(errno));
+        goto fail;
+    }
+
+    memset(&sll, 0, sizeof (sll));
+    sll.sll_family   = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex  = ifindex;
+    if (bind(fd, (struct sockaddr *)&sll, sizeof (sll)) == -1)
+    {
+        fprintf(stderr, "bind(): %s\n", strerror(errno));
+        goto fail;
+    }
+
+    memset(&mr, 0, sizeof (mr));
+    mr.mr_ifindex = ifindex;
+    mr.mr_type    = PACKET_MR_PROMISC;
+    if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof (mr)) == -1)
+    {
+        fprintf(stderr, "PACKET_ADD_MEMBERSHIP: %s\n", strerror(errno));
+        goto fail;
+    }
+    return (fd);
+
+fail:
+    close(fd);
+    return (-1);
+}
+
+/* the frame every message starts from */
+static int
+sim_template(struct sim *s)
+{
+    uint8_t opt[SIM_OPT_S] = { LIBNET_DHCP_END };
+    uint8_t *packet;
+    uint32_t packet_s;
+    libnet_t *l = s->l;
+
+    if (libnet_build_dhcpv4(LIBNET_DHCP_REQUEST, 1, 6, 0, 0, 0, 0, 0, 0, 0, 0,
+            s->mac, NULL, NULL, opt, SIM_OPT_S, l, 0) == -1 ||
+        libnet_build_udp(68, 67, LIBNET_UDP_H + LIBNET_DHCPV4_H + SIM_OPT_S, 0,
+            NULL, 0, l, 0) == -1 ||
+        libnet_build_ipv4(SIM_FRAME - LIBNET_ETH_H, 0, 0, 0, 64, IPPROTO_UDP,
+            0, 0, 0xffffffff, NULL, 0, l, 0) == -1 ||
+        libnet_build_ethernet(s->mac, s->mac, ETHERTYPE_IP, NULL, 0, l, 0) == -1 ||
+        libnet_adv_cull_packet(l, &packet, &packet_s) == -1)
+    {
+        fprintf(stderr, "template: %s\n", libnet_geterror(l));
+        return (-1);
+    }
+
+    memcpy(s->template, packet, SIM_FRAME);
+    libnet_adv_free_packet(l, packet);
+    libnet_clear_packet(l);
+    return (1);
+}
+
+static void
+sim_tokens(struct sim *s, uint32_t last)
+{
+    if (s->rate == 0)
+    {
+        s->tokens = SIM_BURST;
+        return;
+    }
+    s->tokens += (double)(s->now - last) * s->rate / 1000;
+    if (s->tokens > SIM_BURST)
+    {
+        s->tokens = SIM_BURST;
+    }
+}
+
+static void
+sim_status(const struct sim *s, FILE *fp)
+{
+    fprintf(fp, "%6us bound %u/%u  tx %llu rx %llu  offers %llu acks %llu "
+        "naks %llu timeouts %llu  dora avg %.1f max %u ms\n",
+        s->now / 1000, s->st.bound, s->n,
+        (unsigned long long)s->st.tx, (unsigned long long)s->st.rx,
+        (unsigned long long)s->st.offers, (unsigned long long)s->st.acks,
+        (unsigned long long)s->st.naks, (unsigned long long)s->st.timeouts,
+        s->st.dora_n ? (double)s->st.dora_sum / s->st.dora_n : 0.0,
+        s->st.dora_max);
+}
+
+/* sends a RELEASE for every lease, still under the rate limit */
+static void
+sim_release(struct sim *s)
+{
+    struct timespec ts = { 0, 1000000 };
+    uint32_t i, last = s->now;
+
+    for (i = 0; i < s->n; i++)
+    {
+        if (s->c[i].state < SIM_BOUND)
+        {
+            continue;
+        }
+        while (s->tokens < 1)
+        {
+            sim_flush(s);
+            nanosleep(&ts, NULL);
+            s->now = sim_clock(s);
+            sim_tokens(s, last);
+            last = s->now;
+        }
+        sim_send(s, i, LIBNET_DHCP_MSGRELEASE);
+        s->st.releases++;
+        sim_unbind(s, i);
+    }
+    sim_flush(s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint32_t duration = 0, last, status = 1000, i, n;
+    int c, release = 0, timeout;
+    struct sigaction sa;
+    struct pollfd pfd;
+    char *device = NULL;
+    struct sim *s;
+
+    s = calloc(1, sizeof (*s));
+    if (s == NULL)
+    {
+        perror("calloc");
+        return (EXIT_FAILURE);
+    }
+    s->n    = 1000;
+    s->rate = 1000;
+    s->rto  = 4000;
+    memcpy(s->mac, "\x02\x4c\x4e\x00\x00\x00", 6);
+
+    while ((c = getopt(argc, argv, "d:hi:l:L:m:n:r:Rt:")) != EOF)
+    {
+        switch (c)
+        {
+            case 'd':
+                if (sim_ms(optarg, &duration) == -1)
+                {
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'i':
+                device = optarg;
+                break;
+            case 'l':
+                if (sim_ms(optarg, &s->renew) == -1)
+                {
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'L':
+                if (sim_ms(optarg, &s->hold) == -1)
+                {
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'm':
+                if (sscanf(optarg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &s->mac[0],
+                        &s->mac[1], &s->mac[2], &s->mac[3], &s->mac[4],
+                        &s->mac[5]) != 6)
+                {
+                    fprintf(stderr, "%s: invalid MAC address\n", optarg);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'n':
+                s->n = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                s->rate = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'R':
+                release = 1;
+                break;
+            case 't':
+                s->rto = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (EXIT_FAILURE);
+        }
+    }
+
+    if (device == NULL || optind != argc)
+    {
+        usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+    if (s->n == 0 || s->n > SIM_CLIENTS_MAX || s->rto == 0)
+    {
+        fprintf(stderr, "%s: between 1 and %u clients, and a timeout\n",
+            argv[0], SIM_CLIENTS_MAX);
+        return (EXIT_FAILURE);
+    }
+    if (sim_mac_low(s->mac) + s->n - 1 > 0xffffffffffULL)
+    {
+        fprintf(stderr, "%s: %u clients from %02x:%02x:%02x:%02x:%02x:%02x "
+            "run past %02x:ff:ff:ff:ff:ff\n", argv[0], s->n, s->mac[0],
+            s->mac[1], s->mac[2], s->mac[3], s->mac[4], s->mac[5], s->mac[0]);
+        return (EXIT_FAILURE);
+    }
+
+    for (n = 1; n < s->n; n <<= 1)
+        ;
+    s->c      = calloc(s->n, sizeof (*s->c));
+    s->heap   = calloc(s->n, sizeof (*s->heap));
+    s->bucket = calloc(n, sizeof (*s->bucket));
+    if (s->c == NULL || s->heap == NULL || s->bucket == NULL)
+    {
+        perror("calloc");
+        return (EXIT_FAILURE);
+    }
+    s->bucket_mask = n - 1;
+
+    s->l = libnet_init(LIBNET_LINK_ADV, device, errbuf);
+    if (s->l == NULL)
+    {
+        fprintf(stderr, "libnet_init() failed: %s\n", errbuf);
+        return (EXIT_FAILURE);
+    }
+    s->fd = sim_socket(device);
+    if (s->fd == -1 || sim_template(s) == -1)
+    {
+        libnet_destroy(s->l);
+        return (EXIT_FAILURE);
+    }
+    s->salt = libnet_get_prand_r(s->l, LIBNET_PRu32);
+
+    /* everybody starts in INIT, now; the rate limit spreads them out */
+    for (i = 0; i < s->n; i++)
+    {
+        s->c[i].srv = 0xff;
+        heap_set(s, i, i);
+    }
+
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &s->t0);
+    s->tokens = s->rate ? 1 : SIM_BURST;
+    last = 0;
+    pfd.fd = s->fd;
+    pfd.events = POLLIN;
+
+    while (running && (duration == 0 || SIM_BEFORE(s->now, duration)))
+    {
+        s->now = sim_clock(s);
+        sim_tokens(s, last);
+        last = s->now;
+
+        while (s->tokens >= 1 && !SIM_BEFORE(s->now, s->c[s->heap[0]].deadline))
+        {
+            i = s->heap[0];
+            sim_timer(s, i);
+            heap_fix(s, i);
+        }
+        sim_flush(s);
+        sim_rx(s);
+
+        if (!SIM_BEFORE(s->now, status))
+        {
+            sim_status(s, stdout);
+            fflush(stdout);
+            status += 1000;
+        }
+
+        /* sleep until the next timer, a token or a reply */
+        timeout = (int)(s->c[s->heap[0]].deadline - s->now);
+        if (timeout <= 0)
+        {
+            timeout = s->tokens < 1 ? 1 : 0;
+        }
+        else if (timeout > 100)
+        {
+            timeout = 100;
+        }
+        poll(&pfd, 1, timeout);
+    }
+
+    s->now = sim_clock(s);
+    if (release)
+    {
+        sim_release(s);
+    }
+    sim_status(s, stdout);
+    printf("%s: %llu discovers, %llu requests, %llu releases, %llu renewals, "
+        "%llu expired, %llu ARP replies, %llu errors\n", device,
+        (unsigned long long)s->st.discovers, (unsigned long long)s->st.requests,
+        (unsigned long long)s->st.releases, (unsigned long long)s->st.renewals,
+        (unsigned long long)s->st.expired, (unsigned long long)s->st.arp_replies,
+        (unsigned long long)s->st.tx_errors);
+
+    close(s->fd);
+    libnet_destroy(s->l);
+    free(s->bucket);
+    free(s->heap);
+    free(s->c);
+    free(s);
+    return (EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,322 @@
+/*
+ *  libnet
+ *  libnet-stat.c - reads published context statistics
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  libnet-stat shows the counters that contexts publish with
+ *  libnet_stats_publish(), live, or once in the Prometheus text format,
+ *  e.g. for the textfile collector of the node exporter.  Reading a page
+ *  costs the sending process nothing.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <dirent.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libnet.h>
+
+#define STAT_PAGES_MAX  64
+#define STAT_SHM_DIR    "/dev/shm"          /* where shm_open() puts them */
+
+struct stat_page
+{
+    char name[64];
+    const struct libnet_stats_page *page;
+    struct libnet_stats_page last;
+};
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-i interval] [-c count] [-p] [name ...]\n"
+        "  -i interval   seconds between updates (default 1)\n"
+        "  -c count      stop after count updates\n"
+        "  -p            print once in the Prometheus text format\n"
+        "\n"
+        "Without names, shows all pages published on this host\n",
+        name);
+}
+
+/* finds the pages in /dev/shm, returns how many */
+static int
+scan(struct stat_page *pages, int max)
+{
+    const size_t plen = strlen(LIBNET_STATS_PAGE_PREFIX) - 1;
+    struct dirent *d;
+    DIR *dir;
+    int n = 0;
+
+    dir = opendir(STAT_SHM_DIR);
+    if (dir == NULL)
+    {
+        return (0);
+    }
+    while ((d = readdir(dir)) != NULL && n < max)
+    {
+        /* the prefix without its leading slash */
+        if (strncmp(d->d_name, LIBNET_STATS_PAGE_PREFIX + 1, plen) == 0 &&
+            d->d_name[plen] != '\0')
+        {
+            snprintf(pages[n].name, sizeof (pages[n].name), "%s",
+                    d->d_name + plen);
+            n++;
+        }
+    }
+    closedir(dir);
+
+    return (n);
+}
+
+static void
+prometheus(const struct stat_page *p, const struct libnet_stats_page *s)
+{
+    const struct libnet_stats_ex *x = &s->stats;
+    char labels[256];
+    uint64_t cum = 0;
+    int i;
+
+    /* the page is another process's, don't count on a terminating NUL */
+    snprintf(labels, sizeof (labels), "name=\"%.*s\",device=\"%.*s\"",
+            (int)sizeof (p->name), p->name, (int)sizeof (s->device),
+            s->device);
+
+#define METRIC(m, v) \
+    printf("libnet_" m "{%s} %llu\n", labels, (unsigned long long)(v))
+    METRIC("packets_sent_total", x->packets_sent);
+    METRIC("bytes_written_total", x->bytes_written);
+    METRIC("packet_errors_total", x->packet_errors);
+    printf("libnet_write_errors_total{%s,cause=\"nobufs\"} %llu\n", labels,
+            (unsigned long long)x->err_nobufs);
+    printf("libnet_write_errors_total{%s,cause=\"again\"} %llu\n", labels,
+            (unsigned long long)x->err_again);
+    printf("libnet_write_errors_total{%s,cause=\"msgsize\"} %llu\n", labels,
+            (unsigned long long)x->err_msgsize);
+    printf("libnet_write_errors_total{%s,cause=\"perm\"} %llu\n", labels,
+            (unsigned long long)x->err_perm);
+    printf("libnet_write_errors_total{%s,cause=\"other\"} %llu\n", labels,
+            (unsigned long long)x->err_other);
+    METRIC("partial_writes_total", x->partial_writes);
+    METRIC("coalesces_total", x->coalesces);
+    printf("libnet_coalesce_seconds_total{%s} %.9f\n", labels,
+            x->coalesce_ns / 1e9);
+    printf("libnet_checksum_seconds_total{%s} %.9f\n", labels,
+            x->checksum_ns / 1e9);
+    printf("libnet_packets_per_second{%s} %.1f\n", labels, x->pps);
+    printf("libnet_bits_per_second{%s} %.1f\n", labels, x->bps);
+
+    /* a bucket's upper bound is 2^(i+1) ns */
+    for (i = 0; i < LIBNET_STATS_HIST; i++)
+    {
+        cum += x->syscall_hist[i];
+        if (x->syscall_hist[i] || i == LIBNET_STATS_HIST - 1)
+        {
+            printf("libnet_syscall_seconds_bucket{%s,le=\"%g\"} %llu\n",
+                    labels, (double)(2ULL << i) / 1e9,
+                    (unsigned long long)cum);
+        }
+    }
+    printf("libnet_syscall_seconds_bucket{%s,le=\"+Inf\"} %llu\n", labels,
+            (unsigned long long)x->syscalls);
+    printf("libnet_syscall_seconds_sum{%s} %.9f\n", labels,
+            x->syscall_ns / 1e9);
+    printf("libnet_syscall_seconds_count{%s} %llu\n", labels,
+            (unsigned long long)x->syscalls);
+
+    if (s->queue.depth)
+    {
+        METRIC("queue_depth", s->queue.depth);
+        METRIC("queue_used", s->queue.used);
+        METRIC("queue_dropped_total", s->queue.dropped);
+    }
+#undef METRIC
+}
+
+static void
+row(struct stat_page *p, const struct libnet_stats_page *s, double dt)
+{
+    const struct libnet_stats_ex *x = &s->stats;
+    double pps = x->pps, bps = x->bps;
+    char queue[32] = "-";
+
+    /* the publisher's rates age while it is idle, ours do not */
+    if (dt > 0)
+    {
+        pps = (x->packets_sent - p->last.stats.packets_sent) / dt;
+        bps = (x->bytes_written - p->last.stats.bytes_written) * 8 / dt;
+    }
+    if (s->queue.depth)
+    {
+        snprintf(queue, sizeof (queue), "%u/%u", s->queue.used,
+                s->queue.depth);
+    }
+
+    printf("%-16s %-10.*s %7u %10.0f %9.2f %12lld %8lld %6lld %6lld %6lld "
+            "%6lld %10s\n", p->name, (int)sizeof (s->device),
+            s->device[0] ? s->device : "-", s->pid,
+            pps, bps / 1e6, (long long)x->packets_sent,
+            (long long)x->packet_errors, (long long)x->err_nobufs,
+            (long long)x->err_again, (long long)x->err_msgsize,
+            (long long)x->err_perm, queue);
+
+    p->last = *s;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct stat_page pages[STAT_PAGES_MAX];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_stats_page s;
+    struct timespec ts, t0, t1;
+    double interval = 1, dt = 0;
+    long count = -1, round;
+    int c, i, n, prom = 0;
+
+    while ((c = getopt(argc, argv, "c:hi:p")) != EOF)
+    {
+        switch (c)
+        {
+            case 'c':
+                count = strtol(optarg, NULL, 0);
+                break;
+            case 'i':
+                interval = strtod(optarg, NULL);
+                break;
+            case 'p':
+                prom = 1;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (EXIT_FAILURE);
+        }
+    }
+    if (interval <= 0)
+    {
+        usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    if (optind < argc)
+    {
+        for (n = 0; optind < argc && n < STAT_PAGES_MAX; n++, optind++)
+        {
+            snprintf(pages[n].name, sizeof (pages[n].name), "%s",
+                    argv[optind]);
+        }
+    }
+    else
+    {
+        n = scan(pages, STAT_PAGES_MAX);
+    }
+
+    /* pages that cannot be mapped are left out, with a warning */
+    for (i = c = 0; i < n; i++)
+    {
+        pages[c] = pages[i];
+        pages[c].page = libnet_stats_map(pages[i].name, errbuf);
+        if (pages[c].page == NULL)
+        {
+            fprintf(stderr, "%s\n", errbuf);
+            continue;
+        }
+        c++;
+    }
+    n = c;
+    if (n == 0)
+    {
+        fprintf(stderr, "%s: no statistics pages\n", argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    if (prom)
+    {
+        for (i = 0; i < n; i++)
+        {
+            if (libnet_stats_read(pages[i].page, &s) == 1)
+            {
+                prometheus(&pages[i], &s);
+            }
+            libnet_stats_unmap(pages[i].page);
+        }
+        return (EXIT_SUCCESS);
+    }
+
+    ts.tv_sec  = (time_t)interval;
+    ts.tv_nsec = (long)((interval - ts.tv_sec) * 1e9);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (round = 0; count < 0 || round < count; round++)
+    {
+        if (round)
+        {
+            nanosleep(&ts, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            dt = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+            t0 = t1;
+        }
+
+        printf("%-16s %-10s %7s %10s %9s %12s %8s %6s %6s %6s %6s %10s\n",
+                "name", "device", "pid", "pkts/s", "Mbit/s", "sent",
+                "errors", "nobufs", "again", "msgsz", "perm", "queue");
+        for (i = 0; i < n; i++)
+        {
+            if (libnet_stats_read(pages[i].page, &s) == 1)
+            {
+                row(&pages[i], &s, dt);
+            }
+            else
+            {
+                printf("%-16s (busy)\n", pages[i].name);
+            }
+        }
+        fflush(stdout);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        libnet_stats_unmap(pages[i].page);
+    }
+    return (EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,328 @@
+/*
+ *  libnet
+ *  libnet-txd.c - drains shared memory rings to a device
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  libnet-txd creates one or more rings in shared memory, see libnet_ring.h,
+ *  and sends whatever LIBNET_SHM contexts put in them out on a device.
+ *  Only the daemon needs to be privileged; producers only need access to
+ *  the ring, which is governed by its file mode (-m).  A slot a producer
+ *  claims and does not fill in within a second, e.g. because it died, is
+ *  skipped, so the ring does not stall behind it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <libnet.h>
+#include "libnet_ring.h"
+
+#define TXD_RINGS_MAX  32
+#define TXD_BURST      64
+#define TXD_SPIN       1024                 /* idle rounds before sleeping */
+#define TXD_SLEEP_MAX  1000000              /* ns */
+#define TXD_STALL      1000000000ULL        /* ns a slot may stay claimed */
+
+/* the ring header is the producers' to scribble on, rd is ours */
+struct txd_ring
+{
+    char name[64];
+    struct libnet_ring *ring;
+    struct libnet_ring_reader rd;
+    size_t size;
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [-d depth] [-s frame_max] [-m mode] -i device ring ...\n"
+        "  -i device     send on device\n"
+        "  -d depth      slots per ring, a power of two (default 1024)\n"
+        "  -s frame_max  largest frame in bytes (default 2048)\n"
+        "  -m mode       file mode of the rings, octal (default 0600)\n"
+        "\n"
+        "Producers open a ring with libnet_init(LIBNET_SHM, \"ring\", ...)\n",
+        name);
+}
+
+static void
+on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static int
+ring_create(struct txd_ring *t, const char *ring, uint32_t depth,
+        uint32_t frame_max, mode_t mode)
+{
+    int fd;
+
+    if (strchr(ring, '/') ||
+        snprintf(t->name, sizeof (t->name), "%s%s", LIBNET_RING_PREFIX, ring)
+        >= (int)sizeof (t->name))
+    {
+        fprintf(stderr, "%s: invalid ring name\n", ring);
+        return (-1);
+    }
+
+    t->size = libnet_ring_size(depth, frame_max);
+
+    /* a ring left behind by a daemon that did not exit cleanly */
+    shm_unlink(t->name);
+
+    fd = shm_open(t->name, O_RDWR | O_CREAT | O_EXCL, mode);
+    if (fd == -1)
+    {
+        fprintf(stderr, "%s: shm_open(): %s\n", ring, strerror(errno));
+        return (-1);
+    }
+
+    /* shm_open() is subject to the umask */
+    if (fchmod(fd, mode) == -1 || ftruncate(fd, (off_t)t->size) == -1)
+    {
+        fprintf(stderr, "%s: %s\n", ring, strerror(errno));
+        goto fail;
+    }
+
+    t->ring = mmap(NULL, t->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (t->ring == MAP_FAILED)
+    {
+        fprintf(stderr, "%s: mmap(): %s\n", ring, strerror(errno));
+        goto fail;
+    }
+    close(fd);
+
+    libnet_ring_init(t->ring, depth, frame_max);
+    libnet_ring_reader_init(&t->rd, t->ring, t->size, depth, frame_max);
+    return (1);
+
+fail:
+    close(fd);
+    shm_unlink(t->name);
+    return (-1);
+}
+
+/* hands up to one burst from a ring to the device, returns slots taken */
+static uint32_t
+ring_drain(libnet_t *l, struct txd_ring *t, uint64_t *sent, uint64_t *errors)
+{
+    struct libnet_frame frames[TXD_BURST];
+    const uint64_t refused = t->rd.refused;
+    uint32_t i, n, len, ok, done;
+    struct timespec now;
+    uint8_t *buf;
+
+    for (i = n = 0; i < TXD_BURST; i++)
+    {
+        buf = libnet_ring_peek(&t->rd, i, &len);
+        if (buf == NULL)
+        {
+            break;
+        }
+        if (len)
+        {
+            frames[n].buf = buf;
+            frames[n].len = len;
+            n++;
+        }
+    }
+    if (i == 0)
+    {
+        /* a producer that died holding the next slot would stop us here */
+        if (libnet_ring_pending(&t->rd) == 0)
+        {
+            return (0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (libnet_ring_skip(&t->rd,
+                (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec, TXD_STALL));
+    }
+    *errors += t->rd.refused - refused;
+
+    /* a frame the device refuses is dropped, not retried */
+    ok = 0;
+    while (ok < n)
+    {
+        done = libnet_write_batch(l, frames + ok, n - ok);
+        *sent += done;
+        ok += done;
+        if (ok < n)
+        {
+            (*errors)++;
+            ok++;
+        }
+    }
+
+    libnet_ring_release(&t->rd, i);
+    return (i);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct txd_ring rings[TXD_RINGS_MAX];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint32_t depth = 1024, frame_max = 2048;
+    uint64_t sent = 0, errors = 0, skipped = 0;
+    mode_t mode = 0600;
+    char *device = NULL;
+    struct sigaction sa;
+    struct timespec ts;
+    long idle = 0;
+    libnet_t *l;
+    int c, i, n;
+
+    while ((c = getopt(argc, argv, "d:hi:m:s:")) != EOF)
+    {
+        switch (c)
+        {
+            case 'd':
+                depth = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                device = optarg;
+                break;
+            case 'm':
+                mode = (mode_t)strtoul(optarg, NULL, 8);
+                break;
+            case 's':
+                frame_max = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (EXIT_FAILURE);
+        }
+    }
+
+    n = argc - optind;
+    if (device == NULL || n < 1 || n > TXD_RINGS_MAX)
+    {
+        usage(argv[0]);
+        return (EXIT_FAILURE);
+    }
+    if (libnet_ring_size(depth, frame_max) == 0 || frame_max < LIBNET_ETH_H)
+    {
+        fprintf(stderr, "%s: depth must be a power of two\n", argv[0]);
+        return (EXIT_FAILURE);
+    }
+
+    l = libnet_init(LIBNET_LINK, device, errbuf);
+    if (l == NULL)
+    {
+        fprintf(stderr, "libnet_init() failed: %s\n", errbuf);
+        return (EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (ring_create(&rings[i], argv[optind + i], depth, frame_max, mode) == -1)
+        {
+            while (i--)
+            {
+                munmap(rings[i].ring, rings[i].size);
+                shm_unlink(rings[i].name);
+            }
+            libnet_destroy(l);
+            return (EXIT_FAILURE);
+        }
+    }
+
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (1)
+    {
+        uint32_t taken = 0;
+
+        for (i = 0; i < n; i++)
+        {
+            taken += ring_drain(l, &rings[i], &sent, &errors);
+        }
+
+        if (taken)
+        {
+            idle = 0;
+            continue;
+        }
+        if (!running)
+        {
+            break;              /* drained */
+        }
+
+        /* spin a while, then back off up to TXD_SLEEP_MAX */
+        if (++idle > TXD_SPIN)
+        {
+            ts.tv_sec  = 0;
+            ts.tv_nsec = idle - TXD_SPIN < TXD_SLEEP_MAX / 1000 ?
+                (idle - TXD_SPIN) * 1000 : TXD_SLEEP_MAX;
+            nanosleep(&ts, NULL);
+        }
+    }
+
+    /* producers still holding a mapping keep it until they let go */
+    for (i = 0; i < n; i++)
+    {
+        skipped += rings[i].rd.skipped;
+        shm_unlink(rings[i].name);
+        munmap(rings[i].ring, rings[i].size);
+    }
+
+    printf("%s: %llu frames sent, %llu errors, %llu slots skipped\n", device,
+        (unsigned long long)sent, (unsigned long long)errors,
+        (unsigned long long)skipped);
+
+    libnet_destroy(l);
+    return (EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
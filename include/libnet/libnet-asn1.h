@@ -250,6 +250,88 @@ libnet_build_asn1_bitstring(
     );
 
 
+/*
+ *  The build_asn1_r* functions encode back to front, so the length of a
+ *  constructed object is known by the time its header is written.  They take
+ *  the same first arguments as the ones above, except that:
+ *
+ *  uint8_t *data:   This points at the first byte already written, i.e. one
+ *                  past the end of the buffer to begin with.  The object is
+ *                  written immediately before it.
+ *  int *datalen:   This is a pointer to the number of free bytes before
+ *                  "data".
+ *
+ *  They return NULL upon error or a pointer to the first byte of the object
+ *  just written, which is where the next (preceding) object ends.  To wrap
+ *  a SEQUENCE around some objects, encode them last to first, then call
+ *  libnet_build_asn1_rheader() with the number of bytes they took.
+ */
+
+uint8_t *
+libnet_build_asn1_rlength(
+    uint8_t *,           /* Pointer past the free space in the buffer */
+    int *,              /* Number of free bytes before it */
+    int                 /* Length of object */
+    );
+
+
+uint8_t *
+libnet_build_asn1_rheader(
+    uint8_t *,
+    int *,
+    uint8_t,             /* ASN object type */
+    int                 /* Length of the contents, already written */
+    );
+
+
+/* signed integer, in as few bytes as it takes */
+uint8_t *
+libnet_build_asn1_rint(
+    uint8_t *,
+    int *,
+    uint8_t,
+    int64_t
+    );
+
+
+/* unsigned integer (Counter32, Gauge32, TimeTicks, Counter64, ...) */
+uint8_t *
+libnet_build_asn1_ruint(
+    uint8_t *,
+    int *,
+    uint8_t,
+    uint64_t
+    );
+
+
+uint8_t *
+libnet_build_asn1_rstring(
+    uint8_t *,
+    int *,
+    uint8_t,
+    const uint8_t *,     /* Pointer to the string */
+    int                 /* Size of the string */
+    );
+
+
+uint8_t *
+libnet_build_asn1_robjid(
+    uint8_t *,
+    int *,
+    uint8_t,
+    const oid *,
+    int                 /* Number of sub-identifiers, at most MAX_OID_LEN */
+    );
+
+
+uint8_t *
+libnet_build_asn1_rnull(
+    uint8_t *,
+    int *,
+    uint8_t
+    );
+
+
 #endif  /* __LIBNET_ASN1_H */
 
 /**
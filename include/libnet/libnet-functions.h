@@ -49,12 +49,17 @@
  * device's IP address (192.168.0.1). If device is NULL, libnet attempts to
  * find a suitable device to use. If the injection_type is LIBNET_RAW4 or
  * LIBNET_RAW4_ADV, the function initializes the injection primitives for the
- * IPv4 raw socket interface. The final argument, err_buf, should be a buffer
- * of size LIBNET_ERRBUF_SIZE and holds an error message if the function fails.
- * This function requires root privileges to execute successfully. Upon
+ * IPv4 raw socket interface. If the injection_type is LIBNET_SHM, packets
+ * are built starting at the data-link layer, as with LIBNET_LINK, but are
+ * written to the shared memory ring named by device, which must have been
+ * created by libnet-txd(8).  That daemon sends them on, so LIBNET_SHM needs
+ * no privileges beyond access to the ring.  The final argument, err_buf,
+ * should be a buffer of size LIBNET_ERRBUF_SIZE and holds an error message
+ * if the function fails.  Except for LIBNET_NONE and LIBNET_SHM, this
+ * function requires root privileges to execute successfully. Upon
  * success, the function returns a valid libnet context for use in later
  * function calls; upon failure, the function returns NULL.
- * @param injection_type packet injection type (LIBNET_LINK, LIBNET_LINK_ADV, LIBNET_RAW4, LIBNET_RAW4_ADV, LIBNET_RAW6, LIBNET_RAW6_ADV)
+ * @param injection_type packet injection type (LIBNET_LINK, LIBNET_LINK_ADV, LIBNET_RAW4, LIBNET_RAW4_ADV, LIBNET_RAW6, LIBNET_RAW6_ADV, LIBNET_SHM, LIBNET_NONE)
  * @param device the interface to use (NULL and libnet will choose one)
  * @param err_buf will contain an error message on failure
  * @return libnet context ready for use or NULL on error.
@@ -72,6 +77,69 @@ LIBNET_API
 void
 libnet_destroy(libnet_t *l);
 
+/**
+ * Creates a context that writes to the same device as l, for instance one
+ * per worker thread, without going through libnet_init() again.  The clone
+ * shares the socket of l, or maps the same LIBNET_SHM ring, and starts out
+ * with the packet built in l, same ptags included.  The protocol block
+ * buffers are shared until either context modifies a block, which then
+ * gets its own copy, so only the headers a thread changes cost memory.
+ * Field variations, a TX thread, a carousel, an LSDB, BGP-4 routes to
+ * pack, a DNS message, periodic streams and an LLDPDU template are not
+ * carried over, and the statistics start at zero.  l must not be modified while it is being cloned, but afterwards l
+ * and its clones may be used from different threads, and destroyed in any
+ * order.
+ * @param l pointer to a libnet context
+ * @return a new libnet context, or NULL on error, see libnet_geterror(l)
+ */
+LIBNET_API
+libnet_t *
+libnet_clone(libnet_t *l);
+
+/**
+ * Routes the memory libnet allocates, for contexts, protocol blocks, packet
+ * buffers and queues alike, to the functions of a, e.g. to put it in a
+ * jemalloc arena or a pool of huge pages.  The allocator is global and
+ * must be set before the first libnet_init(), or once every context has
+ * been destroyed and memory returned by libnet freed: memory is always
+ * released by the allocator that was set at the time it is freed.  The
+ * functions may be called from any thread that uses libnet.  Memory that
+ * older functions such as libnet_hex_aton() return for the caller to
+ * free() still comes from the C library.
+ * @param a the allocator to use, copied, or NULL for malloc(), realloc()
+ * and free()
+ * @retval 1 on success
+ * @retval -1 if a function of a is missing
+ */
+LIBNET_API
+int
+libnet_set_allocator(const struct libnet_allocator *a);
+
+/**
+ * Fills in the number of allocations made on behalf of a context, and the
+ * bytes they asked for, since it was created.  A loop that rebuilds and
+ * writes a packet of unchanging size allocates nothing once the first
+ * packet has been written, which lets tests assert that a send path is
+ * free of allocations.
+ * @param l pointer to a libnet context
+ * @param as pointer to a libnet allocation statistics structure
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_alloc_stats(const libnet_t *l, struct libnet_alloc_stats *as);
+
+/**
+ * Releases memory that libnet returned to be freed with this function,
+ * e.g. by libnet_bgp4_packer_pack(), with the allocator set by
+ * libnet_set_allocator().  Not for memory to be released with free().
+ * @param ptr the memory to release, may be NULL
+ */
+LIBNET_API
+void
+libnet_free(void *ptr);
+
 /**
  * Clears the current packet referenced and frees all pblocks. Should be
  * called when the programmer want to send a completely new packet of
@@ -92,6 +160,100 @@ LIBNET_API
 void
 libnet_stats(const libnet_t *l, struct libnet_stats *ls);
 
+/**
+ * Fills in a libnet_stats_ex structure, a superset of libnet_stats().  On
+ * top of the totals it splits the write errors by cause (ENOBUFS, EAGAIN,
+ * EMSGSIZE, EPERM), counts partial writes and tracks packet and bit rates
+ * as exponentially weighted moving averages, with a time constant of one
+ * second, sampled on each call.  With timing enabled, see
+ * libnet_stats_timing(), it also has the time spent coalescing and
+ * checksumming, and a histogram of the latency of the write system calls.
+ * @param l pointer to a libnet context
+ * @param ls pointer to a libnet extended statistics structure
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_stats_ex(libnet_t *l, struct libnet_stats_ex *ls);
+
+/**
+ * Turns timing of writes and packet assembly on or off.  It is off by
+ * default, it costs two clock reads per write call and per packet.
+ * @param l pointer to a libnet context
+ * @param on 1 to turn timing on, 0 to turn it off
+ */
+LIBNET_API
+void
+libnet_stats_timing(libnet_t *l, int on);
+
+/**
+ * Publishes the statistics of a context in a page of shared memory, named
+ * /dev/shm/libnet-stats-NAME on Linux, for monitoring tools like
+ * libnet-stat to read at any frequency, see libnet_stats_map().  The
+ * packet, byte and error counts are updated on every write, the rest of
+ * struct libnet_stats_ex and the TX queue occupancy every 64 writes.
+ * Updates are lock-free and take no system call.  While a TX thread runs,
+ * see libnet_tx_start(), it updates the page with what it writes, so the
+ * page must be published before the thread is started.  The page is
+ * removed by libnet_stats_unpublish() or libnet_destroy().
+ * @param l pointer to a libnet context
+ * @param name name of the page, no slashes
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_stats_publish(libnet_t *l, const char *name);
+
+/**
+ * Removes the statistics page of a context, see libnet_stats_publish().
+ * Readers that have it mapped keep their copy, which no longer changes.
+ * @param l pointer to a libnet context
+ * @retval 1 on success
+ * @retval -1 if the context has no statistics page, or a TX thread is
+ * running
+ */
+LIBNET_API
+int
+libnet_stats_unpublish(libnet_t *l);
+
+/**
+ * Maps the statistics page another process published under a name, see
+ * libnet_stats_publish(), read-only.
+ * @param name name of the page
+ * @param errbuf a buffer of size LIBNET_ERRBUF_SIZE for an error message
+ * @return a pointer to the page, to be passed to libnet_stats_read(), or
+ * NULL on failure
+ */
+LIBNET_API
+const struct libnet_stats_page *
+libnet_stats_map(const char *name, char *errbuf);
+
+/**
+ * Takes a consistent copy of a statistics page, retrying while the
+ * publisher is updating it.  The rates, which the publisher samples every
+ * 64 writes only, are brought up to the time of the call, so they decay
+ * while it sends nothing.  No system calls are involved.
+ * @param page pointer to a page from libnet_stats_map()
+ * @param copy pointer to a page to copy into
+ * @retval 1 on success
+ * @retval -1 if the page is not quiescing, e.g. its publisher died while
+ * updating it
+ */
+LIBNET_API
+int
+libnet_stats_read(const struct libnet_stats_page *page,
+        struct libnet_stats_page *copy);
+
+/**
+ * Unmaps a statistics page, see libnet_stats_map().
+ * @param page pointer to a page from libnet_stats_map()
+ */
+LIBNET_API
+void
+libnet_stats_unmap(const struct libnet_stats_page *page);
+
 /**
  * Returns the FILENO of the file descriptor used for packet injection.
  * @param l pointer to a libnet context
@@ -196,6 +358,21 @@ LIBNET_API
 uint32_t
 libnet_get_prand(int mod);
 
+/**
+ * Generates an unsigned pseudo-random value within the range specified by
+ * mod, like libnet_get_prand(), but from a generator whose state is kept in
+ * the given context.  This is considerably cheaper than random() and safe
+ * to use from several threads as long as each uses its own context.  The
+ * generator is seeded from libnet_get_prand() on first use, and reseeded
+ * after a call to libnet_seed_prand().
+ * @param l pointer to a libnet context
+ * @param mod one the of LIBNET_PR* constants
+ * @return a pseudo-random value
+ */
+LIBNET_API
+uint32_t
+libnet_get_prand_r(libnet_t *l, int mod);
+
 /**
  * If a given protocol header is built with the checksum field set to "0", by
  * default libnet will calculate the header checksum prior to injection. If the
@@ -222,6 +399,33 @@ LIBNET_API
 int
 libnet_toggle_checksum(libnet_t *l, libnet_ptag_t ptag, int mode);
 
+/**
+ * Computes the IPv4 header checksum and the TCP or UDP checksum of many
+ * wire-ready frames in one go.  Frames sharing a layout, e.g. variants of
+ * one packet, are processed several at a time across SIMD lanes where the
+ * CPU supports it (AVX2), so this is considerably cheaper than checksumming
+ * each frame on its own.  Each frame must hold an IPv4 header ip_offset
+ * bytes into it, the TCP or UDP segment is taken to run to the end of the
+ * frame.  Other transport protocols, and non-initial fragments, only get
+ * their IPv4 header checksum.  Any previous checksum value is overwritten.
+ * The carousel and IPv4 fragmentation use it.  A frame that differs from
+ * a checksummed one in a few fields, as periodic stream counters and
+ * fanout source addresses do, is cheaper to fix up incrementally (RFC
+ * 1624) than to sum again; OSPF checksums, as in LSDB LSUs, and LSA
+ * Fletcher checksums are not covered.
+ * @param l pointer to a libnet context
+ * @param frames the frames to update
+ * @param n number of frames
+ * @param ip_offset offset of the IPv4 header in every frame
+ * @param mode LIBNET_CSUM_IP, LIBNET_CSUM_L4 or both
+ * @retval 1 on success
+ * @retval -1 on failure, when a frame is not IPv4 or is truncated
+ */
+LIBNET_API
+int
+libnet_checksum_batch(libnet_t *l, const struct libnet_frame *frames,
+uint32_t n, uint32_t ip_offset, int mode);
+
 /**
  * Takes a network byte ordered IPv4 address and returns a pointer to either a 
  * canonical DNS name (if it has one) or a string of dotted decimals. This may
@@ -823,12 +1027,52 @@ libnet_ptag_t libnet_build_lldp_org_spec(const uint8_t *value,
 uint16_t value_s, libnet_t *l, libnet_ptag_t ptag);
 
 /**
- * At the moment, this function is not implemented.
- *
- * This stub may be useful in feature to let to the user build the
- * LLDPDU in one function by passing corresponding arguments.
+ * Builds a whole LLDPDU in one protocol block: the TLVs described by tlv,
+ * in order, and the End of LLDPDU TLV, which is added.  The Chassis ID and
+ * Port ID TLVs take a subtype and a 1 to 255 byte string; for every other
+ * type val is the information string as it goes on the wire, e.g. an OUI,
+ * a subtype and the information for an Organizationally Specific TLV, or,
+ * if val is NULL, num is encoded in 2 bytes, as for the TTL TLV.
+ * The LLDPDU is serialized in an arena kept by the context, reused by the
+ * next call, and becomes the template of libnet_lldp_patch(): the pblock
+ * is allocated with room for the longest Port ID, so that patching it, or
+ * rebuilding it through its ptag, needs no further allocation.
+ * @param tlv TLVs of the LLDPDU, chassis, port and TTL first
+ * @param tlv_n number of TLVs
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag to modify an existing header, 0 to build a new one
+ * @return protocol tag value on success
+ * @retval -1 on error
+ */
+LIBNET_API
+libnet_ptag_t libnet_build_lldp(const struct libnet_lldp_tlv *tlv,
+uint32_t tlv_n, libnet_t *l, libnet_ptag_t ptag);
+
+/**
+ * Rewrites the Port ID string and the TTL of the LLDPDU last built with
+ * libnet_build_lldp(), leaving the other TLVs as they were serialized,
+ * to send the LLDPDU of every port of a switch from one template.  The
+ * subtype of the Port ID is kept; its string may change length.
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag returned by libnet_build_lldp()
+ * @param port_id the Port ID string
+ * @param port_id_s length of port_id, 1 to 255
+ * @param ttl number of seconds
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+LIBNET_API
+int libnet_lldp_patch(libnet_t *l, libnet_ptag_t ptag,
+const uint8_t *port_id, uint8_t port_id_s, uint16_t ttl);
+
+/**
+ * Frees the TLV arena of the context and forgets its LLDPDU template.
+ * This is also done by libnet_clear_packet() and libnet_destroy().
+ * Pblocks already built are unaffected.
+ * @param l pointer to a libnet context
  */
-//libnet_ptag_t libnet_build_lldp(libnet_t *l, libnet_ptag_t ptag);
+LIBNET_API
+void libnet_lldp_free(libnet_t *l);
 
 /**
  * Builds an IP version 4 RFC 792 Internet Control Message Protocol (ICMP)
@@ -1373,6 +1617,187 @@ uint16_t num_q, uint16_t num_anws_rr, uint16_t num_auth_rr,
 uint16_t num_addi_rr, const uint8_t* payload, uint32_t payload_s, libnet_t *l,
 libnet_ptag_t ptag);
 
+/**
+ * Builds a DNS header carrying the message put together with
+ * libnet_dns_question() and the libnet_dns_rr*() functions as its payload,
+ * the section counts filled in.  The message stays with the context, so
+ * the same ptag can be rebuilt with another id or flags at no encoding
+ * cost; see libnet_dns_template() for varying it on every packet.
+ * @param h_len LIBNET_UDP_DNSV4_H, or LIBNET_TCP_DNSV4_H for the 2 byte
+ * length prefix of DNS over TCP
+ * @param id DNS packet id
+ * @param flags control flags
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag to modify an existing header, 0 to build a new one
+ * @return protocol tag value on success
+ * @retval -1 on error
+ */
+LIBNET_API
+libnet_ptag_t
+libnet_build_dns_message(uint16_t h_len, uint16_t id, uint16_t flags,
+libnet_t *l, libnet_ptag_t ptag);
+
+/**
+ * [DNS Encoder]
+ * Appends a question to the context's DNS message, see
+ * libnet_build_dns_message().  Names are given in dotted form, a trailing
+ * dot optional, "." or "" being the root; there are no escapes.  Every
+ * name is compressed against those already in the message, case
+ * insensitively.  Questions come first, then the answer, authority and
+ * additional records, in that order.
+ * @param l pointer to a libnet context
+ * @param name the QNAME
+ * @param type the QTYPE, e.g. LIBNET_DNS_TYPE_A
+ * @param class the QCLASS, e.g. LIBNET_DNS_CLASS_IN
+ * @retval 1 on success
+ * @retval -1 on failure, e.g. a bad name or a message over 64 kB
+ */
+LIBNET_API
+int
+libnet_dns_question(libnet_t *l, const char *name, uint16_t type,
+uint16_t class);
+
+/**
+ * [DNS Encoder]
+ * Appends a resource record with the given RDATA to a section of the
+ * context's DNS message.  Names inside rdata are not compressed.
+ * @param l pointer to a libnet context
+ * @param section LIBNET_DNS_ANSWER, LIBNET_DNS_AUTHORITY or
+ * LIBNET_DNS_ADDITIONAL, never going back to an earlier one
+ * @param name owner name
+ * @param type RR type
+ * @param class RR class
+ * @param ttl time to live, in seconds
+ * @param rdata RDATA, in wire format
+ * @param rdata_s length of rdata
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_rr(libnet_t *l, uint8_t section, const char *name, uint16_t type,
+uint16_t class, uint32_t ttl, const uint8_t *rdata, uint16_t rdata_s);
+
+/**
+ * [DNS Encoder]
+ * Appends an IN A record, see libnet_dns_rr().
+ * @param l pointer to a libnet context
+ * @param section section of the message
+ * @param name owner name
+ * @param ttl time to live, in seconds
+ * @param addr IPv4 address (in network byte order)
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_rr_a(libnet_t *l, uint8_t section, const char *name, uint32_t ttl,
+uint32_t addr);
+
+/**
+ * [DNS Encoder]
+ * Appends an IN AAAA record, see libnet_dns_rr().
+ * @param l pointer to a libnet context
+ * @param section section of the message
+ * @param name owner name
+ * @param ttl time to live, in seconds
+ * @param addr IPv6 address
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_rr_aaaa(libnet_t *l, uint8_t section, const char *name,
+uint32_t ttl, struct libnet_in6_addr addr);
+
+/**
+ * [DNS Encoder]
+ * Appends an IN record whose RDATA is a domain name, compressed: NS, CNAME
+ * or PTR.  See libnet_dns_rr().
+ * @param l pointer to a libnet context
+ * @param section section of the message
+ * @param name owner name
+ * @param type LIBNET_DNS_TYPE_NS, LIBNET_DNS_TYPE_CNAME or
+ * LIBNET_DNS_TYPE_PTR
+ * @param ttl time to live, in seconds
+ * @param target the name in the RDATA
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_rr_name(libnet_t *l, uint8_t section, const char *name,
+uint16_t type, uint32_t ttl, const char *target);
+
+/**
+ * [DNS Encoder]
+ * Appends an IN MX record, the exchange compressed.  See libnet_dns_rr().
+ * @param l pointer to a libnet context
+ * @param section section of the message
+ * @param name owner name
+ * @param ttl time to live, in seconds
+ * @param pref preference
+ * @param exchange mail exchange
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_rr_mx(libnet_t *l, uint8_t section, const char *name, uint32_t ttl,
+uint16_t pref, const char *exchange);
+
+/**
+ * [DNS Encoder]
+ * Appends the EDNS0 OPT pseudo-RR (RFC 6891) to the additional section.
+ * It must be the last record of the message.
+ * @param l pointer to a libnet context
+ * @param udp_size requestor's UDP payload size
+ * @param ext_rcode upper 8 bits of the extended RCODE
+ * @param version EDNS version, 0
+ * @param flags e.g. LIBNET_DNS_EDNS0_DO
+ * @param options EDNS options, <code, length, data> in wire format, or NULL
+ * @param options_s length of options
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_edns0(libnet_t *l, uint16_t udp_size, uint8_t ext_rcode,
+uint8_t version, uint16_t flags, const uint8_t *options, uint16_t options_s);
+
+/**
+ * [DNS Encoder]
+ * Turns the message last built with libnet_build_dns_message() into a
+ * template for resolver load tests: attaches field variations, see
+ * libnet_vary_add(), that give every packet a random transaction ID
+ * (LIBNET_DNS_TEMPLATE_ID) and replace the first label of the first QNAME
+ * with random [a-z0-9] characters of the same length
+ * (LIBNET_DNS_TEMPLATE_QNAME), for random subdomain and cache miss tests.
+ * Culling the packet once and calling libnet_vary_packet() before each
+ * send then rewrites both in place, fixing the UDP checksum up
+ * incrementally, with no encoding at all.  Names compressed against the
+ * QNAME change with it.  Rebuilding the message with a different layout
+ * requires libnet_vary_clear() and a new template.  After
+ * libnet_clear_packet() the message has to be built again first.
+ * @param l pointer to a libnet context
+ * @param flags LIBNET_DNS_TEMPLATE_ID and/or LIBNET_DNS_TEMPLATE_QNAME
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_dns_template(libnet_t *l, uint32_t flags);
+
+/**
+ * [DNS Encoder]
+ * Frees the context's DNS message, if any, to start a new one.  This is
+ * also done by libnet_destroy().  Pblocks already built are unaffected.
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_dns_free(libnet_t *l);
+
 /**
  * Builds a Routing Information Protocol header (RFCs 1058 and 2453).
  * @param cmd command
@@ -1398,6 +1823,69 @@ uint16_t rt, uint32_t addr, uint32_t mask, uint32_t next_hop,
 uint32_t metric, const uint8_t* payload, uint32_t payload_s, libnet_t *l,
 libnet_ptag_t ptag);
 
+/**
+ * Builds a Simple Network Management Protocol version 1 or 2c message
+ * (RFCs 1157, 1901 and 3416) holding a GetRequest, GetNextRequest,
+ * GetBulkRequest, Response, SetRequest, InformRequest, SNMPv2-Trap or Report
+ * PDU.  The message is BER encoded back to front, so it costs one pass over
+ * the varbinds however deeply nested; it must fit LIBNET_SNMP_MAX_MESSAGE.
+ * An SNMPv2-Trap takes sysUpTime.0 and snmpTrapOID.0 as its first two
+ * varbinds, they are not added. SNMPv1 traps have a PDU of their own, see
+ * libnet_build_snmp_trap(). Goes on top of libnet_build_udp().
+ * @param version LIBNET_SNMP_VERSION_1 or LIBNET_SNMP_VERSION_2C
+ * @param community community string, not NUL terminated
+ * @param community_s length of the community string
+ * @param type PDU type, LIBNET_SNMP_GET, LIBNET_SNMP_RESPONSE, ...
+ * @param request_id request ID
+ * @param error_status error status, or non-repeaters for LIBNET_SNMP_GETBULK
+ * @param error_index error index, or max-repetitions for LIBNET_SNMP_GETBULK
+ * @param vb array of variable bindings; the value is taken from num for the
+ * integer types and from val and val_s for the others, the ASN.1 NULL and
+ * the exceptions have none
+ * @param vb_n number of variable bindings
+ * @param payload optional payload or NULL
+ * @param payload_s payload length or 0
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag to modify an existing header, 0 to build a new one
+ * @return protocol tag value on success
+ * @retval -1 on error
+ */
+LIBNET_API
+libnet_ptag_t
+libnet_build_snmp(uint8_t version, const uint8_t *community,
+uint32_t community_s, uint8_t type, int32_t request_id, int32_t error_status,
+int32_t error_index, const struct libnet_snmp_varbind *vb, uint32_t vb_n,
+const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag);
+
+/**
+ * Builds an SNMPv1 message holding a Trap-PDU (RFC 1157). See
+ * libnet_build_snmp() for the variable bindings. Goes on top of
+ * libnet_build_udp().
+ * @param community community string, not NUL terminated
+ * @param community_s length of the community string
+ * @param enterprise object identifier of the entity sending the trap
+ * @param enterprise_n number of sub-identifiers in enterprise
+ * @param agent_addr address of the agent (in network byte order)
+ * @param generic generic trap, LIBNET_SNMP_COLDSTART ... LIBNET_SNMP_ENTERPRISE
+ * @param specific specific trap code
+ * @param timestamp sysUpTime of the agent, in hundredths of a second
+ * @param vb array of variable bindings
+ * @param vb_n number of variable bindings
+ * @param payload optional payload or NULL
+ * @param payload_s payload length or 0
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag to modify an existing header, 0 to build a new one
+ * @return protocol tag value on success
+ * @retval -1 on error
+ */
+LIBNET_API
+libnet_ptag_t
+libnet_build_snmp_trap(const uint8_t *community, uint32_t community_s,
+const uint32_t *enterprise, uint32_t enterprise_n, uint32_t agent_addr,
+int32_t generic, int32_t specific, uint32_t timestamp,
+const struct libnet_snmp_varbind *vb, uint32_t vb_n,
+const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag);
+
 /**
  * Builds an Remote Procedure Call (Version 2) Call message header as
  * specified in RFC 1831. This builder provides the option for
@@ -1923,6 +2411,91 @@ libnet_build_ospfv2_lsa_as(uint32_t nmask, uint32_t metric, uint32_t fwdaddr,
 uint32_t tag, const uint8_t* payload, uint32_t payload_s, libnet_t *l,
 libnet_ptag_t ptag);
 
+/**
+ * Builds an OSPFv2 Link State Update header carrying LSU i of the
+ * context's synthetic LSDB, see libnet_lsdb_build(), as its payload.
+ * The LSU takes libnet_lsdb_lsu_size() bytes; pass that as the length to
+ * libnet_build_ospfv2(), plus LIBNET_OSPF_AUTH_H if an authentication
+ * header is built.  To send the whole LSDB, build LSU 0 and update the
+ * same ptag with the following ones, e.g. from a libnet_carousel_build()
+ * callback.
+ * @param i LSU number, from 0
+ * @param l pointer to a libnet context
+ * @param ptag protocol tag to modify an existing header, 0 to build a new one
+ * @return protocol tag value on success
+ * @retval -1 on error
+ */
+LIBNET_API
+libnet_ptag_t
+libnet_build_ospfv2_lsdb_lsu(uint32_t i, libnet_t *l, libnet_ptag_t ptag);
+
+/**
+ * [OSPF LSDB]
+ * Generates a synthetic OSPFv2 link state database, for loading an OSPF
+ * control plane: spec->routers router LSAs, each with spec->links
+ * point-to-point links to the next routers in turn, spec->networks network
+ * LSAs with spec->attached routers each, and spec->summaries summary LSAs.
+ * Router IDs count up from spec->router_id, and the networks and then the
+ * summaries take consecutive /24s from spec->prefix.  The LSAs are encoded
+ * and checksummed once, and packed in order into as few Link State Updates
+ * as fit spec->mtu, leaving room for the IPv4 header and the OSPF header
+ * with authentication.  Any LSDB already held by the context is replaced.
+ * @param l pointer to a libnet context
+ * @param spec what to generate
+ * @return the number of LSUs, see libnet_build_ospfv2_lsdb_lsu()
+ * @retval -1 on error, e.g. if an LSA would not fit in an LSU on its own
+ */
+LIBNET_API
+int
+libnet_lsdb_build(libnet_t *l, const struct libnet_lsdb_spec *spec);
+
+/**
+ * [OSPF LSDB]
+ * Returns the size of LSU i of the context's LSDB.
+ * @param l pointer to a libnet context
+ * @param i LSU number, from 0
+ * @return bytes in the LSU, its 4 byte header included
+ * @retval -1 if there is no such LSU
+ */
+LIBNET_API
+int
+libnet_lsdb_lsu_size(libnet_t *l, uint32_t i);
+
+/**
+ * [OSPF LSDB]
+ * Originates new instances of every LSA in the context's LSDB: the LS
+ * sequence numbers are incremented and the checksums computed again, in
+ * place.  LSUs built from the LSDB afterwards carry the new instances.
+ * @param l pointer to a libnet context
+ * @retval 1 on success
+ * @retval -1 on failure, e.g. at MaxSequenceNumber
+ */
+LIBNET_API
+int
+libnet_lsdb_refresh(libnet_t *l);
+
+/**
+ * [OSPF LSDB]
+ * Frees the context's LSDB, if any.  This is also done by libnet_destroy().
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_lsdb_free(libnet_t *l);
+
+/**
+ * Computes the Fletcher checksum of an OSPF LSA, RFC 2328 section 12.1.7,
+ * and stores it in the LS checksum field.  The LS age is not covered.
+ * Used by libnet for LSA headers built with a zero checksum; summing is
+ * done 32 bytes at a time where the CPU has AVX2.
+ * @param lsa the LSA, starting with its 20 byte header
+ * @param len length of the LSA, as in its LS length field
+ * @return the checksum, in host byte order, or 0 if len is too short
+ */
+LIBNET_API
+uint16_t
+libnet_ospf_lsa_cksum(uint8_t *lsa, uint32_t len);
+
 /**
  * Builds a generic libnet protocol header. This is useful for including an
  * optional payload to a packet that might need to change repeatedly inside
@@ -2000,6 +2573,34 @@ uint32_t cip, uint32_t yip,  uint32_t sip, uint32_t gip, const uint8_t *chaddr,
 const char *sname, const char *file, const uint8_t* payload, uint32_t payload_s, 
 libnet_t *l, libnet_ptag_t ptag);
 
+/**
+ * [DHCP]
+ * Encodes DHCP options for the payload of libnet_build_dhcpv4() or
+ * libnet_build_bootpv4().  An option with a val is copied as is; one
+ * without has num encoded according to its code: a byte for
+ * LIBNET_DHCP_MESSAGETYPE and the other flag and count options, 16 bits
+ * for the sizes (LIBNET_DHCP_MAXMSGSIZE, LIBNET_DHCP_MTUSIZE, ...), 32 bits
+ * for the times (LIBNET_DHCP_LEASETIME, LIBNET_DHCP_RENEWTIME, ...), all
+ * in host byte order, and 4 bytes in network byte order for the single
+ * address options (LIBNET_DHCP_SUBNETMASK, LIBNET_DHCP_DISCOVERADDR,
+ * LIBNET_DHCP_SERVIDENT, ...).  Values over 255 bytes are split over
+ * consecutive options of the same code (RFC 3396).  LIBNET_DHCP_END is
+ * appended and the options padded to make the message LIBNET_BOOTP_MIN_LEN
+ * bytes long.
+ * @param l pointer to a libnet context
+ * @param opt options, in the order they are to appear
+ * @param opt_n number of options
+ * @param buf where to put the encoded options
+ * @param buf_s size of buf
+ * @return the number of bytes written to buf
+ * @retval -1 on error, e.g. a num for an option of unknown type or a
+ * buffer too small
+ */
+LIBNET_API
+int
+libnet_dhcp_options(libnet_t *l, const struct libnet_dhcp_option *opt,
+uint32_t opt_n, uint8_t *buf, uint32_t buf_s);
+
 /**
  * @param fv see libnet_build_gre().
  * @return size
@@ -2187,17 +2788,81 @@ libnet_build_bgp4_notification(uint8_t err_code, uint8_t err_subcode,
 const uint8_t* payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag);
 
 /**
- * Builds a Sebek header. The Sebek protocol was designed by the Honeynet
- * Project as a transport mechanism for post-intrusion forensic data. More
- * information may be found here: http://www.honeynet.org/papers/sebek.pdf.
- * @param magic identify packets that should be hidden 
- * @param version protocol version, currently 1 
- * @param type type of record (read data is type 0, write data is type 1) 
- * @param counter PDU counter used to identify when packet are lost 
- * @param time_sec seconds since EPOCH according to the honeypot 
- * @param time_usec residual microseconds 
- * @param pid PID 
- * @param uid UID 
+ * [BGP-4 Packer]
+ * Registers a set of path attributes for libnet_bgp4_packer_add(), and
+ * returns its number.  Identical attributes give the same number, so
+ * every route added with one set ends up sharing UPDATE messages.
+ * @param l pointer to a libnet context
+ * @param attrs the path attributes, encoded as in an UPDATE message
+ * @param attrs_s length of attrs, at most what leaves room for a /32 in a
+ * 4096 byte UPDATE
+ * @return the attribute set number, from 1
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_bgp4_packer_attrs(libnet_t *l, const uint8_t *attrs, uint16_t attrs_s);
+
+/**
+ * [BGP-4 Packer]
+ * Adds an IPv4 route to be packed by libnet_bgp4_packer_pack(), with the
+ * path attributes of set, or as withdrawn.
+ * @param l pointer to a libnet context
+ * @param set an attribute set from libnet_bgp4_packer_attrs(), or
+ * LIBNET_BGP4_WITHDRAWN
+ * @param prefix the prefix, in network byte order; bits past len are
+ * ignored
+ * @param len prefix length, 0 to 32
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_bgp4_packer_add(libnet_t *l, int set, uint32_t prefix, uint8_t len);
+
+/**
+ * [BGP-4 Packer]
+ * Encodes every route added so far as complete BGP-4 UPDATE messages,
+ * header included, back to back in one buffer.  Withdrawn routes come
+ * first, then the routes of each attribute set in the order the sets
+ * were registered, with as many routes per UPDATE as fit in 4096 bytes.
+ * The buffer can be written to a BGP session as it is, or each message
+ * replayed with libnet_build_bgp4_header(), taking its length from
+ * bytes 16 and 17 of the message.  The routes are kept, until
+ * libnet_bgp4_packer_free().
+ * @param l pointer to a libnet context
+ * @param buf where to return the messages, to be freed with libnet_free(),
+ * or NULL if there are none
+ * @param buf_s where to return the length of buf
+ * @return the number of UPDATE messages
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_bgp4_packer_pack(libnet_t *l, uint8_t **buf, uint32_t *buf_s);
+
+/**
+ * [BGP-4 Packer]
+ * Forgets all routes and attribute sets.  This is also done by
+ * libnet_destroy().
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_bgp4_packer_free(libnet_t *l);
+
+/**
+ * Builds a Sebek header. The Sebek protocol was designed by the Honeynet
+ * Project as a transport mechanism for post-intrusion forensic data. More
+ * information may be found here: http://www.honeynet.org/papers/sebek.pdf.
+ * @param magic identify packets that should be hidden 
+ * @param version protocol version, currently 1 
+ * @param type type of record (read data is type 0, write data is type 1) 
+ * @param counter PDU counter used to identify when packet are lost 
+ * @param time_sec seconds since EPOCH according to the honeypot 
+ * @param time_usec residual microseconds 
+ * @param pid PID 
+ * @param uid UID 
  * @param fd FD 
  * @param cmd 12 first characters of the command 
  * @param length length in bytes of the PDU's body 
@@ -2296,6 +2961,121 @@ LIBNET_API
 int
 libnet_write(libnet_t *l);
 
+/**
+ * Splits the IP datagram built in the context into fragments of at most
+ * mtu bytes, IP header included, and writes them all with one batch write.
+ * The datagram is IPv4 or IPv6, by its outermost IP header, see
+ * libnet_fragment_ipv4() and libnet_fragment_ipv6().  The fragment data
+ * but the last are multiples of 8 bytes, and the transport checksum covers
+ * the whole datagram, computed once before it is split.  A datagram that
+ * fits is written as it is.  Link headers, if any, are repeated.
+ * flags shape the fragments for IDS and reassembly tests:
+ * LIBNET_FRAG_TINY puts only 8 bytes of data in the first fragment,
+ * LIBNET_FRAG_OVERLAP starts each fragment 8 bytes before the end of the
+ * previous one, with the same data, and LIBNET_FRAG_REVERSE or
+ * LIBNET_FRAG_SHUFFLE, which uses libnet_get_prand_r(), send them out of
+ * order.
+ * @param l pointer to a libnet context
+ * @param mtu the MTU in bytes, 0 for that of the device, libnet_get_mtu()
+ * @param flags LIBNET_FRAG_* or 0
+ * @return the number of fragments written
+ * @retval -1 on error, or if not all fragments could be written
+ */
+LIBNET_API
+int
+libnet_write_fragmented(libnet_t *l, uint32_t mtu, int flags);
+
+/**
+ * Fragments the IPv4 datagram built in the context as
+ * libnet_write_fragmented() does, without writing the fragments, e.g. to
+ * keep them for replay.  Offsets and MF bits are set and the IP header
+ * checksum of each fragment is computed.  The first fragment has all IP
+ * options, the following ones those with the copied flag.  A datagram with
+ * DF set is refused.  If its IP ID is 0, the fragments share a nonzero one
+ * from libnet_get_prand_r() instead, unless the datagram is itself a
+ * fragment.
+ * @param l pointer to a libnet context
+ * @param mtu the MTU in bytes, 0 for that of the device, libnet_get_mtu()
+ * @param flags LIBNET_FRAG_* or 0
+ * @param frames where to return the fragments, in l and valid until the
+ * next call or libnet_destroy()
+ * @param frames_n where to return the number of fragments
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_fragment_ipv4(libnet_t *l, uint32_t mtu, int flags,
+struct libnet_frame **frames, uint32_t *frames_n);
+
+/**
+ * Fragments the IPv6 packet built in the context, for LIBNET_RAW6 or
+ * LIBNET_LINK, as libnet_write_fragmented() does, without writing the
+ * fragments.  The unfragmentable part, the IPv6 header and any Hop-by-Hop
+ * Options and Routing headers, with the Destination Options headers before
+ * them (RFC 8200), is repeated in every fragment and followed by a Fragment
+ * header whose identification comes from libnet_get_prand_r(), the same in
+ * all fragments; seed it with libnet_seed_prand(), or every process sends
+ * the same identifications.  A packet that already has a Fragment header is refused,
+ * one that fits is left as it is, without one (RFC 8021).
+ * @param l pointer to a libnet context
+ * @param mtu the MTU in bytes, 0 for that of the device, libnet_get_mtu()
+ * @param flags LIBNET_FRAG_* or 0
+ * @param frames where to return the fragments, in l and valid until the
+ * next call or libnet_destroy()
+ * @param frames_n where to return the number of fragments
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_fragment_ipv6(libnet_t *l, uint32_t mtu, int flags,
+struct libnet_frame **frames, uint32_t *frames_n);
+
+/**
+ * Cuts a stream of data into TCP segments of at most mss bytes of data,
+ * each with the TCP and IPv4 headers built in the context, and writes them
+ * all with one batch write, much like TSO hardware would.  The headers are
+ * those of the first segment; any payload they were built with is left
+ * out.  The sequence number advances by the data of each segment and the
+ * IP identification by one, CWR is kept on the first segment only, PSH and
+ * FIN on the last one.  Both checksums are computed incrementally, from
+ * sums of the headers taken once.  To go on with the stream, rebuild the
+ * headers with the sequence number and identification past the last
+ * segment.  No data sends one segment with none.
+ * @param l pointer to a libnet context
+ * @param data the stream data
+ * @param data_s length of data
+ * @param mss the MSS in bytes, 0 for the device MTU, libnet_get_mtu(), less
+ * the IPv4 and TCP headers
+ * @return the number of segments written
+ * @retval -1 on error, or if not all segments could be written
+ */
+LIBNET_API
+int
+libnet_write_segmented(libnet_t *l, const uint8_t *data, uint32_t data_s,
+uint32_t mss);
+
+/**
+ * Segments a stream of data as libnet_write_segmented() does, without
+ * writing the segments.  The IPv4 header must not be that of a fragment,
+ * and the TCP header must follow it.
+ * @param l pointer to a libnet context
+ * @param data the stream data
+ * @param data_s length of data
+ * @param mss the MSS in bytes, 0 for the device MTU, libnet_get_mtu(), less
+ * the IPv4 and TCP headers
+ * @param frames where to return the segments, in l and valid until the
+ * next call or libnet_destroy()
+ * @param frames_n where to return the number of segments
+ * @retval 1 on success
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_segment_tcp(libnet_t *l, const uint8_t *data, uint32_t data_s,
+uint32_t mss, struct libnet_frame **frames, uint32_t *frames_n);
+
 /**
  * Returns the IP address for the device libnet was initialized with. If
  * libnet was initialized without a device (in raw socket mode) the function
@@ -2334,6 +3114,19 @@ LIBNET_API
 struct libnet_ether_addr *
 libnet_get_hwaddr(libnet_t *l);
 
+/**
+ * Returns the MTU of the device libnet was initialized with, asked of the
+ * system the first time and cached in the context afterwards.  If libnet
+ * was initialized without a device the function will attempt to find one.
+ * This function is not yet implemented for Win32 platforms.
+ * @param l pointer to a libnet context
+ * @return the MTU in bytes
+ * @retval -1 on error
+ */
+LIBNET_API
+int
+libnet_get_mtu(libnet_t *l);
+
 /**
  * Takes a colon separated hexidecimal address (from the command line) and
  * returns a bytestring suitable for use in a libnet_build function. Note this
@@ -2439,6 +3232,410 @@ LIBNET_API
 void
 libnet_adv_free_packet(const libnet_t *l, uint8_t *packet);
 
+/**
+ * [Field Variation]
+ * Attaches a variation to a field of an existing pblock, so that successive
+ * packets carry successive values in it without calling the builder again.
+ * The field is width bytes (1, 2 or 4) at offset bytes into the pblock
+ * referenced by ptag, and is written in network byte order.  spec->op
+ * selects how the value changes:
+ *
+ * - LIBNET_VARY_INC: min, min + step, ... wrapping back to min past max
+ * - LIBNET_VARY_DEC: max, max - step, ... wrapping back to max below min
+ * - LIBNET_VARY_RANDOM: uniformly random in [min, max], see
+ *   libnet_get_prand_r()
+ * - LIBNET_VARY_LIST: each of the list_n values in list, in turn
+ * - LIBNET_VARY_LABEL: width random characters from [a-z0-9], a field of
+ *   up to LIBNET_VARY_LABEL_MAX bytes, e.g. a DNS label; min, max and
+ *   step are not used
+ *
+ * Each value is used for spec->every consecutive packets before moving on.
+ * A context may carry any number of variations; they are stepped together.
+ *
+ * Variations are applied every time the packet is coalesced, i.e. on each
+ * libnet_write() and libnet_adv_cull_packet(), before checksums are
+ * computed.  Alternatively, libnet_vary_packet() applies them to a packet
+ * that was already culled, without rebuilding it.  All variations are
+ * dropped by libnet_clear_packet().
+ * @param l pointer to a libnet context
+ * @param ptag the ptag of the pblock holding the field
+ * @param offset field offset from the start of the pblock
+ * @param spec the variation, copied (including its list) by libnet
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_vary_add(libnet_t *l, libnet_ptag_t ptag, uint32_t offset,
+const struct libnet_vary_spec *spec);
+
+/**
+ * [Field Variation]
+ * Removes all variations from the given context.
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_vary_clear(libnet_t *l);
+
+/**
+ * [Field Variation]
+ * Steps all variations of the context and writes the new values straight
+ * into packet, a wire-ready packet previously returned by
+ * libnet_adv_cull_packet() on the same context.  Checksums covering the
+ * varied fields (IPv4 header, TCP, UDP, ICMP, ICMPv6 and IGMP, including
+ * the TCP/UDP pseudo header) are updated incrementally, so the cost does
+ * not depend on the packet size.  This lets a send loop reuse one culled
+ * packet for every variant.  Fields covered by other checksums can only be
+ * varied through libnet_write() or libnet_adv_cull_packet().
+ * @param l pointer to a libnet context
+ * @param packet the packet to modify
+ * @param packet_s the size of the packet
+ * @retval 1 on success
+ * @retval -1 on failure, e.g. if the pblocks changed since packet was culled
+ */
+LIBNET_API
+int
+libnet_vary_packet(libnet_t *l, uint8_t *packet, uint32_t packet_s);
+
+/**
+ * [Carousel]
+ * Precomputes n packets and stores them wire-ready in one slab, so that
+ * libnet_carousel_send() can transmit them without any per-packet build
+ * work.  For each i from 0 to n - 1, build(l, i, arg) is called to update
+ * the context's pblocks, e.g. by re-calling builders with their ptags,
+ * after which the packet is coalesced (checksums included) and copied into
+ * the slab.  build may be NULL, in which case the variations attached with
+ * libnet_vary_add() alone make the packets differ.  Any carousel already
+ * held by the context is replaced.  The pblocks are left as the last call
+ * to build made them.
+ * @param l pointer to a libnet context
+ * @param n number of packets to precompute
+ * @param build callback updating the pblocks for packet i, or NULL
+ * @param arg passed unchanged to build
+ * @retval 1 on success
+ * @retval -1 on failure, including build returning -1
+ */
+LIBNET_API
+int
+libnet_carousel_build(libnet_t *l, uint32_t n,
+int (*build)(libnet_t *l, uint32_t i, void *arg), void *arg);
+
+/**
+ * [Carousel]
+ * Writes count packets from the context's carousel, cycling through it in
+ * order and continuing where the previous call stopped.  Packets are
+ * handed to the kernel in batches where the platform supports it.  The
+ * context statistics are updated as for libnet_write().
+ * @param l pointer to a libnet context
+ * @param count number of packets to write
+ * @return the number of packets written, which is less than count if a
+ * write failed, or -1 if no packet could be written
+ */
+LIBNET_API
+int
+libnet_carousel_send(libnet_t *l, uint32_t count);
+
+/**
+ * [Carousel]
+ * Gives read access to a packet of the context's carousel, as it will be
+ * written, e.g. to check or log it.
+ * @param l pointer to a libnet context
+ * @param i packet number, from 0 to n - 1
+ * @param len where to put the packet length, or NULL
+ * @return the packet, or NULL if there is no such packet
+ */
+LIBNET_API
+const uint8_t *
+libnet_carousel_frame(libnet_t *l, uint32_t i, uint32_t *len);
+
+/**
+ * [Carousel]
+ * Frees the context's carousel, if any.  This is also done by
+ * libnet_destroy().
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_carousel_free(libnet_t *l);
+
+/**
+ * [Periodic]
+ * Coalesces the packet built in the context into a new periodic stream,
+ * sent by libnet_periodic_dispatch() every interval milliseconds, give or
+ * take up to jitter, e.g. the hellos of a simulated device.  The streams
+ * hang off one hierarchical timer wheel with 1 ms ticks, so adding, firing
+ * and removing one costs the same whether there are ten or a million.  The
+ * pblocks are left as they are and can be rebuilt for the next stream.
+ * @param l pointer to a libnet context
+ * @param interval milliseconds between two frames, at least 1
+ * @param jitter milliseconds each interval varies by, uniformly at random,
+ * less than interval, and with interval + jitter at most UINT32_MAX
+ * @param first milliseconds until the first frame, counted from the first
+ * libnet_periodic_dispatch(), or from the last one if there was one
+ * @return a stream id, 0 or more
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_periodic_add(libnet_t *l, uint32_t interval, uint32_t jitter,
+uint32_t first);
+
+/**
+ * [Periodic]
+ * Makes a big endian counter of a stream's frame advance by step after
+ * every send, e.g. a sequence number, wrapping around at its width.  A
+ * checksum covering the field is updated incrementally (RFC 1624); like
+ * all Internet checksums it must be at an even distance from the start of
+ * the region it covers, and in use, not a zero UDP checksum.  At most
+ * LIBNET_PERIODIC_PATCH_MAX fields per stream.
+ * @param l pointer to a libnet context
+ * @param id stream id from libnet_periodic_add()
+ * @param offset of the field in the frame
+ * @param width of the field, 1, 2 or 4 bytes
+ * @param step added after every send, e.g. (uint32_t)-1 counts down
+ * @param csum offset in the frame of the 16-bit checksum covering the
+ * field, or 0 for none
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_periodic_patch(libnet_t *l, int id, uint32_t offset, uint8_t width,
+uint32_t step, uint32_t csum);
+
+/**
+ * [Periodic]
+ * Gives access to a stream's frame, to be changed in place between two
+ * calls to libnet_periodic_dispatch(), e.g. a TTL set to 0 before a device
+ * goes away.  Checksums covering what is changed are up to the caller.
+ * @param l pointer to a libnet context
+ * @param id stream id from libnet_periodic_add()
+ * @param len where to put the frame length, or NULL
+ * @return the frame, or NULL if there is no such stream
+ */
+LIBNET_API
+uint8_t *
+libnet_periodic_frame(libnet_t *l, int id, uint32_t *len);
+
+/**
+ * [Periodic]
+ * Stops a stream and frees its frame.  Its id may be handed out again by
+ * libnet_periodic_add().
+ * @param l pointer to a libnet context
+ * @param id stream id from libnet_periodic_add()
+ * @retval 1 on success
+ * @retval -1 if there is no such stream
+ */
+LIBNET_API
+int
+libnet_periodic_remove(libnet_t *l, int id);
+
+/**
+ * [Periodic]
+ * Advances the timer wheel to now and writes every frame that came due,
+ * in batches.  The clock is the caller's, in milliseconds, e.g. from
+ * CLOCK_MONOTONIC, and the first call sets its zero.  A stream that fell
+ * behind, because this was not called for a while, fires once and keeps
+ * its interval from now on, it does not catch up.  A single thread calling
+ * this in a loop, sleeping until libnet_periodic_next(), drives all
+ * streams.  Frames the device refuses are dropped and counted in
+ * libnet_stats().
+ * @param l pointer to a libnet context
+ * @param now the current time, in milliseconds
+ * @return the number of frames handed to libnet_write_batch()
+ * @retval -1 if the context has no streams
+ */
+LIBNET_API
+int
+libnet_periodic_dispatch(libnet_t *l, uint64_t now);
+
+/**
+ * [Periodic]
+ * Tells when libnet_periodic_dispatch() needs to be called next, at the
+ * latest, to send the next frames on time.
+ * @param l pointer to a libnet context
+ * @return a time on the caller's clock, in milliseconds, 0 before the
+ * first libnet_periodic_dispatch()
+ * @retval -1 if there are no streams
+ */
+LIBNET_API
+int64_t
+libnet_periodic_next(libnet_t *l);
+
+/**
+ * [Periodic]
+ * Frees all periodic streams of the context.  This is also done by
+ * libnet_destroy().
+ * @param l pointer to a libnet context
+ */
+LIBNET_API
+void
+libnet_periodic_free(libnet_t *l);
+
+/**
+ * [TX Thread]
+ * Starts a library managed thread that writes frames queued on this
+ * context with libnet_enqueue() or libnet_enqueue_frame(), in batches.
+ * This separates packet synthesis, which may then run on several producer
+ * threads, from the system calls, which stay on one thread.  The queue is
+ * a bounded lock-free ring of depth slots, each holding a frame of up to
+ * frame_max bytes.  The thread writes through its own clone of l, see
+ * libnet_clone(), sharing its socket, so l remains the producers' to build
+ * and queue packets in; while the thread runs, l must not be used to write
+ * packets directly.  The thread must be stopped before libnet_destroy(),
+ * which does so if need be.  With LIBNET_TX_BLOCK, producers facing a
+ * full queue sleep until the thread frees slots.
+ * @param l pointer to a libnet context, opened on the device to write to
+ * @param depth queue depth, a power of two
+ * @param frame_max largest frame that will be queued, 0 for 2048 bytes
+ * @param policy LIBNET_TX_DROP or LIBNET_TX_BLOCK, what libnet_enqueue()
+ * does when the queue is full
+ * @param cpu CPU to pin the thread to, or -1 to leave that to the system
+ * @retval 1 on success
+ * @retval -1 on failure, also on platforms without threads
+ */
+LIBNET_API
+int
+libnet_tx_start(libnet_t *l, uint32_t depth, uint32_t frame_max, int policy,
+int cpu);
+
+/**
+ * [TX Thread]
+ * Coalesces the packet built in src straight into a free slot of the
+ * queue of l, for its TX thread to write.  Each producer thread builds in
+ * its own context, e.g. one from libnet_init() with LIBNET_NONE, and they
+ * may all call this concurrently on the same l.  src may also be l itself,
+ * or NULL for l, when there is a single producer.  Checksums and field
+ * variations are applied as with libnet_write().
+ * @param l pointer to the libnet context running the TX thread
+ * @param src pointer to the libnet context holding the packet, or NULL
+ * @retval 1 if the frame was queued
+ * @retval -1 on failure, or if the frame was dropped for a full queue
+ */
+LIBNET_API
+int
+libnet_enqueue(libnet_t *l, libnet_t *src);
+
+/**
+ * [TX Thread]
+ * Copies an already built frame into the queue of l, see libnet_enqueue().
+ * @param l pointer to the libnet context running the TX thread
+ * @param frame the wire-ready frame
+ * @param frame_s size of the frame
+ * @retval 1 if the frame was queued
+ * @retval -1 on failure, or if the frame was dropped for a full queue
+ */
+LIBNET_API
+int
+libnet_enqueue_frame(libnet_t *l, const uint8_t *frame, uint32_t frame_s);
+
+/**
+ * [TX Thread]
+ * Gets the TX thread and queue statistics, including the current and the
+ * highest queue occupancy.  The context statistics, see libnet_stats(),
+ * count the writes done by the thread once it is stopped.
+ * @param l pointer to the libnet context running the TX thread
+ * @param ts where to store the statistics
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_tx_stats(libnet_t *l, struct libnet_tx_stats *ts);
+
+/**
+ * [TX Thread]
+ * Stops the TX thread, once all frames queued so far have been written,
+ * and frees the queue.  Producers must have stopped queueing frames.
+ * @param l pointer to the libnet context running the TX thread
+ * @retval 1 on success
+ * @retval -1 if no TX thread was running
+ */
+LIBNET_API
+int
+libnet_tx_stop(libnet_t *l);
+
+/**
+ * [TX Timestamps]
+ * Turns on kernel software timestamps for the frames written on a link or
+ * raw socket context (SO_TIMESTAMPING, Linux only): one when a frame enters
+ * the qdisc and one when it is handed to the driver, which also works on
+ * veth and loopback devices.  Timestamps are collected by libnet_ts_poll()
+ * and passed to the callback, if any, and accounted in libnet_ts_stats(),
+ * which splits the time spent in libnet and the system call from the time
+ * spent queued.  Frames are numbered in the order the socket sends them.
+ * Contexts made with libnet_clone() share the socket and its numbering:
+ * only one of them may timestamp, and frames the others write take numbers
+ * too.  While they write at the same time as libnet_write_ts(), a frame
+ * may be reported as unmatched.  The timestamps queue up in the receive
+ * buffer of the socket, so a link socket, and so its clones, stops
+ * receiving frames until libnet_ts_stop().
+ * @param l pointer to a libnet context
+ * @param cb function called for each frame sent, or NULL
+ * @param arg passed to cb
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_ts_start(libnet_t *l, libnet_ts_cb cb, void *arg);
+
+/**
+ * [TX Timestamps]
+ * Writes the packet like libnet_write() and notes the time of the call, so
+ * that the report for the frame has the time libnet spent on it before it
+ * reached the qdisc.  A failed write on the socket may or may not have
+ * taken a number, so the first call after one reads the timestamps queued
+ * so far, reporting the frames they are for, and takes the number of its
+ * frame from the kernel.
+ * @param l pointer to a libnet context with timestamping on
+ * @param id where to store the number of the frame, see struct
+ * libnet_ts_report, or NULL
+ * @return the number of bytes written, or -1 on failure
+ */
+LIBNET_API
+int
+libnet_write_ts(libnet_t *l, uint32_t *id);
+
+/**
+ * [TX Timestamps]
+ * Reads the timestamps queued by the kernel, in batches, and reports the
+ * frames they complete.
+ * @param l pointer to a libnet context with timestamping on
+ * @param timeout_ms how long to wait for a first timestamp, 0 not to wait,
+ * -1 to wait indefinitely
+ * @return the number of frames reported, or -1 on failure
+ */
+LIBNET_API
+int
+libnet_ts_poll(libnet_t *l, int timeout_ms);
+
+/**
+ * [TX Timestamps]
+ * Gets the TX timestamp statistics, with histograms of the time from
+ * libnet_write_ts() to the qdisc and of the time in the qdisc.
+ * @param l pointer to a libnet context with timestamping on
+ * @param ts where to store the statistics
+ * @retval 1 on success
+ * @retval -1 on failure
+ */
+LIBNET_API
+int
+libnet_ts_stats(libnet_t *l, struct libnet_ts_stats *ts);
+
+/**
+ * [TX Timestamps]
+ * Turns timestamping off and frees its state.  Timestamps not polled yet
+ * are lost.
+ * @param l pointer to a libnet context
+ * @retval 1 on success
+ * @retval -1 if timestamping was not on
+ */
+LIBNET_API
+int
+libnet_ts_stop(libnet_t *l);
+
 /**
  * [Context Queue] 
  * Adds a new context to the libnet context queue. If no queue exists, this
@@ -2501,6 +3698,26 @@ LIBNET_API
 const char *
 libnet_cq_getlabel(const libnet_t *l);
  
+/**
+ * [Context Queue]
+ * Sets the source addresses libnet_cq_fanout_write() stamps for a context
+ * in the queue, in place of those looked up on its device when it was
+ * added.  Needed for LIBNET_SHM contexts, whose device is a ring name and
+ * gets no lookup.
+ * @param label canonical label of the libnet context
+ * @param flags LIBNET_FANOUT_SRC_MAC and/or LIBNET_FANOUT_SRC_IP, those
+ * left out are not stamped
+ * @param hwaddr Ethernet source address, if LIBNET_FANOUT_SRC_MAC
+ * @param ipaddr IPv4 source address (network byte order), if
+ * LIBNET_FANOUT_SRC_IP
+ * @retval 1 on success
+ * @retval -1 if the label is not in the queue, or hwaddr is missing
+ */
+LIBNET_API
+int
+libnet_cq_set_addrs(const char *label, uint32_t flags, const uint8_t *hwaddr,
+uint32_t ipaddr);
+
 /**
  * [Context Queue] 
  * Locates a libnet context from the queue, indexed by a canonical label.
@@ -2521,12 +3738,100 @@ LIBNET_API
 void
 libnet_cq_destroy(void);
 
+/**
+ * [Context Queue]
+ * Starts walking the context queue with a caller owned iterator.  Unlike
+ * libnet_cq_head(), any number of threads may walk the queue at once, each
+ * with its own iterator.  The queue is only locked within each call, so a
+ * walk may be left at any point and contexts may be added or removed while
+ * it runs, by the walking thread too.  Contexts added meanwhile are not
+ * visited, the others are visited once unless removed first.  A context
+ * returned is not kept from being removed and destroyed by another thread,
+ * that is up to the application:
+ *
+ *    for (l = libnet_cq_iter_first(&it); l; l = libnet_cq_iter_next(&it))
+ *    {
+ *         ...
+ *    }
+ *    libnet_cq_iter_end(&it);
+ *
+ * @param it pointer to an iterator
+ * @return the first context in the queue
+ * @retval NULL if the queue is empty
+ */
+LIBNET_API
+libnet_t *
+libnet_cq_iter_first(libnet_cq_iter_t *it);
+
+/**
+ * [Context Queue]
+ * Advances an iterator started with libnet_cq_iter_first().
+ * @param it pointer to an iterator
+ * @return the next context in the queue
+ * @retval NULL at the end of the queue
+ */
+LIBNET_API
+libnet_t *
+libnet_cq_iter_next(libnet_cq_iter_t *it);
+
+/**
+ * [Context Queue]
+ * Ends a walk started with libnet_cq_iter_first().  Nothing is held
+ * between steps, so this is optional and only resets the iterator.
+ * @param it pointer to an iterator
+ */
+LIBNET_API
+void
+libnet_cq_iter_end(libnet_cq_iter_t *it);
+
+/**
+ * [Context Queue]
+ * Writes the packet of every context in the queue, as libnet_write() would,
+ * in parallel on a pool of worker threads.  The calling thread is one of
+ * the workers and the call returns when all contexts are written.  The pool
+ * is kept for later calls; its threads are joined by libnet_cq_destroy() or
+ * when the last context is removed from the queue.  Each context must only
+ * be used by this call while it runs.  On platforms without threads the
+ * contexts are written one after the other.
+ * @param workers number of threads to write with, the calling one included,
+ * or 0 for one per online CPU.  No more threads than contexts are used.
+ * @return the number of contexts whose packet was written, the errors of
+ * the others are in their contexts, see libnet_geterror()
+ * @retval -1 if the queue is empty or memory runs out
+ */
+LIBNET_API
+int
+libnet_cq_write_all(uint32_t workers);
+
+/**
+ * [Context Queue]
+ * Sends the packet built in l out of every context in the queue, e.g., an
+ * advertisement or a probe on many interfaces.  The packet is coalesced
+ * once and the buffer reused, only the source addresses selected by flags
+ * are re-stamped for each context, with the checksums fixed up
+ * incrementally.  The addresses are those of the context's device when it
+ * was added to the queue, or set with libnet_cq_set_addrs().  Link layer
+ * contexts get the whole Ethernet frame, raw IPv4 contexts the IPv4 packet
+ * in it.  l may be a LIBNET_NONE context, or one in the queue.
+ * @param l pointer to the libnet context holding the packet
+ * @param flags LIBNET_FANOUT_SRC_MAC and/or LIBNET_FANOUT_SRC_IP, or 0 to
+ * send the packet unchanged
+ * @return the number of contexts the packet was written on, the errors of
+ * the others are in their contexts, see libnet_geterror()
+ * @retval -1 if the packet could not be coalesced or the queue is empty
+ */
+LIBNET_API
+int
+libnet_cq_fanout_write(libnet_t *l, uint32_t flags);
+
 /**
  * [Context Queue] 
  * Intiailizes the interator interface and set a write lock on the entire
  * queue. This function is intended to be called just prior to interating
  * through the entire list of contexts (with the probable intent of inject a
- * series of packets in rapid succession). This function is often used as
+ * series of packets in rapid succession). The iterator is global, so only
+ * one thread can use it at a time, see libnet_cq_iter_first() for one that
+ * each thread can have.  This function is often used as
  * per the following:
  *
  *    for (l = libnet_cq_head(); libnet_cq_last(); l = libnet_cq_next())
@@ -2648,6 +3953,54 @@ LIBNET_API
 int
 libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size);
 
+/*
+ * [Internal] 
+ * Function writes frames, n of them, using the injection type of the
+ * context and the fewest system calls the platform allows.  Returns the
+ * number of frames written and updates the statistics.  On a short count,
+ * err_buf says why the next frame failed.
+ */
+int
+libnet_write_batch(libnet_t *l, const struct libnet_frame *frames, uint32_t n);
+
+/*
+ * [Internal] 
+ * Maps the shared memory ring named by l->device, for LIBNET_SHM.
+ */
+int
+libnet_open_shm(libnet_t *l);
+
+/*
+ * [Internal] 
+ */
+int
+libnet_close_shm(libnet_t *l);
+
+/*
+ * [Internal] 
+ * Coalesces the packet straight into a slot of the shared memory ring,
+ * returns the number of bytes written, like libnet_write().
+ */
+int
+libnet_write_shm(libnet_t *l);
+
+/*
+ * [Internal] 
+ * Shared memory backend for libnet_write_batch().
+ */
+int
+libnet_write_shm_batch(libnet_t *l, const struct libnet_frame *frames,
+        uint32_t n);
+
+/*
+ * [Internal] 
+ * Link layer backend for libnet_write_batch(), where available (see
+ * HAVE_LINK_BATCH), returns the number of frames written.
+ */
+int
+libnet_write_link_batch(libnet_t *l, const struct libnet_frame *frames,
+        uint32_t n);
+
 /*
  * [Internal] 
  */
@@ -2788,6 +4141,127 @@ LIBNET_API
 void
 libnet_pblock_delete(libnet_t *l, libnet_pblock_t *p);
 
+/*
+ * [Internal] 
+ * Allocates memory with the allocator set by libnet_set_allocator(),
+ * accounted to l unless it is NULL.  Release it with libnet_free().
+ */
+void *
+libnet_malloc(libnet_t *l, size_t size);
+
+/*
+ * [Internal] 
+ * As libnet_malloc(), for n zeroed objects of size bytes.
+ */
+void *
+libnet_calloc(libnet_t *l, size_t n, size_t size);
+
+/*
+ * [Internal] 
+ * As libnet_malloc(), resizing ptr.
+ */
+void *
+libnet_realloc(libnet_t *l, void *ptr, size_t size);
+
+/*
+ * [Internal] 
+ * As libnet_malloc(), for a copy of s.
+ */
+char *
+libnet_strdup(libnet_t *l, const char *s);
+
+/*
+ * [Internal] 
+ * Makes the socket of l shareable with clones, see struct libnet_fd_share.
+ */
+int
+libnet_fd_share(libnet_t *l);
+
+/*
+ * [Internal] 
+ * Returns a monotonic timestamp in ns if timing is enabled for the
+ * context, or 0, see libnet_stats_timing().
+ */
+uint64_t
+libnet_stats_clock(const libnet_t *l);
+
+/*
+ * [Internal] 
+ * Adds one write system call, started at t0, to the latency histogram.
+ */
+void
+libnet_stats_syscall(libnet_t *l, uint64_t t0);
+
+/*
+ * [Internal] 
+ * Adds a latency of ns to a histogram of LIBNET_STATS_HIST buckets.
+ */
+void
+libnet_stats_hist(uint64_t *hist, uint64_t ns);
+
+/*
+ * [Internal] 
+ * Accounts for frames written in full.
+ */
+void
+libnet_stats_sent(libnet_t *l, uint32_t frames, uint64_t bytes);
+
+/*
+ * [Internal] 
+ * Accounts for a failed frame, err is the errno, partial the number of
+ * bytes that were written anyway.
+ */
+void
+libnet_stats_error(libnet_t *l, int err, int partial);
+
+/*
+ * [Internal] 
+ * Accounts for one frame of len bytes, c as returned by the write
+ * function, which was called at t0 (see libnet_stats_clock()).
+ */
+void
+libnet_stats_write(libnet_t *l, int c, uint32_t len, uint64_t t0);
+
+/*
+ * [Internal] 
+ * Adds the write counters of from, e.g. the writer of a TX thread, to l.
+ */
+void
+libnet_stats_merge(libnet_t *l, const libnet_t *from);
+
+/*
+ * [Internal] 
+ * Hands the statistics page of l, if any, over to w, the writer of its TX
+ * thread, which publishes the counts of l as of now plus its own until
+ * libnet_stats_page_return().
+ */
+void
+libnet_stats_page_lend(libnet_t *l, libnet_t *w);
+
+/*
+ * [Internal] 
+ * Takes the statistics page back from w, once it no longer writes, see
+ * libnet_stats_page_lend().
+ */
+void
+libnet_stats_page_return(libnet_t *l, libnet_t *w);
+
+/*
+ * [Internal] 
+ * Function makes sure the buffer of a pblock is not shared with a clone
+ * before it is written to.  Returns 1 on success, -1 on failure.
+ */
+int
+libnet_pblock_own(libnet_t *l, libnet_pblock_t *p);
+
+/*
+ * [Internal] 
+ * Function appends the pblocks of src to l, sharing their buffers, see
+ * libnet_clone().  Returns 1 on success, -1 on failure.
+ */
+int
+libnet_pblock_clone(libnet_t *l, libnet_t *src);
+
 /*
  * [Internal] 
  * Function updates the pblock meta-information.  Internally it updates the
@@ -2835,12 +4309,64 @@ libnet_pblock_p2p(uint8_t type);
 /*
  * [Internal] 
  * Function assembles the protocol blocks into a packet, checksums are
- * calculated if that was requested.
+ * calculated if that was requested.  With l->csum_defer set, the IPv4
+ * and TCP/UDP checksums of a plain IPv4 packet are left to the caller, see
+ * libnet_checksum_batch(), and l->csum_deferred says which were.
  */
 LIBNET_API
 int
 libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size);
 
+/*
+ * [Internal] 
+ * As libnet_pblock_coalesce(), but into a buffer kept in l and reused from
+ * one call to the next, so *packet must not be freed, and is only valid
+ * until the next call.
+ */
+int
+libnet_pblock_coalesce_cached(libnet_t *l, uint8_t **packet, uint32_t *size);
+
+/*
+ * [Internal] 
+ * Function assembles the protocol blocks into the caller's buffer, like
+ * libnet_pblock_coalesce() but without allocating.  The packet starts at
+ * buf, its size is returned in size.
+ */
+int
+libnet_pblock_coalesce_buf(libnet_t *l, uint8_t *buf, uint32_t buf_s,
+        uint32_t *size);
+
+/*
+ * [Internal] 
+ * Function writes the current value of every variation into its pblock.
+ */
+int
+libnet_vary_apply(libnet_t *l);
+
+/*
+ * [Internal] 
+ * Function steps every variation to its next value, once the packet with
+ * the current ones has been assembled.
+ */
+void
+libnet_vary_step(libnet_t *l);
+
+/*
+ * [Internal] 
+ * Function records where varied fields sit in a freshly coalesced frame,
+ * and which checksums cover them.
+ */
+void
+libnet_vary_layout(libnet_t *l, const uint8_t *frame, uint32_t frame_s);
+
+/*
+ * [Internal] 
+ * Forgets the pblock the DNS message was last built into, for when ptags
+ * start over, leaving the message itself as it is.
+ */
+void
+libnet_dns_clear_ptag(libnet_t *l);
+
 #if !(__WIN32__)
 /*
  * [Internal] 
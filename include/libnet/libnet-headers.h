@@ -49,6 +49,7 @@
 #define LIBNET_BGP4_OPEN_H      0x0a    /**< BGP open header:     10 bytes */
 #define LIBNET_BGP4_UPDATE_H    0x04    /**< BGP open header:      4 bytes */
 #define LIBNET_BGP4_NOTIFICATION_H 0x02 /**< BGP notif. header:    2 bytes */
+#define LIBNET_BGP4_MAX_MESSAGE 0x1000  /**< BGP message max:   4096 bytes */
 #define LIBNET_CDP_H            0x08    /**< CDP header base:      8 bytes */
 #define LIBNET_LLDP_H           0x02    /**< LLDP header base:     2 bytes */
 #define LIBNET_DHCPV4_H         0xf0    /**< DHCP v4 header:     240 bytes */
@@ -580,6 +581,33 @@ struct libnet_dnsv4udp_hdr
     uint16_t num_addi_rr;    /* Number of additional resource records */
 };
 
+/* DNS message encoder, see libnet_dns_question() */
+#define LIBNET_DNS_MAX_MESSAGE      0xffff  /* what the TCP length allows */
+#define LIBNET_DNS_MAX_NAME         255
+#define LIBNET_DNS_MAX_LABEL        63
+/* sections */
+#define LIBNET_DNS_ANSWER           1
+#define LIBNET_DNS_AUTHORITY        2
+#define LIBNET_DNS_ADDITIONAL       3
+/* types */
+#define LIBNET_DNS_TYPE_A           1
+#define LIBNET_DNS_TYPE_NS          2
+#define LIBNET_DNS_TYPE_CNAME       5
+#define LIBNET_DNS_TYPE_SOA         6
+#define LIBNET_DNS_TYPE_PTR         12
+#define LIBNET_DNS_TYPE_MX          15
+#define LIBNET_DNS_TYPE_TXT         16
+#define LIBNET_DNS_TYPE_AAAA        28
+#define LIBNET_DNS_TYPE_SRV         33
+#define LIBNET_DNS_TYPE_OPT         41
+#define LIBNET_DNS_TYPE_ANY         255
+#define LIBNET_DNS_CLASS_IN         1
+/* EDNS0 flags */
+#define LIBNET_DNS_EDNS0_DO         0x8000
+/* what libnet_dns_template() varies */
+#define LIBNET_DNS_TEMPLATE_ID      0x01
+#define LIBNET_DNS_TEMPLATE_QNAME   0x02
+
 /*
  *  Ethernet II header
  *  Static header size: 14 bytes
@@ -1639,6 +1667,44 @@ struct libnet_rip_hdr
     uint32_t rip_metric;      /* Metric */
 };
 
+/*
+ *  SNMP
+ *  Simple Network Management Protocol (RFCs 1157, 1901 and 3416)
+ *  BER encoded, no fixed size header
+ */
+#define LIBNET_SNMP_MAX_MESSAGE     8192    /* largest message we build */
+#define LIBNET_SNMP_VERSION_1       0
+#define LIBNET_SNMP_VERSION_2C      1
+/* PDU types */
+#define LIBNET_SNMP_GET             0xa0
+#define LIBNET_SNMP_GETNEXT         0xa1
+#define LIBNET_SNMP_RESPONSE        0xa2
+#define LIBNET_SNMP_SET             0xa3
+#define LIBNET_SNMP_TRAP            0xa4    /* SNMPv1 Trap-PDU */
+#define LIBNET_SNMP_GETBULK         0xa5
+#define LIBNET_SNMP_INFORM          0xa6
+#define LIBNET_SNMP_TRAP2           0xa7    /* SNMPv2-Trap-PDU */
+#define LIBNET_SNMP_REPORT          0xa8
+/* SMI application types, see libnet_snmp_varbind */
+#define LIBNET_SNMP_IPADDRESS       0x40
+#define LIBNET_SNMP_COUNTER32       0x41
+#define LIBNET_SNMP_GAUGE32         0x42
+#define LIBNET_SNMP_TIMETICKS       0x43
+#define LIBNET_SNMP_OPAQUE          0x44
+#define LIBNET_SNMP_COUNTER64       0x46
+/* varbind exceptions in responses */
+#define LIBNET_SNMP_NOSUCHOBJECT    0x80
+#define LIBNET_SNMP_NOSUCHINSTANCE  0x81
+#define LIBNET_SNMP_ENDOFMIBVIEW    0x82
+/* SNMPv1 generic traps */
+#define LIBNET_SNMP_COLDSTART       0
+#define LIBNET_SNMP_WARMSTART       1
+#define LIBNET_SNMP_LINKDOWN        2
+#define LIBNET_SNMP_LINKUP          3
+#define LIBNET_SNMP_AUTHFAILURE     4
+#define LIBNET_SNMP_EGPNEIGHBORLOSS 5
+#define LIBNET_SNMP_ENTERPRISE      6
+
 /*
  *  RPC headers
  *  Remote Procedure Call
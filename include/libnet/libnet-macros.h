@@ -79,6 +79,47 @@
 #define LIBNET_PRu32        5
 #define LIBNET_PRAND_MAX    0xffffffff
 
+/**
+ * Used for libnet_vary_add() to specify how a field changes between packets
+ */
+#define LIBNET_VARY_INC     0   /* min to max by step, then wrap to min */
+#define LIBNET_VARY_DEC     1   /* max to min by step, then wrap to max */
+#define LIBNET_VARY_RANDOM  2   /* uniformly random in [min, max] */
+#define LIBNET_VARY_LIST    3   /* cycle through a list of values */
+#define LIBNET_VARY_LABEL   4   /* random [a-z0-9] string, e.g. a DNS label */
+#define LIBNET_VARY_LABEL_MAX 63    /* longest LIBNET_VARY_LABEL field */
+
+/**
+ * Used for libnet_tx_start() to say what happens when the queue is full
+ */
+#define LIBNET_TX_DROP      0       /* the frame is dropped and counted */
+#define LIBNET_TX_BLOCK     1       /* the producer waits for room */
+
+/**
+ * Used for libnet_checksum_batch() to select the checksums to compute
+ */
+#define LIBNET_CSUM_IP      0x01    /* the IPv4 header checksum */
+#define LIBNET_CSUM_L4      0x02    /* the TCP or UDP checksum */
+
+/**
+ * Used for libnet_bgp4_packer_add() for a route that is withdrawn
+ */
+#define LIBNET_BGP4_WITHDRAWN   0
+
+/**
+ * Used for libnet_write_fragmented() to shape the fragments, for IDS and
+ * reassembly tests
+ */
+#define LIBNET_FRAG_TINY    0x01    /* first fragment carries 8 bytes */
+#define LIBNET_FRAG_OVERLAP 0x02    /* each overlaps the last 8 bytes of the previous */
+#define LIBNET_FRAG_REVERSE 0x04    /* last fragment first */
+#define LIBNET_FRAG_SHUFFLE 0x08    /* in random order */
+
+/**
+ * Fields libnet_periodic_patch() can step per stream
+ */
+#define LIBNET_PERIODIC_PATCH_MAX   4
+
 /**
  * The biggest an IP packet can be -- 65,535 bytes.
  */
@@ -177,6 +218,10 @@ if (payload_s)                                                               \
 #define CQ_LOCK_READ        (uint32_t)0x00000001
 #define CQ_LOCK_WRITE       (uint32_t)0x00000002
 
+/* what libnet_cq_fanout_write() re-stamps for each context */
+#define LIBNET_FANOUT_SRC_MAC   0x01    /* Ethernet source address */
+#define LIBNET_FANOUT_SRC_IP    0x02    /* IPv4 source address */
+
 /**
  * Provides an interface to iterate through the context queue of libnet
  * contexts. Before calling this macro, be sure to set the queue using
@@ -55,6 +55,188 @@ struct libnet_stats
 };
 
 
+/* libnet extended statistics, see libnet_stats_ex() */
+#define LIBNET_STATS_HIST 32            /* latency histogram buckets */
+struct libnet_stats_ex
+{
+    int64_t packets_sent;               /* as in struct libnet_stats */
+    int64_t packet_errors;
+    int64_t bytes_written;
+
+    int64_t err_nobufs;                 /* ENOBUFS, device queue full */
+    int64_t err_again;                  /* EAGAIN, socket buffer or ring full */
+    int64_t err_msgsize;                /* EMSGSIZE, larger than the MTU */
+    int64_t err_perm;                   /* EPERM or EACCES, e.g. a firewall */
+    int64_t err_other;                  /* any other error */
+    int64_t partial_writes;             /* fewer bytes written than asked */
+
+    uint64_t coalesces;                 /* packets assembled from pblocks */
+    uint64_t coalesce_ns;               /* time assembling, when timed */
+    uint64_t checksum_ns;               /* ... of which checksumming */
+    uint64_t syscalls;                  /* write calls timed */
+    uint64_t syscall_ns;                /* time in them */
+    uint64_t syscall_hist[LIBNET_STATS_HIST]; /* calls of [2^i, 2^(i+1)) ns */
+
+    double pps;                         /* packets per second, EWMA */
+    double bps;                         /* bits per second, EWMA */
+};
+
+
+/* libnet TX thread statistics, see libnet_tx_stats() */
+struct libnet_tx_stats
+{
+    uint64_t enqueued;                  /* frames accepted by the queue */
+    uint64_t dropped;                   /* frames dropped, queue full */
+    uint64_t blocked;                   /* producer waits, queue full */
+    uint64_t sent;                      /* frames written by the thread */
+    uint64_t errors;                    /* frames the write failed for */
+    uint32_t depth;                     /* queue capacity */
+    uint32_t used;                      /* frames queued right now */
+    uint32_t max_used;                  /* most frames ever queued */
+};
+
+
+/* kernel timestamps of one frame, see libnet_ts_start() */
+struct libnet_ts_report
+{
+    uint32_t id;                        /* frame number on the socket */
+    struct timespec user;               /* libnet_write_ts() called, or 0 */
+    struct timespec sched;              /* entered the qdisc, or 0 */
+    struct timespec sent;               /* handed to the driver */
+};
+
+
+/* TX timestamp statistics, see libnet_ts_stats() */
+struct libnet_ts_stats
+{
+    uint64_t reports;                   /* frames with a send timestamp */
+    uint64_t lost;                      /* libnet_write_ts() frames without */
+    uint64_t unmatched;                 /* reports for an unexpected id */
+    uint64_t build_ns;                  /* libnet_write_ts() to qdisc */
+    uint64_t queue_ns;                  /* qdisc to driver */
+    uint64_t build_hist[LIBNET_STATS_HIST]; /* frames of [2^i, 2^(i+1)) ns */
+    uint64_t queue_hist[LIBNET_STATS_HIST];
+};
+
+
+/*
+ * Memory allocator for libnet to use instead of malloc(), realloc() and
+ * free(), see libnet_set_allocator().  ctx is passed to every call.
+ */
+struct libnet_allocator
+{
+    void *(*malloc_fn)(size_t size, void *ctx);
+    void *(*realloc_fn)(void *ptr, size_t size, void *ctx);
+    void (*free_fn)(void *ptr, void *ctx);
+    void *ctx;
+};
+
+
+/* allocations made on behalf of a context, see libnet_alloc_stats() */
+struct libnet_alloc_stats
+{
+    uint64_t allocs;                    /* malloc() and realloc() calls */
+    uint64_t bytes;                     /* bytes asked for by them */
+};
+
+
+/*
+ * libnet statistics page, see libnet_stats_publish().  The page lives in
+ * shared memory and is updated by the sending process without locking:
+ * seq is odd while an update is in progress, readers copy the page and
+ * retry if seq was odd or has changed meanwhile, see libnet_stats_read().
+ */
+#define LIBNET_STATS_PAGE_MAGIC   0x6c6e7370  /* "lnsp" */
+#define LIBNET_STATS_PAGE_VERSION 2
+#define LIBNET_STATS_PAGE_PREFIX  "/libnet-stats-"
+struct libnet_stats_page
+{
+    uint32_t magic;                     /* LIBNET_STATS_PAGE_MAGIC */
+    uint32_t version;                   /* LIBNET_STATS_PAGE_VERSION */
+    uint32_t pid;                       /* of the publishing process */
+    uint32_t seq;                       /* update sequence, odd = busy */
+    char label[LIBNET_LABEL_SIZE];      /* context label */
+    char device[64];                    /* context device, if any */
+    struct libnet_stats_ex stats;       /* counters, see libnet_stats_ex() */
+    struct libnet_tx_stats queue;       /* TX queue, depth 0 if none */
+    uint64_t rate_t;                    /* pps and bps are as of, ns */
+    int64_t rate_packets;               /* ... packets_sent then */
+    int64_t rate_bytes;                 /* ... bytes_written then */
+};
+
+
+/* one wire-ready frame, see libnet_checksum_batch() */
+struct libnet_frame
+{
+    uint8_t *buf;                       /* start of the frame */
+    uint32_t len;                       /* length of the frame */
+};
+
+
+/* libnet field variation descriptor, see libnet_vary_add() */
+struct libnet_vary_spec
+{
+    uint8_t  op;                        /* one of LIBNET_VARY_* */
+    uint8_t  width;                     /* field width in bytes: 1, 2 or 4,
+                                           up to 63 for LIBNET_VARY_LABEL */
+    uint32_t min;                       /* lowest value (host byte order) */
+    uint32_t max;                       /* highest value (host byte order) */
+    uint32_t step;                      /* increment/decrement, 0 means 1 */
+    uint32_t every;                     /* packets per value, 0 means 1 */
+    const uint32_t *list;               /* values for LIBNET_VARY_LIST */
+    uint32_t list_n;                    /* number of values in list */
+};
+
+
+/* synthetic OSPF link state database, see libnet_lsdb_build() */
+struct libnet_lsdb_spec
+{
+    uint32_t routers;                   /* router LSAs, one per router */
+    uint16_t links;                     /* point-to-point links in each */
+    uint32_t networks;                  /* network LSAs */
+    uint16_t attached;                  /* routers on each network */
+    uint32_t summaries;                 /* summary LSAs (type 3) */
+    uint32_t router_id;                 /* first router ID (host byte order) */
+    uint32_t prefix;                    /* first /24 (host byte order) */
+    uint32_t seq;                       /* LS sequence number, 0 for initial */
+    uint16_t age;                       /* LS age */
+    uint8_t  opts;                      /* LIBNET_OPT_* */
+    uint16_t mtu;                       /* IP MTU of the LSUs, 0 means 1500 */
+};
+
+
+/* one DHCP option, see libnet_dhcp_options() */
+struct libnet_dhcp_option
+{
+    uint8_t code;                       /* LIBNET_DHCP_* */
+    uint32_t num;                       /* value of the typed options */
+    const void *val;                    /* raw value, NULL to encode num */
+    uint32_t val_s;                     /* length of val */
+};
+
+
+/* one LLDP TLV, see libnet_build_lldp() */
+struct libnet_lldp_tlv
+{
+    uint8_t type;                       /* LIBNET_LLDP_* TLV type */
+    uint8_t subtype;                    /* Chassis ID or Port ID subtype */
+    uint16_t num;                       /* value, e.g. the TTL, if val is NULL */
+    const void *val;                    /* raw value, NULL to encode num */
+    uint16_t val_s;                     /* length of val */
+};
+
+
+/* one SNMP variable binding, see libnet_build_snmp() */
+struct libnet_snmp_varbind
+{
+    const uint32_t *name;               /* object identifier */
+    uint32_t name_n;                    /* number of sub-identifiers */
+    uint8_t type;                       /* ASN_INTEGER, LIBNET_SNMP_*, ... */
+    int64_t num;                        /* value of the integer types */
+    const void *val;                    /* strings, addresses, uint32_t OIDs */
+    uint32_t val_s;                     /* bytes, or sub-identifiers of OIDs */
+};
+
 /*
  *  Libnet ptags are how we identify specific protocol blocks inside the
  *  list.
@@ -170,6 +352,7 @@ struct libnet_protocol_block
 #define LIBNET_PBLOCK_UDLD_TMT_INTERVAL_H 0x61  /* UDLD Timeout Interval header */
 #define LIBNET_PBLOCK_UDLD_DEVICE_NAME_H  0x62  /* UDLD Device Name header*/
 #define LIBNET_PBLOCK_UDLD_SEQ_NUMBER_H 0x63    /* UDLD Sequence Number header */
+#define LIBNET_PBLOCK_SNMP_H            0x64    /* SNMP message */
 
     uint8_t flags;                             /* control flags */
 #define LIBNET_PBLOCK_DO_CHECKSUM       0x01    /* needs a checksum */
@@ -180,9 +363,20 @@ struct libnet_protocol_block
      */
     struct libnet_protocol_block *next; /* next pblock */
     struct libnet_protocol_block *prev; /* prev pblock */
+    uint32_t *refs;                     /* buf shared with clones, or NULL */
 };
 typedef struct libnet_protocol_block libnet_pblock_t;
 
+/*
+ *  A socket shared by a context and its clones, see libnet_clone().
+ */
+struct libnet_fd_share
+{
+    uint32_t refs;                      /* contexts on the socket */
+    uint32_t frames;                    /* frames sent on it, all contexts */
+    uint32_t errors;                    /* failed or partial writes on it */
+    uint32_t ts;                        /* a context timestamps on it */
+};
 
 /*
  *  Libnet context
@@ -197,11 +391,13 @@ struct libnet_context
 #else
     int fd;                             /* file descriptor of packet device */
 #endif
+    struct libnet_fd_share *fd_share;   /* fd shared with clones, or NULL */
     int injection_type;                 /* one of: */
 #define LIBNET_NONE     0xf8            /* no injection type, only construct packets */
 #define LIBNET_LINK     0x00            /* link-layer interface */
 #define LIBNET_RAW4     0x01            /* raw socket interface (ipv4) */
 #define LIBNET_RAW6     0x02            /* raw socket interface (ipv6) */
+#define LIBNET_SHM      0x03            /* shared memory ring, see libnet-txd */
 /* the following should actually set a flag in the flags variable above */
 #define LIBNET_LINK_ADV 0x08            /* advanced mode link-layer */
 #define LIBNET_RAW4_ADV 0x09            /* advanced mode raw socket (ipv4) */
@@ -239,9 +435,51 @@ struct libnet_context
     uint32_t total_size;               /* total size */
 
     struct libnet_ether_addr link_addr; /* Link HW addr */
+
+    uint64_t prand_state;               /* libnet_get_prand_r() state */
+    struct libnet_vary_prog *vary;      /* field variation program */
+    struct libnet_carousel *carousel;   /* precomputed frames */
+    struct libnet_lsdb *lsdb;           /* synthetic OSPF LSAs */
+    struct libnet_bgp4_packer *bgp4_packer; /* routes to pack */
+    struct libnet_dns *dns;             /* DNS message being encoded */
+    struct libnet_periodic *periodic;   /* timer wheel of periodic frames */
+    struct libnet_lldp *lldp;           /* TLV arena and LLDPDU template */
+
+    uint8_t csum_defer;                 /* LIBNET_CSUM_* left to the caller */
+    uint8_t csum_deferred;              /* ... and actually left out */
+    uint32_t csum_ip_offset;            /* where the IPv4 header is */
+
+    struct libnet_tx *tx;               /* TX thread and its queue */
+    struct libnet_shm *shm;             /* LIBNET_SHM ring mapping */
+    struct libnet_ts *ts;               /* TX timestamping state */
+
+    struct libnet_stats_ex xstats;      /* extended statistics, the base */
+                                        /* counters are in stats */
+    uint8_t stats_timing;               /* time writes and coalescing */
+    uint64_t rate_t;                    /* last rate sample, ns */
+    int64_t rate_packets;               /* ... packets_sent then */
+    int64_t rate_bytes;                 /* ... bytes_written then */
+
+    struct libnet_stats_page *stats_page; /* published statistics */
+    char *stats_page_name;              /* ... shared memory name */
+    uint32_t stats_page_tick;           /* updates since the full one */
+    struct libnet_context *stats_page_owner; /* ... lent by, to a TX thread */
+    struct libnet_stats_ex stats_page_base; /* ... with its counts then */
+
+    uint64_t alloc_count;               /* allocations for this context */
+    uint64_t alloc_bytes;               /* ... bytes asked for */
+    uint8_t *write_buf;                 /* libnet_write() packet buffer */
+    uint32_t write_buf_s;               /* ... its size */
+    uint8_t *frag_buf;                  /* libnet_fragment() fragments */
+    uint32_t frag_buf_s;                /* ... its size */
+    uint32_t mtu;                       /* device MTU, 0 until asked */
 };
 typedef struct libnet_context libnet_t;
 
+/* TX timestamp callback, see libnet_ts_start() */
+typedef void (*libnet_ts_cb)(libnet_t *l, const struct libnet_ts_report *r,
+        void *arg);
+
 /*
  *  Libnet context queue structure
  *  Opaque structure.  Nothing in here should ever been touched first hand by
@@ -253,6 +491,11 @@ struct _libnet_context_queue
     libnet_t *context;                  /* pointer to libnet context */
     libnet_cq_t *next;                  /* next node in the list */
     libnet_cq_t *prev;                  /* previous node in the list */
+    libnet_cq_t *hnext;                 /* next node in the label bucket */
+    uint8_t hwaddr[6];                  /* device addresses, for fan-out */
+    uint32_t ipaddr;
+    uint8_t have_addr;                  /* LIBNET_FANOUT_* found at add */
+    uint64_t seq;                       /* order of addition, see iterator */
 };
 
 struct _libnet_context_queue_descriptor
@@ -260,9 +503,23 @@ struct _libnet_context_queue_descriptor
     uint32_t node;                     /* number of nodes in the list */
     uint32_t cq_lock;                  /* lock status */
     libnet_cq_t *current;               /* current context */
+    uint64_t seq;                       /* last libnet_cq_t.seq handed out */
+    uint64_t gen;                       /* bumped whenever the list changes */
 };
 typedef struct _libnet_context_queue_descriptor libnet_cqd_t;
 
+/*
+ *  Context queue iterator, one per caller, see libnet_cq_iter_first().
+ *  Opaque structure.
+ */
+struct _libnet_context_queue_iterator
+{
+    libnet_cq_t *node;                  /* current node, valid while gen is */
+    uint64_t seq;                       /* its libnet_cq_t.seq */
+    uint64_t gen;                       /* libnet_cqd_t.gen seen at node */
+};
+typedef struct _libnet_context_queue_iterator libnet_cq_iter_t;
+
 #endif  /* __LIBNET_STRUCTURES_H */
 
 /**
@@ -45,8 +45,8 @@ int
 main(int argc, char *argv[])
 {
     char *intf;
-    u_long src_ip, options_len, orig_len;
-    int i;
+    u_long src_ip;
+    int i, n, options_len;
     
     libnet_t *l;
     libnet_ptag_t t;
@@ -62,9 +62,9 @@ main(int argc, char *argv[])
                              LIBNET_DHCP_BROADCASTADDR, LIBNET_DHCP_TIMEOFFSET,
                              LIBNET_DHCP_ROUTER, LIBNET_DHCP_DOMAINNAME,
                              LIBNET_DHCP_DNS, LIBNET_DHCP_HOSTNAME };
-    u_char *options;
+    struct libnet_dhcp_option opt[3];
+    u_char options[LIBNET_BOOTP_MIN_LEN];
     u_char enet_dst[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
-    u_char *tmp;
     
     if (argc != 2)
     {
@@ -102,74 +102,30 @@ main(int argc, char *argv[])
         printf("\n");
         
         
-        /* build options packet */
-        i = 0;
-	/* update total payload size */
-        options_len = 3;
-        
-        /* we are a discover packet */
-        options = malloc(3);
-        options[i++] = LIBNET_DHCP_MESSAGETYPE;     /* type */
-        options[i++] = 1;                           /* len */
-        options[i++] = LIBNET_DHCP_MSGDISCOVER;     /* data */
-        
-        orig_len = options_len;
-	/* update total payload size */
-        options_len += sizeof(options_req) + 2;
-        
-        tmp = malloc(options_len);
-        memcpy(tmp, options, orig_len);
-        free(options);
-        options = tmp;
-        
-        /* we are going to request some parameters */
-        options[i++] = LIBNET_DHCP_PARAMREQUEST;                 /* type */
-        options[i++] = sizeof(options_req);                      /* len */
-        memcpy(options + i, options_req, sizeof(options_req));   /* data */
-        i += sizeof(options_req);
-        
+        /* we are a discover packet requesting some parameters */
+        memset(opt, 0, sizeof(opt));
+        n = 0;
+        opt[n].code  = LIBNET_DHCP_MESSAGETYPE;
+        opt[n++].num = LIBNET_DHCP_MSGDISCOVER;
+        opt[n].code  = LIBNET_DHCP_PARAMREQUEST;
+        opt[n].val   = options_req;
+        opt[n++].val_s = sizeof(options_req);
+
         /* if we have an ip already, let's request it. */
         if (src_ip)
         {
-            orig_len = options_len;
-            options_len += 2 + sizeof(src_ip);
-            
-            tmp = malloc(options_len);
-            memcpy(tmp, options, orig_len);
-            free(options);
-            options = tmp;
-            
-            options[i++] = LIBNET_DHCP_DISCOVERADDR;	          /* type */
-            options[i++] = sizeof(src_ip);			  /* len */
-            memcpy(options + i, (char *)&src_ip, sizeof(src_ip)); /* data */
-            i += sizeof(src_ip);
+            opt[n].code  = LIBNET_DHCP_DISCOVERADDR;
+            opt[n++].num = src_ip;
         }
-        
-        /* end our options packet */
-        orig_len = options_len;
-        options_len += 1;
-        tmp = malloc(options_len);
-        memcpy(tmp, options, orig_len);
-        free(options);
-        options = tmp;
-        options[i++] = LIBNET_DHCP_END;
 
-        
-        /* make sure we are at least the minimum length, if not fill */
-        /* this could go in libnet, but we will leave it in the app for now */
-        if (options_len + LIBNET_DHCPV4_H < LIBNET_BOOTP_MIN_LEN)
+        /* terminated and padded to the minimum length */
+        options_len = libnet_dhcp_options(l, opt, n, options, sizeof(options));
+        if (options_len == -1)
         {
-            orig_len = options_len;
-            options_len = LIBNET_BOOTP_MIN_LEN - LIBNET_DHCPV4_H;
-            
-            tmp = malloc(options_len);
-            memcpy(tmp, options, orig_len);
-            free(options);
-            options = tmp;
-            
-            memset(options + i, 0, options_len - i);
+            fprintf(stderr, "libnet_dhcp_options: %s\n", libnet_geterror(l));
+            exit(EXIT_FAILURE);
         }
-        
+
         dhcp = libnet_build_dhcpv4(
                 LIBNET_DHCP_REQUEST,            /* opcode */
                 1,                              /* hardware type */
@@ -236,8 +192,6 @@ main(int argc, char *argv[])
 		    (long long)ls.bytes_written);
         libnet_destroy(l);
         
-        free(options);
-        
         exit(0);
     }
     exit(0);
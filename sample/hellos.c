@@ -0,0 +1,248 @@
+/*
+ *  libnet
+ *  hellos.c - periodic hellos of many simulated routers
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  Every simulated router sends an STP configuration BPDU every 2 s, a
+ *  VRRP advertisement every second, an HSRP hello every 3 s and an OSPF
+ *  hello every 10 s, all from one thread driving libnet_periodic_dispatch().
+ */
+
+#if (HAVE_CONFIG_H)
+#include "../include/config.h"
+#endif
+#include "./libnet_test.h"
+
+#include <signal.h>
+#include <time.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void
+on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static uint64_t
+now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/* adds the packet built in l as a stream, the IP ID stepped if there is one */
+static int
+stream(libnet_t *l, uint32_t interval, uint32_t jitter, uint32_t first, int ip)
+{
+    int id;
+
+    id = libnet_periodic_add(l, interval, jitter, first);
+    if (id == -1 || (ip && libnet_periodic_patch(l, id, LIBNET_ETH_H + 4, 2, 1,
+            LIBNET_ETH_H + 10) == -1))
+    {
+        fprintf(stderr, "stream: %s\n", libnet_geterror(l));
+        return (-1);
+    }
+    libnet_clear_packet(l);
+    return (id);
+}
+
+static int
+router(libnet_t *l, uint32_t i)
+{
+    static const uint8_t stp_dst[6]  = { 0x01, 0x80, 0xc2, 0x00, 0x00, 0x00 };
+    static const uint8_t vrrp_dst[6] = { 0x01, 0x00, 0x5e, 0x00, 0x00, 0x12 };
+    static const uint8_t hsrp_dst[6] = { 0x01, 0x00, 0x5e, 0x00, 0x00, 0x02 };
+    static const uint8_t ospf_dst[6] = { 0x01, 0x00, 0x5e, 0x00, 0x00, 0x05 };
+    static const uint8_t auth[HSRP_AUTHDATA_LENGTH] = "cisco";
+    static const uint8_t ospf_auth[LIBNET_OSPF_AUTH_H] = { 0 };
+    uint8_t mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    uint8_t bridge[8], vrrp[12];
+    uint32_t addr, vip;
+    uint32_t first = i % 1000;          /* spread the routers out */
+
+    mac[3] = (uint8_t)(i >> 16);
+    mac[4] = (uint8_t)(i >> 8);
+    mac[5] = (uint8_t)i;
+    addr = htonl(0x0a000000 + i + 1);
+    vip  = htonl(0x0a800000 + i + 1);
+    bridge[0] = 0x80;
+    bridge[1] = 0x00;
+    memcpy(bridge + 2, mac, 6);
+
+    if (libnet_build_stp_conf(0, 0, 0, 0, bridge, 0, bridge, 0x8001, 0,
+            0x0014, 0x0002, 0x000f, NULL, 0, l, 0) == -1 ||
+        libnet_build_802_2(LIBNET_SAP_STP, LIBNET_SAP_STP, 0x03, NULL, 0, l,
+            0) == -1 ||
+        libnet_build_802_3(stp_dst, mac, LIBNET_802_2_H + LIBNET_STP_CONF_H,
+            NULL, 0, l, 0) == -1 ||
+        stream(l, 2000, 0, first, 0) == -1)
+    {
+        return (-1);
+    }
+
+    /* the virtual address, then 8 bytes of (no) authentication data */
+    memset(vrrp, 0, sizeof (vrrp));
+    memcpy(vrrp, &vip, 4);
+    if (libnet_build_vrrp(2, LIBNET_VRRP_TYPE_ADVERT, 1, 100, 1, 0, 1, 0,
+            vrrp, sizeof (vrrp), l, 0) == -1 ||
+        libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_VRRP_H + sizeof (vrrp), 0xc0,
+            0, 0, 255,
+            IPPROTO_VRRP, 0, addr, htonl(0xe0000012), NULL, 0, l, 0) == -1 ||
+        libnet_build_ethernet(vrrp_dst, mac, ETHERTYPE_IP, NULL, 0, l, 0) == -1 ||
+        stream(l, 1000, 0, first, 1) == -1)
+    {
+        return (-1);
+    }
+
+    if (libnet_build_hsrp(0, LIBNET_HSRP_TYPE_HELLO, LIBNET_HSRP_STATE_ACTIVE, 3, 10, 100,
+            1, 0, auth, vip, NULL, 0, l, 0) == -1 ||
+        libnet_build_udp(1985, 1985, LIBNET_UDP_H + LIBNET_HSRP_H, 0, NULL, 0,
+            l, 0) == -1 ||
+        libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + LIBNET_HSRP_H, 0xc0, 0,
+            0, 1, IPPROTO_UDP, 0, addr, htonl(0xe0000002), NULL, 0, l, 0) == -1 ||
+        libnet_build_ethernet(hsrp_dst, mac, ETHERTYPE_IP, NULL, 0, l, 0) == -1 ||
+        stream(l, 3000, 300, first, 1) == -1)
+    {
+        return (-1);
+    }
+
+    if (libnet_build_ospfv2_hello(htonl(0xffffff00), 10, 0x02, 1, 40, 0, 0,
+            NULL, 0, l, 0) == -1 ||
+        libnet_build_data(ospf_auth, LIBNET_OSPF_AUTH_H, l, 0) == -1 ||
+        libnet_build_ospfv2(LIBNET_OSPF_HELLO_H + LIBNET_OSPF_AUTH_H,
+            LIBNET_OSPF_HELLO, addr, 0, 0, LIBNET_OSPF_AUTH_NULL, NULL, 0, l,
+            0) == -1 ||
+        libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_OSPF_H + LIBNET_OSPF_AUTH_H +
+            LIBNET_OSPF_HELLO_H, 0xc0, 0, 0, 1, IPPROTO_OSPF, 0, addr,
+            htonl(0xe0000005), NULL, 0, l, 0) == -1 ||
+        libnet_build_ethernet(ospf_dst, mac, ETHERTYPE_IP, NULL, 0, l, 0) == -1 ||
+        stream(l, 10000, 1000, first, 1) == -1)
+    {
+        return (-1);
+    }
+    return (1);
+}
+
+void
+usage(char *name)
+{
+    fprintf(stderr, "usage: %s [-n routers] [-d seconds] -i device\n", name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint32_t i, n = 1000, duration = 10;
+    uint64_t start, now, sent = 0;
+    struct libnet_stats ls;
+    struct timespec ts;
+    char *device = NULL;
+    int64_t next;
+    libnet_t *l;
+    int c;
+
+    while ((c = getopt(argc, argv, "d:i:n:")) != EOF)
+    {
+        switch (c)
+        {
+            case 'd':
+                duration = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                device = optarg;
+                break;
+            case 'n':
+                n = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (device == NULL || n == 0 || n > 0xffffff)
+    {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    l = libnet_init(LIBNET_LINK, device, errbuf);
+    if (l == NULL)
+    {
+        fprintf(stderr, "libnet_init() failed: %s\n", errbuf);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (router(l, i) == -1)
+        {
+            libnet_destroy(l);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("%u routers, %u streams\n", n, 4 * n);
+
+    signal(SIGINT, on_signal);
+    start = now = now_ms();
+    while (running && now - start < duration * 1000ULL)
+    {
+        sent += libnet_periodic_dispatch(l, now);
+
+        /* one sleep for all streams */
+        next = libnet_periodic_next(l);
+        now = now_ms();
+        if (next > (int64_t)now)
+        {
+            ts.tv_sec  = (next - now) / 1000;
+            ts.tv_nsec = (next - now) % 1000 * 1000000;
+            nanosleep(&ts, NULL);
+            now = now_ms();
+        }
+    }
+
+    libnet_stats(l, &ls);
+    printf("%llu frames due, %lld sent, %lld errors\n", (unsigned long long)sent,
+        (long long)ls.packets_sent, (long long)ls.packet_errors);
+
+    libnet_destroy(l);
+    return (EXIT_SUCCESS);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
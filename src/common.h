@@ -27,6 +27,9 @@
  *
  */
 
+/* first, so feature test macros like _GNU_SOURCE apply to system headers */
+#include <config.h>
+
 #if (_WIN32) || (__CYGWIN__)
 
   /* MSVC warns about snprintf */
@@ -60,8 +63,8 @@
 
 #endif
 
-#include <config.h>
 #include "../include/libnet.h"
+#include "libnet_probes.h"
 
 /* IPPROTO_ and sockaddr_ definitions are here. They are often
  * implicitly pulled in, but some systems need them explicitly
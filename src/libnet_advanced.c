@@ -75,13 +75,18 @@ libnet_adv_cull_header(libnet_t *l, libnet_ptag_t ptag, uint8_t **header,
     }
 #endif
 
-    const libnet_pblock_t *p = libnet_pblock_find(l, ptag);
+    libnet_pblock_t *p = libnet_pblock_find(l, ptag);
     if (p == NULL)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
             "%s(): ptag not found, you sure it exists?", __func__);
         return (-1);
     }
+    if (libnet_pblock_own(l, p) == -1)
+    {
+        /* err msg set in libnet_pblock_own() */
+        return (-1);
+    }
     *header   = p->buf;
     *header_s = p->b_len;
 
@@ -97,26 +102,11 @@ libnet_adv_write_link(libnet_t *l, const uint8_t *packet, uint32_t packet_s)
                 "%s(): advanced link mode not enabled", __func__);
         return (-1);
     }
+    const uint64_t t0 = libnet_stats_clock(l);
     const ssize_t c = libnet_write_link(l, packet, packet_s);
 
     /* do statistics */
-    if (c == (ssize_t)packet_s)
-    {
-        l->stats.packets_sent++;
-        l->stats.bytes_written += c;
-    }
-    else
-    {
-        l->stats.packet_errors++;
-        /*
-         *  XXX - we probably should have a way to retrieve the number of
-         *  bytes actually written (since we might have written something).
-         */
-        if (c > 0)
-        {
-            l->stats.bytes_written += c;
-        }
-    }
+    libnet_stats_write(l, (int)c, packet_s, t0);
     return (c);
 }
 
@@ -129,26 +119,11 @@ libnet_adv_write_raw_ipv4(libnet_t *l, const uint8_t *packet, uint32_t packet_s)
                 "%s(): advanced raw4 mode not enabled", __func__);
         return (-1);
     }
+    const uint64_t t0 = libnet_stats_clock(l);
     const ssize_t c = libnet_write_raw_ipv4(l, packet, packet_s);
 
     /* do statistics */
-    if (c == (ssize_t)packet_s)
-    {
-        l->stats.packets_sent++;
-        l->stats.bytes_written += c;
-    }
-    else
-    {
-        l->stats.packet_errors++;
-        /*
-         *  XXX - we probably should have a way to retrieve the number of
-         *  bytes actually written (since we might have written something).
-         */
-        if (c > 0)
-        {
-            l->stats.bytes_written += c;
-        }
-    }
+    libnet_stats_write(l, (int)c, packet_s, t0);
     return (c);
 }
 
@@ -163,7 +138,7 @@ libnet_adv_free_packet(const libnet_t *l, uint8_t *packet)
     {
         packet = packet - l->aligner;
     }
-    free(packet);
+    libnet_free(packet);
 }
 
 /**
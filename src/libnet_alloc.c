@@ -0,0 +1,164 @@
+/*
+ *  libnet
+ *  libnet_alloc.c - memory allocation
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+static void *
+default_malloc(size_t size, void *ctx)
+{
+    (void)ctx;
+    return (malloc(size));
+}
+
+static void *
+default_realloc(void *ptr, size_t size, void *ctx)
+{
+    (void)ctx;
+    return (realloc(ptr, size));
+}
+
+static void
+default_free(void *ptr, void *ctx)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static struct libnet_allocator allocator =
+{
+    default_malloc, default_realloc, default_free, NULL
+};
+
+int
+libnet_set_allocator(const struct libnet_allocator *a)
+{
+    if (a == NULL)
+    {
+        allocator.malloc_fn  = default_malloc;
+        allocator.realloc_fn = default_realloc;
+        allocator.free_fn    = default_free;
+        allocator.ctx        = NULL;
+        return (1);
+    }
+    if (a->malloc_fn == NULL || a->realloc_fn == NULL || a->free_fn == NULL)
+    {
+        return (-1);
+    }
+    allocator = *a;
+    return (1);
+}
+
+int
+libnet_alloc_stats(const libnet_t *l, struct libnet_alloc_stats *as)
+{
+    if (l == NULL || as == NULL)
+    {
+        return (-1);
+    }
+    as->allocs = l->alloc_count;
+    as->bytes  = l->alloc_bytes;
+    return (1);
+}
+
+void *
+libnet_malloc(libnet_t *l, size_t size)
+{
+    void *p;
+
+    p = allocator.malloc_fn(size, allocator.ctx);
+    if (p && l)
+    {
+        l->alloc_count++;
+        l->alloc_bytes += size;
+    }
+    return (p);
+}
+
+void *
+libnet_calloc(libnet_t *l, size_t n, size_t size)
+{
+    void *p;
+
+    if (size && n > SIZE_MAX / size)
+    {
+        errno = ENOMEM;
+        return (NULL);
+    }
+    p = libnet_malloc(l, n * size);
+    if (p)
+    {
+        memset(p, 0, n * size);
+    }
+    return (p);
+}
+
+void *
+libnet_realloc(libnet_t *l, void *ptr, size_t size)
+{
+    void *p;
+
+    p = allocator.realloc_fn(ptr, size, allocator.ctx);
+    if (p && l)
+    {
+        l->alloc_count++;
+        l->alloc_bytes += size;
+    }
+    return (p);
+}
+
+char *
+libnet_strdup(libnet_t *l, const char *s)
+{
+    const size_t len = strlen(s) + 1;
+    char *p;
+
+    p = libnet_malloc(l, len);
+    if (p)
+    {
+        memcpy(p, s, len);
+    }
+    return (p);
+}
+
+void
+libnet_free(void *ptr)
+{
+    if (ptr)
+    {
+        allocator.free_fn(ptr, allocator.ctx);
+    }
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -427,6 +427,196 @@ libnet_build_asn1_bitstring(uint8_t *data, int *datalen, uint8_t type,
     return (data + str_s);
 }
 
+
+uint8_t *
+libnet_build_asn1_rlength(uint8_t *data, int *datalen, int len)
+{
+    int n, i;
+
+    if (len < 0)
+    {
+        return (NULL);
+    }
+    /* no indefinite lengths sent */
+    n = len < 0x80 ? 1 : len <= 0xFF ? 2 : len <= 0xFFFF ? 3 :
+        len <= 0xFFFFFF ? 4 : 5;
+    if (*datalen < n)
+    {
+        return (NULL);
+    }
+    *datalen -= n;
+
+    if (n == 1)
+    {
+        *--data = (uint8_t)len;
+        return (data);
+    }
+    for (i = 1; i < n; i++)
+    {
+        *--data = (uint8_t)(len & 0xFF);
+        len >>= 8;
+    }
+    *--data = (uint8_t)((n - 1) | ASN_LONG_LEN);
+    return (data);
+}
+
+
+uint8_t *
+libnet_build_asn1_rheader(uint8_t *data, int *datalen, uint8_t type, int len)
+{
+    data = libnet_build_asn1_rlength(data, datalen, len);
+    if (data == NULL || *datalen < 1)
+    {
+        return (NULL);
+    }
+    *--data = type;
+    (*datalen)--;
+
+    return (data);
+}
+
+
+/* writes the n low order bytes of v, zero past the 8th, before data */
+static uint8_t *
+asn1_rbytes(uint8_t *data, int *datalen, uint8_t type, uint64_t v, int n)
+{
+    int i;
+
+    if (*datalen < n)
+    {
+        return (NULL);
+    }
+    *datalen -= n;
+    for (i = 0; i < n; i++)
+    {
+        *--data = (uint8_t)(v & 0xFF);
+        v >>= 8;
+    }
+    return (libnet_build_asn1_rheader(data, datalen, type, n));
+}
+
+
+uint8_t *
+libnet_build_asn1_rint(uint8_t *data, int *datalen, uint8_t type,
+            int64_t integer)
+{
+    /*
+     *  ASN.1 integer ::= 0x02 asnlength byte {byte}*
+     *  The shortest two's complement form: drop leading bytes for as long as
+     *  the next one carries the same sign.
+     */
+    int n = 1;
+
+    while (n < 8 && (integer >= 0 ?
+        integer >= (int64_t)1 << (8 * n - 1) :
+        integer < -((int64_t)1 << (8 * n - 1))))
+    {
+        n++;
+    }
+    return (asn1_rbytes(data, datalen, type, (uint64_t)integer, n));
+}
+
+
+uint8_t *
+libnet_build_asn1_ruint(uint8_t *data, int *datalen, uint8_t type,
+            uint64_t integer)
+{
+    /*
+     *  Same as above, with a leading zero byte when the most significant bit
+     *  would read as a sign.
+     */
+    int n = 1;
+
+    while (n < 9 && integer >> (8 * n - 1))
+    {
+        n++;
+    }
+    return (asn1_rbytes(data, datalen, type, integer, n));
+}
+
+
+uint8_t *
+libnet_build_asn1_rstring(uint8_t *data, int *datalen, uint8_t type,
+            const uint8_t *string, int str_s)
+{
+    if (str_s < 0 || *datalen < str_s)
+    {
+        return (NULL);
+    }
+    data -= str_s;
+    if (str_s)
+    {
+        memmove(data, string, str_s);
+    }
+    *datalen -= str_s;
+
+    return (libnet_build_asn1_rheader(data, datalen, type, str_s));
+}
+
+
+uint8_t *
+libnet_build_asn1_robjid(uint8_t *data, int *datalen, uint8_t type,
+            const oid *objid, int objidlen)
+{
+    uint8_t * const end = data;
+    uint32_t objid_val;
+    int i;
+
+    if (objidlen > MAX_OID_LEN)
+    {
+        return (NULL);
+    }
+
+    /* the first two sub-identifiers are combined, see above */
+    for (i = objidlen - 1; i >= 1; i--)
+    {
+        if (i == 1)
+        {
+            objid_val = (objid[0] * 40) + objid[1];
+        }
+        else
+        {
+            objid_val = objid[i];
+        }
+
+        /* base 128, most significant first, high bit on all but the last */
+        if (*datalen < 1)
+        {
+            return (NULL);
+        }
+        *--data = (uint8_t)(objid_val & 0x7f);
+        (*datalen)--;
+        while ((objid_val >>= 7))
+        {
+            if (*datalen < 1)
+            {
+                return (NULL);
+            }
+            *--data = (uint8_t)((objid_val & 0x7f) | 0x80);
+            (*datalen)--;
+        }
+    }
+    if (objidlen < 2)
+    {
+        /* same as libnet_build_asn1_objid(): a lone 0.0 */
+        if (*datalen < 1)
+        {
+            return (NULL);
+        }
+        *--data = 0;
+        (*datalen)--;
+    }
+
+    return (libnet_build_asn1_rheader(data, datalen, type, (int)(end - data)));
+}
+
+
+uint8_t *
+libnet_build_asn1_rnull(uint8_t *data, int *datalen, uint8_t type)
+{
+    return (libnet_build_asn1_rheader(data, datalen, type, 0));
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
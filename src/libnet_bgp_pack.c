@@ -0,0 +1,396 @@
+/*
+ *  libnet
+ *  libnet_bgp_pack.c - BGP-4 UPDATE packing
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  The packer keeps one set per distinct path attribute blob, holding the
+ *  NLRI added for it already encoded, <length, prefix> after <length,
+ *  prefix>, so packing is mostly copying.  Set 0 holds the withdrawn
+ *  routes.  Sets are found by their attributes through a hash table of
+ *  set numbers, open addressing with linear probing.
+ */
+#define BGP_PACK_SETS_MIN   16
+#define BGP_PACK_NLRI_MIN   256
+#define BGP_PACK_ROOM       (LIBNET_BGP4_MAX_MESSAGE - LIBNET_BGP4_HEADER_H - \
+                             LIBNET_BGP4_UPDATE_H)
+
+struct libnet_bgp4_set
+{
+    uint8_t *attrs;                     /* path attributes */
+    uint16_t attrs_s;
+    uint32_t hash;
+    uint8_t *nlri;                      /* encoded prefixes */
+    uint32_t nlri_s;
+    uint32_t nlri_max;
+};
+
+struct libnet_bgp4_packer
+{
+    struct libnet_bgp4_set *set;
+    uint32_t n;                         /* sets in use, withdrawn included */
+    uint32_t max;
+    uint32_t *table;                    /* set numbers, 0 for a free slot */
+    uint32_t table_s;                   /* a power of two, > 2 * n */
+};
+
+static uint32_t
+bgp_pack_hash(const uint8_t *p, uint16_t len)
+{
+    uint32_t h = 2166136261u;           /* FNV-1a */
+
+    while (len--)
+    {
+        h = (h ^ *p++) * 16777619u;
+    }
+    return (h);
+}
+
+static struct libnet_bgp4_packer *
+bgp_pack_get(libnet_t *l)
+{
+    struct libnet_bgp4_packer *bp = l->bgp4_packer;
+
+    if (bp)
+    {
+        return (bp);
+    }
+
+    bp = libnet_calloc(l, 1, sizeof (*bp));
+    if (bp == NULL ||
+        (bp->set = libnet_calloc(l, BGP_PACK_SETS_MIN,
+                                 sizeof (*bp->set))) == NULL ||
+        (bp->table = libnet_calloc(l, 2 * BGP_PACK_SETS_MIN,
+                                   sizeof (*bp->table))) == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        if (bp)
+        {
+            libnet_free(bp->set);
+            libnet_free(bp);
+        }
+        return (NULL);
+    }
+    bp->n = 1;                          /* the withdrawn routes */
+    bp->max = BGP_PACK_SETS_MIN;
+    bp->table_s = 2 * BGP_PACK_SETS_MIN;
+
+    l->bgp4_packer = bp;
+    return (bp);
+}
+
+/* doubles the hash table, rehashing the sets */
+static int
+bgp_pack_rehash(libnet_t *l, struct libnet_bgp4_packer *bp)
+{
+    uint32_t *table, size = bp->table_s * 2, i, j;
+
+    table = libnet_calloc(l, size, sizeof (*table));
+    if (table == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+
+    for (i = 1; i < bp->n; i++)
+    {
+        for (j = bp->set[i].hash & (size - 1); table[j];
+             j = (j + 1) & (size - 1))
+            ;
+        table[j] = i;
+    }
+
+    libnet_free(bp->table);
+    bp->table = table;
+    bp->table_s = size;
+    return (1);
+}
+
+int
+libnet_bgp4_packer_attrs(libnet_t *l, const uint8_t *attrs, uint16_t attrs_s)
+{
+    struct libnet_bgp4_packer *bp;
+    struct libnet_bgp4_set *s;
+    uint32_t hash, i;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    /* at least a /32 has to fit next to the attributes */
+    if (attrs_s == 0 || attrs == NULL || attrs_s > BGP_PACK_ROOM - 5)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): need 1 to %d bytes of path attributes", __func__,
+                BGP_PACK_ROOM - 5);
+        return (-1);
+    }
+
+    bp = bgp_pack_get(l);
+    if (bp == NULL)
+    {
+        return (-1);
+    }
+
+    hash = bgp_pack_hash(attrs, attrs_s);
+    for (i = hash & (bp->table_s - 1); bp->table[i];
+         i = (i + 1) & (bp->table_s - 1))
+    {
+        s = &bp->set[bp->table[i]];
+        if (s->hash == hash && s->attrs_s == attrs_s &&
+            memcmp(s->attrs, attrs, attrs_s) == 0)
+        {
+            return ((int)bp->table[i]);
+        }
+    }
+
+    if (bp->n == bp->max)
+    {
+        s = libnet_realloc(l, bp->set, 2 * bp->max * sizeof (*bp->set));
+        if (s == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        memset(s + bp->max, 0, bp->max * sizeof (*s));
+        bp->set = s;
+        bp->max *= 2;
+    }
+
+    s = &bp->set[bp->n];
+    s->attrs = libnet_malloc(l, attrs_s);
+    if (s->attrs == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+    memcpy(s->attrs, attrs, attrs_s);
+    s->attrs_s = attrs_s;
+    s->hash = hash;
+    bp->table[i] = bp->n++;
+
+    if (2 * bp->n > bp->table_s && bgp_pack_rehash(l, bp) == -1)
+    {
+        /* the set is in, the table is just fuller than it should be */
+        return (-1);
+    }
+
+    return ((int)(bp->n - 1));
+}
+
+int
+libnet_bgp4_packer_add(libnet_t *l, int set, uint32_t prefix, uint8_t len)
+{
+    struct libnet_bgp4_packer *bp;
+    struct libnet_bgp4_set *s;
+    uint32_t max, bytes;
+    uint8_t *p;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    bp = set == LIBNET_BGP4_WITHDRAWN ? bgp_pack_get(l) : l->bgp4_packer;
+    if (bp == NULL || set < 0 || (uint32_t)set >= bp->n || len > 32)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no attribute set %d, or prefix length %u over 32",
+                __func__, set, len);
+        return (-1);
+    }
+
+    s = &bp->set[set];
+    if (s->nlri_s + 5 > s->nlri_max)
+    {
+        max = s->nlri_max ? 2 * s->nlri_max : BGP_PACK_NLRI_MIN;
+        p = libnet_realloc(l, s->nlri, max);
+        if (p == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        s->nlri = p;
+        s->nlri_max = max;
+    }
+
+    /* the prefix is in network byte order, bits past len are cleared */
+    if (len < 32)
+    {
+        prefix &= htonl(len ? ~0u << (32 - len) : 0);
+    }
+    bytes = (len + 7) / 8;
+    p = s->nlri + s->nlri_s;
+    p[0] = len;
+    memcpy(p + 1, &prefix, bytes);
+    s->nlri_s += 1 + bytes;
+
+    return (1);
+}
+
+/* starts an UPDATE at p, returns where the NLRI or withdrawn routes go */
+static uint8_t *
+bgp_pack_header(uint8_t *p, const struct libnet_bgp4_set *s)
+{
+    memset(p, 0xff, LIBNET_BGP4_MARKER_SIZE);
+    p[18] = LIBNET_BGP4_UPDATE;
+    p += LIBNET_BGP4_HEADER_H;
+
+    if (s->attrs_s)
+    {
+        p[0] = 0;                       /* no withdrawn routes */
+        p[1] = 0;
+        p[2] = (uint8_t)(s->attrs_s >> 8);
+        p[3] = (uint8_t)s->attrs_s;
+        memcpy(p + 4, s->attrs, s->attrs_s);
+        return (p + 4 + s->attrs_s);
+    }
+    return (p + 2);                     /* the withdrawn routes length later */
+}
+
+int
+libnet_bgp4_packer_pack(libnet_t *l, uint8_t **buf, uint32_t *buf_s)
+{
+    struct libnet_bgp4_packer *bp;
+    const struct libnet_bgp4_set *s;
+    uint8_t *out = NULL, *msg, *p, *q;
+    uint32_t i, off, room, chunk, size = 0, max = 0, len;
+    int messages = 0;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (buf == NULL || buf_s == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL buffer",
+                __func__);
+        return (-1);
+    }
+
+    bp = l->bgp4_packer;
+    for (i = 0; bp && i < bp->n; i++)
+    {
+        s = &bp->set[i];
+        room = BGP_PACK_ROOM - s->attrs_s;
+
+        for (off = 0; off < s->nlri_s; off += chunk)
+        {
+            /* as many whole prefixes as fit */
+            p = s->nlri + off;
+            q = s->nlri + s->nlri_s;
+            if ((uint32_t)(q - p) > room)
+            {
+                q = p;
+                while (q + 1 + (q[0] + 7) / 8 <= p + room)
+                {
+                    q += 1 + (q[0] + 7) / 8;
+                }
+            }
+            chunk = (uint32_t)(q - p);
+
+            if (size + LIBNET_BGP4_MAX_MESSAGE > max)
+            {
+                max = max ? 2 * max : 16 * LIBNET_BGP4_MAX_MESSAGE;
+                msg = libnet_realloc(l, out, max);
+                if (msg == NULL)
+                {
+                    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                            "%s(): realloc(): %s", __func__, strerror(errno));
+                    libnet_free(out);
+                    return (-1);
+                }
+                out = msg;
+            }
+
+            msg = out + size;
+            p = bgp_pack_header(msg, s);
+            memcpy(p, s->nlri + off, chunk);
+            if (i == 0)
+            {
+                /* withdrawn routes, and no path attributes */
+                p[-2] = (uint8_t)(chunk >> 8);
+                p[-1] = (uint8_t)chunk;
+                p[chunk] = 0;
+                p[chunk + 1] = 0;
+                len = (uint32_t)(p - msg) + chunk + 2;
+            }
+            else
+            {
+                len = (uint32_t)(p - msg) + chunk;
+            }
+            msg[16] = (uint8_t)(len >> 8);
+            msg[17] = (uint8_t)len;
+
+            size += len;
+            messages++;
+        }
+    }
+
+    *buf = out;
+    *buf_s = size;
+    return (messages);
+}
+
+void
+libnet_bgp4_packer_free(libnet_t *l)
+{
+    struct libnet_bgp4_packer *bp;
+    uint32_t i;
+
+    if (l == NULL || (bp = l->bgp4_packer) == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < bp->n; i++)
+    {
+        libnet_free(bp->set[i].attrs);
+        libnet_free(bp->set[i].nlri);
+    }
+    libnet_free(bp->set);
+    libnet_free(bp->table);
+    libnet_free(bp);
+    l->bgp4_packer = NULL;
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
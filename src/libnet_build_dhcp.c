@@ -132,6 +132,181 @@ libnet_t *l, libnet_ptag_t ptag)
         l, ptag));
 }
 
+/* how libnet_dhcp_options() encodes num for an option without val */
+#define DHCP_NUM_NONE   0
+#define DHCP_NUM_U8     1
+#define DHCP_NUM_U16    2
+#define DHCP_NUM_U32    4
+#define DHCP_NUM_ADDR   5               /* 4 bytes, already in network order */
+
+static int
+dhcp_num_kind(uint8_t code)
+{
+    switch (code)
+    {
+        case LIBNET_DHCP_IPFORWARD:
+        case LIBNET_DHCP_SRCROUTE:
+        case LIBNET_DHCP_IPTTL:
+        case LIBNET_DHCP_LOCALSUBNETS:
+        case LIBNET_DHCP_DOMASKDISCOV:
+        case LIBNET_DHCP_MASKSUPPLY:
+        case LIBNET_DHCP_DOROUTEDISC:
+        case LIBNET_DHCP_TRAILERENCAP:
+        case LIBNET_DHCP_ETHERENCAP:
+        case LIBNET_DHCP_TCPTTL:
+        case LIBNET_DHCP_TCPALIVEGARBAGE:
+        case LIBNET_DHCP_NBTCPIP:
+        case LIBNET_DHCP_OPTIONOVERLOAD:
+        case LIBNET_DHCP_MESSAGETYPE:
+            return (DHCP_NUM_U8);
+        case LIBNET_DHCP_BOOTFILESIZE:
+        case LIBNET_DHCP_MAXASMSIZE:
+        case LIBNET_DHCP_MTUSIZE:
+        case LIBNET_DHCP_MAXMSGSIZE:
+            return (DHCP_NUM_U16);
+        case LIBNET_DHCP_TIMEOFFSET:
+        case LIBNET_DHCP_MTUTIMEOUT:
+        case LIBNET_DHCP_ARPTIMEOUT:
+        case LIBNET_DHCP_TCPKEEPALIVE:
+        case LIBNET_DHCP_LEASETIME:
+        case LIBNET_DHCP_RENEWTIME:
+        case LIBNET_DHCP_REBINDTIME:
+            return (DHCP_NUM_U32);
+        case LIBNET_DHCP_SUBNETMASK:
+        case LIBNET_DHCP_SWAPSERV:
+        case LIBNET_DHCP_BROADCASTADDR:
+        case LIBNET_DHCP_ROUTERSOLICIT:
+        case LIBNET_DHCP_DISCOVERADDR:
+        case LIBNET_DHCP_SERVIDENT:
+            return (DHCP_NUM_ADDR);
+        default:
+            return (DHCP_NUM_NONE);
+    }
+}
+
+int
+libnet_dhcp_options(libnet_t *l, const struct libnet_dhcp_option *opt,
+uint32_t opt_n, uint8_t *buf, uint32_t buf_s)
+{
+    const struct libnet_dhcp_option *o;
+    const uint8_t *val;
+    uint8_t num[4];
+    uint32_t i, n, val_s, chunk, min;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    if (buf == NULL || (opt_n && opt == NULL))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): NULL buffer or options", __func__);
+        return (-1);
+    }
+
+    n = 0;
+    for (i = 0; i < opt_n; i++)
+    {
+        o = &opt[i];
+        if (o->code == LIBNET_DHCP_PAD || o->code == LIBNET_DHCP_END)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): option %u: PAD and END are added as needed",
+                    __func__, i);
+            return (-1);
+        }
+
+        if (o->val)
+        {
+            val   = o->val;
+            val_s = o->val_s;
+        }
+        else
+        {
+            val   = num;
+            val_s = 0;
+            switch (dhcp_num_kind(o->code))
+            {
+                case DHCP_NUM_U8:
+                    if (o->num > 0xff)
+                    {
+                        break;
+                    }
+                    num[0] = (uint8_t)o->num;
+                    val_s = 1;
+                    break;
+                case DHCP_NUM_U16:
+                    if (o->num > 0xffff)
+                    {
+                        break;
+                    }
+                    num[0] = (uint8_t)(o->num >> 8);
+                    num[1] = (uint8_t)o->num;
+                    val_s = 2;
+                    break;
+                case DHCP_NUM_U32:
+                    num[0] = (uint8_t)(o->num >> 24);
+                    num[1] = (uint8_t)(o->num >> 16);
+                    num[2] = (uint8_t)(o->num >> 8);
+                    num[3] = (uint8_t)o->num;
+                    val_s = 4;
+                    break;
+                case DHCP_NUM_ADDR:
+                    memcpy(num, &o->num, 4);
+                    val_s = 4;
+                    break;
+            }
+            if (val_s == 0)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): option %u (code %u): no value, or num out of range",
+                        __func__, i, o->code);
+                return (-1);
+            }
+        }
+
+        /* RFC 3396: a long value goes into consecutive options of its code */
+        do
+        {
+            chunk = val_s > 255 ? 255 : val_s;
+            if (buf_s - n < 2 + chunk)
+            {
+                goto full;
+            }
+            buf[n++] = o->code;
+            buf[n++] = (uint8_t)chunk;
+            memcpy(buf + n, val, chunk);
+            n     += chunk;
+            val   += chunk;
+            val_s -= chunk;
+        } while (val_s);
+    }
+
+    if (n == buf_s)
+    {
+        goto full;
+    }
+    buf[n++] = LIBNET_DHCP_END;
+
+    /* BOOTP relays may drop anything shorter */
+    min = LIBNET_BOOTP_MIN_LEN - LIBNET_DHCPV4_H;
+    if (n < min)
+    {
+        if (buf_s < min)
+        {
+            goto full;
+        }
+        memset(buf + n, LIBNET_DHCP_PAD, min - n);
+        n = min;
+    }
+    return ((int)n);
+
+full:
+    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+            "%s(): options do not fit in %u bytes", __func__, buf_s);
+    return (-1);
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
@@ -109,6 +109,679 @@ bad:
     return (-1);
 }
 
+/*
+ *  The encoder appends the question and resource record sections to a
+ *  growing buffer, which libnet_build_dns_message() hands to
+ *  libnet_build_dnsv4() as payload.  Names are compressed (RFC 1035 4.1.4):
+ *  every name suffix written out in full is entered in a hash table, open
+ *  addressing with linear probing, keyed on its lowercased wire form, so a
+ *  later name sharing a suffix costs one lookup per label and is ended with
+ *  a pointer.  Offsets count from the start of the DNS header.
+ */
+#define DNS_MSG_MIN     512
+#define DNS_NAMES_MIN   64              /* a power of two */
+#define DNS_PTR_MAX     0x3fff          /* furthest a pointer reaches */
+
+struct libnet_dns_name
+{
+    uint32_t hash;
+    uint16_t off;                       /* 0 for a free slot */
+};
+
+struct libnet_dns
+{
+    uint8_t *msg;                       /* sections, after the header */
+    uint32_t msg_s;
+    uint32_t msg_max;
+    uint16_t count[4];                  /* questions, then per section */
+    uint8_t section;                    /* last section added to */
+    uint8_t edns0;                      /* OPT RR added */
+    struct libnet_dns_name *names;      /* compression targets */
+    uint32_t names_n;
+    uint32_t names_s;                   /* a power of two, > 2 * names_n */
+    libnet_ptag_t ptag;                 /* last libnet_build_dns_message() */
+    uint16_t h_len;
+};
+
+static struct libnet_dns *
+dns_get(libnet_t *l)
+{
+    struct libnet_dns *d = l->dns;
+
+    if (d)
+    {
+        return (d);
+    }
+
+    d = libnet_calloc(l, 1, sizeof (*d));
+    if (d == NULL ||
+        (d->msg = libnet_malloc(l, DNS_MSG_MIN)) == NULL ||
+        (d->names = libnet_calloc(l, DNS_NAMES_MIN,
+                                  sizeof (*d->names))) == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        if (d)
+        {
+            libnet_free(d->msg);
+            libnet_free(d);
+        }
+        return (NULL);
+    }
+    d->msg_max = DNS_MSG_MIN;
+    d->names_s = DNS_NAMES_MIN;
+
+    l->dns = d;
+    return (d);
+}
+
+/* makes room for len more bytes */
+static int
+dns_room(libnet_t *l, struct libnet_dns *d, uint32_t len)
+{
+    uint32_t max = d->msg_max;
+    uint8_t *msg;
+
+    if (LIBNET_UDP_DNSV4_H + d->msg_s + len > LIBNET_DNS_MAX_MESSAGE)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): message larger than %d bytes", __func__,
+                LIBNET_DNS_MAX_MESSAGE);
+        return (-1);
+    }
+    if (d->msg_s + len <= max)
+    {
+        return (1);
+    }
+    while (d->msg_s + len > max)
+    {
+        max *= 2;
+    }
+    msg = libnet_realloc(l, d->msg, max);
+    if (msg == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+    d->msg = msg;
+    d->msg_max = max;
+    return (1);
+}
+
+static void
+dns_put16(struct libnet_dns *d, uint16_t v)
+{
+    d->msg[d->msg_s++] = (uint8_t)(v >> 8);
+    d->msg[d->msg_s++] = (uint8_t)v;
+}
+
+static void
+dns_put32(struct libnet_dns *d, uint32_t v)
+{
+    dns_put16(d, (uint16_t)(v >> 16));
+    dns_put16(d, (uint16_t)v);
+}
+
+static uint8_t
+dns_lower(uint8_t c)
+{
+    return ((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+}
+
+/* FNV-1a of a wire format name, case folded, the root label left out */
+static uint32_t
+dns_hash(const uint8_t *name)
+{
+    uint32_t h = 2166136261u;
+
+    /* length bytes are below 64, so folding leaves them alone */
+    while (*name)
+    {
+        h = (h ^ dns_lower(*name++)) * 16777619u;
+    }
+    return (h);
+}
+
+/*
+ *  Whether the name at message offset off, pointers followed, is name.
+ *  Both end with the root label; names in the table are well formed.
+ */
+static int
+dns_name_equal(const struct libnet_dns *d, uint16_t off, const uint8_t *name)
+{
+    const uint8_t *p = d->msg + off - LIBNET_UDP_DNSV4_H;
+    uint8_t i;
+
+    while (1)
+    {
+        if ((*p & 0xc0) == 0xc0)
+        {
+            off = (uint16_t)((p[0] & 0x3f) << 8 | p[1]);
+            p = d->msg + off - LIBNET_UDP_DNSV4_H;
+            continue;
+        }
+        if (*p != *name)
+        {
+            return (0);
+        }
+        if (*p == 0)
+        {
+            return (1);
+        }
+        for (i = 1; i <= *p; i++)
+        {
+            if (dns_lower(p[i]) != dns_lower(name[i]))
+            {
+                return (0);
+            }
+        }
+        p += i;
+        name += i;
+    }
+}
+
+static int
+dns_names_grow(libnet_t *l, struct libnet_dns *d)
+{
+    struct libnet_dns_name *names;
+    uint32_t size = d->names_s * 2, i, j;
+
+    names = libnet_calloc(l, size, sizeof (*names));
+    if (names == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+
+    for (i = 0; i < d->names_s; i++)
+    {
+        if (d->names[i].off == 0)
+        {
+            continue;
+        }
+        for (j = d->names[i].hash & (size - 1); names[j].off;
+             j = (j + 1) & (size - 1))
+            ;
+        names[j] = d->names[i];
+    }
+
+    libnet_free(d->names);
+    d->names = names;
+    d->names_s = size;
+    return (1);
+}
+
+/*
+ *  Appends name, compressed against the names already in the message
+ *  unless compress is 0, and enters its new suffixes in the table.
+ */
+static int
+dns_name(libnet_t *l, struct libnet_dns *d, const char *name, int compress)
+{
+    uint8_t wire[LIBNET_DNS_MAX_NAME + 1];
+    uint32_t hash[LIBNET_DNS_MAX_NAME / 2 + 1];
+    uint8_t lab[LIBNET_DNS_MAX_NAME / 2 + 1];
+    uint32_t n = 0, nl = 0, full, i, j, len;
+    uint16_t ptr = 0;
+    const char *c;
+
+    if (name == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL name", __func__);
+        return (-1);
+    }
+
+    /* text to wire format, one label per dot, a trailing dot optional */
+    for (c = name; *c; )
+    {
+        if (*c == '.' && c == name && c[1] == '\0')
+        {
+            break;                      /* "." is the root */
+        }
+        for (len = 0; c[len] && c[len] != '.'; len++)
+            ;
+        if (len == 0 || len > LIBNET_DNS_MAX_LABEL ||
+            n + 1 + len + 1 > LIBNET_DNS_MAX_NAME)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): bad name \"%s\"", __func__, name);
+            return (-1);
+        }
+        lab[nl++] = (uint8_t)n;
+        wire[n++] = (uint8_t)len;
+        memcpy(wire + n, c, len);
+        n += len;
+        c += len;
+        if (*c == '.')
+        {
+            c++;
+        }
+    }
+    wire[n++] = 0;
+
+    /* the longest suffix already in the message ends it as a pointer */
+    full = nl;
+    for (i = 0; i < nl; i++)
+    {
+        hash[i] = dns_hash(wire + lab[i]);
+        if (!compress)
+        {
+            continue;
+        }
+        for (j = hash[i] & (d->names_s - 1); d->names[j].off;
+             j = (j + 1) & (d->names_s - 1))
+        {
+            if (d->names[j].hash == hash[i] &&
+                dns_name_equal(d, d->names[j].off, wire + lab[i]))
+            {
+                ptr = d->names[j].off;
+                break;
+            }
+        }
+        if (ptr)
+        {
+            full = i;
+            break;
+        }
+    }
+
+    len = ptr ? lab[full] + 2u : n;
+    if (dns_room(l, d, len) == -1)
+    {
+        return (-1);
+    }
+
+    /* the suffixes written out in full */
+    for (i = 0; i < full; i++)
+    {
+        const uint32_t off = LIBNET_UDP_DNSV4_H + d->msg_s + lab[i];
+
+        if (off > DNS_PTR_MAX)
+        {
+            break;
+        }
+        if (2 * (d->names_n + 1) >= d->names_s &&
+            dns_names_grow(l, d) == -1)
+        {
+            return (-1);
+        }
+        for (j = hash[i] & (d->names_s - 1); d->names[j].off;
+             j = (j + 1) & (d->names_s - 1))
+            ;
+        d->names[j].hash = hash[i];
+        d->names[j].off = (uint16_t)off;
+        d->names_n++;
+    }
+
+    if (ptr)
+    {
+        memcpy(d->msg + d->msg_s, wire, len - 2);
+        d->msg_s += len - 2;
+        dns_put16(d, 0xc000 | ptr);
+    }
+    else
+    {
+        memcpy(d->msg + d->msg_s, wire, n);
+        d->msg_s += n;
+    }
+    return (1);
+}
+
+/*
+ *  Drops whatever a failed call appended past msg_s, compression targets
+ *  included, so the message stays well formed.
+ */
+static void
+dns_truncate(struct libnet_dns *d, uint32_t msg_s)
+{
+    const uint32_t end = LIBNET_UDP_DNSV4_H + msg_s;
+    struct libnet_dns_name keep;
+    uint32_t i, j;
+
+    d->msg_s = msg_s;
+    for (i = 0; i < d->names_s; i++)
+    {
+        if (d->names[i].off >= end)
+        {
+            d->names[i].off = 0;
+            d->names_n--;
+        }
+    }
+    /* reinsert the rest, a removal may have broken a probe sequence */
+    for (i = 0; i < d->names_s; i++)
+    {
+        if (d->names[i].off == 0)
+        {
+            continue;
+        }
+        keep = d->names[i];
+        d->names[i].off = 0;
+        for (j = keep.hash & (d->names_s - 1); d->names[j].off;
+             j = (j + 1) & (d->names_s - 1))
+            ;
+        d->names[j] = keep;
+    }
+}
+
+/* common to the RR adders: checks the section, writes the owner name */
+static struct libnet_dns *
+dns_rr_start(libnet_t *l, uint8_t section, const char *name, uint16_t type,
+        uint16_t class, uint32_t ttl, uint32_t *msg_s)
+{
+    struct libnet_dns *d;
+
+    if (l == NULL)
+    {
+        return (NULL);
+    }
+    if (section < LIBNET_DNS_ANSWER || section > LIBNET_DNS_ADDITIONAL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): bad section %d", __func__, section);
+        return (NULL);
+    }
+    d = dns_get(l);
+    if (d == NULL)
+    {
+        return (NULL);
+    }
+    if (section < d->section || d->edns0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): sections must be added in order, OPT last", __func__);
+        return (NULL);
+    }
+    if (d->count[section] == UINT16_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): too many records in section %d", __func__, section);
+        return (NULL);
+    }
+
+    *msg_s = d->msg_s;
+    if (dns_name(l, d, name, 1) == -1 || dns_room(l, d, 10) == -1)
+    {
+        dns_truncate(d, *msg_s);
+        return (NULL);
+    }
+    dns_put16(d, type);
+    dns_put16(d, class);
+    dns_put32(d, ttl);
+    dns_put16(d, 0);                    /* RDLENGTH, see dns_rr_end() */
+    return (d);
+}
+
+static int
+dns_rr_end(struct libnet_dns *d, uint8_t section, uint32_t rdata_off)
+{
+    const uint32_t rdlength = d->msg_s - rdata_off;
+
+    d->msg[rdata_off - 2] = (uint8_t)(rdlength >> 8);
+    d->msg[rdata_off - 1] = (uint8_t)rdlength;
+    d->section = section;
+    d->count[section]++;
+    return (1);
+}
+
+int
+libnet_dns_question(libnet_t *l, const char *name, uint16_t type,
+        uint16_t class)
+{
+    struct libnet_dns *d;
+    uint32_t msg_s;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    d = dns_get(l);
+    if (d == NULL)
+    {
+        return (-1);
+    }
+    if (d->section || d->edns0 || d->count[0] == UINT16_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): questions must come before any resource record",
+                __func__);
+        return (-1);
+    }
+
+    msg_s = d->msg_s;
+    if (dns_name(l, d, name, 1) == -1 || dns_room(l, d, 4) == -1)
+    {
+        dns_truncate(d, msg_s);
+        return (-1);
+    }
+    dns_put16(d, type);
+    dns_put16(d, class);
+    d->count[0]++;
+    return (1);
+}
+
+int
+libnet_dns_rr(libnet_t *l, uint8_t section, const char *name, uint16_t type,
+        uint16_t class, uint32_t ttl, const uint8_t *rdata, uint16_t rdata_s)
+{
+    struct libnet_dns *d;
+    uint32_t msg_s;
+
+    d = dns_rr_start(l, section, name, type, class, ttl, &msg_s);
+    if (d == NULL)
+    {
+        return (-1);
+    }
+    if (rdata_s && rdata == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL rdata",
+                __func__);
+        dns_truncate(d, msg_s);
+        return (-1);
+    }
+    if (dns_room(l, d, rdata_s) == -1)
+    {
+        dns_truncate(d, msg_s);
+        return (-1);
+    }
+    if (rdata_s)
+    {
+        memcpy(d->msg + d->msg_s, rdata, rdata_s);
+    }
+    d->msg_s += rdata_s;
+    return (dns_rr_end(d, section, d->msg_s - rdata_s));
+}
+
+int
+libnet_dns_rr_a(libnet_t *l, uint8_t section, const char *name,
+        uint32_t ttl, uint32_t addr)
+{
+    return (libnet_dns_rr(l, section, name, LIBNET_DNS_TYPE_A,
+            LIBNET_DNS_CLASS_IN, ttl, (const uint8_t *)&addr, 4));
+}
+
+int
+libnet_dns_rr_aaaa(libnet_t *l, uint8_t section, const char *name,
+        uint32_t ttl, struct libnet_in6_addr addr)
+{
+    return (libnet_dns_rr(l, section, name, LIBNET_DNS_TYPE_AAAA,
+            LIBNET_DNS_CLASS_IN, ttl, (const uint8_t *)&addr, 16));
+}
+
+/* RDATA of a domain name, optionally after a 16-bit preference */
+static int
+dns_rr_target(libnet_t *l, uint8_t section, const char *name, uint16_t type,
+        uint32_t ttl, int pref, const char *target)
+{
+    struct libnet_dns *d;
+    uint32_t msg_s, rdata_off;
+
+    d = dns_rr_start(l, section, name, type, LIBNET_DNS_CLASS_IN, ttl,
+            &msg_s);
+    if (d == NULL)
+    {
+        return (-1);
+    }
+    rdata_off = d->msg_s;
+    if (pref >= 0)
+    {
+        if (dns_room(l, d, 2) == -1)
+        {
+            dns_truncate(d, msg_s);
+            return (-1);
+        }
+        dns_put16(d, (uint16_t)pref);
+    }
+    if (dns_name(l, d, target, 1) == -1)
+    {
+        dns_truncate(d, msg_s);
+        return (-1);
+    }
+    return (dns_rr_end(d, section, rdata_off));
+}
+
+int
+libnet_dns_rr_name(libnet_t *l, uint8_t section, const char *name,
+        uint16_t type, uint32_t ttl, const char *target)
+{
+    return (dns_rr_target(l, section, name, type, ttl, -1, target));
+}
+
+int
+libnet_dns_rr_mx(libnet_t *l, uint8_t section, const char *name,
+        uint32_t ttl, uint16_t pref, const char *exchange)
+{
+    return (dns_rr_target(l, section, name, LIBNET_DNS_TYPE_MX, ttl, pref,
+            exchange));
+}
+
+int
+libnet_dns_edns0(libnet_t *l, uint16_t udp_size, uint8_t ext_rcode,
+        uint8_t version, uint16_t flags, const uint8_t *options,
+        uint16_t options_s)
+{
+    const uint32_t ttl = (uint32_t)ext_rcode << 24 |
+        (uint32_t)version << 16 | flags;
+
+    /* RFC 6891: the root name, the payload size in place of the class */
+    if (libnet_dns_rr(l, LIBNET_DNS_ADDITIONAL, ".", LIBNET_DNS_TYPE_OPT,
+            udp_size, ttl, options, options_s) == -1)
+    {
+        return (-1);
+    }
+    l->dns->edns0 = 1;
+    return (1);
+}
+
+libnet_ptag_t
+libnet_build_dns_message(uint16_t h_len, uint16_t id, uint16_t flags,
+        libnet_t *l, libnet_ptag_t ptag)
+{
+    struct libnet_dns *d;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    d = dns_get(l);
+    if (d == NULL)
+    {
+        return (-1);
+    }
+
+    ptag = libnet_build_dnsv4(h_len, id, flags, d->count[0],
+            d->count[LIBNET_DNS_ANSWER], d->count[LIBNET_DNS_AUTHORITY],
+            d->count[LIBNET_DNS_ADDITIONAL], d->msg, d->msg_s, l, ptag);
+    if (ptag != -1)
+    {
+        d->ptag = ptag;
+        d->h_len = h_len;
+    }
+    return (ptag);
+}
+
+int
+libnet_dns_template(libnet_t *l, uint32_t flags)
+{
+    struct libnet_vary_spec spec;
+    struct libnet_dns *d;
+    uint32_t off;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    d = l->dns;
+    if (d == NULL || d->ptag == 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no message built by libnet_build_dns_message()",
+                __func__);
+        return (-1);
+    }
+
+    /* the ID follows the TCP length, if any */
+    off = d->h_len - LIBNET_UDP_DNSV4_H;
+
+    if (flags & LIBNET_DNS_TEMPLATE_QNAME)
+    {
+        if (d->count[0] == 0 || d->msg[0] == 0)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): no question, or a root QNAME, to vary", __func__);
+            return (-1);
+        }
+        memset(&spec, 0, sizeof (spec));
+        spec.op    = LIBNET_VARY_LABEL;
+        spec.width = d->msg[0];
+        if (libnet_vary_add(l, d->ptag, d->h_len + 1, &spec) == -1)
+        {
+            return (-1);
+        }
+    }
+    if (flags & LIBNET_DNS_TEMPLATE_ID)
+    {
+        memset(&spec, 0, sizeof (spec));
+        spec.op    = LIBNET_VARY_RANDOM;
+        spec.width = 2;
+        spec.max   = 0xffff;
+        if (libnet_vary_add(l, d->ptag, off, &spec) == -1)
+        {
+            return (-1);
+        }
+    }
+    return (1);
+}
+
+void
+libnet_dns_clear_ptag(libnet_t *l)
+{
+    if (l == NULL || l->dns == NULL)
+    {
+        return;
+    }
+
+    l->dns->ptag  = 0;
+    l->dns->h_len = 0;
+}
+
+void
+libnet_dns_free(libnet_t *l)
+{
+    struct libnet_dns *d;
+
+    if (l == NULL || (d = l->dns) == NULL)
+    {
+        return;
+    }
+
+    libnet_free(d->msg);
+    libnet_free(d->names);
+    libnet_free(d);
+    l->dns = NULL;
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
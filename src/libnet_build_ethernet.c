@@ -46,6 +46,7 @@ const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag)
 
     /* sanity check injection type if we're not in advanced mode */
     if (l->injection_type != LIBNET_LINK &&
+            l->injection_type != LIBNET_SHM &&
             !(((l->injection_type) & LIBNET_ADV_MASK)))
     {
          snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -104,6 +105,7 @@ libnet_autobuild_ethernet(const uint8_t *dst, uint16_t type, libnet_t *l)
 
     /* sanity check injection type if we're not in advanced mode */
     if (l->injection_type != LIBNET_LINK &&
+            l->injection_type != LIBNET_SHM &&
             !(((l->injection_type) & LIBNET_ADV_MASK)))
     {
          snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
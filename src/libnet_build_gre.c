@@ -371,7 +371,7 @@ libnet_build_gre_last_sre(libnet_t *l, libnet_ptag_t ptag)
         l,
         ptag,
         n,
-        LIBNET_PBLOCK_GRE_H);
+        LIBNET_PBLOCK_GRE_SRE_H);
     if (p == NULL)
     {
         return (-1);
@@ -395,6 +395,10 @@ libnet_ptag_t ptag)
         /* fix the IP header sizes */
         if (p_temp->type == LIBNET_PBLOCK_IPV4_H)
         {
+            if (libnet_pblock_own(l, p_temp) == -1)
+            {
+                goto bad;
+            }
             struct libnet_ipv4_hdr * const ip_hdr = (struct libnet_ipv4_hdr *) p_temp->buf;
             ip_hdr->ip_hl = 5 + adj_size / 4; /* 4 bits wide, so no byte order concerns */
             ip_hdr->ip_len = htons(ntohs(ip_hdr->ip_len) + options_size_increase);
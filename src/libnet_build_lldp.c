@@ -281,6 +281,390 @@ bad:
     return (-1);
 }
 
+/* offsets of the TLVs libnet_lldp_patch() rewrites, when there are none */
+#define LLDP_NONE UINT32_MAX
+
+/* longest Chassis or Port ID string */
+#define LLDP_ID_MAX 255
+
+/* the LLDPDU last built with libnet_build_lldp() */
+struct libnet_lldp
+{
+    uint8_t *arena;                     /* the LLDPDU, serialized */
+    uint32_t arena_s;                   /* bytes allocated for it */
+    uint32_t n;                         /* its length */
+    uint32_t port;                      /* offset of the Port ID TLV */
+    uint32_t ttl;                       /* offset of the TTL TLV */
+    libnet_ptag_t ptag;                 /* its pblock, 0 if none */
+    uint32_t cap;                       /* bytes allocated for the pblock */
+};
+
+static struct libnet_lldp *
+lldp_get(libnet_t *l)
+{
+    struct libnet_lldp *t = l->lldp;
+
+    if (t)
+    {
+        return (t);
+    }
+
+    t = libnet_calloc(l, 1, sizeof (*t));
+    if (t == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): calloc(): %s", __func__, strerror(errno));
+        return (NULL);
+    }
+
+    l->lldp = t;
+    return (t);
+}
+
+/* makes room for an LLDPDU of len bytes in the arena */
+static int
+lldp_room(libnet_t *l, struct libnet_lldp *t, uint32_t len)
+{
+    uint32_t size = t->arena_s ? t->arena_s : 256;
+    uint8_t *arena;
+
+    if (len <= t->arena_s)
+    {
+        return (1);
+    }
+    while (size < len)
+    {
+        size *= 2;
+    }
+
+    arena = libnet_realloc(l, t->arena, size);
+    if (arena == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): realloc(): %s", __func__, strerror(errno));
+        return (-1);
+    }
+    t->arena   = arena;
+    t->arena_s = size;
+    return (1);
+}
+
+static void
+lldp_tlv_header(uint8_t *buf, uint8_t type, uint16_t len)
+{
+    uint16_t tlv_info = 0;
+
+    LIBNET_LLDP_TLV_SET_TYPE(tlv_info, type);
+    LIBNET_LLDP_TLV_SET_LEN(tlv_info, len);
+    buf[0] = tlv_info >> 8;
+    buf[1] = tlv_info & 0xff;
+}
+
+/*
+ *  Resizes the pblock for an LLDPDU of n bytes.  The one of the template
+ *  keeps its buffer as long as the LLDPDU fits in it; otherwise the pblock
+ *  is probed with room for a Port ID of LLDP_ID_MAX bytes, cap, so that
+ *  libnet_lldp_patch() never has to reallocate it.  *kept tells whether the
+ *  buffer still holds the previous LLDPDU.
+ */
+static libnet_pblock_t *
+lldp_pblock(libnet_t *l, struct libnet_lldp *t, libnet_ptag_t ptag,
+        uint32_t n, uint32_t cap, int *kept)
+{
+    libnet_pblock_t *p;
+    uint8_t *buf;
+
+    if (ptag && ptag == t->ptag)
+    {
+        p = libnet_pblock_find(l, ptag);
+        if (p == NULL)
+        {
+            /* err msg set in libnet_pblock_find() */
+            return (NULL);
+        }
+        /* a clone may share the buffer, the copy is only as long as b_len */
+        buf = p->buf;
+        if (libnet_pblock_own(l, p) == -1)
+        {
+            /* err msg set in libnet_pblock_own() */
+            return (NULL);
+        }
+        if (p->buf != buf)
+        {
+            t->cap = p->b_len;
+        }
+        if (p->type == LIBNET_PBLOCK_LLDP_H && n <= t->cap)
+        {
+            l->total_size = l->total_size - p->b_len + n;
+            p->b_len  = p->h_len = n;
+            p->copied = 0;
+            *kept = 1;
+            return (p);
+        }
+    }
+
+    p = libnet_pblock_probe(l, ptag, cap, LIBNET_PBLOCK_LLDP_H);
+    if (p == NULL)
+    {
+        return (NULL);
+    }
+    l->total_size = l->total_size - p->b_len + n;
+    p->b_len = p->h_len = n;
+    t->cap = cap;
+    *kept = 0;
+    return (p);
+}
+
+LIBNET_API
+libnet_ptag_t
+libnet_build_lldp(const struct libnet_lldp_tlv *tlv, uint32_t tlv_n,
+        libnet_t *l, libnet_ptag_t ptag)
+{
+    struct libnet_lldp *t;
+    libnet_pblock_t *p;
+    uint32_t i, n, len, port, ttl, cap;
+    uint8_t *buf;
+    int kept;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    if (tlv == NULL && tlv_n)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): TLVs are NULL", __func__);
+        return (-1);
+    }
+
+    /* check everything, and size the LLDPDU, before touching the arena */
+    n = LIBNET_LLDP_TLV_HDR_SIZE;       /* End of LLDPDU */
+    port = ttl = LLDP_NONE;
+    cap = 0;
+    for (i = 0; i < tlv_n; i++)
+    {
+        if (tlv[i].type == LIBNET_LLDP_END_LLDPDU || tlv[i].type > 0x7f)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): invalid TLV type %d", __func__, tlv[i].type);
+            return (-1);
+        }
+        if (tlv[i].val == NULL && tlv[i].val_s)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): TLV %d value is NULL", __func__, tlv[i].type);
+            return (-1);
+        }
+
+        len = tlv[i].val ? tlv[i].val_s : sizeof (uint16_t);
+        if (tlv[i].type == LIBNET_LLDP_CHASSIS_ID ||
+            tlv[i].type == LIBNET_LLDP_PORT_ID)
+        {
+            if (len == 0 || len > LLDP_ID_MAX)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): incorrect ID string length: %d", __func__, len);
+                return (-1);
+            }
+            if (tlv[i].type == LIBNET_LLDP_PORT_ID && port == LLDP_NONE)
+            {
+                port = n - LIBNET_LLDP_TLV_HDR_SIZE;
+                cap  = LLDP_ID_MAX - len;
+            }
+            len += LIBNET_LLDP_SUBTYPE_SIZE;
+        }
+        if (tlv[i].type == LIBNET_LLDP_TTL && ttl == LLDP_NONE)
+        {
+            if (len != sizeof (uint16_t))
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): TTL TLV is not 2 bytes long", __func__);
+                return (-1);
+            }
+            ttl = n - LIBNET_LLDP_TLV_HDR_SIZE;
+        }
+        if (len > 0x1ff)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): TLV %d is too long: %d", __func__, tlv[i].type, len);
+            return (-1);
+        }
+        n += LIBNET_LLDP_TLV_HDR_SIZE + len;
+    }
+
+    t = lldp_get(l);
+    if (t == NULL || lldp_room(l, t, n) == -1)
+    {
+        return (-1);
+    }
+
+    for (i = 0, buf = t->arena; i < tlv_n; i++)
+    {
+        len = tlv[i].val ? tlv[i].val_s : sizeof (uint16_t);
+        if (tlv[i].type == LIBNET_LLDP_CHASSIS_ID ||
+            tlv[i].type == LIBNET_LLDP_PORT_ID)
+        {
+            lldp_tlv_header(buf, tlv[i].type, LIBNET_LLDP_SUBTYPE_SIZE + len);
+            buf[2] = tlv[i].subtype;
+            buf += LIBNET_LLDP_TLV_HDR_SIZE + LIBNET_LLDP_SUBTYPE_SIZE;
+        }
+        else
+        {
+            lldp_tlv_header(buf, tlv[i].type, len);
+            buf += LIBNET_LLDP_TLV_HDR_SIZE;
+        }
+
+        if (tlv[i].val)
+        {
+            memcpy(buf, tlv[i].val, len);
+        }
+        else
+        {
+            buf[0] = tlv[i].num >> 8;
+            buf[1] = tlv[i].num & 0xff;
+        }
+        buf += len;
+    }
+    lldp_tlv_header(buf, LIBNET_LLDP_END_LLDPDU, 0);
+
+    p = lldp_pblock(l, t, ptag, n, n + cap, &kept);
+    if (p == NULL)
+    {
+        t->ptag = 0;                    /* the arena no longer matches it */
+        return (-1);
+    }
+
+    if (libnet_pblock_append(l, p, t->arena, n) == -1)
+    {
+        goto bad;
+    }
+
+    if (ptag == 0)
+    {
+        ptag = libnet_pblock_update(l, p, n, LIBNET_PBLOCK_LLDP_H);
+    }
+    t->n    = n;
+    t->port = port;
+    t->ttl  = ttl;
+    t->ptag = ptag;
+    return (ptag);
+bad:
+    libnet_pblock_delete(l, p);
+    t->ptag = 0;
+    return (-1);
+}
+
+LIBNET_API
+int
+libnet_lldp_patch(libnet_t *l, libnet_ptag_t ptag, const uint8_t *port_id,
+        uint8_t port_id_s, uint16_t ttl)
+{
+    struct libnet_lldp *t;
+    libnet_pblock_t *p;
+    uint32_t old, end, n, from;
+    uint8_t *buf;
+    int kept;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    t = l->lldp;
+    if (t == NULL || t->ptag == 0 || t->ptag != ptag)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): ptag %d was not last built by libnet_build_lldp()",
+                __func__, ptag);
+        return (-1);
+    }
+    if (t->port == LLDP_NONE || t->ttl == LLDP_NONE)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): LLDPDU has no Port ID or no TTL TLV", __func__);
+        return (-1);
+    }
+    if (port_id == NULL || port_id_s == 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): incorrect Port ID string", __func__);
+        return (-1);
+    }
+
+    /* the Port ID string as it is now, less the subtype */
+    buf = t->arena + t->port;
+    old = ((buf[0] & 0x01) << 8 | buf[1]) - LIBNET_LLDP_SUBTYPE_SIZE;
+    n   = t->n - old + port_id_s;
+
+    /* a string of a different length moves the TLVs that follow */
+    if (port_id_s != old)
+    {
+        if (lldp_room(l, t, n) == -1)
+        {
+            return (-1);
+        }
+        buf = t->arena + t->port;
+        end = t->port + LIBNET_LLDP_TLV_HDR_SIZE + LIBNET_LLDP_SUBTYPE_SIZE;
+        memmove(t->arena + end + port_id_s, t->arena + end + old,
+                t->n - end - old);
+        lldp_tlv_header(buf, LIBNET_LLDP_PORT_ID,
+                LIBNET_LLDP_SUBTYPE_SIZE + port_id_s);
+        if (t->ttl > t->port)
+        {
+            t->ttl = t->ttl - old + port_id_s;
+        }
+        t->n = n;
+    }
+    memcpy(buf + LIBNET_LLDP_TLV_HDR_SIZE + LIBNET_LLDP_SUBTYPE_SIZE,
+            port_id, port_id_s);
+    t->arena[t->ttl + LIBNET_LLDP_TLV_HDR_SIZE]     = ttl >> 8;
+    t->arena[t->ttl + LIBNET_LLDP_TLV_HDR_SIZE + 1] = ttl & 0xff;
+
+    p = lldp_pblock(l, t, ptag, n, n + LLDP_ID_MAX - port_id_s, &kept);
+    if (p == NULL)
+    {
+        t->ptag = 0;                    /* the arena no longer matches it */
+        return (-1);
+    }
+
+    /* the TLVs before the first one patched are already there */
+    from = 0;
+    if (kept)
+    {
+        from = t->port < t->ttl ? t->port : t->ttl;
+    }
+    if (kept && port_id_s == old)
+    {
+        memcpy(p->buf + t->port, t->arena + t->port,
+                LIBNET_LLDP_TLV_HDR_SIZE + LIBNET_LLDP_SUBTYPE_SIZE + old);
+        memcpy(p->buf + t->ttl, t->arena + t->ttl,
+                LIBNET_LLDP_TLV_HDR_SIZE + sizeof (uint16_t));
+    }
+    else
+    {
+        memcpy(p->buf + from, t->arena + from, n - from);
+    }
+    p->copied = n;
+
+    return (1);
+}
+
+LIBNET_API
+void
+libnet_lldp_free(libnet_t *l)
+{
+    struct libnet_lldp *t;
+
+    if (l == NULL || (t = l->lldp) == NULL)
+    {
+        return;
+    }
+
+    libnet_free(t->arena);
+    libnet_free(t);
+    l->lldp = NULL;
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
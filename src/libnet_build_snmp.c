@@ -32,15 +32,294 @@
 
 #include "common.h"
 
-libnet_ptag_t
-libnet_build_snmp(void)
+/*
+ *  The message is encoded back to front into a buffer on the stack, see
+ *  libnet_build_asn1_rheader(), so no length has to be known in advance or
+ *  patched afterwards, and then copied into the pblock in one go.
+ */
+
+/* varbind value by type, returns NULL on unknown types and overflow */
+static uint8_t *
+snmp_value(uint8_t *data, int *datalen, const struct libnet_snmp_varbind *vb)
+{
+    switch (vb->type)
+    {
+        case ASN_INTEGER:
+            return (libnet_build_asn1_rint(data, datalen, vb->type, vb->num));
+        case LIBNET_SNMP_COUNTER32:
+        case LIBNET_SNMP_GAUGE32:
+        case LIBNET_SNMP_TIMETICKS:
+        case LIBNET_SNMP_COUNTER64:
+            return (libnet_build_asn1_ruint(data, datalen, vb->type,
+                    (uint64_t)vb->num));
+        case ASN_OCTET_STR:
+        case LIBNET_SNMP_IPADDRESS:
+        case LIBNET_SNMP_OPAQUE:
+            return (libnet_build_asn1_rstring(data, datalen, vb->type,
+                    vb->val, (int)vb->val_s));
+        case ASN_OBJECT_ID:
+            return (libnet_build_asn1_robjid(data, datalen, vb->type,
+                    vb->val, (int)vb->val_s));
+        case ASN_NULL:
+        case LIBNET_SNMP_NOSUCHOBJECT:
+        case LIBNET_SNMP_NOSUCHINSTANCE:
+        case LIBNET_SNMP_ENDOFMIBVIEW:
+            return (libnet_build_asn1_rnull(data, datalen, vb->type));
+    }
+    return (NULL);
+}
+
+
+/* VarBindList, last varbind first */
+static uint8_t *
+snmp_varbinds(libnet_t *l, uint8_t *data, int *datalen,
+        const struct libnet_snmp_varbind *vb, uint32_t vb_n)
 {
+    uint8_t * const end = data;
+    uint8_t *vb_end;
+    uint32_t i;
+
+    if (vb_n && vb == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): NULL varbind list", __func__);
+        return (NULL);
+    }
+
+    for (i = vb_n; i-- > 0; )
+    {
+        vb_end = data;
+        data = snmp_value(data, datalen, &vb[i]);
+        if (data)
+        {
+            data = libnet_build_asn1_robjid(data, datalen, ASN_OBJECT_ID,
+                    vb[i].name, (int)vb[i].name_n);
+        }
+        if (data)
+        {
+            data = libnet_build_asn1_rheader(data, datalen,
+                    ASN_SEQUENCE | ASN_CONSTRUCTOR, (int)(vb_end - data));
+        }
+        if (data == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                     "%s(): varbind %u: bad type 0x%02x or OID, or message larger than %d bytes",
+                     __func__, i, vb[i].type, LIBNET_SNMP_MAX_MESSAGE);
+            return (NULL);
+        }
+    }
+
+    data = libnet_build_asn1_rheader(data, datalen,
+            ASN_SEQUENCE | ASN_CONSTRUCTOR, (int)(end - data));
+    if (data == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): message larger than %d bytes", __func__,
+                 LIBNET_SNMP_MAX_MESSAGE);
+    }
+    return (data);
+}
+
+
+/*
+ *  Wraps the message around the PDU that starts at data and ends at the end
+ *  of the buffer, datalen bytes past its start, and puts it in a pblock.
+ */
+static libnet_ptag_t
+snmp_message(libnet_t *l, libnet_ptag_t ptag, uint8_t *data, int datalen,
+        uint8_t version, const uint8_t *community, uint32_t community_s,
+        const uint8_t *payload, uint32_t payload_s)
+{
+    uint8_t * const end = data + (LIBNET_SNMP_MAX_MESSAGE - datalen);
+    uint32_t n;
+
+    if (community_s && community == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): NULL community", __func__);
+        return (-1);
+    }
+
+    data = libnet_build_asn1_rstring(data, &datalen, ASN_OCTET_STR,
+            community, (int)community_s);
+    if (data)
+    {
+        data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER, version);
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_rheader(data, &datalen,
+                ASN_SEQUENCE | ASN_CONSTRUCTOR, (int)(end - data));
+    }
+    if (data == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): message larger than %d bytes", __func__,
+                 LIBNET_SNMP_MAX_MESSAGE);
+        return (-1);
+    }
+
+    n = (uint32_t)(end - data) + payload_s;
+    const uint32_t h = 0;
+
     /*
-     *  We need an ASN.1 BER encoder before we can write this.
+     *  Find the existing protocol block if a ptag is specified, or create
+     *  a new one.
      */
+    libnet_pblock_t * const p = libnet_pblock_probe(
+        l,
+        ptag,
+        n,
+        LIBNET_PBLOCK_SNMP_H);
+    if (p == NULL)
+    {
+        return (-1);
+    }
+
+    if (libnet_pblock_append(l, p, data, (uint32_t)(end - data)) == -1)
+    {
+        goto bad;
+    }
+
+    /* boilerplate payload sanity check / append macro */
+    LIBNET_DO_PAYLOAD(l, p);
+
+    return (ptag ? ptag : libnet_pblock_update(l, p, h, LIBNET_PBLOCK_SNMP_H));
+bad:
+    libnet_pblock_delete(l, p);
     return (-1);
 }
 
+
+libnet_ptag_t
+libnet_build_snmp(uint8_t version, const uint8_t *community,
+uint32_t community_s, uint8_t type, int32_t request_id, int32_t error_status,
+int32_t error_index, const struct libnet_snmp_varbind *vb, uint32_t vb_n,
+const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag)
+{
+    uint8_t buf[LIBNET_SNMP_MAX_MESSAGE];
+    uint8_t * const end = buf + sizeof (buf);
+    int datalen = sizeof (buf);
+    uint8_t *data;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (type < LIBNET_SNMP_GET || type > LIBNET_SNMP_REPORT ||
+        type == LIBNET_SNMP_TRAP)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): bad PDU type 0x%02x, SNMPv1 traps are built by libnet_build_snmp_trap()",
+                 __func__, type);
+        return (-1);
+    }
+
+    /*
+     *  PDU ::= request-id, error-status, error-index, variable-bindings
+     *  GetBulkRequest-PDU has non-repeaters and max-repetitions in place of
+     *  the error fields.
+     */
+    data = snmp_varbinds(l, end, &datalen, vb, vb_n);
+    if (data == NULL)
+    {
+        return (-1);
+    }
+    data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER, error_index);
+    if (data)
+    {
+        data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER,
+                error_status);
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER,
+                request_id);
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_rheader(data, &datalen, type,
+                (int)(end - data));
+    }
+    if (data == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): message larger than %d bytes", __func__,
+                 LIBNET_SNMP_MAX_MESSAGE);
+        return (-1);
+    }
+
+    return (snmp_message(l, ptag, data, datalen, version, community,
+            community_s, payload, payload_s));
+}
+
+
+libnet_ptag_t
+libnet_build_snmp_trap(const uint8_t *community, uint32_t community_s,
+const uint32_t *enterprise, uint32_t enterprise_n, uint32_t agent_addr,
+int32_t generic, int32_t specific, uint32_t timestamp,
+const struct libnet_snmp_varbind *vb, uint32_t vb_n,
+const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag)
+{
+    uint8_t buf[LIBNET_SNMP_MAX_MESSAGE];
+    uint8_t * const end = buf + sizeof (buf);
+    int datalen = sizeof (buf);
+    uint8_t *data;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    /*
+     *  Trap-PDU ::= enterprise, agent-addr, generic-trap, specific-trap,
+     *  time-stamp, variable-bindings
+     */
+    data = snmp_varbinds(l, end, &datalen, vb, vb_n);
+    if (data == NULL)
+    {
+        return (-1);
+    }
+    data = libnet_build_asn1_ruint(data, &datalen, LIBNET_SNMP_TIMETICKS,
+            timestamp);
+    if (data)
+    {
+        data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER, specific);
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_rint(data, &datalen, ASN_INTEGER, generic);
+    }
+    if (data)
+    {
+        /* already in network byte order */
+        data = libnet_build_asn1_rstring(data, &datalen,
+                LIBNET_SNMP_IPADDRESS, (const uint8_t *)&agent_addr,
+                sizeof (agent_addr));
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_robjid(data, &datalen, ASN_OBJECT_ID,
+                enterprise, (int)enterprise_n);
+    }
+    if (data)
+    {
+        data = libnet_build_asn1_rheader(data, &datalen, LIBNET_SNMP_TRAP,
+                (int)(end - data));
+    }
+    if (data == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                 "%s(): bad enterprise OID or message larger than %d bytes",
+                 __func__, LIBNET_SNMP_MAX_MESSAGE);
+        return (-1);
+    }
+
+    return (snmp_message(l, ptag, data, datalen, LIBNET_SNMP_VERSION_1,
+            community, community_s, payload, payload_s));
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
@@ -122,6 +122,10 @@ libnet_build_tcp(
 
         if(ipblock && ipblock->type == LIBNET_PBLOCK_IPV4_H)
         {
+            if (libnet_pblock_own(l, ipblock) == -1)
+            {
+                goto bad;
+            }
             struct libnet_ipv4_hdr * const ip_hdr = (struct libnet_ipv4_hdr *)ipblock->buf;
             const int ip_len = ntohs(ip_hdr->ip_len) + offset;
             ip_hdr->ip_len = htons(ip_len);
@@ -269,6 +273,10 @@ libnet_ptag_t ptag)
             {
                 (i % 4) ? j : j++;
             }
+            if (libnet_pblock_own(l, p_temp) == -1)
+            {
+                goto bad;
+            }
             struct libnet_tcp_hdr * const tcp_hdr = (struct libnet_tcp_hdr *)p_temp->buf;
             tcp_hdr->th_off = j + 5;
             if (!underflow)
@@ -286,6 +294,10 @@ libnet_ptag_t ptag)
         }
         if (p_temp->type == LIBNET_PBLOCK_IPV4_H)
         {
+            if (libnet_pblock_own(l, p_temp) == -1)
+            {
+                goto bad;
+            }
             struct libnet_ipv4_hdr * const ip_hdr = (struct libnet_ipv4_hdr *)p_temp->buf;
             if (!underflow)
             {
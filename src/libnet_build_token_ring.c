@@ -47,6 +47,7 @@ const uint8_t *payload, uint32_t payload_s, libnet_t *l, libnet_ptag_t ptag)
 
     /* sanity check injection type if we're not in advanced mode */
     if (l->injection_type != LIBNET_LINK &&
+            l->injection_type != LIBNET_SHM &&
             !(((l->injection_type) & LIBNET_ADV_MASK)))
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -112,6 +113,7 @@ libnet_t *l)
 
     /* sanity check injection type if we're not in advanced mode */
     if (l->injection_type != LIBNET_LINK &&
+            l->injection_type != LIBNET_SHM &&
             !(((l->injection_type) & LIBNET_ADV_MASK)))
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
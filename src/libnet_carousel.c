@@ -0,0 +1,278 @@
+/*
+ *  libnet
+ *  libnet_carousel.c - precomputed packet carousel
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  The carousel keeps n coalesced frames back to back in one slab.  Each
+ *  frame gets its own cache line aligned slot, and starts l->aligner bytes
+ *  into it, so the network header keeps the alignment libnet_write() would
+ *  give it.  The frame index doubles as the argument to the batch writer.
+ */
+#define LIBNET_CAROUSEL_ALIGN   64
+#define LIBNET_CAROUSEL_ROUND(x) \
+    (((x) + LIBNET_CAROUSEL_ALIGN - 1) & ~(size_t)(LIBNET_CAROUSEL_ALIGN - 1))
+
+/* frames per libnet_write_batch() call */
+#define LIBNET_CAROUSEL_BURST   64
+
+struct libnet_carousel
+{
+    uint8_t *slab;                      /* as returned by libnet_malloc() */
+    struct libnet_frame *frame;         /* frame index into the slab */
+    uint32_t n;                         /* number of frames */
+    uint32_t next;                      /* next frame to send */
+};
+
+/* checksums left to libnet_checksum_batch() for one frame */
+struct libnet_carousel_csum
+{
+    uint32_t ip_offset;
+    uint8_t mode;
+};
+
+int
+libnet_carousel_build(libnet_t *l, uint32_t n,
+        int (*build)(libnet_t *l, uint32_t i, void *arg), void *arg)
+{
+    struct libnet_carousel_csum *csum = NULL;
+    struct libnet_carousel *cl = NULL;
+    uint32_t aligner = 0;
+    uint8_t *packet;
+    size_t size, off;
+    uint32_t i, j;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (n == 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): need at least one packet", __func__);
+        return (-1);
+    }
+
+    cl = libnet_calloc(l, 1, sizeof (*cl));
+    if (cl == NULL ||
+        (cl->frame = libnet_calloc(l, n, sizeof (*cl->frame))) == NULL ||
+        (csum = libnet_calloc(l, n, sizeof (*csum))) == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        goto bad;
+    }
+
+    /*
+     *  Coalesce every variant first, the slab size is only known after.
+     *  IPv4 and TCP/UDP checksums are left out, to be done across all
+     *  frames at once below.
+     */
+    size = 0;
+    l->csum_defer = LIBNET_CSUM_IP | LIBNET_CSUM_L4;
+    for (i = 0; i < n; i++)
+    {
+        if (build && build(l, i, arg) == -1)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): build callback failed for packet %u", __func__, i);
+            goto bad;
+        }
+
+        if (libnet_pblock_coalesce(l, &cl->frame[i].buf,
+                &cl->frame[i].len) == -1)
+        {
+            /* err msg set in libnet_pblock_coalesce() */
+            goto bad;
+        }
+        cl->n = i + 1;
+        csum[i].mode = l->csum_deferred;
+        csum[i].ip_offset = l->csum_ip_offset;
+        aligner = l->aligner;
+        size += LIBNET_CAROUSEL_ROUND(aligner + cl->frame[i].len);
+    }
+    l->csum_defer = 0;
+
+    cl->slab = libnet_malloc(l, size + LIBNET_CAROUSEL_ALIGN - 1);
+    if (cl->slab == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        goto bad;
+    }
+
+    off = LIBNET_CAROUSEL_ROUND((uintptr_t)cl->slab) - (uintptr_t)cl->slab;
+    for (i = 0; i < n; i++)
+    {
+        packet = cl->frame[i].buf;
+
+        cl->frame[i].buf = cl->slab + off + aligner;
+        memcpy(cl->frame[i].buf, packet, cl->frame[i].len);
+        off += LIBNET_CAROUSEL_ROUND(aligner + cl->frame[i].len);
+
+        libnet_adv_free_packet(l, packet);
+    }
+    cl->n = 0;      /* frames are in the slab now */
+
+    /* finish the checksums, a run of frames with the same layout at a time */
+    for (i = 0; i < n; i = j)
+    {
+        for (j = i + 1; j < n; j++)
+        {
+            if (csum[j].mode != csum[i].mode ||
+                csum[j].ip_offset != csum[i].ip_offset)
+            {
+                break;
+            }
+        }
+
+        if (csum[i].mode && libnet_checksum_batch(l, &cl->frame[i], j - i,
+                csum[i].ip_offset, csum[i].mode) == -1)
+        {
+            /* err msg set in libnet_checksum_batch() */
+            goto bad;
+        }
+    }
+    libnet_free(csum);
+
+    cl->n = n;
+    libnet_carousel_free(l);
+    l->carousel = cl;
+
+    return (1);
+
+bad:
+    l->csum_defer = 0;
+    libnet_free(csum);
+    if (cl)
+    {
+        if (cl->frame)
+        {
+            for (i = 0; i < cl->n; i++)
+            {
+                libnet_adv_free_packet(l, cl->frame[i].buf);
+            }
+            libnet_free(cl->frame);
+        }
+        libnet_free(cl->slab);
+        libnet_free(cl);
+    }
+    return (-1);
+}
+
+int
+libnet_carousel_send(libnet_t *l, uint32_t count)
+{
+    struct libnet_carousel *cl;
+    uint32_t sent, burst;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    cl = l->carousel;
+    if (cl == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no carousel, see libnet_carousel_build()", __func__);
+        return (-1);
+    }
+
+    for (sent = 0; sent < count; )
+    {
+        /* up to the end of the slab, then wrap around */
+        burst = cl->n - cl->next;
+        if (burst > count - sent)
+        {
+            burst = count - sent;
+        }
+        if (burst > LIBNET_CAROUSEL_BURST)
+        {
+            burst = LIBNET_CAROUSEL_BURST;
+        }
+
+        c = libnet_write_batch(l, &cl->frame[cl->next], burst);
+        if (c > 0)
+        {
+            sent += c;
+            cl->next = (cl->next + c) % cl->n;
+        }
+        if (c != (int)burst)
+        {
+            /* err msg set in libnet_write_batch() */
+            break;
+        }
+    }
+
+    return ((sent == 0 && count) ? -1 : (int)sent);
+}
+
+const uint8_t *
+libnet_carousel_frame(libnet_t *l, uint32_t i, uint32_t *len)
+{
+    if (l == NULL)
+    {
+        return (NULL);
+    }
+
+    if (l->carousel == NULL || i >= l->carousel->n)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no packet %u in the carousel", __func__, i);
+        return (NULL);
+    }
+    if (len)
+    {
+        *len = l->carousel->frame[i].len;
+    }
+    return (l->carousel->frame[i].buf);
+}
+
+void
+libnet_carousel_free(libnet_t *l)
+{
+    if (l && l->carousel)
+    {
+        libnet_free(l->carousel->slab);
+        libnet_free(l->carousel->frame);
+        libnet_free(l->carousel);
+        l->carousel = NULL;
+    }
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -142,6 +142,32 @@ libnet_do_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len)
 } while(0)
 
 
+static int
+lsa_checksum(libnet_t *l, uint8_t *lsa, const uint8_t *end)
+{
+    uint32_t len;
+
+    if (lsa + LIBNET_OSPF_LSA_H > end)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): lsa hdr not inside packet", __func__);
+        return (-1);
+    }
+
+    len = (uint32_t)lsa[18] << 8 | lsa[19];
+    if (len < LIBNET_OSPF_LSA_H || lsa + len > end)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): lsa length %u not inside packet (%d bytes)", __func__,
+                len, (int)(end - lsa));
+        return (-1);
+    }
+
+    libnet_ospf_lsa_cksum(lsa, len);
+    return (1);
+}
+
+
 /*
  * We are checksumming pblock "q"
  *
@@ -149,8 +175,8 @@ libnet_do_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len)
  * protocol describes the type of "q", expressed as an IPPROTO_ value
  * h_len is the h_len from "q"
  */
-int
-libnet_inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const uint8_t *beg, const uint8_t * end)
+static int
+inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const uint8_t *beg, const uint8_t * end)
 {
     /* will need to update this for ipv6 at some point */
     struct libnet_ipv4_hdr *iph_p = (struct libnet_ipv4_hdr *)iphdr;
@@ -159,6 +185,15 @@ libnet_inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const
     int sum = 0;
     uint8_t ip_nh = 0;
 
+    /*
+     *  An LSA is checksummed on its own, with no pseudo header, so here
+     *  iphdr is the LSA itself, see calculate_ip_offset().
+     */
+    if (protocol == IPPROTO_OSPF_LSA)
+    {
+        return (lsa_checksum(l, iphdr, end));
+    }
+
     /* Check for memory under/over reads/writes. */
     if(iphdr < beg || (iphdr+sizeof(*iph_p)) > end)
     {
@@ -407,72 +442,6 @@ libnet_inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const
             oh_p->ospf_sum = LIBNET_CKSUM_CARRY(sum);
             break;
         }
-        case IPPROTO_OSPF_LSA:
-        {
-            struct libnet_ospf_hdr *oh_p =
-                (struct libnet_ospf_hdr *)(iphdr + ip_hl);
-            struct libnet_lsa_hdr *lsa_p =
-                (struct libnet_lsa_hdr *)(iphdr + 
-                ip_hl + oh_p->ospf_len);
-
-            /* FIXME need additional length check, to account for ospf_len */
-            lsa_p->lsa_sum = 0;
-            sum += libnet_in_cksum((uint16_t *)lsa_p, h_len);
-            lsa_p->lsa_sum = LIBNET_CKSUM_CARRY(sum);
-            break;
-#if 0
-            /*
-             *  Reworked fletcher checksum taken from RFC 1008.
-             */
-            int c0, c1;
-            struct libnet_lsa_hdr *lsa_p = (struct libnet_lsa_hdr *)buf;
-            uint8_t *p, *p1, *p2, *p3;
-
-            c0 = 0;
-            c1 = 0;
-
-            lsa_p->lsa_cksum = 0;
-
-            p = buf;
-            p1 = buf;
-            p3 = buf + len;             /* beginning and end of buf */
-
-            while (p1 < p3)
-            {
-                p2 = p1 + LIBNET_MODX;
-                if (p2 > p3)
-                {
-                    p2 = p3;
-                }
-  
-                for (p = p1; p < p2; p++)
-                {
-                    c0 += (*p);
-                    c1 += c0;
-                }
-
-                c0 %= 255;
-                c1 %= 255;      /* modular 255 */
- 
-                p1 = p2;
-            }
-
-#if AWR_PLEASE_REWORK_THIS
-            lsa_p->lsa_cksum[0] = (((len - 17) * c0 - c1) % 255);
-            if (lsa_p->lsa_cksum[0] <= 0)
-            {
-                lsa_p->lsa_cksum[0] += 255;
-            }
-
-            lsa_p->lsa_cksum[1] = (510 - c0 - lsa_p->lsa_cksum[0]);
-            if (lsa_p->lsa_cksum[1] > 255)
-            {
-                lsa_p->lsa_cksum[1] -= 255;
-            }
-#endif
-            break;
-#endif
-        }
         case IPPROTO_IP:
         {
             if(!iph_p) {
@@ -560,6 +529,18 @@ libnet_inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const
     return (1);
 }
 
+int
+libnet_inet_checksum(libnet_t *l, uint8_t *iphdr, int protocol, int h_len, const uint8_t *beg, const uint8_t * end)
+{
+    int c;
+
+    LIBNET_PROBE3(checksum_entry, protocol, h_len, (int)(end - beg));
+    c = inet_checksum(l, iphdr, protocol, h_len, beg, end);
+    LIBNET_PROBE2(checksum_return, protocol, c);
+
+    return (c);
+}
+
 
 uint16_t
 libnet_ip_check(const uint16_t *addr, int len)
@@ -570,6 +551,436 @@ libnet_ip_check(const uint16_t *addr, int len)
     return (LIBNET_CKSUM_CARRY(sum));
 }
 
+/*
+ *  Batched checksums.  Frames are grouped by layout, i.e. IPv4 header
+ *  length, transport protocol and segment length, and each group of
+ *  CKSUM_LANES frames is summed in lockstep: the n-th 32-bit word of every
+ *  frame is gathered into one vector (structure of arrays), so a single
+ *  add advances all the sums.  Leftover frames, and CPUs without AVX2,
+ *  take the scalar path, which gives the same results.
+ */
+#define CKSUM_LANES 8
+
+struct cksum_layout
+{
+    uint32_t ip_hl;                     /* IPv4 header length */
+    uint32_t l4_len;                    /* TCP/UDP segment length */
+    uint8_t  proto;                     /* IPPROTO_TCP, _UDP, or 0 */
+    uint8_t  l4_sum;                    /* offset of the TCP/UDP checksum */
+};
+
+/* unfolded one's complement sum of len bytes, any alignment */
+static uint32_t
+cksum_sum(const uint8_t *p, uint32_t len)
+{
+    uint32_t sum = 0;
+    uint16_t w;
+
+    for (; len > 1; p += 2, len -= 2)
+    {
+        memcpy(&w, p, sizeof (w));
+        sum += w;
+    }
+    if (len)
+    {
+        w = 0;
+        memcpy(&w, p, 1);
+        sum += w;
+    }
+
+    return (sum);
+}
+
+#ifdef HAVE_AVX2_ATTRIBUTE
+#include <immintrin.h>
+
+/* like cksum_sum(), for CKSUM_LANES buffers of the same length at once */
+__attribute__((target("avx2")))
+static void
+cksum_sum_avx2(uint8_t *const p[CKSUM_LANES], uint32_t len,
+        uint32_t sum[CKSUM_LANES])
+{
+    const __m256i mask = _mm256_set1_epi32(0xffff);
+    const __m256i lo = _mm256_set_epi64x(p[3] - p[0], p[2] - p[0],
+            p[1] - p[0], 0);
+    const __m256i hi = _mm256_set_epi64x(p[7] - p[0], p[6] - p[0],
+            p[5] - p[0], p[4] - p[0]);
+    __m256i acc = _mm256_setzero_si256();
+    uint32_t off, i;
+
+    /*
+     *  Each round adds at most 2 * 0xffff per lane, so 32-bit lanes
+     *  cannot overflow for anything that fits in an IPv4 packet.
+     */
+    for (off = 0; off + 4 <= len; off += 4)
+    {
+        const int *base = (const int *)(p[0] + off);
+        __m256i w = _mm256_castsi128_si256(_mm256_i64gather_epi32(base, lo, 1));
+
+        w = _mm256_inserti128_si256(w, _mm256_i64gather_epi32(base, hi, 1), 1);
+        acc = _mm256_add_epi32(acc, _mm256_and_si256(w, mask));
+        acc = _mm256_add_epi32(acc, _mm256_srli_epi32(w, 16));
+    }
+    _mm256_storeu_si256((__m256i *)sum, acc);
+
+    for (i = 0; i < CKSUM_LANES; i++)
+    {
+        sum[i] += cksum_sum(p[i] + off, len - off);
+    }
+}
+
+static int
+cksum_have_avx2(void)
+{
+    static int have = -1;
+
+    if (have == -1)
+    {
+        have = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return (have);
+}
+#endif  /* HAVE_AVX2_ATTRIBUTE */
+
+static int
+cksum_layout(libnet_t *l, const struct libnet_frame *f, uint32_t ip_offset,
+        int mode, struct cksum_layout *lo)
+{
+    const uint8_t *iph = f->buf + ip_offset;
+
+    memset(lo, 0, sizeof (*lo));
+
+    if (f->len < ip_offset + LIBNET_IPV4_H || (iph[0] >> 4) != 4)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no IPv4 header at offset %u", __func__, ip_offset);
+        return (-1);
+    }
+
+    lo->ip_hl = (iph[0] & 0x0f) << 2;
+    if (lo->ip_hl < LIBNET_IPV4_H || f->len < ip_offset + lo->ip_hl)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): ip hdr len not inside packet", __func__);
+        return (-1);
+    }
+
+    /* only the first fragment carries the transport header */
+    if (!(mode & LIBNET_CSUM_L4) || ((iph[6] & 0x1f) | iph[7]))
+    {
+        return (1);
+    }
+
+    lo->l4_len = f->len - ip_offset - lo->ip_hl;
+    switch (iph[9])
+    {
+        case IPPROTO_TCP:
+            lo->l4_sum = 16;
+            if (lo->l4_len < LIBNET_TCP_H)
+            {
+                goto short_l4;
+            }
+            break;
+        case IPPROTO_UDP:
+            lo->l4_sum = 6;
+            if (lo->l4_len < LIBNET_UDP_H)
+            {
+                goto short_l4;
+            }
+            break;
+        default:
+            lo->l4_len = 0;
+            return (1);
+    }
+    lo->proto = iph[9];
+
+    return (1);
+
+short_l4:
+    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+            "%s(): %s header not inside packet", __func__,
+            iph[9] == IPPROTO_TCP ? "tcp" : "udp");
+    return (-1);
+}
+
+/* stores the checksums of one frame, given its unfolded sums */
+static void
+cksum_store(uint8_t *iph, const struct cksum_layout *lo, int mode,
+        uint32_t ip_sum, uint32_t l4_sum)
+{
+    uint16_t v;
+
+    if (mode & LIBNET_CSUM_IP)
+    {
+        v = LIBNET_CKSUM_CARRY(ip_sum);
+        memcpy(iph + 10, &v, sizeof (v));
+    }
+
+    if (lo->proto)
+    {
+        l4_sum += htons(lo->proto) + htons(lo->l4_len);
+        v = LIBNET_CKSUM_CARRY(l4_sum);
+        if (v == 0 && lo->proto == IPPROTO_UDP)
+        {
+            v = 0xffff;     /* RFC 768: zero means no checksum */
+        }
+        memcpy(iph + lo->ip_hl + lo->l4_sum, &v, sizeof (v));
+    }
+}
+
+/* zeroes the checksum fields that are about to be summed over */
+static void
+cksum_clear(uint8_t *iph, const struct cksum_layout *lo, int mode)
+{
+    if (mode & LIBNET_CSUM_IP)
+    {
+        memset(iph + 10, 0, 2);
+    }
+    if (lo->proto)
+    {
+        memset(iph + lo->ip_hl + lo->l4_sum, 0, 2);
+    }
+}
+
+static void
+cksum_one(uint8_t *iph, const struct cksum_layout *lo, int mode)
+{
+    uint32_t ip_sum = 0, l4_sum = 0;
+
+    cksum_clear(iph, lo, mode);
+    if (mode & LIBNET_CSUM_IP)
+    {
+        ip_sum = cksum_sum(iph, lo->ip_hl);
+    }
+    if (lo->proto)
+    {
+        /* pseudo header src and dst, then the segment */
+        l4_sum = cksum_sum(iph + 12, 8) + cksum_sum(iph + lo->ip_hl, lo->l4_len);
+    }
+    cksum_store(iph, lo, mode, ip_sum, l4_sum);
+}
+
+int
+libnet_checksum_batch(libnet_t *l, const struct libnet_frame *frames,
+        uint32_t n, uint32_t ip_offset, int mode)
+{
+    struct cksum_layout lo, next;
+    uint32_t i, j;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    for (i = 0; i < n; i = j)
+    {
+        if (cksum_layout(l, &frames[i], ip_offset, mode, &lo) == -1)
+        {
+            return (-1);
+        }
+
+        /* how many of the following frames share this layout */
+        for (j = i + 1; j < n && j - i < CKSUM_LANES; j++)
+        {
+            if (cksum_layout(l, &frames[j], ip_offset, mode, &next) == -1)
+            {
+                return (-1);
+            }
+            if (memcmp(&lo, &next, sizeof (lo)))
+            {
+                break;
+            }
+        }
+
+#ifdef HAVE_AVX2_ATTRIBUTE
+        if (j - i == CKSUM_LANES && cksum_have_avx2())
+        {
+            uint32_t ip_sum[CKSUM_LANES], ph_sum[CKSUM_LANES];
+            uint32_t l4_sum[CKSUM_LANES];
+            uint8_t *p[CKSUM_LANES];
+            uint32_t k;
+
+            for (k = 0; k < CKSUM_LANES; k++)
+            {
+                p[k] = frames[i + k].buf + ip_offset;
+                cksum_clear(p[k], &lo, mode);
+                ip_sum[k] = l4_sum[k] = ph_sum[k] = 0;
+            }
+            if (mode & LIBNET_CSUM_IP)
+            {
+                cksum_sum_avx2(p, lo.ip_hl, ip_sum);
+            }
+            if (lo.proto)
+            {
+                uint8_t *q[CKSUM_LANES];
+
+                for (k = 0; k < CKSUM_LANES; k++)
+                {
+                    q[k] = p[k] + 12;
+                }
+                cksum_sum_avx2(q, 8, ph_sum);
+                for (k = 0; k < CKSUM_LANES; k++)
+                {
+                    q[k] = p[k] + lo.ip_hl;
+                }
+                cksum_sum_avx2(q, lo.l4_len, l4_sum);
+            }
+            for (k = 0; k < CKSUM_LANES; k++)
+            {
+                cksum_store(p[k], &lo, mode, ip_sum[k], ph_sum[k] + l4_sum[k]);
+            }
+            continue;
+        }
+#endif
+        for (; i < j; i++)
+        {
+            cksum_one(frames[i].buf + ip_offset, &lo, mode);
+        }
+    }
+
+    return (1);
+}
+
+/*
+ *  Fletcher checksum of OSPF LSAs (RFC 2328, 12.1.7 and RFC 905, annex B).
+ *  Over n bytes b[0..n-1], starting from sums c0 and c1,
+ *
+ *      c0' = c0 + sum b[i]
+ *      c1' = c1 + n * c0 + sum (n - i) * b[i]
+ *
+ *  so the modulo 255 can be left until the sums might overflow, after
+ *  FLETCHER_NMAX bytes, and with AVX2, 32 bytes are summed at a time.
+ */
+#define FLETCHER_NMAX   5792        /* 181 * 32, c1 stays below 2^32 */
+#define FLETCHER_BLOCK  32
+
+static void
+fletcher_sum(const uint8_t *p, uint32_t len, uint32_t *c0, uint32_t *c1)
+{
+    uint32_t a = *c0, b = *c1;
+
+    for (; len >= 4; p += 4, len -= 4)
+    {
+        a += p[0];
+        b += a;
+        a += p[1];
+        b += a;
+        a += p[2];
+        b += a;
+        a += p[3];
+        b += a;
+    }
+    while (len--)
+    {
+        a += *p++;
+        b += a;
+    }
+
+    *c0 = a;
+    *c1 = b;
+}
+
+#ifdef HAVE_AVX2_ATTRIBUTE
+/* like fletcher_sum(), for blocks of FLETCHER_BLOCK bytes */
+__attribute__((target("avx2")))
+static void
+fletcher_sum_avx2(const uint8_t *p, uint32_t blocks, uint32_t *c0,
+        uint32_t *c1)
+{
+    const __m256i weight = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+            24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9,
+            8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i s0 = zero, s1 = zero, prev = zero;
+    uint32_t a[8], b[8], i, sa = 0, sb = 0;
+
+    /*
+     *  s0 sums the bytes, s1 the bytes weighted by their distance from the
+     *  end of their block, and prev the byte sums of the blocks before, so
+     *  that FLETCHER_BLOCK * prev accounts for the blocks still to come.
+     */
+    for (i = 0; i < blocks; i++, p += FLETCHER_BLOCK)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)p);
+
+        prev = _mm256_add_epi32(prev, s0);
+        s0 = _mm256_add_epi32(s0, _mm256_sad_epu8(v, zero));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(
+                    _mm256_maddubs_epi16(v, weight), ones));
+    }
+    s1 = _mm256_add_epi32(s1, _mm256_slli_epi32(prev, 5));
+
+    _mm256_storeu_si256((__m256i *)a, s0);
+    _mm256_storeu_si256((__m256i *)b, s1);
+    for (i = 0; i < 8; i++)
+    {
+        sa += a[i];
+        sb += b[i];
+    }
+
+    *c1 += blocks * FLETCHER_BLOCK * *c0 + sb;
+    *c0 += sa;
+}
+#endif  /* HAVE_AVX2_ATTRIBUTE */
+
+uint16_t
+libnet_ospf_lsa_cksum(uint8_t *lsa, uint32_t len)
+{
+    const uint8_t *p = lsa + 2;             /* the age is left out */
+    uint32_t n, left, c0 = 0, c1 = 0;
+    int x, y;
+
+    if (len < LIBNET_OSPF_LSA_H)
+    {
+        return (0);
+    }
+
+    lsa[16] = 0;
+    lsa[17] = 0;
+
+    for (left = len - 2; left; left -= n)
+    {
+        n = left < FLETCHER_NMAX ? left : FLETCHER_NMAX;
+#ifdef HAVE_AVX2_ATTRIBUTE
+        if (n >= FLETCHER_BLOCK && cksum_have_avx2())
+        {
+            const uint32_t blocks = n / FLETCHER_BLOCK;
+
+            fletcher_sum_avx2(p, blocks, &c0, &c1);
+            fletcher_sum(p + blocks * FLETCHER_BLOCK,
+                    n - blocks * FLETCHER_BLOCK, &c0, &c1);
+        }
+        else
+#endif
+        {
+            fletcher_sum(p, n, &c0, &c1);
+        }
+        p += n;
+        c0 %= 255;
+        c1 %= 255;
+    }
+
+    /*
+     *  The checksum octets are 15 and 16, counting from 1 after the age,
+     *  and are chosen to bring both sums over the LSA to zero.
+     */
+    x = (int)((((len - 2 - 15) % 255) * c0 + 255 - c1) % 255);
+    if (x == 0)
+    {
+        x = 255;
+    }
+    y = 510 - (int)c0 - x;
+    if (y > 255)
+    {
+        y -= 255;
+    }
+
+    lsa[16] = (uint8_t)x;
+    lsa[17] = (uint8_t)y;
+    return ((uint16_t)(x << 8 | y));
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
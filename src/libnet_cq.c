@@ -33,15 +33,90 @@
 
 #include "common.h"
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 /* private function prototypes */
 static libnet_cq_t *libnet_cq_find_internal(const libnet_t *);
 static int libnet_cq_dup_check(libnet_t *, const char *);
 static libnet_cq_t *libnet_cq_find_by_label_internal(const char *label);
+static libnet_cq_t *libnet_cq_unlink(libnet_cq_t *);
+static void libnet_cq_get_addrs(libnet_cq_t *, libnet_t *);
+static void cq_pool_stop(void);
 
 /* global context queue */
 static libnet_cq_t *l_cq = NULL;
-static libnet_cqd_t l_cqd = {0, CQ_LOCK_UNLOCKED, NULL};
+static libnet_cqd_t l_cqd = {0, CQ_LOCK_UNLOCKED, NULL, 0, 0};
+
+/* label index, chained through libnet_cq_t.hnext */
+#define CQ_HASH_SIZE        256
+static libnet_cq_t *l_cq_hash[CQ_HASH_SIZE];
+
+/*
+ *  All of the above is guarded by one readers/writer lock.  The CQ_LOCK_*
+ *  flags are older and something else: they keep the queue from changing
+ *  while the legacy iterator, libnet_cq_head() et al., walks it.
+ */
+#ifdef HAVE_PTHREAD
+static pthread_rwlock_t l_cq_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+#define CQ_RDLOCK()         pthread_rwlock_rdlock(&l_cq_rwlock)
+#define CQ_WRLOCK()         pthread_rwlock_wrlock(&l_cq_rwlock)
+#define CQ_UNLOCK()         pthread_rwlock_unlock(&l_cq_rwlock)
+#else
+#define CQ_RDLOCK()
+#define CQ_WRLOCK()
+#define CQ_UNLOCK()
+#endif
+
+/* 32-bit FNV-1a */
+static uint32_t
+cq_hash(const char *label)
+{
+    uint32_t h = 2166136261U;
+    int i;
+
+    for (i = 0; i < LIBNET_LABEL_SIZE && label[i]; i++)
+    {
+        h ^= (uint8_t)label[i];
+        h *= 16777619U;
+    }
+    return (h & (CQ_HASH_SIZE - 1));
+}
+
+/*
+ *  Looks up the addresses of the device of l once, for fan-out writes, so
+ *  they don't cost two ioctl()s per context and packet.
+ */
+static void
+libnet_cq_get_addrs(libnet_cq_t *p, libnet_t *l)
+{
+    struct libnet_ether_addr *ea;
+    uint32_t ip;
 
+    p->have_addr = 0;
+    if (l->device == NULL)
+    {
+        return;         /* e.g., LIBNET_NONE, nothing to look up */
+    }
+    if (l->injection_type == LIBNET_SHM)
+    {
+        return;         /* the device is a ring name, see libnet_cq_set_addrs() */
+    }
+
+    ea = libnet_get_hwaddr(l);
+    if (ea)
+    {
+        memcpy(p->hwaddr, ea->ether_addr_octet, 6);
+        p->have_addr |= LIBNET_FANOUT_SRC_MAC;
+    }
+    ip = libnet_get_ipaddr4(l);
+    if (ip != (uint32_t)-1)
+    {
+        p->ipaddr = ip;
+        p->have_addr |= LIBNET_FANOUT_SRC_IP;
+    }
+}
 
 static int
 set_cq_lock(uint32_t x) 
@@ -70,19 +145,15 @@ clear_cq_lock(uint32_t x)
 int 
 libnet_cq_add(libnet_t *l, const char *label)
 {
+    char name[LIBNET_LABEL_SIZE];
+    libnet_cq_t *new_cq;
+    uint32_t h;
+
     if (l == NULL) 
     {
         return (-1);
     }
 
-    /* check for write lock on the context queue */
-    if (cq_is_wlocked()) 
-    {
-        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
-                "%s(): can't add, context queue is write locked", __func__);
-        return (-1);
-    }
-  
     /* ensure there is a label */
     if (label == NULL)
     {
@@ -91,156 +162,189 @@ libnet_cq_add(libnet_t *l, const char *label)
         return (-1);
     }
 
-    /* check to see if we're the first node on the list */
-    if (l_cq == NULL)
-    {
-        l_cq = (libnet_cq_t *)malloc(sizeof (libnet_cq_t));
-        if (l_cq == NULL)
-        {
-            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
-                    "%s(): can't malloc initial context queue: %s",
-                    __func__, strerror(errno));
-            return (-1);
-        }
-
-        l_cq->context = l;
+    /* the label as the context will carry it */
+    strncpy(name, label, LIBNET_LABEL_SIZE);
+    name[LIBNET_LABEL_SIZE - 1] = '\0';
 
-        /* label the context with the user specified string */
-        strncpy(l->label, label, LIBNET_LABEL_SIZE);
-        l->label[LIBNET_LABEL_SIZE - 1] = '\0';
-
-        l_cq->next = NULL;
-        l_cq->prev = NULL;
-
-        /* track the number of nodes in the context queue */
-        l_cqd.node = 1;
-
-        return (1);
+    new_cq = (libnet_cq_t *)libnet_malloc(l, sizeof (libnet_cq_t));
+    if (new_cq == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): can't malloc new context queue: %s",
+                __func__, strerror(errno));
+        return (-1);
     }
+    libnet_cq_get_addrs(new_cq, l);
 
-    /* check to see if the cq we're about to add is already in the list */
-    if (libnet_cq_dup_check(l, label)) 
+    CQ_WRLOCK();
+
+    /* check for write lock on the context queue */
+    if (cq_is_wlocked()) 
     {
-        /* error message set in libnet_cq_dup_check() */
+        CQ_UNLOCK();
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): can't add, context queue is write locked", __func__);
+        libnet_free(new_cq);
         return (-1);
     }
 
-    libnet_cq_t * const new_cq = (libnet_cq_t *)malloc(sizeof (libnet_cq_t));
-    if (new_cq == NULL)
+    /* check to see if the cq we're about to add is already in the list */
+    if (libnet_cq_dup_check(l, name)) 
     {
-        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
-                "%s(): can't malloc new context queue: %s",
-                __func__, strerror(errno));
+        CQ_UNLOCK();
+        /* error message set in libnet_cq_dup_check() */
+        libnet_free(new_cq);
         return (-1);
     }
 
     new_cq->context = l;
+    new_cq->seq = ++l_cqd.seq;
 
     /* label the context with the user specified string */
-    strncpy(l->label, label, LIBNET_LABEL_SIZE);
-    l->label[LIBNET_LABEL_SIZE -1] = '\0';
+    memcpy(l->label, name, LIBNET_LABEL_SIZE);
 
     new_cq->next = l_cq;
     new_cq->prev = NULL;
-
-    l_cq->prev = new_cq;
+    if (l_cq)
+    {
+        l_cq->prev = new_cq;
+    }
     l_cq = new_cq;
 
+    h = cq_hash(name);
+    new_cq->hnext = l_cq_hash[h];
+    l_cq_hash[h] = new_cq;
+
     /* track the number of nodes in the context queue */
     l_cqd.node++;
+    l_cqd.gen++;
+
+    CQ_UNLOCK();
 
     return (1); 
 }
 
+/* takes p off the list and the index, the write lock must be held */
+static libnet_cq_t *
+libnet_cq_unlink(libnet_cq_t *p)
+{
+    libnet_cq_t **pp;
+
+    if (p->prev) 
+    {
+        p->prev->next = p->next;
+    }
+    else
+    {
+        l_cq = p->next;
+    }
+    if (p->next)
+    {
+        p->next->prev = p->prev;
+    }
+
+    for (pp = &l_cq_hash[cq_hash(p->context->label)]; *pp; pp = &(*pp)->hnext)
+    {
+        if (*pp == p)
+        {
+            *pp = p->hnext;
+            break;
+        }
+    }
+
+    /* track the number of nodes in the cq */
+    l_cqd.node--;
+    l_cqd.gen++;
+
+    return (p);
+}
+
 libnet_t *
 libnet_cq_remove(libnet_t *l) 
 {
+    libnet_cq_t *p;
+    libnet_t *ret;
+    int empty;
+
+    if (l == NULL)
+    {
+        return(NULL);
+    }
+
+    CQ_WRLOCK();
+
     if (l_cq == NULL) 
     {
+        CQ_UNLOCK();
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
                 "%s(): can't remove from empty context queue", __func__);
         return (NULL);
     }
 
-    if (l == NULL)
-    {
-        return(NULL);
-    }
-
     /* check for write lock on the cq */
     if (cq_is_wlocked()) 
     {
+        CQ_UNLOCK();
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
                 "%s(): can't remove, context queue is write locked",
                 __func__);
         return (NULL);
     }
 
-    libnet_cq_t * const p = libnet_cq_find_internal(l);
+    p = libnet_cq_find_internal(l);
     if (p == NULL)
     {
+        CQ_UNLOCK();
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
                 "%s(): context not present in context queue", __func__);
         return (NULL);
     }
 
-    if (p->prev) 
-    {
-        p->prev->next = p->next;
-    }
-    else
-    {
-        l_cq = p->next;
-    }
-    if (p->next)
+    ret = libnet_cq_unlink(p)->context;
+    empty = (l_cq == NULL);
+    CQ_UNLOCK();
+
+    libnet_free(p);
+    if (empty)
     {
-        p->next->prev = p->prev;
+        cq_pool_stop();
     }
-
-    libnet_t * const ret = p->context;
-    free(p);
-
-    /* track the number of nodes in the cq */
-    l_cqd.node--;
-  
     return (ret);
 }
 
 libnet_t *
 libnet_cq_remove_by_label(const char *label) 
 {
-    libnet_cq_t * const p = libnet_cq_find_by_label_internal(label);
+    libnet_cq_t *p;
+    libnet_t *ret;
+    int empty;
+
+    CQ_WRLOCK();
+
+    p = libnet_cq_find_by_label_internal(label);
     if (p == NULL)
     {
+        CQ_UNLOCK();
         /* no context to write an error message */
         return (NULL);
     }
 
     if (cq_is_wlocked()) 
     {
+        CQ_UNLOCK();
         /* now we have a context, but the user can't see it */
         return (NULL);
     }
 
-    if (p->prev) 
-    {
-        p->prev->next = p->next;
-    }
-    else
+    ret = libnet_cq_unlink(p)->context;
+    empty = (l_cq == NULL);
+    CQ_UNLOCK();
+
+    libnet_free(p);
+    if (empty)
     {
-        l_cq = p->next;
+        cq_pool_stop();
     }
-    if (p->next)
-    {
-        p->next->prev = p->prev;
-    }
-
-    libnet_t * const ret = p->context;
-    free(p);
-
-    /* track the number of nodes in the cq */
-    l_cqd.node--;
-  
     return (ret);
 }
 
@@ -262,22 +366,17 @@ libnet_cq_find_internal(const libnet_t *l)
 int
 libnet_cq_dup_check(libnet_t *l, const char *label)
 {
-    libnet_cq_t *p;
-
-    for (p = l_cq; p; p = p->next)
+    if (libnet_cq_find_internal(l))
     {
-        if (p->context == l)
-        {
-            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
-                "%s(): context already in context queue", __func__);
-            return (1);
-        }
-        if (strncmp(p->context->label, label, LIBNET_LABEL_SIZE) == 0)
-        {
-            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
-                    "%s(): duplicate label %s", __func__, label);
-            return (1);
-        }
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+            "%s(): context already in context queue", __func__);
+        return (1);
+    }
+    if (libnet_cq_find_by_label_internal(label))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): duplicate label %s", __func__, label);
+        return (1);
     }
     /* no duplicate */
     return (0);
@@ -293,7 +392,7 @@ libnet_cq_find_by_label_internal(const char *label)
         return (NULL);
     }
 
-    for (p = l_cq; p; p = p->next)
+    for (p = l_cq_hash[cq_hash(label)]; p; p = p->hnext)
     {
         if (!strncmp(p->context->label, label, LIBNET_LABEL_SIZE))
         {
@@ -306,90 +405,636 @@ libnet_cq_find_by_label_internal(const char *label)
 libnet_t *
 libnet_cq_find_by_label(const char *label)
 {
-    libnet_cq_t * const p = libnet_cq_find_by_label_internal(label);
+    libnet_cq_t *p;
+
+    CQ_RDLOCK();
+    p = libnet_cq_find_by_label_internal(label);
+    CQ_UNLOCK();
+
     return (p ? p->context : NULL);
 }
 
+int
+libnet_cq_set_addrs(const char *label, uint32_t flags, const uint8_t *hwaddr,
+        uint32_t ipaddr)
+{
+    libnet_cq_t *p;
+
+    if ((flags & LIBNET_FANOUT_SRC_MAC) && hwaddr == NULL)
+    {
+        return (-1);
+    }
+
+    CQ_WRLOCK();
+    p = libnet_cq_find_by_label_internal(label);
+    if (p)
+    {
+        if (flags & LIBNET_FANOUT_SRC_MAC)
+        {
+            memcpy(p->hwaddr, hwaddr, 6);
+        }
+        if (flags & LIBNET_FANOUT_SRC_IP)
+        {
+            p->ipaddr = ipaddr;
+        }
+        p->have_addr = flags & (LIBNET_FANOUT_SRC_MAC | LIBNET_FANOUT_SRC_IP);
+    }
+    CQ_UNLOCK();
+
+    return (p ? 1 : -1);
+}
+
 const char *
 libnet_cq_getlabel(const libnet_t *l)
 {
     return (l->label);
 }
 
+/* sets it to p, the lock must be held */
+static libnet_t *
+cq_iter_set(libnet_cq_iter_t *it, libnet_cq_t *p)
+{
+    it->node = p;
+    it->seq  = p ? p->seq : 0;
+    it->gen  = l_cqd.gen;
+
+    return (p ? p->context : NULL);
+}
+
+libnet_t *
+libnet_cq_iter_first(libnet_cq_iter_t *it)
+{
+    libnet_t *l;
+
+    CQ_RDLOCK();
+    l = cq_iter_set(it, l_cq);
+    CQ_UNLOCK();
+
+    return (l);
+}
+
+libnet_t *
+libnet_cq_iter_next(libnet_cq_iter_t *it)
+{
+    libnet_cq_t *p;
+    libnet_t *l;
+
+    if (it->node == NULL)
+    {
+        return (NULL);
+    }
+
+    CQ_RDLOCK();
+    if (it->gen == l_cqd.gen)
+    {
+        p = it->node->next;
+    }
+    else
+    {
+        /*
+         *  The queue changed since the last step and it->node may be gone.
+         *  Nodes are added at the head, so the list runs from the newest to
+         *  the oldest and the next one is the first older than it->node.
+         */
+        for (p = l_cq; p && p->seq >= it->seq; p = p->next)
+            ;
+    }
+    l = cq_iter_set(it, p);
+    CQ_UNLOCK();
+
+    return (l);
+}
+
+void
+libnet_cq_iter_end(libnet_cq_iter_t *it)
+{
+    it->node = NULL;
+}
+
+#ifdef HAVE_PTHREAD
+/*
+ *  libnet_cq_write_all() hands out the contexts of a snapshot of the queue
+ *  to a pool of worker threads, the calling thread being one of them.  The
+ *  pool outlives the call and is only rebuilt when the number of workers
+ *  asked for changes.
+ */
+struct cq_job
+{
+    libnet_t **ctx;
+    uint32_t n;
+    uint32_t next;                      /* next context to write, atomic */
+    uint32_t written;                   /* atomic */
+    uint32_t active;                    /* pool threads on this job */
+};
+
+struct cq_pool
+{
+    pthread_mutex_t busy;               /* one libnet_cq_write_all() at a time */
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    pthread_t *threads;
+    uint32_t n;
+    struct cq_job *job;                 /* current job, or NULL */
+    uint64_t gen;                       /* bumped for every job */
+    int stop;
+};
+
+static struct cq_pool l_cq_pool =
+{
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    NULL, 0, NULL, 0, 0
+};
+
+static void
+cq_job_run(struct cq_job *j)
+{
+    uint32_t i;
+
+    while ((i = __atomic_fetch_add(&j->next, 1, __ATOMIC_RELAXED)) < j->n)
+    {
+        if (libnet_write(j->ctx[i]) != -1)
+        {
+            __atomic_fetch_add(&j->written, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void *
+cq_worker(void *arg)
+{
+    struct cq_pool *p = arg;
+    struct cq_job *j;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&p->lock);
+    while (1)
+    {
+        while (!p->stop && (p->job == NULL || p->gen == seen))
+        {
+            pthread_cond_wait(&p->work, &p->lock);
+        }
+        if (p->stop)
+        {
+            break;
+        }
+
+        seen = p->gen;
+        j = p->job;
+        j->active++;
+        pthread_mutex_unlock(&p->lock);
+
+        cq_job_run(j);
+
+        pthread_mutex_lock(&p->lock);
+        if (--j->active == 0)
+        {
+            pthread_cond_signal(&p->done);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return (NULL);
+}
+
+/* (re)starts the pool with n threads, p->busy must be held */
+static int
+cq_pool_resize(struct cq_pool *p, uint32_t n)
+{
+    uint32_t i;
+
+    if (p->n == n)
+    {
+        return (1);
+    }
+
+    if (p->n)
+    {
+        pthread_mutex_lock(&p->lock);
+        p->stop = 1;
+        pthread_cond_broadcast(&p->work);
+        pthread_mutex_unlock(&p->lock);
+
+        for (i = 0; i < p->n; i++)
+        {
+            pthread_join(p->threads[i], NULL);
+        }
+        libnet_free(p->threads);
+        p->threads = NULL;
+        p->n = 0;
+        p->stop = 0;
+    }
+
+    if (n == 0)
+    {
+        return (1);
+    }
+
+    p->threads = libnet_malloc(NULL, n * sizeof (*p->threads));
+    if (p->threads == NULL)
+    {
+        return (-1);
+    }
+    for (p->n = 0; p->n < n; p->n++)
+    {
+        if (pthread_create(&p->threads[p->n], NULL, cq_worker, p))
+        {
+            /* make do with the ones we have */
+            break;
+        }
+    }
+
+    return (p->n ? 1 : -1);
+}
+#endif  /* HAVE_PTHREAD */
+
+/* joins the pool threads, they don't outlive the queue */
+static void
+cq_pool_stop(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&l_cq_pool.busy);
+    cq_pool_resize(&l_cq_pool, 0);
+    pthread_mutex_unlock(&l_cq_pool.busy);
+#endif
+}
+
+int
+libnet_cq_write_all(uint32_t workers)
+{
+    libnet_t **ctx;
+    libnet_cq_t *p;
+    uint32_t n, i;
+    int written = 0;
+
+    CQ_RDLOCK();
+
+    n = l_cqd.node;
+    if (n == 0 || (ctx = libnet_malloc(NULL, n * sizeof (*ctx))) == NULL)
+    {
+        CQ_UNLOCK();
+        return (-1);
+    }
+    for (i = 0, p = l_cq; p; p = p->next)
+    {
+        ctx[i++] = p->context;
+    }
+
+#ifdef HAVE_PTHREAD
+    if (workers == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+        workers = ncpu > 0 ? (uint32_t)ncpu : 1;
+    }
+    if (workers > n)
+    {
+        workers = n;
+    }
+
+    if (workers > 1)
+    {
+        struct cq_pool *pool = &l_cq_pool;
+        struct cq_job j = { ctx, n, 0, 0, 0 };
+
+        pthread_mutex_lock(&pool->busy);
+        if (cq_pool_resize(pool, workers - 1) == 1)
+        {
+            pthread_mutex_lock(&pool->lock);
+            pool->job = &j;
+            pool->gen++;
+            pthread_cond_broadcast(&pool->work);
+            pthread_mutex_unlock(&pool->lock);
+
+            cq_job_run(&j);
+
+            /* all contexts are claimed, wait for the pool to finish them */
+            pthread_mutex_lock(&pool->lock);
+            while (j.active)
+            {
+                pthread_cond_wait(&pool->done, &pool->lock);
+            }
+            pool->job = NULL;
+            pthread_mutex_unlock(&pool->lock);
+        }
+        else
+        {
+            cq_job_run(&j);
+        }
+        pthread_mutex_unlock(&pool->busy);
+
+        written = (int)j.written;
+    }
+    else
+#endif  /* HAVE_PTHREAD */
+    {
+        (void)workers;
+        for (i = 0; i < n; i++)
+        {
+            if (libnet_write(ctx[i]) != -1)
+            {
+                written++;
+            }
+        }
+    }
+
+    CQ_UNLOCK();
+    libnet_free(ctx);
+
+    return (written);
+}
+
+/* RFC 1624: HC' = ~(~HC + ~m + m'), for a 32-bit field m */
+static void
+cq_sum_adjust(uint8_t *sum, uint32_t m, uint32_t m_new, int udp)
+{
+    uint32_t hc = (sum[0] << 8) | sum[1];
+    uint32_t s;
+
+    if (udp && hc == 0)
+    {
+        return;         /* UDP checksum not in use */
+    }
+
+    m = ntohl(m);
+    m_new = ntohl(m_new);
+    s = (~hc & 0xffff) + (~m >> 16 & 0xffff) + (~m & 0xffff) +
+        (m_new >> 16) + (m_new & 0xffff);
+    while (s >> 16)
+    {
+        s = (s & 0xffff) + (s >> 16);
+    }
+    s = ~s & 0xffff;
+    if (udp && s == 0)
+    {
+        s = 0xffff;
+    }
+    sum[0] = (uint8_t)(s >> 8);
+    sum[1] = (uint8_t)s;
+}
+
+/* sets the IPv4 source of the packet at ip, fixing up the checksums */
+static void
+cq_set_ip_src(uint8_t *ip, uint32_t len, uint32_t src)
+{
+    const uint32_t hl = (ip[0] & 0x0f) << 2;
+    uint32_t old;
+
+    memcpy(&old, ip + 12, 4);
+    if (old == src)
+    {
+        return;
+    }
+    memcpy(ip + 12, &src, 4);
+    cq_sum_adjust(ip + 10, old, src, 0);
+
+    /* the L4 checksum covers the source in the pseudo header */
+    if ((((ip[6] << 8) | ip[7]) & 0x1fff) != 0)
+    {
+        return;         /* not the first fragment */
+    }
+    if (ip[9] == IPPROTO_TCP && len >= hl + LIBNET_TCP_H)
+    {
+        cq_sum_adjust(ip + hl + 16, old, src, 0);
+    }
+    else if (ip[9] == IPPROTO_UDP && len >= hl + LIBNET_UDP_H)
+    {
+        cq_sum_adjust(ip + hl + 6, old, src, 1);
+    }
+}
+
+int
+libnet_cq_fanout_write(libnet_t *l, uint32_t flags)
+{
+    /* everything re-stamped: link, IPv4 and TCP headers at their largest */
+    uint8_t orig[LIBNET_802_1Q_H + 60 + LIBNET_TCP_H];
+    struct libnet_frame frame;
+    uint8_t *packet;
+    uint32_t len, l3, orig_len;
+    int link, stamped, written = 0;
+    libnet_cq_t *p;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (libnet_pblock_coalesce(l, &packet, &len) == -1)
+    {
+        /* err msg set in libnet_pblock_coalesce() */
+        return (-1);
+    }
+
+    /* where the IPv4 header is, if there is one, in the frame */
+    link = 0;
+    l3 = UINT32_MAX;
+    if (l->pblock_end && l->pblock_end->type == LIBNET_PBLOCK_ETH_H)
+    {
+        link = 1;
+        if (len >= LIBNET_ETH_H + LIBNET_IPV4_H &&
+            packet[12] == 0x08 && packet[13] == 0x00)
+        {
+            l3 = LIBNET_ETH_H;
+        }
+        else if (len >= LIBNET_802_1Q_H + LIBNET_IPV4_H &&
+            packet[12] == 0x81 && packet[13] == 0x00 &&
+            packet[16] == 0x08 && packet[17] == 0x00)
+        {
+            l3 = LIBNET_802_1Q_H;
+        }
+    }
+    else if (len >= LIBNET_IPV4_H && (packet[0] >> 4) == 4)
+    {
+        l3 = 0;
+    }
+    if (l3 != UINT32_MAX && len < l3 + ((packet[l3] & 0x0f) << 2))
+    {
+        l3 = UINT32_MAX;
+    }
+
+    CQ_RDLOCK();
+
+    if (l_cq == NULL)
+    {
+        CQ_UNLOCK();
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): context queue is empty", __func__);
+        libnet_adv_free_packet(l, packet);
+        return (-1);
+    }
+
+    /*
+     *  One buffer, re-stamped in place for every context in turn.  A context
+     *  whose addresses aren't known gets the packet as built, so the headers
+     *  are put back before each context after one that stamped them.
+     */
+    orig_len = len < sizeof (orig) ? len : (uint32_t)sizeof (orig);
+    memcpy(orig, packet, orig_len);
+    stamped = 0;
+    for (p = l_cq; p; p = p->next)
+    {
+        libnet_t * const c = p->context;
+
+        if (stamped)
+        {
+            memcpy(packet, orig, orig_len);
+            stamped = 0;
+        }
+        if ((flags & LIBNET_FANOUT_SRC_MAC) && link &&
+            (p->have_addr & LIBNET_FANOUT_SRC_MAC))
+        {
+            memcpy(packet + 6, p->hwaddr, 6);
+            stamped = 1;
+        }
+        if ((flags & LIBNET_FANOUT_SRC_IP) && l3 != UINT32_MAX &&
+            (p->have_addr & LIBNET_FANOUT_SRC_IP))
+        {
+            cq_set_ip_src(packet + l3, len - l3, p->ipaddr);
+            stamped = 1;
+        }
+
+        /* raw sockets get the frame from the IP header on */
+        switch (c->injection_type)
+        {
+            case LIBNET_RAW4:
+            case LIBNET_RAW4_ADV:
+                if (l3 == UINT32_MAX)
+                {
+                    snprintf(c->err_buf, LIBNET_ERRBUF_SIZE,
+                            "%s(): no IPv4 packet to write", __func__);
+                    libnet_stats_error(c, 0, 0);
+                    continue;
+                }
+                frame.buf = packet + l3;
+                frame.len = len - l3;
+                break;
+            case LIBNET_LINK:
+            case LIBNET_LINK_ADV:
+            case LIBNET_SHM:
+                if (!link)
+                {
+                    snprintf(c->err_buf, LIBNET_ERRBUF_SIZE,
+                            "%s(): no Ethernet frame to write", __func__);
+                    libnet_stats_error(c, 0, 0);
+                    continue;
+                }
+                frame.buf = packet;
+                frame.len = len;
+                break;
+            default:
+                snprintf(c->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): unsupported injection type", __func__);
+                libnet_stats_error(c, 0, 0);
+                continue;
+        }
+
+        written += libnet_write_batch(c, &frame, 1);
+    }
+
+    CQ_UNLOCK();
+
+    libnet_adv_free_packet(l, packet);
+    return (written);
+}
+
 void
 libnet_cq_destroy() 
 {
-    libnet_cq_t *p = l_cq;
+    libnet_cq_t *p;
     libnet_cq_t *tmp;
 
+    cq_pool_stop();
+
+    CQ_WRLOCK();
+    p = l_cq;
     while (p)
     {
         tmp = p;
         p = p->next;
         libnet_destroy(tmp->context);
-        free(tmp);
+        libnet_free(tmp);
     }
     l_cq = NULL;
-    memset(&l_cqd, 0, sizeof(l_cqd));
+    memset(l_cq_hash, 0, sizeof(l_cq_hash));
+    l_cqd.node = 0;
+    l_cqd.cq_lock = CQ_LOCK_UNLOCKED;
+    l_cqd.current = NULL;
+    /* seq keeps counting, so iterators still out there stay ordered */
+    l_cqd.gen++;
+    CQ_UNLOCK();
 }
 
 libnet_t *
 libnet_cq_head()
 {
-    if (l_cq == NULL) 
-    {
-        return (NULL);
-    }
+    libnet_t *l = NULL;
 
-    if (!set_cq_lock(CQ_LOCK_WRITE)) 
+    CQ_WRLOCK();
+    if (l_cq && set_cq_lock(CQ_LOCK_WRITE)) 
     {
-        return (NULL);
+        l_cqd.current = l_cq;
+        l = l_cqd.current->context;
     }
+    CQ_UNLOCK();
 
-    l_cqd.current = l_cq;
-    return (l_cqd.current->context);
+    return (l);
 }
 
 int
 libnet_cq_last()
 {
-    if (l_cqd.current)
-    {
-        return (1);
-    }
-    else
-    {
-        return (0);
-    }
+    int rc;
+
+    CQ_RDLOCK();
+    rc = l_cqd.current ? 1 : 0;
+    CQ_UNLOCK();
+
+    return (rc);
 }
 
 libnet_t *
 libnet_cq_next()
 {
-    if (l_cqd.current == NULL)
+    libnet_t *l = NULL;
+
+    CQ_WRLOCK();
+    if (l_cqd.current)
     {
-        return (NULL);
+        l_cqd.current = l_cqd.current->next;
+        l = l_cqd.current ? l_cqd.current->context : NULL;
     }
+    CQ_UNLOCK();
 
-    l_cqd.current = l_cqd.current->next;
-    return (l_cqd.current ? l_cqd.current->context : NULL);
+    return (l);
 }
 
 uint32_t
 libnet_cq_size()
 {
-    return (l_cqd.node);
+    uint32_t n;
+
+    CQ_RDLOCK();
+    n = l_cqd.node;
+    CQ_UNLOCK();
+
+    return (n);
 }
 
 uint32_t
 libnet_cq_end_loop()
 {
-    if (! clear_cq_lock(CQ_LOCK_WRITE))
+    uint32_t rc = 0;
+
+    CQ_WRLOCK();
+    if (clear_cq_lock(CQ_LOCK_WRITE))
     {
-        return (0);
+        l_cqd.current = l_cq;
+        rc = 1;
     }
-    l_cqd.current = l_cq;
-    return (1);
+    CQ_UNLOCK();
+
+    return (rc);
 }
 
 /**
@@ -0,0 +1,709 @@
+/*
+ *  libnet
+ *  libnet_fragment.c - software IP fragmentation and TCP segmentation
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  Finds where the outermost header of the given pblock type starts in the
+ *  coalesced packet.  The pblock list runs from the end of the packet to
+ *  its start, so that is the last one found.
+ */
+static int
+frag_offset(libnet_t *l, uint8_t type, uint32_t *offset)
+{
+    libnet_pblock_t *p;
+    uint32_t n = l->total_size;
+    int found = 0;
+
+    for (p = l->protocol_blocks; p; p = p->next)
+    {
+        n -= p->b_len;
+        if (p->type == type)
+        {
+            *offset = n;
+            found = 1;
+        }
+    }
+
+    if (!found)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): packet has no %s header", __func__,
+                type == LIBNET_PBLOCK_IPV4_H ? "IPv4" :
+                type == LIBNET_PBLOCK_IPV6_H ? "IPv6" : "TCP");
+        return (-1);
+    }
+    return (1);
+}
+
+/* makes room for n frames of up to frame_s bytes in l->frag_buf */
+static struct libnet_frame *
+frag_room(libnet_t *l, uint32_t n, uint32_t frame_s)
+{
+    const uint64_t need = (uint64_t)n * (sizeof (struct libnet_frame) + frame_s);
+    uint8_t *buf;
+
+    if (need > UINT32_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): too many fragments: %u", __func__, n);
+        return (NULL);
+    }
+    if (need > l->frag_buf_s)
+    {
+        buf = libnet_realloc(l, l->frag_buf, need);
+        if (buf == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (NULL);
+        }
+        l->frag_buf   = buf;
+        l->frag_buf_s = need;
+    }
+    return ((struct libnet_frame *)l->frag_buf);
+}
+
+/* puts the fragments in the order asked for by flags */
+static void
+frag_order(libnet_t *l, struct libnet_frame *frames, uint32_t n, int flags)
+{
+    struct libnet_frame f;
+    uint32_t i, j;
+
+    if (flags & LIBNET_FRAG_REVERSE)
+    {
+        for (i = 0; i < n / 2; i++)
+        {
+            f = frames[i];
+            frames[i] = frames[n - 1 - i];
+            frames[n - 1 - i] = f;
+        }
+    }
+    if (flags & LIBNET_FRAG_SHUFFLE)
+    {
+        for (i = n - 1; i > 0; i--)
+        {
+            j = libnet_get_prand_r(l, LIBNET_PRu32) % (i + 1);
+            f = frames[i];
+            frames[i] = frames[j];
+            frames[j] = f;
+        }
+    }
+}
+
+/*
+ *  Copies the options of an IPv4 header that RFC 791 has copied into every
+ *  fragment, those with the copied flag set, padded to 32 bits.  Returns
+ *  their length.
+ */
+static uint32_t
+frag_ipv4_options(const uint8_t *opt, uint32_t opt_s, uint8_t *out)
+{
+    uint32_t i = 0, n = 0, len;
+
+    while (i < opt_s && opt[i] != IPOPT_EOL)
+    {
+        if (opt[i] == IPOPT_NOP)
+        {
+            i++;
+            continue;
+        }
+        if (i + 1 >= opt_s || (len = opt[i + 1]) < 2 || i + len > opt_s)
+        {
+            break;                      /* malformed, the rest is dropped */
+        }
+        if (opt[i] & 0x80)
+        {
+            memcpy(out + n, opt + i, len);
+            n += len;
+        }
+        i += len;
+    }
+    while (n & 3)
+    {
+        out[n++] = IPOPT_EOL;
+    }
+    return (n);
+}
+
+LIBNET_API
+int
+libnet_fragment_ipv4(libnet_t *l, uint32_t mtu, int flags,
+        struct libnet_frame **frames, uint32_t *frames_n)
+{
+    uint32_t ip_off, len, hl, ip_len, data, opt_s, first, rest, step, max;
+    uint32_t frame_s, n, off, start, end, h, v, total, fo, id;
+    struct libnet_frame *fr;
+    uint8_t opt[40], *packet, *iph, *f, mf, evil;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (mtu == 0)
+    {
+        c = libnet_get_mtu(l);
+        if (c == -1)
+        {
+            /* err msg set in libnet_get_mtu() */
+            return (-1);
+        }
+        mtu = c;
+    }
+
+    if (frag_offset(l, LIBNET_PBLOCK_IPV4_H, &ip_off) == -1 ||
+        libnet_pblock_coalesce_cached(l, &packet, &len) == -1)
+    {
+        return (-1);
+    }
+
+    /* checksums left to the caller cover the whole datagram */
+    if (l->csum_deferred)
+    {
+        struct libnet_frame whole = { packet, len };
+
+        if (libnet_checksum_batch(l, &whole, 1, ip_off, l->csum_deferred) == -1)
+        {
+            return (-1);
+        }
+    }
+
+    iph = packet + ip_off;
+    hl  = (iph[0] & 0x0f) << 2;
+    ip_len = iph[2] << 8 | iph[3];
+    if (len < ip_off + LIBNET_IPV4_H || hl < LIBNET_IPV4_H || ip_len < hl ||
+        ip_off + ip_len > len)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): IPv4 header length or total length is invalid",
+                __func__);
+        return (-1);
+    }
+    if (iph[6] & (IP_DF >> 8))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): datagram has the DF bit set", __func__);
+        return (-1);
+    }
+
+    /* the datagram may itself be a fragment, which is split further */
+    fo   = ((iph[6] & 0x1f) << 8 | iph[7]) * 8;
+    mf   = iph[6] & (IP_MF >> 8);
+    evil = iph[6] & (IP_RF >> 8);
+    data = ip_len - hl;
+
+    opt_s = frag_ipv4_options(iph + LIBNET_IPV4_H, hl - LIBNET_IPV4_H, opt);
+    if (mtu < hl + 8 ||
+        mtu < LIBNET_IPV4_H + opt_s + (flags & LIBNET_FRAG_OVERLAP ? 16 : 8))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): MTU of %u bytes is too small", __func__, mtu);
+        return (-1);
+    }
+
+    /* fragment data comes in multiples of 8 bytes, but for the last one */
+    first = flags & LIBNET_FRAG_TINY ? 8 : (mtu - hl) & ~7;
+    rest  = (mtu - LIBNET_IPV4_H - opt_s) & ~7;
+    step  = rest - (flags & LIBNET_FRAG_OVERLAP ? 8 : 0);
+
+    /*
+     *  Fragments are reassembled by ID, and receivers and middleboxes take
+     *  an ID of 0 for "not set", so one is picked for the datagram.  The
+     *  ID of a datagram that is itself a fragment is left as it is, its
+     *  other fragments carry it too.
+     */
+    id = iph[4] << 8 | iph[5];
+    if (id == 0 && first < data && fo == 0 && !mf)
+    {
+        do
+        {
+            id = libnet_get_prand_r(l, LIBNET_PRu16);
+        } while (id == 0);
+    }
+
+    max     = 1 + (data + step - 1) / step;
+    frame_s = ip_off + hl + (first > rest ? first : rest);
+    fr = frag_room(l, max, frame_s);
+    if (fr == NULL)
+    {
+        return (-1);
+    }
+    f = l->frag_buf + max * sizeof (*fr);
+
+    for (n = off = 0; n == 0 || off < data; n++, f += frame_s)
+    {
+        start = n && (flags & LIBNET_FRAG_OVERLAP) ? off - 8 : off;
+        end   = start + (n ? rest : first);
+        if (end > data)
+        {
+            end = data;
+        }
+
+        /* the link header and the fixed part of the IPv4 header */
+        memcpy(f, packet, ip_off + LIBNET_IPV4_H);
+        if (n == 0)
+        {
+            h = hl;
+            memcpy(f + ip_off + LIBNET_IPV4_H, iph + LIBNET_IPV4_H,
+                    hl - LIBNET_IPV4_H);
+        }
+        else
+        {
+            h = LIBNET_IPV4_H + opt_s;
+            memcpy(f + ip_off + LIBNET_IPV4_H, opt, opt_s);
+            f[ip_off] = 0x40 | h >> 2;
+        }
+        memcpy(f + ip_off + h, iph + hl + start, end - start);
+
+        total = h + end - start;
+        v = (fo + start) / 8;
+        f[ip_off + 2] = total >> 8;
+        f[ip_off + 3] = total & 0xff;
+        f[ip_off + 4] = id >> 8;
+        f[ip_off + 5] = id & 0xff;
+        f[ip_off + 6] = evil | (end < data || mf ? IP_MF >> 8 : 0) | v >> 8;
+        f[ip_off + 7] = v & 0xff;
+
+        fr[n].buf = f;
+        fr[n].len = ip_off + total;
+        off = end;
+    }
+
+    frag_order(l, fr, n, flags);
+    if (libnet_checksum_batch(l, fr, n, ip_off, LIBNET_CSUM_IP) == -1)
+    {
+        return (-1);
+    }
+
+    *frames   = fr;
+    *frames_n = n;
+    return (1);
+}
+
+/*
+ *  Finds the end of the unfragmentable part of an IPv6 packet, RFC 8200
+ *  4.5: the IPv6 header, and the Hop-by-Hop Options and Routing headers
+ *  with the Destination Options headers before them.  *nh is where the
+ *  Next Header field that comes to point to the Fragment header is.
+ */
+static int
+frag_ipv6_unfragmentable(libnet_t *l, const uint8_t *iph, uint32_t ip_len,
+        uint32_t *unfrag, uint32_t *nh)
+{
+    uint32_t pos = LIBNET_IPV6_H, len;
+    uint8_t next = iph[6];
+
+    *unfrag = LIBNET_IPV6_H;
+    *nh     = 6;
+
+    while (next == IPPROTO_HOPOPTS || next == IPPROTO_ROUTING ||
+           next == IPPROTO_DSTOPTS)
+    {
+        if (pos + 8 > ip_len || pos + (len = (iph[pos + 1] + 1) * 8) > ip_len)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): extension header not inside packet", __func__);
+            return (-1);
+        }
+        if (next != IPPROTO_DSTOPTS)
+        {
+            *unfrag = pos + len;
+            *nh     = pos;
+        }
+        next = iph[pos];
+        pos += len;
+    }
+
+    if (iph[*nh] == IPPROTO_FRAGMENT)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): packet already has a Fragment header", __func__);
+        return (-1);
+    }
+    return (1);
+}
+
+LIBNET_API
+int
+libnet_fragment_ipv6(libnet_t *l, uint32_t mtu, int flags,
+        struct libnet_frame **frames, uint32_t *frames_n)
+{
+    uint32_t ip_off, len, ip_len, unfrag, nh, data, first, rest, step, max;
+    uint32_t frame_s, n, off, start, end, total, id;
+    struct libnet_frame *fr;
+    uint8_t *packet, *iph, *f, *fh;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (mtu == 0)
+    {
+        c = libnet_get_mtu(l);
+        if (c == -1)
+        {
+            /* err msg set in libnet_get_mtu() */
+            return (-1);
+        }
+        mtu = c;
+    }
+
+    /* the upper-layer checksum is computed here, once, over all the data */
+    if (frag_offset(l, LIBNET_PBLOCK_IPV6_H, &ip_off) == -1 ||
+        libnet_pblock_coalesce_cached(l, &packet, &len) == -1)
+    {
+        return (-1);
+    }
+
+    iph = packet + ip_off;
+    ip_len = len < ip_off + LIBNET_IPV6_H ? 0 :
+        LIBNET_IPV6_H + (iph[4] << 8 | iph[5]);
+    if (ip_len == 0 || ip_off + ip_len > len)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): IPv6 payload length is invalid", __func__);
+        return (-1);
+    }
+    if (frag_ipv6_unfragmentable(l, iph, ip_len, &unfrag, &nh) == -1)
+    {
+        return (-1);
+    }
+    data = ip_len - unfrag;
+
+    /* no atomic fragments, RFC 8021 */
+    if (ip_len <= mtu && !(flags & LIBNET_FRAG_TINY))
+    {
+        fr = frag_room(l, 1, len);
+        if (fr == NULL)
+        {
+            return (-1);
+        }
+        fr[0].buf = l->frag_buf + sizeof (*fr);
+        fr[0].len = len;
+        memcpy(fr[0].buf, packet, len);
+
+        *frames   = fr;
+        *frames_n = 1;
+        return (1);
+    }
+
+    if (mtu < unfrag + LIBNET_IPV6_FRAG_H +
+        (flags & LIBNET_FRAG_OVERLAP ? 16 : 8))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): MTU of %u bytes is too small", __func__, mtu);
+        return (-1);
+    }
+
+    /* fragment data comes in multiples of 8 bytes, but for the last one */
+    rest  = (mtu - unfrag - LIBNET_IPV6_FRAG_H) & ~7;
+    first = flags & LIBNET_FRAG_TINY ? 8 : rest;
+    step  = rest - (flags & LIBNET_FRAG_OVERLAP ? 8 : 0);
+
+    max     = 1 + (data + step - 1) / step;
+    frame_s = ip_off + unfrag + LIBNET_IPV6_FRAG_H + rest;
+    fr = frag_room(l, max, frame_s);
+    if (fr == NULL)
+    {
+        return (-1);
+    }
+    f  = l->frag_buf + max * sizeof (*fr);
+    id = libnet_get_prand_r(l, LIBNET_PRu32);
+
+    for (n = off = 0; n == 0 || off < data; n++, f += frame_s)
+    {
+        start = n && (flags & LIBNET_FRAG_OVERLAP) ? off - 8 : off;
+        end   = start + (n ? rest : first);
+        if (end > data)
+        {
+            end = data;
+        }
+
+        /* the link header and the unfragmentable part, then a Fragment header */
+        memcpy(f, packet, ip_off + unfrag);
+        f[ip_off + nh] = IPPROTO_FRAGMENT;
+        fh = f + ip_off + unfrag;
+        fh[0] = iph[nh];
+        fh[1] = 0;
+        fh[2] = start >> 8;
+        fh[3] = (start & 0xf8) | (end < data ? 1 : 0);
+        fh[4] = id >> 24;
+        fh[5] = (id >> 16) & 0xff;
+        fh[6] = (id >> 8) & 0xff;
+        fh[7] = id & 0xff;
+        memcpy(fh + LIBNET_IPV6_FRAG_H, iph + unfrag + start, end - start);
+
+        total = unfrag + LIBNET_IPV6_FRAG_H + end - start;
+        f[ip_off + 4] = (total - LIBNET_IPV6_H) >> 8;
+        f[ip_off + 5] = (total - LIBNET_IPV6_H) & 0xff;
+
+        fr[n].buf = f;
+        fr[n].len = ip_off + total;
+        off = end;
+    }
+
+    frag_order(l, fr, n, flags);
+
+    *frames   = fr;
+    *frames_n = n;
+    return (1);
+}
+
+LIBNET_API
+int
+libnet_write_fragmented(libnet_t *l, uint32_t mtu, int flags)
+{
+    struct libnet_frame *frames;
+    libnet_pblock_t *p;
+    uint32_t n;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    /* by the outermost IP header, the last in the list */
+    c = 0;
+    for (p = l->protocol_blocks; p; p = p->next)
+    {
+        if (p->type == LIBNET_PBLOCK_IPV4_H || p->type == LIBNET_PBLOCK_IPV6_H)
+        {
+            c = p->type;
+        }
+    }
+    if (c == LIBNET_PBLOCK_IPV6_H)
+    {
+        c = libnet_fragment_ipv6(l, mtu, flags, &frames, &n);
+    }
+    else
+    {
+        c = libnet_fragment_ipv4(l, mtu, flags, &frames, &n);
+    }
+    if (c == -1)
+    {
+        return (-1);
+    }
+
+    /* err msg set by the writer, the fragments are counted there */
+    if (libnet_write_batch(l, frames, n) != (int)n)
+    {
+        return (-1);
+    }
+    return (n);
+}
+
+/* a 16-bit word as libnet_in_cksum() adds it, in network byte order */
+static uint32_t
+seg_word(const uint8_t *p)
+{
+    uint16_t w;
+
+    memcpy(&w, p, sizeof (w));
+    return (w);
+}
+
+LIBNET_API
+int
+libnet_segment_tcp(libnet_t *l, const uint8_t *data, uint32_t data_s,
+        uint32_t mss, struct libnet_frame **frames, uint32_t *frames_n)
+{
+    uint32_t ip_off, tcp_off, len, hl, doff, hdr_s, frame_s, max, n, off;
+    uint32_t seg, seq, ip_base, tcp_base, sum, total;
+    uint16_t id, v;
+    struct libnet_frame *fr;
+    uint8_t *packet, *iph, *f, *tcp, th_flags;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    if (data == NULL && data_s)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL data", __func__);
+        return (-1);
+    }
+
+    if (frag_offset(l, LIBNET_PBLOCK_IPV4_H, &ip_off) == -1 ||
+        frag_offset(l, LIBNET_PBLOCK_TCP_H, &tcp_off) == -1 ||
+        libnet_pblock_coalesce_cached(l, &packet, &len) == -1)
+    {
+        return (-1);
+    }
+
+    iph = packet + ip_off;
+    hl  = (iph[0] & 0x0f) << 2;
+    if (len < ip_off + LIBNET_IPV4_H || hl < LIBNET_IPV4_H ||
+        tcp_off != ip_off + hl || iph[9] != IPPROTO_TCP)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): TCP header does not follow the IPv4 header", __func__);
+        return (-1);
+    }
+    if ((iph[6] & (IP_MF >> 8 | 0x1f)) || iph[7])
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): IPv4 header is that of a fragment", __func__);
+        return (-1);
+    }
+    doff = len < tcp_off + LIBNET_TCP_H ? 0 : (packet[tcp_off + 12] >> 4) << 2;
+    if (doff < LIBNET_TCP_H || tcp_off + doff > len)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): TCP data offset is invalid", __func__);
+        return (-1);
+    }
+    hdr_s = tcp_off + doff;
+
+    if (mss == 0)
+    {
+        c = libnet_get_mtu(l);
+        if (c == -1)
+        {
+            /* err msg set in libnet_get_mtu() */
+            return (-1);
+        }
+        mss = (uint32_t)c > hl + doff ? c - hl - doff : 0;
+    }
+    if (mss == 0 || hl + doff + mss > IP_MAXPACKET)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): MSS of %u bytes is out of range", __func__, mss);
+        return (-1);
+    }
+
+    /* an empty stream is one segment, a bare FIN or ACK */
+    max     = data_s ? (data_s - 1) / mss + 1 : 1;
+    frame_s = hdr_s + (data_s < mss ? data_s : mss);
+    fr = frag_room(l, max, frame_s);
+    if (fr == NULL)
+    {
+        return (-1);
+    }
+    f = l->frag_buf + max * sizeof (*fr);
+
+    /*
+     *  The headers, any template payload dropped, are the same in every
+     *  segment but for the fields set below.  Their sums are taken once,
+     *  with those fields zeroed, the pseudo header in the TCP one; each
+     *  segment adds its own fields and data.
+     */
+    memcpy(f, packet, hdr_s);
+    iph = f + ip_off;
+    tcp = f + tcp_off;
+    id  = iph[4] << 8 | iph[5];
+    seq = (uint32_t)tcp[4] << 24 | tcp[5] << 16 | tcp[6] << 8 | tcp[7];
+    th_flags = tcp[13];
+
+    memset(iph + 2, 0, 4);              /* total length, identification */
+    memset(iph + 10, 0, 2);
+    memset(tcp + 4, 0, 4);              /* sequence number */
+    memset(tcp + 12, 0, 2);             /* data offset, flags */
+    memset(tcp + 16, 0, 2);
+    ip_base  = libnet_in_cksum((uint16_t *)iph, hl);
+    tcp_base = libnet_in_cksum((uint16_t *)(iph + 12), 8) + htons(IPPROTO_TCP) +
+        libnet_in_cksum((uint16_t *)tcp, doff);
+
+    for (n = off = 0; n < max; n++, f += frame_s, off += seg)
+    {
+        seg = data_s - off < mss ? data_s - off : mss;
+        memcpy(f, packet, hdr_s);
+        iph = f + ip_off;
+        tcp = f + tcp_off;
+        if (seg)
+        {
+            memcpy(tcp + doff, data + off, seg);
+        }
+
+        total = hl + doff + seg;
+        iph[2] = total >> 8;
+        iph[3] = total & 0xff;
+        iph[4] = (uint16_t)(id + n) >> 8;
+        iph[5] = (uint16_t)(id + n) & 0xff;
+        sum = ip_base + seg_word(iph + 2) + seg_word(iph + 4);
+        v = LIBNET_CKSUM_CARRY(sum);
+        memcpy(iph + 10, &v, sizeof (v));
+
+        /* as TSO hardware does: CWR on the first, PSH and FIN on the last */
+        tcp[4]  = (seq + off) >> 24;
+        tcp[5]  = ((seq + off) >> 16) & 0xff;
+        tcp[6]  = ((seq + off) >> 8) & 0xff;
+        tcp[7]  = (seq + off) & 0xff;
+        tcp[12] = (doff >> 2) << 4;
+        tcp[13] = th_flags & ~((n ? TH_CWR : 0) |
+                (n + 1 < max ? TH_PUSH | TH_FIN : 0));
+        sum = tcp_base + htons(doff + seg) + seg_word(tcp + 4) +
+            seg_word(tcp + 6) + seg_word(tcp + 12) +
+            libnet_in_cksum((uint16_t *)(tcp + doff), seg);
+        v = LIBNET_CKSUM_CARRY(sum);
+        memcpy(tcp + 16, &v, sizeof (v));
+
+        fr[n].buf = f;
+        fr[n].len = tcp_off + doff + seg;
+    }
+
+    *frames   = fr;
+    *frames_n = n;
+    return (1);
+}
+
+LIBNET_API
+int
+libnet_write_segmented(libnet_t *l, const uint8_t *data, uint32_t data_s,
+        uint32_t mss)
+{
+    struct libnet_frame *frames;
+    uint32_t n;
+
+    if (libnet_segment_tcp(l, data, data_s, mss, &frames, &n) == -1)
+    {
+        return (-1);
+    }
+
+    /* err msg set by the writer, the segments are counted there */
+    if (libnet_write_batch(l, frames, n) != (int)n)
+    {
+        return (-1);
+    }
+    return (n);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -125,7 +125,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
         return 0;
     }
 
-    ifaddrlist = calloc(ip_addr_num, sizeof(struct libnet_ifaddr_list));
+    ifaddrlist = libnet_calloc(NULL, ip_addr_num, sizeof(struct libnet_ifaddr_list));
     if (!ifaddrlist)
     {
         snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM when allocating initial ifaddrlist", __func__);
@@ -142,7 +142,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
         if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET)
             continue;
 
-        al->device = strdup(ifa->ifa_name);
+        al->device = libnet_strdup(NULL, ifa->ifa_name);
         if (al->device == NULL)
         {
             snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM", __func__);
@@ -156,7 +156,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
 
             /* grow by a factor of 1.5, close enough to golden ratio */
             ip_addr_num += ip_addr_num >> 2;
-            tmp = realloc(ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
+            tmp = libnet_realloc(NULL, ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
             if (!tmp)
             {
                 snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM reallocating ifaddrlist", __func__);
@@ -217,7 +217,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
 	goto bad;
     }
 
-    ifaddrlist = calloc(ip_addr_num, sizeof(struct libnet_ifaddr_list));
+    ifaddrlist = libnet_calloc(NULL, ip_addr_num, sizeof(struct libnet_ifaddr_list));
     if (!ifaddrlist)
     {
         snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM when allocating initial ifaddrlist", __func__);
@@ -263,7 +263,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
             al->addr = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr;
         }
 
-        al->device = strdup(ifr.ifr_name);
+        al->device = libnet_strdup(NULL, ifr.ifr_name);
         if (al->device == NULL)
         {
             snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): strdup not enough memory", __func__);
@@ -276,7 +276,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
 
             /* grow by a factor of 1.5, close enough to golden ratio */
             ip_addr_num += ip_addr_num >> 2;
-            tmp = realloc(ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
+            tmp = libnet_realloc(NULL, ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
             if (!tmp) {
                 snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM reallocating ifaddrlist", __func__);
                 break;
@@ -299,7 +299,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
     return ((int)nipaddr);
 bad:
     if (ifaddrlist)
-        free(ifaddrlist);
+        libnet_free(ifaddrlist);
     if (fp)
 	fclose(fp);
     close(fd);
@@ -343,7 +343,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
     pifr = NULL;
     struct ifreq * const lifr = (struct ifreq *)&ifc.ifc_buf[ifc.ifc_len];
 
-    ifaddrlist = calloc(ip_addr_num, sizeof(struct libnet_ifaddr_list));
+    ifaddrlist = libnet_calloc(NULL, ip_addr_num, sizeof(struct libnet_ifaddr_list));
     if (!ifaddrlist)
     {
         snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM when allocating initial ifaddrlist", __func__);
@@ -398,7 +398,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
             al->addr = ((struct sockaddr_in *)&nifr.ifr_addr)->sin_addr.s_addr;
         }
         
-        al->device = strdup(nifr.ifr_name);
+        al->device = libnet_strdup(NULL, nifr.ifr_name);
         if (al->device == NULL)
         {
             snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): strdup not enough memory", __func__);
@@ -411,7 +411,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
 
             /* grow by a factor of 1.5, close enough to golden ratio */
             ip_addr_num += ip_addr_num >> 2;
-            tmp = realloc(ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
+            tmp = libnet_realloc(NULL, ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
             if (!tmp) {
                 snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM reallocating ifaddrlist", __func__);
                 break;
@@ -429,7 +429,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, const char *dev, char *er
     return ((int)nipaddr);
 bad:
     if (ifaddrlist)
-        free(ifaddrlist);
+        libnet_free(ifaddrlist);
     close(fd);
     return (-1);
 }
@@ -472,7 +472,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, char *unused, char *errbu
         return (-1);
     }
 
-    ifaddrlist = calloc(ip_addr_num, sizeof(struct libnet_ifaddr_list));
+    ifaddrlist = libnet_calloc(NULL, ip_addr_num, sizeof(struct libnet_ifaddr_list));
     if (!ifaddrlist)
     {
         snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM when allocating initial ifaddrlist", __func__);
@@ -507,7 +507,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, char *unused, char *errbu
             if (addr->sa_family != AF_INET)
                 continue;
 
-            al->device = strdup(dev->name);
+            al->device = libnet_strdup(NULL, dev->name);
             al->addr = ((struct sockaddr_in *)addr)->sin_addr.s_addr;
             ++nipaddr;
 
@@ -517,7 +517,7 @@ libnet_ifaddrlist(struct libnet_ifaddr_list **ipaddrp, char *unused, char *errbu
 
                 /* grow by a factor of 1.5, close enough to golden ratio */
                 ip_addr_num += ip_addr_num >> 2;
-                tmp = realloc(ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
+                tmp = libnet_realloc(NULL, ifaddrlist, ip_addr_num * sizeof(struct libnet_ifaddr_list));
                 if (!tmp)
                 {
                     snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): OOM reallocating ifaddrlist", __func__);
@@ -587,8 +587,8 @@ libnet_select_device(libnet_t *l)
             if (!strcmp(l->device, al->device) ||  al->addr == addr)
             {
                 /* free the "user supplied device" - see libnet_init() */
-                free(l->device);
-                l->device =  strdup(address_list->device);
+                libnet_free(l->device);
+                l->device =  libnet_strdup(l, address_list->device);
                 goto good;
             }
         }
@@ -601,7 +601,7 @@ libnet_select_device(libnet_t *l)
     }
     else
     {
-        l->device = strdup(address_list->device);
+        l->device = libnet_strdup(l, address_list->device);
     }
 
 good:
@@ -610,10 +610,10 @@ end:
     if (address_list) {
         for (i = 0; i < c; i++)
         {
-            free(address_list[i].device);
+            libnet_free(address_list[i].device);
             address_list[i].device = NULL;
         }
-        free(address_list);
+        libnet_free(address_list);
     }
 
     return rc;
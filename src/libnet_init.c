@@ -48,7 +48,7 @@ libnet_init(int injection_type, const char *device, char *err_buf)
     }
 #endif
 
-    l = (libnet_t *)malloc(sizeof (libnet_t));
+    l = (libnet_t *)libnet_malloc(NULL, sizeof (libnet_t));
     if (l == NULL)
     {
         snprintf(err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s", __func__,
@@ -58,9 +58,11 @@ libnet_init(int injection_type, const char *device, char *err_buf)
 	
     memset(l, 0, sizeof (*l));
 
+    l->alloc_count      = 1;            /* the context itself */
+    l->alloc_bytes      = sizeof (*l);
     l->injection_type   = injection_type;
     l->ptag_state       = LIBNET_PTAG_INITIALIZER;
-    l->device           = (device ? strdup(device) : NULL);
+    l->device           = (device ? libnet_strdup(l, device) : NULL);
     l->fd               = -1;
 
     strncpy(l->label, LIBNET_LABEL_DEFAULT, LIBNET_LABEL_SIZE);
@@ -99,6 +101,20 @@ libnet_init(int injection_type, const char *device, char *err_buf)
                 goto bad;
             }
             break;
+        case LIBNET_SHM:
+#ifdef HAVE_SHM_OPEN
+            if (libnet_open_shm(l) == -1)
+            {
+                snprintf(err_buf, LIBNET_ERRBUF_SIZE, "%s", l->err_buf);
+                goto bad;
+            }
+            break;
+#else
+            snprintf(err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): no shared memory support on this platform",
+                    __func__);
+            goto bad;
+#endif
         default:
             snprintf(err_buf, LIBNET_ERRBUF_SIZE,
                     "%s(): unsupported injection type", __func__);
@@ -121,13 +137,142 @@ libnet_destroy(libnet_t *l)
 {
     if (l)
     {
-        if (l->fd != -1)
+#ifdef HAVE_PTHREAD
+        if (l->tx)
+            libnet_tx_stop(l);
+#endif
+        if (l->stats_page)
+            libnet_stats_unpublish(l);
+        if (l->ts)
+            libnet_ts_stop(l);
+        if (l->fd != -1 && (l->fd_share == NULL ||
+            __atomic_sub_fetch(&l->fd_share->refs, 1, __ATOMIC_ACQ_REL) == 0))
+        {
             close(l->fd);
+            libnet_free(l->fd_share);
+        }
+#ifdef HAVE_SHM_OPEN
+        if (l->shm)
+            libnet_close_shm(l);
+#endif
         if (l->device)
-            free(l->device);
+            libnet_free(l->device);
         libnet_clear_packet(l);
-        free(l);
+        libnet_carousel_free(l);
+        libnet_lsdb_free(l);
+        libnet_bgp4_packer_free(l);
+        libnet_dns_free(l);
+        libnet_periodic_free(l);
+        libnet_lldp_free(l);
+        libnet_free(l->write_buf);
+        libnet_free(l->frag_buf);
+        libnet_free(l);
+    }
+}
+
+int
+libnet_fd_share(libnet_t *l)
+{
+    if (l->fd_share)
+    {
+        return (1);
+    }
+
+    l->fd_share = libnet_calloc(l, 1, sizeof (*l->fd_share));
+    if (l->fd_share == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+    l->fd_share->refs = 1;
+
+    return (1);
+}
+
+libnet_t *
+libnet_clone(libnet_t *l)
+{
+    libnet_t *c;
+
+    if (l == NULL)
+    {
+        return (NULL);
+    }
+
+    c = (libnet_t *)libnet_malloc(NULL, sizeof (libnet_t));
+    if (c == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        return (NULL);
+    }
+    memset(c, 0, sizeof (*c));
+
+    c->alloc_count      = 1;
+    c->alloc_bytes      = sizeof (*c);
+    c->injection_type   = l->injection_type;
+    c->ptag_state       = l->ptag_state;
+    c->link_type        = l->link_type;
+    c->link_offset      = l->link_offset;
+    c->link_addr        = l->link_addr;
+    c->csum_defer       = l->csum_defer;
+    c->stats_timing     = l->stats_timing;
+    c->fd               = -1;
+#if ((_WIN32) && !(__CYGWIN__))
+    c->lpAdapter        = l->lpAdapter;
+#endif
+
+    strncpy(c->label, LIBNET_LABEL_DEFAULT, LIBNET_LABEL_SIZE);
+    c->label[LIBNET_LABEL_SIZE - 1] = '\0';
+
+    if (l->device)
+    {
+        c->device = libnet_strdup(c, l->device);
+        if (c->device == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): strdup(): %s",
+                    __func__, strerror(errno));
+            goto bad;
+        }
     }
+
+#ifdef HAVE_SHM_OPEN
+    if (l->shm)
+    {
+        /* a mapping of its own, the ring takes any number of producers */
+        if (libnet_open_shm(c) == -1)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s", c->err_buf);
+            goto bad;
+        }
+    }
+#endif
+
+    /* a ring mapping has no socket */
+    if (l->fd != -1)
+    {
+        /* one socket, the last context to go closes it */
+        if (libnet_fd_share(l) == -1)
+        {
+            goto bad;
+        }
+        __atomic_add_fetch(&l->fd_share->refs, 1, __ATOMIC_RELAXED);
+        c->fd = l->fd;
+        c->fd_share = l->fd_share;
+    }
+
+    if (libnet_pblock_clone(c, l) == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s", c->err_buf);
+        goto bad;
+    }
+
+    return (c);
+
+bad:
+    libnet_destroy(c);
+    return (NULL);
 }
 
 void
@@ -147,6 +292,11 @@ libnet_clear_packet(libnet_t *l)
 
     /* All pblocks are deleted, so start the tag count over from 1. */
     l->ptag_state = 0;
+
+    /* Variations refer to the old ptags, which are about to be reused. */
+    libnet_vary_clear(l);
+    libnet_lldp_free(l);
+    libnet_dns_clear_ptag(l);
 }
 
 void
@@ -218,6 +368,11 @@ libnet_getpbuf(libnet_t *l, libnet_ptag_t ptag)
         /* err msg set in libnet_pblock_find() */
         return (NULL);
     }
+    else if (libnet_pblock_own(l, p) == -1)
+    {
+        /* the caller may write to it, err msg set in libnet_pblock_own() */
+        return (NULL);
+    }
     else
     {
         return (p->buf);
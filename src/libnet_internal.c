@@ -96,6 +96,9 @@ libnet_diag_dump_context(const libnet_t *l)
         case LIBNET_RAW6_ADV:
             fprintf(stderr, "injection type:\tLIBNET_RAW6_ADV\n");
             break;
+        case LIBNET_SHM:
+            fprintf(stderr, "injection type:\tLIBNET_SHM\n");
+            break;
         default:
             fprintf(stderr, "injection type:\tinvalid injection type %d\n", 
                     l->injection_type);
@@ -111,6 +114,14 @@ libnet_diag_dump_context(const libnet_t *l)
     fprintf(stderr, "packets sent:\t%lld\n", (long long int)l->stats.packets_sent);
     fprintf(stderr, "packet errors:\t%lld\n", (long long int)l->stats.packet_errors);
     fprintf(stderr, "bytes written:\t%lld\n", (long long int)l->stats.bytes_written);
+    fprintf(stderr, "write errors:\t%lld nobufs, %lld again, %lld msgsize, "
+            "%lld perm, %lld other, %lld partial\n",
+            (long long int)l->xstats.err_nobufs,
+            (long long int)l->xstats.err_again,
+            (long long int)l->xstats.err_msgsize,
+            (long long int)l->xstats.err_perm,
+            (long long int)l->xstats.err_other,
+            (long long int)l->xstats.partial_writes);
     fprintf(stderr, "ptag state:\t%d\n", l->ptag_state);
     fprintf(stderr, "context label:\t%s\n", l->label);
     fprintf(stderr, "last errbuf:\t%s\n", l->err_buf);
@@ -336,6 +347,8 @@ libnet_diag_dump_pblock_type(uint8_t type)
             return ("udld_device_name");
         case LIBNET_PBLOCK_UDLD_SEQ_NUMBER_H:
             return ("udld_sequence_number");
+        case LIBNET_PBLOCK_SNMP_H:
+            return ("snmp");
     }
     return ("unrecognized pblock");
 }
@@ -247,7 +247,9 @@ libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size)
         return (-1);
     } 
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const int c = write(l->fd, packet, size);
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != size)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -293,7 +295,7 @@ libnet_get_hwaddr(libnet_t *l)
         return (NULL);
     }
 
-    int8_t * const buf = (int8_t *)malloc(len);
+    int8_t * const buf = (int8_t *)libnet_malloc(l, len);
     if (buf == NULL)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
@@ -304,7 +306,7 @@ libnet_get_hwaddr(libnet_t *l)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): sysctl(): %s",
                 __func__, strerror(errno));
-        free(buf);
+        libnet_free(buf);
         return (NULL);
     }
     int8_t * const end = buf + len;
@@ -340,7 +342,7 @@ libnet_get_hwaddr(libnet_t *l)
             }
         }
     }
-    free(buf);
+    libnet_free(buf);
     if (next == end)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
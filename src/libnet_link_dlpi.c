@@ -735,7 +735,9 @@ libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size)
     data.len    = size;                                
     data.buf    = packet;  
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const int c = putmsg(l->fd, &ctl, &data, 0);
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c == -1)                      
     {                    
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -763,7 +765,9 @@ libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size)
     data.len    = size;
     data.buf    = packet;
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const int c = putmsg(l->fd, NULL, &data, 0);
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c == -1)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -786,7 +790,7 @@ libnet_get_hwaddr(libnet_t *l)
         return (NULL);
     }
 
-    int8_t * const buf = (int8_t *)malloc(2048);
+    int8_t * const buf = (int8_t *)libnet_malloc(l, 2048);
     if (buf == NULL)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
@@ -802,19 +806,19 @@ libnet_get_hwaddr(libnet_t *l)
     if (send_request(l->fd, (int8_t *)dlp, DL_PHYS_ADDR_REQ_SIZE, "physaddr",
             l->err_buf, 0) < 0)
     {
-        free(buf);
+        libnet_free(buf);
         return (NULL);
     }
     if (recv_ack(l->fd, DL_PHYS_ADDR_ACK_SIZE, "physaddr", (int8_t *)dlp,
             l->err_buf) < 0)
     {
-        free(buf);
+        libnet_free(buf);
         return (NULL);
     }
 
     int8_t * const mac = (int8_t *)dlp + dlp->physaddr_ack.dl_addr_offset;
     memcpy(l->link_addr.ether_addr_octet, mac, ETHER_ADDR_LEN);
-    free(buf);
+    libnet_free(buf);
 
     return (&l->link_addr);
 }   
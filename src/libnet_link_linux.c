@@ -217,8 +217,10 @@ libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size)
     }
     sa.sll_protocol  = htons(ETH_P_ALL);
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const ssize_t c = sendto(l->fd, packet, size, 0,
             (struct sockaddr *)&sa, sizeof (sa));
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != (ssize_t)size)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -228,6 +230,78 @@ libnet_write_link(libnet_t *l, const uint8_t *packet, uint32_t size)
     return (c);
 }
 
+#ifdef HAVE_LINK_BATCH
+/* frames handed to one sendmmsg() call */
+#define LIBNET_LINK_BATCH_MAX 64
+
+int
+libnet_write_link_batch(libnet_t *l, const struct libnet_frame *frames,
+        uint32_t n)
+{
+    struct mmsghdr msg[LIBNET_LINK_BATCH_MAX];
+    struct iovec iov[LIBNET_LINK_BATCH_MAX];
+    struct sockaddr_ll sa;
+    uint32_t done, i;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    /* one ioctl per batch instead of one per frame */
+    memset(&sa, 0, sizeof (sa));
+    sa.sll_family    = AF_PACKET;
+    sa.sll_ifindex   = get_iface_index(l->fd, l->device);
+    if (sa.sll_ifindex == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no index for %s: %s", __func__, l->device,
+                strerror(errno));
+        return (0);
+    }
+    sa.sll_protocol  = htons(ETH_P_ALL);
+
+    for (done = 0; done < n; )
+    {
+        uint32_t cnt = n - done;
+        uint64_t t0;
+        int c;
+
+        if (cnt > LIBNET_LINK_BATCH_MAX)
+        {
+            cnt = LIBNET_LINK_BATCH_MAX;
+        }
+
+        memset(msg, 0, cnt * sizeof (msg[0]));
+        for (i = 0; i < cnt; i++)
+        {
+            iov[i].iov_base = frames[done + i].buf;
+            iov[i].iov_len  = frames[done + i].len;
+            msg[i].msg_hdr.msg_name    = &sa;
+            msg[i].msg_hdr.msg_namelen = sizeof (sa);
+            msg[i].msg_hdr.msg_iov     = &iov[i];
+            msg[i].msg_hdr.msg_iovlen  = 1;
+        }
+
+        t0 = libnet_stats_clock(l);
+        LIBNET_PROBE2(write_entry, __func__, cnt);
+        c = sendmmsg(l->fd, msg, cnt, 0);
+        LIBNET_PROBE3(write_return, __func__, c, errno);
+        libnet_stats_syscall(l, t0);
+        if (c == -1)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): sendmmsg: %s", __func__, strerror(errno));
+            break;
+        }
+        /* on a short count, the next round reports the failing frame */
+        done += c;
+    }
+
+    return (done);
+}
+#endif  /* HAVE_LINK_BATCH */
+
 
 struct libnet_ether_addr *
 libnet_get_hwaddr(libnet_t *l)
@@ -47,7 +47,7 @@ libnet_open_link_interface(const int8_t *device, int8_t *ebuf)
 {
     struct sockaddr_nit snit;
 
-    struct libnet_link_int * const l = (struct libnet_link_int *)malloc(sizeof(*p));
+    struct libnet_link_int * const l = (struct libnet_link_int *)libnet_malloc(NULL, sizeof(*p));
     if (l == NULL)
     {
         strcpy(ebuf, strerror(errno));
@@ -86,7 +86,7 @@ bad:
     {
         close(l->fd);
     }
-    free(l);
+    libnet_free(l);
     return (NULL);
 }
 
@@ -97,12 +97,12 @@ libnet_close_link_interface(struct libnet_link_int *l)
 {
     if (close(l->fd) == 0)
     {
-        free(l);
+        libnet_free(l);
         return (1);
     }
     else
     {
-        free(l);
+        libnet_free(l);
         return (-1);
     }
 }
@@ -117,7 +117,9 @@ write_link_layer(const struct libnet_link_int *l, const int8_t *device,
     memset(&sa, 0, sizeof(sa));
     strncpy(sa.sa_data, device, sizeof(sa.sa_data));
 
+    LIBNET_PROBE2(write_entry, __func__, len);
     const int c = sendto(l->fd, buf, len, 0, &sa, sizeof(sa));
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != len)
     {
         /* error */
@@ -53,7 +53,7 @@ libnet_open_link_interface(const int8_t *device, int8_t *ebuf)
     struct enfilter Filter;
     struct endevp devparams;
 
-    struct libnet_link_int * const l = (struct libnet_link_int *)malloc(sizeof(*l));
+    struct libnet_link_int * const l = (struct libnet_link_int *)libnet_malloc(NULL, sizeof(*l));
     if (l == NULL)
     {
         snprintf(ebuf, LIBNET_ERRBUF_SIZE,
@@ -136,7 +136,7 @@ libnet_open_link_interface(const int8_t *device, int8_t *ebuf)
 
     return (l);
 bad:
-    free(l);
+    libnet_free(l);
     return (NULL);
 }
 
@@ -147,12 +147,12 @@ libnet_close_link_interface(struct libnet_link_int *l)
 {
     if (close(l->fd) == 0)
     {
-        free(l);
+        libnet_free(l);
         return (1);
     }
     else
     {
-        free(l);
+        libnet_free(l);
         return (-1);
     }
 }
@@ -162,7 +162,9 @@ int
 libnet_write_link_layer(struct libnet_link_int *l, const int8_t *device,
             const uint8_t *buf, int len)
 {
+    LIBNET_PROBE2(write_entry, __func__, len);
     const int c = write(l->fd, buf, len);
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != len)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -53,7 +53,7 @@ libnet_open_link_interface(const int8_t *device, int8_t *ebuf)
     struct ifreq ifr;       /* interface request struct */
     static const int8_t dev[] = "/dev/nit";
 
-    struct libnet_link_int * const l = (struct libnet_link_int *)malloc(sizeof(*l));
+    struct libnet_link_int * const l = (struct libnet_link_int *)libnet_malloc(NULL, sizeof(*l));
     if (l == NULL)
     {
         strcpy(ebuf, strerror(errno));
@@ -112,7 +112,7 @@ bad:
     {
         close(l->fd);
     }
-    free(l);
+    libnet_free(l);
     return (NULL);
 }
 
@@ -123,12 +123,12 @@ libnet_close_link_interface(struct libnet_link_int *l)
 {
     if (close(l->fd) == 0)
     {
-        free(l);
+        libnet_free(l);
         return (1);
     }
     else
     {
-        free(l);
+        libnet_free(l);
         return (-1);
     }
 }
@@ -143,7 +143,9 @@ libnet_write_link_layer(struct libnet_link_int *l, const int8_t *device,
     memset(&sa, 0, sizeof(sa));
     strncpy(sa.sa_data, device, sizeof(sa.sa_data));
 
+    LIBNET_PROBE2(write_entry, __func__, len);
     const int c = sendto(l->fd, buf, len, 0, &sa, sizeof(sa));
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != len)
     {
         /* err */
@@ -133,7 +133,7 @@ libnet_open_link(libnet_t *l)
 bad:
     /* FIXME: Is this bug? closing uninitialized fd */
     close(fd);
-    free(l);
+    libnet_free(l);
     return -1;
 }
 
@@ -170,7 +170,10 @@ libnet_write_link(libnet_t *l, const uint8_t *buf, uint32_t len)
 
     memcpy(eh->ether_shost, ifr.ifr_addr.sa_data, sizeof(eh->ether_shost));
 
-    if (write(l->fd, buf, len) == -1)
+    LIBNET_PROBE2(write_entry, __func__, len);
+    c = write(l->fd, buf, len);
+    LIBNET_PROBE3(write_return, __func__, c, errno);
+    if (c == -1)
     {
         /* err */
         return (-1);
@@ -212,7 +215,7 @@ libnet_get_hwaddr(libnet_t *l)
     }
     if (ea)
     {
-        free(ea);
+        libnet_free(ea);
         ea = 0;
     }
 
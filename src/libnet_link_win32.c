@@ -208,8 +208,11 @@ libnet_write_link(libnet_t *l, const uint8_t *data, uint32_t size)
      */
     PacketInitPacket(&pkt, (PVOID)data, size);
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     if (PacketSendPacket(l->lpAdapter, &pkt, TRUE))
        BytesTransfered = size;
+    LIBNET_PROBE3(write_return, __func__, (int)BytesTransfered,
+            (int)GetLastError());
 
     return (BytesTransfered);
  }
@@ -237,7 +240,7 @@ libnet_get_hwaddr(libnet_t *l)
         }
     }
 
-    const PPACKET_OID_DATA OidData = (struct _PACKET_OID_DATA *)malloc(IoCtlBufferLength);
+    const PPACKET_OID_DATA OidData = (struct _PACKET_OID_DATA *)libnet_malloc(l, IoCtlBufferLength);
     if (OidData == NULL)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -266,7 +269,7 @@ libnet_get_hwaddr(libnet_t *l)
             mac->ether_addr_octet[i] = OidData->Data[i];
         }
     }
-    free(OidData);
+    libnet_free(OidData);
     return(mac);
 }
 
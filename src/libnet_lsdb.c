@@ -0,0 +1,379 @@
+/*
+ *  libnet
+ *  libnet_lsdb.c - synthetic OSPF link state databases
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  A synthetic LSDB is kept as the LSAs themselves, wire-ready and
+ *  checksummed, back to back in one slab in the order they are packed into
+ *  LSUs.  Each LSU is a run of LSAs in the slab, handed to
+ *  libnet_build_ospfv2_lsu() as its payload, so there is one pblock per
+ *  LSU rather than two per LSA.
+ */
+#define LIBNET_LSDB_SEQ_INIT    0x80000001  /* InitialSequenceNumber */
+#define LIBNET_LSDB_SEQ_MAX     0x7fffffff  /* MaxSequenceNumber */
+#define LIBNET_LSDB_METRIC      10
+#define LIBNET_LSDB_MTU         1500
+
+struct libnet_lsdb_lsu
+{
+    uint32_t off;                       /* first LSA in the slab */
+    uint32_t len;                       /* bytes of LSAs */
+    uint32_t num;                       /* number of LSAs */
+};
+
+struct libnet_lsdb
+{
+    uint8_t *slab;                      /* the LSAs, LSU by LSU */
+    struct libnet_lsdb_lsu *lsu;        /* LSU index into the slab */
+    uint32_t n;                         /* number of LSUs */
+};
+
+static void
+lsdb_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void
+lsdb_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/*
+ *  Writes LSA k of the database to buf, router LSAs first, then network
+ *  and summary LSAs, and returns its length.  With buf NULL only the
+ *  length is returned.
+ */
+static uint32_t
+lsdb_lsa(const struct libnet_lsdb_spec *spec, uint32_t seq, uint32_t k,
+        uint8_t *buf)
+{
+    uint32_t len, i, id, adv;
+    uint8_t type, *p;
+
+    if (k < spec->routers)
+    {
+        type = LIBNET_LS_TYPE_RTR;
+        len  = LIBNET_OSPF_LSA_H + 4 + 12 * spec->links;
+        id   = spec->router_id + k;
+        adv  = id;
+    }
+    else if ((k -= spec->routers) < spec->networks)
+    {
+        type = LIBNET_LS_TYPE_NET;
+        len  = LIBNET_OSPF_LSA_H + 4 + 4 * spec->attached;
+        id   = spec->prefix + (k << 8) + 1;     /* the DR's address */
+        adv  = spec->router_id + k % spec->routers;
+    }
+    else
+    {
+        k   -= spec->networks;
+        type = LIBNET_LS_TYPE_IP;
+        len  = LIBNET_OSPF_LSA_H + 8;
+        id   = spec->prefix + ((spec->networks + k) << 8);
+        adv  = spec->router_id + k % spec->routers;
+    }
+
+    if (buf == NULL)
+    {
+        return (len);
+    }
+
+    lsdb_put16(buf, spec->age);
+    buf[2] = spec->opts;
+    buf[3] = type;
+    lsdb_put32(buf + 4, id);
+    lsdb_put32(buf + 8, adv);
+    lsdb_put32(buf + 12, seq);
+    lsdb_put16(buf + 18, (uint16_t)len);
+    p = buf + LIBNET_OSPF_LSA_H;
+
+    switch (type)
+    {
+        case LIBNET_LS_TYPE_RTR:
+            /* point-to-point links to the next routers along */
+            lsdb_put16(p, 0);
+            lsdb_put16(p + 2, spec->links);
+            for (i = 0, p += 4; i < spec->links; i++, p += 12)
+            {
+                lsdb_put32(p, spec->router_id +
+                        (k + i + 1) % spec->routers);
+                lsdb_put32(p + 4, id);
+                p[8] = LIBNET_RTR_TYPE_PTP;
+                p[9] = 0;
+                lsdb_put16(p + 10, LIBNET_LSDB_METRIC);
+            }
+            break;
+        case LIBNET_LS_TYPE_NET:
+            lsdb_put32(p, 0xffffff00);
+            for (i = 0, p += 4; i < spec->attached; i++, p += 4)
+            {
+                lsdb_put32(p, spec->router_id + (k + i) % spec->routers);
+            }
+            break;
+        default:
+            lsdb_put32(p, 0xffffff00);
+            lsdb_put32(p + 4, 1 + k % 1000);
+            break;
+    }
+
+    libnet_ospf_lsa_cksum(buf, len);
+    return (len);
+}
+
+int
+libnet_lsdb_build(libnet_t *l, const struct libnet_lsdb_spec *spec)
+{
+    struct libnet_lsdb *db = NULL;
+    uint32_t room, total, k, len, n, used, seq;
+    uint64_t size;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (spec == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL spec",
+                __func__);
+        return (-1);
+    }
+
+    /* room for LSAs once the IPv4, OSPF (auth too) and LSU headers are in */
+    room = spec->mtu ? spec->mtu : LIBNET_LSDB_MTU;
+    if (room > IP_MAXPACKET)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): mtu %u too large",
+                __func__, room);
+        return (-1);
+    }
+    if (room <= LIBNET_IPV4_H + LIBNET_OSPF_H + LIBNET_OSPF_AUTH_H +
+            LIBNET_OSPF_LSU_H)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): mtu %u too small",
+                __func__, room);
+        return (-1);
+    }
+    room -= LIBNET_IPV4_H + LIBNET_OSPF_H + LIBNET_OSPF_AUTH_H +
+            LIBNET_OSPF_LSU_H;
+
+    if (spec->routers == 0 || spec->attached > spec->routers)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): need at least one router, and no more attached "
+                "than there are", __func__);
+        return (-1);
+    }
+    size = (uint64_t)spec->routers + spec->networks + spec->summaries;
+    if (size > UINT32_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): %llu LSAs is too many",
+                __func__, (unsigned long long)size);
+        return (-1);
+    }
+    total = size;
+    if (LIBNET_OSPF_LSA_H + 4 + 12 * (uint64_t)spec->links > room ||
+        LIBNET_OSPF_LSA_H + 4 + 4 * (uint64_t)spec->attached > room)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): an LSA does not fit in %u bytes of LSU", __func__,
+                room);
+        return (-1);
+    }
+
+    seq = spec->seq ? spec->seq : LIBNET_LSDB_SEQ_INIT;
+
+    /* count the LSUs first, packing greedily, LSAs in order */
+    size = 0;
+    n = 1;
+    used = 0;
+    for (k = 0; k < total; k++)
+    {
+        len = lsdb_lsa(spec, seq, k, NULL);
+        if (used + len > room)
+        {
+            n++;
+            used = 0;
+        }
+        used += len;
+        size += len;
+    }
+    if (size > UINT32_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): %llu bytes of LSAs is too many", __func__,
+                (unsigned long long)size);
+        return (-1);
+    }
+
+    db = libnet_calloc(l, 1, sizeof (*db));
+    if (db == NULL ||
+        (db->lsu = libnet_calloc(l, n, sizeof (*db->lsu))) == NULL ||
+        (db->slab = libnet_malloc(l, (size_t)size)) == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        if (db)
+        {
+            libnet_free(db->lsu);
+            libnet_free(db);
+        }
+        return (-1);
+    }
+
+    db->n = 1;
+    for (k = 0, size = 0; k < total; k++)
+    {
+        struct libnet_lsdb_lsu *u = &db->lsu[db->n - 1];
+
+        len = lsdb_lsa(spec, seq, k, NULL);
+        if (u->len + len > room)
+        {
+            u = &db->lsu[db->n++];
+            u->off = (uint32_t)size;
+        }
+        lsdb_lsa(spec, seq, k, db->slab + size);
+        u->len += len;
+        u->num++;
+        size += len;
+    }
+
+    libnet_lsdb_free(l);
+    l->lsdb = db;
+
+    return ((int)db->n);
+}
+
+int
+libnet_lsdb_lsu_size(libnet_t *l, uint32_t i)
+{
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (l->lsdb == NULL || i >= l->lsdb->n)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): no LSU %u",
+                __func__, i);
+        return (-1);
+    }
+
+    return ((int)(LIBNET_OSPF_LSU_H + l->lsdb->lsu[i].len));
+}
+
+libnet_ptag_t
+libnet_build_ospfv2_lsdb_lsu(uint32_t i, libnet_t *l, libnet_ptag_t ptag)
+{
+    const struct libnet_lsdb_lsu *u;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (l->lsdb == NULL || i >= l->lsdb->n)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): no LSU %u",
+                __func__, i);
+        return (-1);
+    }
+
+    u = &l->lsdb->lsu[i];
+    return (libnet_build_ospfv2_lsu(u->num, l->lsdb->slab + u->off, u->len,
+            l, ptag));
+}
+
+int
+libnet_lsdb_refresh(libnet_t *l)
+{
+    struct libnet_lsdb *db;
+    uint8_t *p, *end;
+    uint32_t seq, len;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    db = l->lsdb;
+    if (db == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): no LSDB", __func__);
+        return (-1);
+    }
+
+    /* all LSAs share one sequence number */
+    p = db->slab;
+    seq = (uint32_t)p[12] << 24 | (uint32_t)p[13] << 16 | p[14] << 8 | p[15];
+    if (seq == LIBNET_LSDB_SEQ_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): sequence number at MaxSequenceNumber", __func__);
+        return (-1);
+    }
+    seq++;
+
+    end = db->slab + db->lsu[db->n - 1].off + db->lsu[db->n - 1].len;
+    for (; p < end; p += len)
+    {
+        len = (uint32_t)p[18] << 8 | p[19];
+        lsdb_put32(p + 12, seq);
+        libnet_ospf_lsa_cksum(p, len);
+    }
+
+    return (1);
+}
+
+void
+libnet_lsdb_free(libnet_t *l)
+{
+    if (l && l->lsdb)
+    {
+        libnet_free(l->lsdb->slab);
+        libnet_free(l->lsdb->lsu);
+        libnet_free(l->lsdb);
+        l->lsdb = NULL;
+    }
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -33,11 +33,15 @@
 #include "common.h"
 #include <assert.h>
 
+static void libnet_pblock_release_buf(libnet_pblock_t *p);
+
 libnet_pblock_t *
 libnet_pblock_probe(libnet_t *l, libnet_ptag_t ptag, uint32_t b_len, uint8_t type)
 {
     int offset;
 
+    LIBNET_PROBE3(pblock_probe, ptag, type, b_len);
+
     if (ptag == LIBNET_PTAG_INITIALIZER)
     {
         return libnet_pblock_new(l, b_len);
@@ -68,8 +72,8 @@ libnet_pblock_probe(libnet_t *l, libnet_ptag_t ptag, uint32_t b_len, uint8_t typ
     if (b_len > p->b_len)
     {
         offset = b_len - p->b_len;  /* how many bytes larger new pblock is */
-        free(p->buf);
-        p->buf = malloc(b_len);
+        libnet_pblock_release_buf(p);
+        p->buf = libnet_malloc(l, b_len);
         if (p->buf == NULL)
         {
             snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -84,6 +88,12 @@ libnet_pblock_probe(libnet_t *l, libnet_ptag_t ptag, uint32_t b_len, uint8_t typ
     }
     else
     {
+        /* about to be rewritten, must not be shared with a clone */
+        if (libnet_pblock_own(l, p) == -1)
+        {
+            /* err msg set in libnet_pblock_own() */
+            return (NULL);
+        }
         offset = p->b_len - b_len;
         p->h_len -= offset; /* new length for checksums */
         p->b_len = b_len;       /* new buf len */
@@ -96,7 +106,7 @@ libnet_pblock_probe(libnet_t *l, libnet_ptag_t ptag, uint32_t b_len, uint8_t typ
 
 static void* zmalloc(libnet_t* l, uint32_t size, const char* func)
 {
-    void * const v = malloc(size);
+    void * const v = libnet_malloc(l, size);
     if(v)
         memset(v, 0, size);
     else
@@ -108,6 +118,8 @@ static void* zmalloc(libnet_t* l, uint32_t size, const char* func)
 libnet_pblock_t *
 libnet_pblock_new(libnet_t *l, uint32_t b_len)
 {
+    LIBNET_PROBE1(pblock_new, b_len);
+
     libnet_pblock_t * const p = zmalloc(l, sizeof(libnet_pblock_t), __func__);
     if(!p)
         return NULL;
@@ -116,7 +128,7 @@ libnet_pblock_new(libnet_t *l, uint32_t b_len)
 
     if(!p->buf)
     {
-        free(p);
+        libnet_free(p);
         return NULL;
     }
 
@@ -299,7 +311,8 @@ static int pblock_is_ip(const libnet_pblock_t* p)
 
 /* q is either an ip hdr, or is followed  by an ip hdr. return the offset
  * from end of packet. if there is no offset, we'll return the total size,
- * and things will break later
+ * and things will break later. an OSPF LSA is checksummed without its ip
+ * hdr, so for one of those the offset of q itself is returned
  */
 static int calculate_ip_offset(const libnet_t* l, const libnet_pblock_t* q)
 {
@@ -312,22 +325,71 @@ static int calculate_ip_offset(const libnet_t* l, const libnet_pblock_t* q)
 
     for(; p; p = p->next) {
 	ip_offset += p->b_len;
-	if(pblock_is_ip(p))
+	if(pblock_is_ip(p) || p->type == LIBNET_PBLOCK_OSPF_LSA_H)
 	    break;
     }
 
     return ip_offset;
 }
 
-int
-libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
+/*
+ * Checksums can be left to libnet_checksum_batch() when all there is to
+ * compute belongs to one IPv4 packet: its header, and its TCP or UDP
+ * segment.  Returns the LIBNET_CSUM_* bits left out, 0 if none are.
+ */
+static uint8_t
+pblock_defer_checksums(libnet_t *l)
+{
+    const libnet_pblock_t *p;
+    uint8_t mode = 0;
+    int off = -1, o;
+
+    for (p = l->protocol_blocks; p; p = p->next)
+    {
+        if (!(p->flags & LIBNET_PBLOCK_DO_CHECKSUM))
+        {
+            continue;
+        }
+
+        switch (p->type)
+        {
+            case LIBNET_PBLOCK_IPV4_H:
+                mode |= LIBNET_CSUM_IP;
+                break;
+            case LIBNET_PBLOCK_TCP_H:
+            case LIBNET_PBLOCK_UDP_H:
+                mode |= LIBNET_CSUM_L4;
+                break;
+            default:
+                return (0);
+        }
+
+        o = calculate_ip_offset(l, p);
+        if (off != -1 && o != off)
+        {
+            return (0);
+        }
+        off = o;
+    }
+
+    if (!(mode & LIBNET_CSUM_IP) || (mode & ~l->csum_defer))
+    {
+        return (0);
+    }
+
+    l->csum_ip_offset = l->total_size - off;
+    return (mode);
+}
+
+/*
+ *  Determine the offset required to keep memory aligned (strict
+ *  architectures like solaris enforce this, but's a good practice
+ *  either way).  This is only required on the link layer with the
+ *  14 byte ethernet offset (others are similarly unkind).
+ */
+static void
+libnet_pblock_align(libnet_t *l)
 {
-    /*
-     *  Determine the offset required to keep memory aligned (strict
-     *  architectures like solaris enforce this, but's a good practice
-     *  either way).  This is only required on the link layer with the
-     *  14 byte ethernet offset (others are similarly unkind).
-     */
     if (l->injection_type == LIBNET_LINK || 
         l->injection_type == LIBNET_LINK_ADV)
     {
@@ -338,13 +400,20 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
     {
         l->aligner = 0;
     }
+}
+
+int
+libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
+{
+    libnet_pblock_align(l);
 
     if(!l->total_size && !l->aligner) {
         /* Avoid allocating zero bytes of memory, it perturbs electric fence. */
-        *packet = malloc(1);
-        **packet = 1;
+        *packet = libnet_malloc(l, 1);
+        if (*packet)
+            **packet = 1;
     } else {
-        *packet = malloc(l->aligner + l->total_size);
+        *packet = libnet_malloc(l, l->aligner + l->total_size);
     }
     if (*packet == NULL)
     {
@@ -353,7 +422,69 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
         return (-1);
     }
 
-    memset(*packet, 0, l->aligner + l->total_size);
+    if (libnet_pblock_coalesce_buf(l, *packet + l->aligner, l->total_size,
+            size) == -1)
+    {
+        libnet_free(*packet);
+        *packet = NULL;
+        return (-1);
+    }
+
+    /* Set the packet pointer to the true beginning of the packet. */
+    *packet += l->aligner;
+
+    return (1);
+}
+
+int
+libnet_pblock_coalesce_cached(libnet_t *l, uint8_t **packet, uint32_t *size)
+{
+    uint8_t *buf;
+    uint32_t need;
+
+    libnet_pblock_align(l);
+
+    /* grown as needed, kept until libnet_destroy() */
+    need = l->aligner + l->total_size;
+    if (need == 0)
+    {
+        need = 1;
+    }
+    if (need > l->write_buf_s)
+    {
+        buf = libnet_realloc(l, l->write_buf, need);
+        if (buf == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        l->write_buf = buf;
+        l->write_buf_s = need;
+    }
+
+    *packet = l->write_buf + l->aligner;
+    return (libnet_pblock_coalesce_buf(l, *packet, l->total_size, size));
+}
+
+int
+libnet_pblock_coalesce_buf(libnet_t *l, uint8_t *buf, uint32_t buf_s,
+        uint32_t *size)
+{
+    const uint64_t t0 = libnet_stats_clock(l);
+    uint64_t t1;
+
+    LIBNET_PROBE2(coalesce_entry, l->n_pblocks, l->total_size);
+
+    if (buf_s < l->total_size)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): %u byte packet does not fit in %u bytes", __func__,
+                l->total_size, buf_s);
+        goto err;
+    }
+
+    memset(buf, 0, l->total_size);
 
     if (l->injection_type == LIBNET_RAW4 && 
         l->pblock_end->type == LIBNET_PBLOCK_IPV4_H)
@@ -367,6 +498,7 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
     	switch (l->injection_type)
     	{
             case LIBNET_LINK:
+            case LIBNET_SHM:
                 if ((l->pblock_end->type != LIBNET_PBLOCK_TOKEN_RING_H) &&
                     (l->pblock_end->type != LIBNET_PBLOCK_FDDI_H)       &&
                     (l->pblock_end->type != LIBNET_PBLOCK_ETH_H)        &&
@@ -408,6 +540,15 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
         }
     }
 
+    /* the variation values for this packet, before the pblocks are copied */
+    if (l->vary && libnet_vary_apply(l) == -1)
+    {
+        /* err msg set in libnet_vary_apply() */
+        goto err;
+    }
+
+    l->csum_deferred = l->csum_defer ? pblock_defer_checksums(l) : 0;
+
     /* Build packet from end to start. */
     {
         /*
@@ -434,7 +575,7 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
         libnet_pblock_t *p = NULL;
         uint32_t n;
 
-        for (n = l->aligner + l->total_size, p = l->protocol_blocks; p || q; )
+        for (n = l->total_size, p = l->protocol_blocks; p || q; )
         {
             if (q)
             {
@@ -444,56 +585,21 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
             {
                 n -= p->b_len;
                 /* copy over the packet chunk */
-                memcpy(*packet + n, p->buf, p->b_len);
-            }
-#if 0
-            printf("-- n %d/%d cksum? %d\n", n, l->aligner + l->total_size,
-                    q &&
-                    (p == NULL || (p->flags & LIBNET_PBLOCK_DO_CHECKSUM)) &&
-                    (q->flags & LIBNET_PBLOCK_DO_CHECKSUM));
-            if(q)
-            {
-                printf(" iph %d/%d offset -%d\n",
-                        (l->total_size + l->aligner) - q->ip_offset,
-                        l->total_size + l->aligner,
-                        q->ip_offset
-                      );
-            }
-            if (p)
-            {
-                printf("p %p ptag %d b_len %d h_len %d cksum? %d type %s\n",
-                        p, p->ptag,
-                        p->b_len, p->h_len,
-                        p->flags & LIBNET_PBLOCK_DO_CHECKSUM,
-                        libnet_diag_dump_pblock_type(p->type)
-                      );
+                memcpy(buf + n, p->buf, p->b_len);
+                LIBNET_PROBE4(coalesce_pblock, p->ptag, p->type, p->b_len, n);
             }
-            if (q)
-            {
-                printf("q %p ptag %d b_len %d h_len %d cksum? %d type %s\n",
-                        q, q->ptag,
-                        q->b_len, q->h_len,
-                        q->flags & LIBNET_PBLOCK_DO_CHECKSUM,
-                        libnet_diag_dump_pblock_type(q->type)
-                      );
-            }
-#endif
             if (q)
             {
                 if (p == NULL || (p->flags & LIBNET_PBLOCK_DO_CHECKSUM))
                 {
-                    if (q->flags & LIBNET_PBLOCK_DO_CHECKSUM)
+                    if ((q->flags & LIBNET_PBLOCK_DO_CHECKSUM) &&
+                        !l->csum_deferred)
                     {
-                        uint8_t* end = *packet + l->aligner + l->total_size;
-                        uint8_t* beg = *packet + n;
+                        uint8_t* end = buf + l->total_size;
+                        uint8_t* beg = buf + n;
                         int ip_offset = calculate_ip_offset(l, q);
                         uint8_t* iph = end - ip_offset;
-#if 0
-			printf("p %d/%s q %d/%s offset calculated %d\n",
-				p ? p->ptag : -1, p ? libnet_diag_dump_pblock_type(p->type) : "nil",
-				q->ptag, libnet_diag_dump_pblock_type(q->type),
-				ip_offset);
-#endif
+                        t1 = libnet_stats_clock(l);
                         if (libnet_inet_checksum(l, iph,
                                                  libnet_pblock_p2p(q->type), q->h_len,
                                                  beg, end) == -1)
@@ -501,6 +607,10 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
                             /* err msg set in libnet_do_checksum() */
                             goto err;
                         }
+                        if (t1)
+                        {
+                            l->xstats.checksum_ns += libnet_stats_clock(l) - t1;
+                        }
                     }
                     q = p;
                 }
@@ -511,23 +621,24 @@ libnet_pblock_coalesce(libnet_t *l, uint8_t **packet, uint32_t *size)
             }
         }
     }
-    *size = l->aligner + l->total_size;
+    *size = l->total_size;
 
-    /*
-     *  Set the packet pointer to the true beginning of the packet and set
-     *  the size for transmission.
-     */
-    if ((l->injection_type == LIBNET_LINK ||
-        l->injection_type == LIBNET_LINK_ADV) && l->aligner)
+    if (l->vary)
     {
-        *packet += l->aligner;
-        *size -= l->aligner;
+        libnet_vary_layout(l, buf, l->total_size);
+        libnet_vary_step(l);
     }
+
+    l->xstats.coalesces++;
+    if (t0)
+    {
+        l->xstats.coalesce_ns += libnet_stats_clock(l) - t0;
+    }
+    LIBNET_PROBE2(coalesce_return, l->total_size, 1);
     return (1);
 
 err:
-    free(*packet);
-    *packet = NULL;
+    LIBNET_PROBE2(coalesce_return, l->total_size, -1);
     return (-1);
 }
 
@@ -541,14 +652,115 @@ libnet_pblock_delete(libnet_t *l, libnet_pblock_t *p)
 
         libnet_pblock_remove_from_list(l, p);
 
-        if (p->buf)
+        libnet_pblock_release_buf(p);
+
+        libnet_free(p);
+    }
+}
+
+/*
+ *  Buffers of pblocks copied by libnet_clone() are shared, with a count of
+ *  holders, until one of them is about to write to its pblock.  Contexts
+ *  sharing a buffer can be used from different threads, hence the atomics.
+ */
+static void
+libnet_pblock_release_buf(libnet_pblock_t *p)
+{
+    if (p->refs)
+    {
+        if (__atomic_sub_fetch(p->refs, 1, __ATOMIC_ACQ_REL) == 0)
+        {
+            libnet_free(p->refs);
+            libnet_free(p->buf);
+        }
+        p->refs = NULL;
+    }
+    else
+    {
+        libnet_free(p->buf);
+    }
+    p->buf = NULL;
+}
+
+int
+libnet_pblock_own(libnet_t *l, libnet_pblock_t *p)
+{
+    uint8_t *buf;
+
+    if (p->refs == NULL)
+    {
+        return (1);
+    }
+
+    /* the last holder, nobody else can take a reference */
+    if (__atomic_load_n(p->refs, __ATOMIC_ACQUIRE) == 1)
+    {
+        libnet_free(p->refs);
+        p->refs = NULL;
+        return (1);
+    }
+
+    /* copy before letting go, the last holder may write right after */
+    buf = libnet_malloc(l, p->b_len ? p->b_len : 1);
+    if (buf == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): can't copy shared pblock buffer: %s", __func__,
+                strerror(errno));
+        return (-1);
+    }
+    memcpy(buf, p->buf, p->b_len);
+    libnet_pblock_release_buf(p);
+    p->buf = buf;
+
+    return (1);
+}
+
+int
+libnet_pblock_clone(libnet_t *l, libnet_t *src)
+{
+    libnet_pblock_t *p, *q;
+
+    for (p = src->protocol_blocks; p; p = p->next)
+    {
+        if (p->refs == NULL)
         {
-            free(p->buf);
-            p->buf = NULL;
+            p->refs = libnet_malloc(l, sizeof (*p->refs));
+            if (p->refs == NULL)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): malloc(): %s", __func__, strerror(errno));
+                return (-1);
+            }
+            *p->refs = 1;
         }
 
-        free(p);
+        q = libnet_malloc(l, sizeof (*q));
+        if (q == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): malloc(): %s", __func__, strerror(errno));
+            return (-1);
+        }
+        *q = *p;
+        __atomic_add_fetch(q->refs, 1, __ATOMIC_RELAXED);
+
+        q->next = NULL;
+        q->prev = l->pblock_end;
+        if (l->pblock_end)
+        {
+            l->pblock_end->next = q;
+        }
+        else
+        {
+            l->protocol_blocks = q;
+        }
+        l->pblock_end = q;
+        l->n_pblocks++;
+        l->total_size += q->b_len;
     }
+
+    return (1);
 }
 
 int
@@ -583,7 +795,7 @@ libnet_pblock_p2p(uint8_t type)
             return (LIBNET_PROTO_ISL);
         case LIBNET_PBLOCK_OSPF_H:
             return (IPPROTO_OSPF);
-        case LIBNET_PBLOCK_LS_RTR_H:
+        case LIBNET_PBLOCK_OSPF_LSA_H:
             return (IPPROTO_OSPF_LSA);
         case LIBNET_PBLOCK_TCP_H:
             return (IPPROTO_TCP);
@@ -0,0 +1,614 @@
+/*
+ *  libnet
+ *  libnet_periodic.c - timer wheel for periodic frames
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  Periodic streams, e.g. the hellos of thousands of simulated devices,
+ *  each a coalesced frame sent every interval ms.  They hang off a
+ *  hierarchical timer wheel of 1 ms ticks: level 0 has a slot per tick for
+ *  the next 256 ms, level 1 a slot per 256 ms for the next 64 s, and so on
+ *  up to 2^32 ms.  When level 0 wraps around, the next slot of level 1 is
+ *  spread over it, which is the only time a stream moves.  Arming, firing
+ *  and removing a stream are O(1), however many there are.
+ *
+ *  Slots are doubly linked lists threaded through the stream table by
+ *  index, so the table can grow with libnet_realloc().  Index + 1 is used
+ *  throughout, 0 being the end of a list.
+ */
+#define LIBNET_PERIODIC_BITS    8
+#define LIBNET_PERIODIC_SLOTS   (1 << LIBNET_PERIODIC_BITS)
+#define LIBNET_PERIODIC_MASK    (LIBNET_PERIODIC_SLOTS - 1)
+#define LIBNET_PERIODIC_LEVELS  4
+
+/* frames per libnet_write_batch() call */
+#define LIBNET_PERIODIC_BURST   64
+
+/* a counter stepped after every send */
+struct libnet_periodic_patch
+{
+    uint32_t offset;                    /* in the frame */
+    uint32_t csum;                      /* checksum to fix up, 0 for none */
+    uint32_t step;
+    uint8_t width;
+};
+
+struct libnet_periodic_stream
+{
+    uint32_t next;                      /* slot list, or free list */
+    uint32_t prev;
+    uint32_t slot;                      /* level * SLOTS + slot, + 1; 0 if free */
+    uint64_t expire;                    /* tick */
+    uint32_t interval;
+    uint32_t jitter;
+    struct libnet_frame frame;          /* as culled, see libnet_adv_free_packet() */
+    uint8_t n_patch;
+    struct libnet_periodic_patch patch[LIBNET_PERIODIC_PATCH_MAX];
+};
+
+struct libnet_periodic
+{
+    struct libnet_periodic_stream *s;
+    uint32_t n;                         /* table entries in use or freed */
+    uint32_t max;                       /* allocated */
+    uint32_t free;                      /* free list */
+    uint32_t armed;                     /* streams in the wheel */
+    uint64_t base;                      /* caller's time of tick 0 */
+    uint64_t tick;                      /* next tick to run */
+    int started;
+    uint32_t wheel[LIBNET_PERIODIC_LEVELS][LIBNET_PERIODIC_SLOTS];
+};
+
+static void
+periodic_link(struct libnet_periodic *pw, uint32_t i)
+{
+    struct libnet_periodic_stream * const s = &pw->s[i];
+    uint64_t delta;
+    uint32_t level, *head;
+
+    /* never behind, or the slot would only come round a rotation later */
+    if (s->expire < pw->tick)
+    {
+        s->expire = pw->tick;
+    }
+    delta = s->expire - pw->tick;
+    for (level = 0; level < LIBNET_PERIODIC_LEVELS - 1; level++)
+    {
+        if (delta < (1ULL << ((level + 1) * LIBNET_PERIODIC_BITS)))
+        {
+            break;
+        }
+    }
+    if (delta >> (LIBNET_PERIODIC_LEVELS * LIBNET_PERIODIC_BITS))
+    {
+        s->expire = pw->tick + UINT32_MAX;
+    }
+
+    s->slot = level * LIBNET_PERIODIC_SLOTS + 1 +
+        ((s->expire >> (level * LIBNET_PERIODIC_BITS)) & LIBNET_PERIODIC_MASK);
+    head = &pw->wheel[0][0] + s->slot - 1;
+    s->prev = 0;
+    s->next = *head;
+    if (*head)
+    {
+        pw->s[*head - 1].prev = i + 1;
+    }
+    *head = i + 1;
+    pw->armed++;
+}
+
+static void
+periodic_unlink(struct libnet_periodic *pw, uint32_t i)
+{
+    struct libnet_periodic_stream * const s = &pw->s[i];
+
+    if (s->prev)
+    {
+        pw->s[s->prev - 1].next = s->next;
+    }
+    else
+    {
+        (&pw->wheel[0][0])[s->slot - 1] = s->next;
+    }
+    if (s->next)
+    {
+        pw->s[s->next - 1].prev = s->prev;
+    }
+    pw->armed--;
+}
+
+/* uniform in [interval - jitter, interval + jitter] */
+static uint32_t
+periodic_interval(libnet_t *l, const struct libnet_periodic_stream *s)
+{
+    if (s->jitter == 0)
+    {
+        return (s->interval);
+    }
+    return (s->interval - s->jitter + (uint32_t)
+        (libnet_get_prand_r(l, LIBNET_PRu32) % (2 * (uint64_t)s->jitter + 1)));
+}
+
+static struct libnet_periodic_stream *
+periodic_stream(libnet_t *l, int id, const char *func)
+{
+    struct libnet_periodic * const pw = l->periodic;
+
+    if (pw == NULL || id < 0 || (uint32_t)id >= pw->n || pw->s[id].slot == 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no periodic stream %d", func, id);
+        return (NULL);
+    }
+    return (&pw->s[id]);
+}
+
+int
+libnet_periodic_add(libnet_t *l, uint32_t interval, uint32_t jitter,
+        uint32_t first)
+{
+    struct libnet_periodic_stream *s;
+    struct libnet_periodic *pw;
+    uint32_t i, max;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (interval == 0 || jitter >= interval)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): need 0 <= jitter < interval", __func__);
+        return (-1);
+    }
+
+    /* the wheel holds 2^32 ticks, the longest interval has to fit */
+    if ((uint64_t)interval + jitter > UINT32_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): interval + jitter over 2^32 - 1 ms", __func__);
+        return (-1);
+    }
+
+    pw = l->periodic;
+    if (pw == NULL)
+    {
+        pw = libnet_calloc(l, 1, sizeof (*pw));
+        if (pw == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        l->periodic = pw;
+    }
+
+    if (pw->free == 0 && pw->n == pw->max)
+    {
+        if (pw->n == INT32_MAX)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): too many streams", __func__);
+            return (-1);
+        }
+        max = pw->max ? pw->max * 2 : 64;
+        if (max > INT32_MAX)
+        {
+            max = INT32_MAX;
+        }
+        s = libnet_realloc(l, pw->s, (size_t)max * sizeof (*s));
+        if (s == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        pw->s = s;
+        pw->max = max;
+    }
+    i = pw->free ? pw->free - 1 : pw->n;
+    s = &pw->s[i];
+
+    if (libnet_pblock_coalesce(l, &s->frame.buf, &s->frame.len) == -1)
+    {
+        /* err msg set in libnet_pblock_coalesce() */
+        return (-1);
+    }
+    if (pw->free)
+    {
+        pw->free = s->next;
+    }
+    else
+    {
+        pw->n++;
+    }
+
+    s->interval = interval;
+    s->jitter   = jitter;
+    s->n_patch  = 0;
+    s->expire   = pw->tick + first;
+    periodic_link(pw, i);
+
+    return ((int)i);
+}
+
+int
+libnet_periodic_patch(libnet_t *l, int id, uint32_t offset, uint8_t width,
+        uint32_t step, uint32_t csum)
+{
+    struct libnet_periodic_stream *s;
+    struct libnet_periodic_patch *p;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    s = periodic_stream(l, id, __func__);
+    if (s == NULL)
+    {
+        return (-1);
+    }
+
+    if ((width != 1 && width != 2 && width != 4) ||
+        offset > s->frame.len || s->frame.len - offset < width)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): bad field width or offset", __func__);
+        return (-1);
+    }
+    if (csum && (csum > s->frame.len - 2 ||
+                 (csum < offset + width && offset < csum + 2)))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): bad checksum offset", __func__);
+        return (-1);
+    }
+    if (s->n_patch == LIBNET_PERIODIC_PATCH_MAX)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): at most %d fields per stream", __func__,
+                LIBNET_PERIODIC_PATCH_MAX);
+        return (-1);
+    }
+
+    p = &s->patch[s->n_patch++];
+    p->offset = offset;
+    p->width  = width;
+    p->step   = step;
+    p->csum   = csum;
+    return (1);
+}
+
+uint8_t *
+libnet_periodic_frame(libnet_t *l, int id, uint32_t *len)
+{
+    struct libnet_periodic_stream *s;
+
+    if (l == NULL)
+    {
+        return (NULL);
+    }
+
+    s = periodic_stream(l, id, __func__);
+    if (s == NULL)
+    {
+        return (NULL);
+    }
+    if (len)
+    {
+        *len = s->frame.len;
+    }
+    return (s->frame.buf);
+}
+
+int
+libnet_periodic_remove(libnet_t *l, int id)
+{
+    struct libnet_periodic_stream *s;
+    struct libnet_periodic *pw;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    s = periodic_stream(l, id, __func__);
+    if (s == NULL)
+    {
+        return (-1);
+    }
+    pw = l->periodic;
+
+    periodic_unlink(pw, (uint32_t)id);
+    libnet_adv_free_packet(l, s->frame.buf);
+    s->frame.buf = NULL;
+    s->slot = 0;
+    s->next = pw->free;
+    pw->free = (uint32_t)id + 1;
+    return (1);
+}
+
+/*
+ *  One's complement sum of a field as it lies in the frame, bytes at an
+ *  even distance from the checksum being the high half of a word.
+ */
+static uint32_t
+periodic_sum(const uint8_t *frame, const struct libnet_periodic_patch *p)
+{
+    uint32_t i, sum = 0;
+
+    for (i = p->offset; i < p->offset + p->width; i++)
+    {
+        sum += ((i - p->csum) & 1) ? frame[i] : frame[i] << 8;
+    }
+    return (sum);
+}
+
+static void
+periodic_step(uint8_t *frame, const struct libnet_periodic_patch *p)
+{
+    uint8_t * const f = frame + p->offset;
+    uint32_t v, sum, hc, old = 0;
+
+    if (p->csum)
+    {
+        old = periodic_sum(frame, p);
+    }
+
+    switch (p->width)
+    {
+        case 1:
+            f[0] = (uint8_t)(f[0] + p->step);
+            break;
+        case 2:
+            v = (f[0] << 8 | f[1]) + p->step;
+            f[0] = (uint8_t)(v >> 8);
+            f[1] = (uint8_t)v;
+            break;
+        default:
+            v = ((uint32_t)f[0] << 24 | f[1] << 16 | f[2] << 8 | f[3]) + p->step;
+            f[0] = (uint8_t)(v >> 24);
+            f[1] = (uint8_t)(v >> 16);
+            f[2] = (uint8_t)(v >> 8);
+            f[3] = (uint8_t)v;
+            break;
+    }
+
+    if (p->csum)
+    {
+        /* RFC 1624: HC' = ~(~HC + ~m + m') */
+        hc = frame[p->csum] << 8 | frame[p->csum + 1];
+        while (old >> 16)
+        {
+            old = (old & 0xffff) + (old >> 16);
+        }
+        sum = (~hc & 0xffff) + (~old & 0xffff) + periodic_sum(frame, p);
+        while (sum >> 16)
+        {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+        sum = ~sum & 0xffff;
+        frame[p->csum]     = (uint8_t)(sum >> 8);
+        frame[p->csum + 1] = (uint8_t)sum;
+    }
+}
+
+/* writes a burst of fired streams, then steps their counters */
+static void
+periodic_flush(libnet_t *l, struct libnet_periodic *pw,
+        const uint32_t *fired, struct libnet_frame *frames, uint32_t n)
+{
+    struct libnet_periodic_stream *s;
+    uint32_t i, j, ok;
+    int c;
+
+    /* a frame the device refuses is dropped, the statistics have it */
+    ok = 0;
+    while (ok < n)
+    {
+        c = libnet_write_batch(l, frames + ok, n - ok);
+        if (c > 0)
+        {
+            ok += c;
+        }
+        if (ok < n)
+        {
+            ok++;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        s = &pw->s[fired[i]];
+        for (j = 0; j < s->n_patch; j++)
+        {
+            periodic_step(s->frame.buf, &s->patch[j]);
+        }
+    }
+}
+
+int
+libnet_periodic_dispatch(libnet_t *l, uint64_t now)
+{
+    struct libnet_frame frames[LIBNET_PERIODIC_BURST];
+    uint32_t fired[LIBNET_PERIODIC_BURST];
+    struct libnet_periodic_stream *s;
+    struct libnet_periodic *pw;
+    uint32_t level, idx, i, iv, list, n = 0;
+    uint64_t end, next;
+    int total = 0;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    pw = l->periodic;
+    if (pw == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no periodic streams, see libnet_periodic_add()",
+                __func__);
+        return (-1);
+    }
+
+    /* tick 0 is the first call, streams added before count from there */
+    if (!pw->started)
+    {
+        pw->base = now;
+        pw->started = 1;
+    }
+    if (now < pw->base)
+    {
+        return (0);
+    }
+    end = now - pw->base;
+
+    for (; pw->tick <= end; pw->tick++)
+    {
+        if (pw->armed == 0)
+        {
+            pw->tick = end + 1;
+            break;
+        }
+
+        /* level 0 wrapped, spread the next slots of the upper levels */
+        idx = pw->tick & LIBNET_PERIODIC_MASK;
+        for (level = 1; idx == 0 && level < LIBNET_PERIODIC_LEVELS; level++)
+        {
+            idx = (pw->tick >> (level * LIBNET_PERIODIC_BITS)) &
+                LIBNET_PERIODIC_MASK;
+            list = pw->wheel[level][idx];
+            pw->wheel[level][idx] = 0;
+            while (list)
+            {
+                i = list - 1;
+                list = pw->s[i].next;
+                pw->armed--;
+                periodic_link(pw, i);
+            }
+        }
+
+        idx = pw->tick & LIBNET_PERIODIC_MASK;
+        list = pw->wheel[0][idx];
+        pw->wheel[0][idx] = 0;
+        while (list)
+        {
+            i = list - 1;
+            s = &pw->s[i];
+            list = s->next;
+            pw->armed--;
+
+            frames[n] = s->frame;
+            fired[n]  = i;
+            if (++n == LIBNET_PERIODIC_BURST)
+            {
+                periodic_flush(l, pw, fired, frames, n);
+                total += n;
+                n = 0;
+            }
+
+            /*
+             *  Keep to the schedule, but a stream that fell behind fires
+             *  once and picks up from now, rather than catching up.
+             */
+            iv = periodic_interval(l, s);
+            next = s->expire + iv;
+            s->expire = next > end ? next : end + iv;
+            periodic_link(pw, i);
+        }
+    }
+
+    if (n)
+    {
+        periodic_flush(l, pw, fired, frames, n);
+        total += n;
+    }
+    return (total);
+}
+
+int64_t
+libnet_periodic_next(libnet_t *l)
+{
+    struct libnet_periodic *pw;
+    uint32_t i, idx;
+
+    if (l == NULL || (pw = l->periodic) == NULL || pw->armed == 0)
+    {
+        return (-1);
+    }
+    if (!pw->started)
+    {
+        return (0);
+    }
+
+    /*
+     *  The first non-empty slot of level 0, or else the next wrap around,
+     *  when streams from the upper levels may come down.
+     */
+    for (i = 0; ; i++)
+    {
+        idx = (pw->tick + i) & LIBNET_PERIODIC_MASK;
+        if (pw->wheel[0][idx] || idx == 0)
+        {
+            return ((int64_t)(pw->base + pw->tick + i));
+        }
+    }
+}
+
+void
+libnet_periodic_free(libnet_t *l)
+{
+    struct libnet_periodic *pw;
+    uint32_t i;
+
+    if (l && (pw = l->periodic))
+    {
+        for (i = 0; i < pw->n; i++)
+        {
+            if (pw->s[i].slot)
+            {
+                libnet_adv_free_packet(l, pw->s[i].frame.buf);
+            }
+        }
+        libnet_free(pw->s);
+        libnet_free(pw);
+        l->periodic = NULL;
+    }
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
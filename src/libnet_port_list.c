@@ -94,13 +94,13 @@ libnet_plist_chain_new(libnet_t *l, libnet_plist_t **plist, char *token_list)
     tmp->next = NULL;
     tmp->id = cur_id;
     uint16_t * const all_lists_tmp = all_lists;
-    all_lists = realloc(all_lists_tmp, (sizeof(uint16_t) * (cur_id + 1)));
+    all_lists = libnet_realloc(l, all_lists_tmp, (sizeof(uint16_t) * (cur_id + 1)));
     if (!all_lists)
     {
         all_lists = all_lists_tmp;
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
                     "libnet_build_plist_chain: realloc %s", strerror(errno));
-        free(tmp);
+        libnet_free(tmp);
         *plist = NULL;
         return(-1);
     }
@@ -120,7 +120,7 @@ libnet_plist_chain_new(libnet_t *l, libnet_plist_t **plist, char *token_list)
          */
         if (i)
         {
-            tmp->next = malloc(sizeof (libnet_plist_t));
+            tmp->next = libnet_malloc(l, sizeof (libnet_plist_t));
             if (!tmp->next)
             {
                 snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -280,7 +280,7 @@ libnet_plist_chain_free(libnet_plist_t *plist)
     {
         tmp = plist;
         plist = plist->next;
-        free(tmp);
+        libnet_free(tmp);
     }
     plist = NULL;
     return (1);
@@ -66,6 +66,7 @@ libnet_seed_prand(libnet_t *l)
      */
     srandom((unsigned)(seed.tv_sec ^ seed.tv_usec));
 #endif
+    l->prand_state = 0;     /* reseeded on next libnet_get_prand_r() */
     return (1);
 }
 
@@ -107,6 +108,52 @@ libnet_get_prand(int mod)
     return (0);                         /* NOTTREACHED */
 }
 
+uint32_t
+libnet_get_prand_r(libnet_t *l, int mod)
+{
+    uint64_t x;
+    uint32_t n;
+
+    if (l == NULL)
+    {
+        return (libnet_get_prand(mod));
+    }
+
+    /*
+     *  xorshift64* keeps its whole state in the context, so it needs no
+     *  locking and costs a handful of instructions per value.  It is seeded
+     *  lazily from the process-wide generator.
+     */
+    x = l->prand_state;
+    if (x == 0)
+    {
+        x = ((uint64_t)libnet_get_prand(LIBNET_PRu32) << 32) |
+            libnet_get_prand(LIBNET_PRu32) | 1;
+    }
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    l->prand_state = x;
+    n = (uint32_t)((x * 0x2545f4914f6cdd1dULL) >> 32);
+
+    switch (mod)
+    {
+        case LIBNET_PR2:
+            return (n & 0x1);           /* 0 - 1 */
+        case LIBNET_PR8:
+            return (n & 0xff);          /* 0 - 255 */
+        case LIBNET_PR16:
+            return (n & 0x7fff);        /* 0 - 32767 */
+        case LIBNET_PRu16:
+            return (n & 0xffff);        /* 0 - 65535 */
+        case LIBNET_PR32:
+            return (n & 0x7fffffff);    /* 0 - 2147483647 */
+        case LIBNET_PRu32:
+            return (n);                 /* 0 - 4294967295 */
+    }
+    return (0);                         /* NOTTREACHED */
+}
+
 /**
  * Local Variables:
  *  indent-tabs-mode: nil
@@ -0,0 +1,84 @@
+/*
+ *  libnet
+ *  libnet_probes.h - USDT tracepoints
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  Statically defined tracepoints, for perf, bpftrace, systemtap and the
+ *  like.  With sys/sdt.h from systemtap, a probe is a nop in the code and
+ *  a note in the ELF file, which tracers patch at runtime.  Without it,
+ *  or with --disable-usdt, they compile to nothing.
+ *
+ *  provider  probe            arguments
+ *  libnet    pblock_new       b_len
+ *  libnet    pblock_probe     ptag, type, b_len
+ *  libnet    coalesce_entry   n_pblocks, total_size
+ *  libnet    coalesce_pblock  ptag, type, b_len, offset
+ *  libnet    coalesce_return  total_size, result
+ *  libnet    checksum_entry   protocol, h_len, length
+ *  libnet    checksum_return  protocol, result
+ *  libnet    write_entry      backend, length
+ *  libnet    write_return     backend, result, errno
+ *
+ *  The backend of the write probes is the name of the function, e.g.
+ *  libnet_write_link, a string.  On Windows the errno is GetLastError().
+ *  For instance, the latency of all link layer writes:
+ *
+ *  bpftrace -e 'usdt:/usr/lib/libnet.so:libnet:write_entry { @t[tid] = nsecs }
+ *      usdt:/usr/lib/libnet.so:libnet:write_return /@t[tid]/ {
+ *          @ns[str(arg0)] = hist(nsecs - @t[tid]); delete(@t[tid]) }'
+ */
+
+#ifndef __LIBNET_PROBES_H
+#define __LIBNET_PROBES_H
+
+#ifdef HAVE_USDT
+#include <sys/sdt.h>
+
+#define LIBNET_PROBE1(n, a)             STAP_PROBE1(libnet, n, a)
+#define LIBNET_PROBE2(n, a, b)          STAP_PROBE2(libnet, n, a, b)
+#define LIBNET_PROBE3(n, a, b, c)       STAP_PROBE3(libnet, n, a, b, c)
+#define LIBNET_PROBE4(n, a, b, c, d)    STAP_PROBE4(libnet, n, a, b, c, d)
+
+#else
+
+#define LIBNET_PROBE1(n, a)             do { } while (0)
+#define LIBNET_PROBE2(n, a, b)          do { } while (0)
+#define LIBNET_PROBE3(n, a, b, c)       do { } while (0)
+#define LIBNET_PROBE4(n, a, b, c, d)    do { } while (0)
+
+#endif  /* HAVE_USDT */
+
+#endif  /* __LIBNET_PROBES_H */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -398,6 +398,60 @@ libnet_get_ipaddr4(libnet_t *l)
     close(fd);
     return (sin->sin_addr.s_addr);
 }
+
+int
+libnet_get_mtu(libnet_t *l)
+{
+    struct ifreq ifr;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    if (l->mtu)
+    {
+        return (l->mtu);
+    }
+
+#ifdef SIOCGIFMTU
+    const int fd = socket(PF_INET, SOCK_DGRAM, 0);
+    if (fd == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): socket(): %s", __func__, strerror(errno));
+        return (-1);
+    }
+
+    if (l->device == NULL)
+    {
+        if (libnet_select_device(l) == -1)
+        {
+            /* error msg set in libnet_select_device() */
+            close(fd);
+            return (-1);
+        }
+    }
+    strncpy(ifr.ifr_name, l->device, sizeof(ifr.ifr_name) -1);
+    ifr.ifr_name[sizeof(ifr.ifr_name) - 1] = '\0';
+
+    if (ioctl(fd, SIOCGIFMTU, (int8_t*) &ifr) < 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): ioctl(): %s", __func__, strerror(errno));
+        close(fd);
+        return (-1);
+    }
+    close(fd);
+
+    l->mtu = ifr.ifr_mtu;
+    return (l->mtu);
+#else
+    (void)ifr;
+    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+            "%s(): not supported on this platform", __func__);
+    return (-1);
+#endif
+}
 #else
 #include <Packet32.h>
 uint32_t
@@ -416,6 +470,18 @@ libnet_get_ipaddr4(libnet_t *l)
     }
     return (sin.sin_addr.s_addr);
 }
+
+int
+libnet_get_mtu(libnet_t *l)
+{
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+            "%s(): not supported on this platform", __func__);
+    return (-1);
+}
 #endif /* WIN32 */
 
 uint8_t *
@@ -436,6 +502,7 @@ libnet_hex_aton(const char *s, int *len)
             (*len)++;
         }
     }
+    /* the caller's to free(), not libnet's allocator */
     uint8_t * const buf = malloc(*len + 1);
     if (buf == NULL)
     {
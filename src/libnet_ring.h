@@ -0,0 +1,358 @@
+/*
+ *  libnet
+ *  libnet_ring.h - bounded lock-free frame ring
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef __LIBNET_RING_H
+#define __LIBNET_RING_H
+
+/*
+ *  A bounded multi-producer, single-consumer ring of frames, after Dmitry
+ *  Vyukov's bounded MPMC queue.  Producers claim a slot with one CAS on
+ *  the head, fill it in place and publish it by bumping the slot sequence
+ *  number; the consumer drains in order from the tail.  No locks are taken
+ *  on either side.
+ *
+ *  The ring holds no pointers, only offsets, so it can live in memory
+ *  shared between processes mapped at different addresses.  Producers and
+ *  consumer only need to agree on the layout below.
+ *
+ *  Producers may be less privileged than the consumer, libnet-txd, and can
+ *  write anything to the shared memory.  The consumer therefore works from
+ *  a private libnet_ring_reader: the layout it created the ring with, and
+ *  its own tail.  Slot addresses only ever come from those, a slot length
+ *  past frame_max is refused, and the head is only used, bounded by the
+ *  depth, to tell how full the ring is.
+ *
+ *  A producer that dies between claim and commit would leave the consumer
+ *  waiting at its slot for good.  The consumer gives up on a slot claimed
+ *  for too long, see libnet_ring_skip(); a commit that comes after that
+ *  fails and its frame is lost.
+ *
+ *  Used by the TX thread (libnet_tx.c) and the shared memory injection
+ *  type (libnet_shm.c).
+ */
+
+#define LIBNET_RING_MAGIC   0x6c6e7231      /* "lnr1" */
+#define LIBNET_RING_PREFIX  "/libnet-"      /* shm_open() name of a ring */
+#define LIBNET_RING_LINE    64              /* cache line */
+
+struct libnet_ring
+{
+    uint32_t magic;                     /* LIBNET_RING_MAGIC once ready */
+    uint32_t depth;                     /* number of slots, power of two */
+    uint32_t frame_max;                 /* largest frame a slot holds */
+    uint32_t stride;                    /* bytes from slot to slot */
+    uint8_t  pad0[LIBNET_RING_LINE - 16];
+
+    uint64_t head;                      /* next slot to claim */
+    uint8_t  pad1[LIBNET_RING_LINE - 8];
+
+    uint64_t tail;                      /* next slot to drain */
+    uint8_t  pad2[LIBNET_RING_LINE - 8];
+
+    /* the slots follow */
+};
+
+struct libnet_ring_slot
+{
+    uint64_t seq;                       /* position this slot is ready for */
+    uint32_t len;                       /* frame length, 0 for none */
+    uint32_t pad;
+    /* the frame follows */
+};
+
+#define LIBNET_RING_SLOT(r, pos) \
+    ((struct libnet_ring_slot *)((uint8_t *)(r) + sizeof (struct libnet_ring) \
+    + ((pos) & ((r)->depth - 1)) * (size_t)(r)->stride))
+
+static inline size_t
+libnet_ring_stride(uint32_t frame_max)
+{
+    size_t s = sizeof (struct libnet_ring_slot) + frame_max;
+
+    return ((s + LIBNET_RING_LINE - 1) & ~(size_t)(LIBNET_RING_LINE - 1));
+}
+
+/* bytes needed for a ring, or 0 if depth is not a power of two */
+static inline size_t
+libnet_ring_size(uint32_t depth, uint32_t frame_max)
+{
+    if (depth == 0 || (depth & (depth - 1)))
+    {
+        return (0);
+    }
+    return (sizeof (struct libnet_ring) + depth * libnet_ring_stride(frame_max));
+}
+
+/* r must be libnet_ring_size() bytes, magic is set last */
+static inline void
+libnet_ring_init(struct libnet_ring *r, uint32_t depth, uint32_t frame_max)
+{
+    uint32_t i;
+
+    memset(r, 0, sizeof (*r));
+    r->depth = depth;
+    r->frame_max = frame_max;
+    r->stride = (uint32_t)libnet_ring_stride(frame_max);
+    for (i = 0; i < depth; i++)
+    {
+        LIBNET_RING_SLOT(r, i)->seq = i;
+        LIBNET_RING_SLOT(r, i)->len = 0;
+    }
+    __atomic_store_n(&r->magic, LIBNET_RING_MAGIC, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Producer side: claims the next slot and returns where to put the frame,
+ *  at most frame_max bytes, or NULL if the ring is full.  Every claimed
+ *  slot must be handed back with libnet_ring_commit().
+ */
+static inline uint8_t *
+libnet_ring_claim(struct libnet_ring *r, uint64_t *pos)
+{
+    struct libnet_ring_slot *s;
+    uint64_t p = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    int64_t dif;
+
+    for (;;)
+    {
+        s = LIBNET_RING_SLOT(r, p);
+        dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - p);
+        if (dif == 0)
+        {
+            if (__atomic_compare_exchange_n(&r->head, &p, p + 1, 1,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                *pos = p;
+                return ((uint8_t *)(s + 1));
+            }
+            /* p was reloaded by the failed CAS */
+        }
+        else if (dif < 0)
+        {
+            return (NULL);
+        }
+        else
+        {
+            p = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ *  Publishes a claimed slot, len 0 if it was not filled in after all.
+ *  Returns 0 if the consumer gave up on the slot meanwhile, see
+ *  libnet_ring_skip(), and the frame is lost.
+ */
+static inline int
+libnet_ring_commit(struct libnet_ring *r, uint64_t pos, uint32_t len)
+{
+    struct libnet_ring_slot *s = LIBNET_RING_SLOT(r, pos);
+    uint64_t seq = pos;
+
+    if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) != pos)
+    {
+        return (0);
+    }
+    s->len = len;
+    return (__atomic_compare_exchange_n(&s->seq, &seq, pos + 1, 0,
+            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+}
+
+/* the consumer's view of a ring, nothing in it is read from the ring */
+struct libnet_ring_reader
+{
+    struct libnet_ring *r;
+    uint32_t depth;
+    uint32_t frame_max;
+    size_t stride;
+    uint64_t tail;                      /* next slot to drain */
+    uint64_t refused;                   /* slots with a bad length */
+    uint64_t skipped;                   /* slots claimed and never published */
+    uint64_t stall_pos;                 /* tail seen claimed, unpublished */
+    uint64_t stall_t;                   /* ... since, 0 for not */
+};
+
+/*
+ *  Sets up the reader of a ring of size bytes that the consumer itself
+ *  initialized with depth and frame_max, see libnet_ring_init().  Returns
+ *  -1 if these do not fit in size.
+ */
+static inline int
+libnet_ring_reader_init(struct libnet_ring_reader *rd, struct libnet_ring *r,
+        size_t size, uint32_t depth, uint32_t frame_max)
+{
+    const size_t need = libnet_ring_size(depth, frame_max);
+
+    if (need == 0 || need > size)
+    {
+        return (-1);
+    }
+    rd->r = r;
+    rd->depth = depth;
+    rd->frame_max = frame_max;
+    rd->stride = libnet_ring_stride(frame_max);
+    rd->tail = 0;
+    rd->refused = 0;
+    rd->skipped = 0;
+    rd->stall_pos = 0;
+    rd->stall_t = 0;
+    return (1);
+}
+
+static inline struct libnet_ring_slot *
+libnet_ring_reader_slot(const struct libnet_ring_reader *rd, uint64_t pos)
+{
+    return ((struct libnet_ring_slot *)((uint8_t *)rd->r +
+            sizeof (struct libnet_ring) + (pos & (rd->depth - 1)) * rd->stride));
+}
+
+/*
+ *  Consumer side: returns the k-th frame past the tail if it has been
+ *  published, otherwise NULL.  A slot with a length past frame_max is
+ *  refused: it is returned with length 0, as one a producer gave up on,
+ *  and counted.
+ */
+static inline uint8_t *
+libnet_ring_peek(struct libnet_ring_reader *rd, uint32_t k, uint32_t *len)
+{
+    const uint64_t p = rd->tail + k;
+    struct libnet_ring_slot *s;
+
+    if (k >= rd->depth)
+    {
+        return (NULL);
+    }
+    s = libnet_ring_reader_slot(rd, p);
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != p + 1)
+    {
+        return (NULL);
+    }
+
+    /* read once, a producer may change it behind our back */
+    *len = __atomic_load_n(&s->len, __ATOMIC_RELAXED);
+    if (*len > rd->frame_max)
+    {
+        *len = 0;
+        rd->refused++;
+    }
+    return ((uint8_t *)(s + 1));
+}
+
+/* hands the first n slots past the tail back to the producers */
+static inline void
+libnet_ring_release(struct libnet_ring_reader *rd, uint32_t n)
+{
+    uint64_t p;
+
+    for (p = rd->tail; p < rd->tail + n; p++)
+    {
+        __atomic_store_n(&libnet_ring_reader_slot(rd, p)->seq, p + rd->depth,
+                __ATOMIC_RELEASE);
+    }
+    rd->tail += n;
+    __atomic_store_n(&rd->r->tail, rd->tail, __ATOMIC_RELEASE);
+}
+
+/*
+ *  Consumer side: gives up on the slot at the tail if a producer claimed
+ *  it but has not published it for timeout, as when it died in between.
+ *  now and timeout are on any clock of the caller's, e.g. in ns since
+ *  boot.  The slot is handed back to the producers empty, and counted.
+ *  Returns 1 if it was skipped, 0 if not (yet).
+ */
+static inline int
+libnet_ring_skip(struct libnet_ring_reader *rd, uint64_t now, uint64_t timeout)
+{
+    struct libnet_ring_slot *s = libnet_ring_reader_slot(rd, rd->tail);
+    const uint64_t h = __atomic_load_n(&rd->r->head, __ATOMIC_ACQUIRE);
+    uint64_t seq = rd->tail;
+
+    /* claimed is past the head with the slot still free for the tail */
+    if (h <= rd->tail || __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != seq)
+    {
+        rd->stall_t = 0;
+        return (0);
+    }
+    if (rd->stall_t == 0 || rd->stall_pos != rd->tail)
+    {
+        rd->stall_pos = rd->tail;
+        rd->stall_t = now;
+        return (0);
+    }
+    if (now - rd->stall_t < timeout)
+    {
+        return (0);
+    }
+
+    /* a commit racing this one wins, its frame goes out after all */
+    if (!__atomic_compare_exchange_n(&s->seq, &seq, rd->tail + rd->depth, 0,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+        return (0);
+    }
+    rd->tail++;
+    __atomic_store_n(&rd->r->tail, rd->tail, __ATOMIC_RELEASE);
+    rd->skipped++;
+    rd->stall_t = 0;
+    return (1);
+}
+
+/* slots claimed but not yet drained, as the consumer sees it */
+static inline uint32_t
+libnet_ring_pending(const struct libnet_ring_reader *rd)
+{
+    const uint64_t h = __atomic_load_n(&rd->r->head, __ATOMIC_ACQUIRE);
+
+    /* the head is the producers', never more than a ring ahead */
+    if (h <= rd->tail)
+    {
+        return (0);
+    }
+    return (h - rd->tail > rd->depth ? rd->depth : (uint32_t)(h - rd->tail));
+}
+
+/* number of slots claimed but not yet released, racy by nature */
+static inline uint32_t
+libnet_ring_used(struct libnet_ring *r)
+{
+    const uint64_t t = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    const uint64_t h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    return (h > t ? (uint32_t)(h - t) : 0);
+}
+
+#endif  /* __LIBNET_RING_H */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,254 @@
+/*
+ *  libnet
+ *  libnet_shm.c - shared memory ring injection
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "libnet_ring.h"
+
+/*
+ *  LIBNET_SHM contexts do not own a socket.  Frames are coalesced into a
+ *  ring in shared memory, created and drained by libnet-txd, which may be
+ *  fed by any number of processes at once.
+ */
+struct libnet_shm
+{
+    struct libnet_ring *ring;
+    size_t size;
+};
+
+int
+libnet_open_shm(libnet_t *l)
+{
+    char name[NAME_MAX];
+    struct libnet_ring hdr;
+    struct stat st;
+    size_t size;
+    void *map;
+    int fd;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (l->device == NULL || l->device[0] == '\0' ||
+        strchr(l->device, '/') ||
+        snprintf(name, sizeof (name), "%s%s", LIBNET_RING_PREFIX,
+            l->device) >= (int)sizeof (name))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): need a ring name, see libnet-txd", __func__);
+        return (-1);
+    }
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): cannot open ring %s: %s (is libnet-txd running?)",
+                __func__, l->device, strerror(errno));
+        return (-1);
+    }
+
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof (hdr) ||
+        pread(fd, &hdr, sizeof (hdr), 0) != sizeof (hdr) ||
+        hdr.magic != LIBNET_RING_MAGIC ||
+        (size = libnet_ring_size(hdr.depth, hdr.frame_max)) == 0 ||
+        size > (size_t)st.st_size)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): %s is not a libnet ring", __func__, l->device);
+        close(fd);
+        return (-1);
+    }
+
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): mmap(): %s",
+                __func__, strerror(errno));
+        return (-1);
+    }
+
+    l->shm = libnet_malloc(l, sizeof (*l->shm));
+    if (l->shm == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        munmap(map, size);
+        return (-1);
+    }
+    l->shm->ring = map;
+    l->shm->size = size;
+
+    /* the daemon writes to an Ethernet device */
+    l->link_type   = 1;                 /* DLT_EN10MB */
+    l->link_offset = LIBNET_ETH_H;
+
+    return (1);
+}
+
+int
+libnet_close_shm(libnet_t *l)
+{
+    if (l == NULL || l->shm == NULL)
+    {
+        return (-1);
+    }
+
+    munmap(l->shm->ring, l->shm->size);
+    libnet_free(l->shm);
+    l->shm = NULL;
+
+    return (1);
+}
+
+int
+libnet_write_shm(libnet_t *l)
+{
+    struct libnet_ring *r;
+    uint32_t len = 0;
+    uint64_t pos;
+    uint8_t *buf;
+
+    if (l == NULL || l->shm == NULL)
+    {
+        return (-1);
+    }
+    r = l->shm->ring;
+    LIBNET_PROBE2(write_entry, __func__, l->total_size);
+
+    buf = libnet_ring_claim(r, &pos);
+    if (buf == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): ring %s is full", __func__, l->device);
+        libnet_stats_error(l, EAGAIN, 0);
+        LIBNET_PROBE3(write_return, __func__, -1, EAGAIN);
+        return (-1);
+    }
+
+    /* every claimed slot must be committed, an empty one is skipped */
+    if (libnet_pblock_coalesce_buf(l, buf, r->frame_max, &len) == -1)
+    {
+        /* err msg set in libnet_pblock_coalesce_buf() */
+        libnet_ring_commit(r, pos, 0);
+        LIBNET_PROBE3(write_return, __func__, -1, 0);
+        return (-1);
+    }
+    if (!libnet_ring_commit(r, pos, len))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): ring %s: slot timed out, frame lost", __func__,
+                l->device);
+        libnet_stats_error(l, ETIMEDOUT, 0);
+        LIBNET_PROBE3(write_return, __func__, -1, ETIMEDOUT);
+        return (-1);
+    }
+    libnet_stats_sent(l, 1, len);
+    LIBNET_PROBE3(write_return, __func__, len, 0);
+
+    return (len);
+}
+
+int
+libnet_write_shm_batch(libnet_t *l, const struct libnet_frame *frames,
+        uint32_t n)
+{
+    struct libnet_ring *r;
+    uint32_t done;
+    uint64_t pos;
+    uint8_t *buf;
+    int err = 0;
+
+    if (l == NULL || l->shm == NULL)
+    {
+        return (0);
+    }
+    r = l->shm->ring;
+    LIBNET_PROBE2(write_entry, __func__, n);
+
+    for (done = 0; done < n; done++)
+    {
+        if (frames[done].len > r->frame_max)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): %u byte frame exceeds the ring's %u", __func__,
+                    frames[done].len, r->frame_max);
+            break;
+        }
+
+        buf = libnet_ring_claim(r, &pos);
+        if (buf == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): ring %s is full", __func__, l->device);
+            break;
+        }
+        memcpy(buf, frames[done].buf, frames[done].len);
+        if (!libnet_ring_commit(r, pos, frames[done].len))
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): ring %s: slot timed out, frame lost", __func__,
+                    l->device);
+            err = ETIMEDOUT;
+            break;
+        }
+        libnet_stats_sent(l, 1, frames[done].len);
+    }
+
+    if (done < n)
+    {
+        /* a full ring is EAGAIN, an oversized frame EMSGSIZE */
+        if (err == 0)
+        {
+            err = frames[done].len > r->frame_max ? EMSGSIZE : EAGAIN;
+        }
+        libnet_stats_error(l, err, 0);
+    }
+
+    LIBNET_PROBE3(write_return, __func__, done, err);
+    return (done);
+}
+
+#endif  /* HAVE_SHM_OPEN */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
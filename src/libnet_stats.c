@@ -0,0 +1,705 @@
+/*
+ *  libnet
+ *  libnet_stats.c - extended statistics
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+#include <stddef.h>
+
+#if !((_WIN32) && !(__CYGWIN__))
+#include <time.h>
+#endif
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define RATE_TAU_NS     1000000000ULL   /* EWMA time constant */
+#define PAGE_FULL_EVERY 64              /* writes between full updates */
+#define PAGE_READ_TRIES 100000          /* before a reader gives up */
+
+/* the part of the page under the seqlock, copied as 64-bit words */
+#define PAGE_BODY_OFF   offsetof(struct libnet_stats_page, stats)
+#define PAGE_BODY_WORDS \
+    ((sizeof (struct libnet_stats_page) - PAGE_BODY_OFF) / sizeof (uint64_t))
+
+/* the counters of struct libnet_stats_ex, everything before the rates */
+#define STATS_COUNT_WORDS \
+    (offsetof(struct libnet_stats_ex, pps) / sizeof (uint64_t))
+
+static void stats_page_update(libnet_t *l, int full);
+
+/* CLOCK_MONOTONIC in ns, the same for all processes */
+static uint64_t
+stats_now(void)
+{
+#if ((_WIN32) && !(__CYGWIN__))
+    {
+        LARGE_INTEGER t, f;
+
+        QueryPerformanceCounter(&t);
+        QueryPerformanceFrequency(&f);
+        return ((uint64_t)(t.QuadPart / (double)f.QuadPart * 1e9) | 1);
+    }
+#else
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        /* never 0, that means "not timed" */
+        return (((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec) | 1);
+    }
+#endif
+}
+
+uint64_t
+libnet_stats_clock(const libnet_t *l)
+{
+    if (!l->stats_timing)
+    {
+        return (0);
+    }
+
+    return (stats_now());
+}
+
+void
+libnet_stats_syscall(libnet_t *l, uint64_t t0)
+{
+    uint64_t ns;
+    int err;
+
+    if (t0 == 0)
+    {
+        return;
+    }
+
+    /* callers look at errno after this */
+    err = errno;
+    ns = libnet_stats_clock(l) - t0;
+    errno = err;
+
+    l->xstats.syscalls++;
+    l->xstats.syscall_ns += ns;
+    libnet_stats_hist(l->xstats.syscall_hist, ns);
+}
+
+void
+libnet_stats_hist(uint64_t *hist, uint64_t ns)
+{
+    int b;
+
+    /* bucket b holds [2^b, 2^(b + 1)) ns, the last one everything above */
+    for (b = 0; b < LIBNET_STATS_HIST - 1 && (ns >> (b + 1)); b++)
+        ;
+    hist[b]++;
+}
+
+void
+libnet_stats_sent(libnet_t *l, uint32_t frames, uint64_t bytes)
+{
+    l->stats.packets_sent  += frames;
+    l->stats.bytes_written += bytes;
+
+    /* the socket numbers the frames of all its contexts, see libnet_ts.c */
+    if (l->fd_share)
+    {
+        __atomic_add_fetch(&l->fd_share->frames, frames, __ATOMIC_RELAXED);
+    }
+
+    if (l->stats_page)
+    {
+        stats_page_update(l, ++l->stats_page_tick % PAGE_FULL_EVERY == 0);
+    }
+}
+
+static void
+stats_classify(libnet_t *l, int err)
+{
+    switch (err)
+    {
+        case ENOBUFS:
+            l->xstats.err_nobufs++;
+            break;
+        case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+            l->xstats.err_again++;
+            break;
+        case EMSGSIZE:
+            l->xstats.err_msgsize++;
+            break;
+        case EPERM:
+        case EACCES:
+            l->xstats.err_perm++;
+            break;
+        default:
+            l->xstats.err_other++;
+            break;
+    }
+}
+
+void
+libnet_stats_error(libnet_t *l, int err, int partial)
+{
+    l->stats.packet_errors++;
+
+    /* the frame may have taken a number on the socket, see libnet_ts.c */
+    if (l->fd_share)
+    {
+        __atomic_add_fetch(&l->fd_share->errors, 1, __ATOMIC_RELAXED);
+    }
+
+    /*
+     *  XXX - we probably should have a way to retrieve the number of
+     *  bytes actually written (since we might have written something).
+     */
+    if (partial > 0)
+    {
+        l->stats.bytes_written += partial;
+        l->xstats.partial_writes++;
+    }
+    else
+    {
+        stats_classify(l, err);
+    }
+
+    if (l->stats_page)
+    {
+        stats_page_update(l, 1);
+    }
+}
+
+void
+libnet_stats_write(libnet_t *l, int c, uint32_t len, uint64_t t0)
+{
+    const int err = errno;
+
+    libnet_stats_syscall(l, t0);
+
+    if (c == (int)len)
+    {
+        libnet_stats_sent(l, 1, len);
+    }
+    else
+    {
+        libnet_stats_error(l, err, c);
+    }
+}
+
+void
+libnet_stats_merge(libnet_t *l, const libnet_t *from)
+{
+    int b;
+
+    l->stats.packets_sent   += from->stats.packets_sent;
+    l->stats.packet_errors  += from->stats.packet_errors;
+    l->stats.bytes_written  += from->stats.bytes_written;
+    l->xstats.err_nobufs    += from->xstats.err_nobufs;
+    l->xstats.err_again     += from->xstats.err_again;
+    l->xstats.err_msgsize   += from->xstats.err_msgsize;
+    l->xstats.err_perm      += from->xstats.err_perm;
+    l->xstats.err_other     += from->xstats.err_other;
+    l->xstats.partial_writes += from->xstats.partial_writes;
+    l->xstats.syscalls      += from->xstats.syscalls;
+    l->xstats.syscall_ns    += from->xstats.syscall_ns;
+    for (b = 0; b < LIBNET_STATS_HIST; b++)
+    {
+        l->xstats.syscall_hist[b] += from->xstats.syscall_hist[b];
+    }
+
+    if (l->stats_page)
+    {
+        stats_page_update(l, 1);
+    }
+}
+
+void
+libnet_stats_timing(libnet_t *l, int on)
+{
+    if (l)
+    {
+        l->stats_timing = on ? 1 : 0;
+    }
+}
+
+/* moves the rates on by dt ns, in which packets and bytes were written */
+static void
+stats_ewma(double *pps, double *bps, uint64_t dt, int64_t packets,
+        int64_t bytes)
+{
+    /* alpha = dt / (tau + dt), close to 1 - e^(-dt/tau) */
+    const double alpha = (double)dt / (double)(RATE_TAU_NS + dt);
+
+    *pps += alpha * (packets * 1e9 / dt - *pps);
+    *bps += alpha * (bytes * 8e9 / dt - *bps);
+}
+
+/* samples the rates, for libnet_stats_ex() */
+static void
+stats_rates(libnet_t *l)
+{
+    /* the rates need a clock, whether or not the writes are timed */
+    const uint64_t now = stats_now();
+
+    if (l->rate_t && now > l->rate_t)
+    {
+        stats_ewma(&l->xstats.pps, &l->xstats.bps, now - l->rate_t,
+                l->stats.packets_sent - l->rate_packets,
+                l->stats.bytes_written - l->rate_bytes);
+    }
+    l->rate_t       = now;
+    l->rate_packets = l->stats.packets_sent;
+    l->rate_bytes   = l->stats.bytes_written;
+}
+
+static void
+stats_copy(const libnet_t *l, struct libnet_stats_ex *ls)
+{
+    *ls = l->xstats;
+    ls->packets_sent  = l->stats.packets_sent;
+    ls->packet_errors = l->stats.packet_errors;
+    ls->bytes_written = l->stats.bytes_written;
+}
+
+int
+libnet_stats_ex(libnet_t *l, struct libnet_stats_ex *ls)
+{
+    if (l == NULL || ls == NULL)
+    {
+        return (-1);
+    }
+
+    stats_rates(l);
+    stats_copy(l, ls);
+
+    return (1);
+}
+
+/*
+ *  The statistics page is a seqlock with a single writer, the thread
+ *  writing the context, or the TX thread while the context has one.
+ *  Every word under it is stored and loaded atomically, so a reader racing
+ *  an update gets a torn copy, which it throws away, but never undefined
+ *  behaviour.
+ */
+static void
+stats_page_update(libnet_t *l, int full)
+{
+    struct libnet_stats_page *page = l->stats_page;
+    const struct libnet_stats_ex *base = &l->stats_page_base;
+    libnet_t *owner = l->stats_page_owner ? l->stats_page_owner : l;
+    uint64_t *dst = (uint64_t *)&page->stats;
+    const uint32_t seq = page->seq;
+    uint32_t i;
+
+    __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (full)
+    {
+        struct libnet_stats_page body;
+        const uint64_t *src = (const uint64_t *)&body.stats;
+        uint64_t *count = (uint64_t *)&body.stats;
+
+        stats_copy(l, &body.stats);
+        for (i = 0; i < STATS_COUNT_WORDS; i++)
+        {
+            count[i] += ((const uint64_t *)base)[i];
+        }
+
+        /* the rates of what the page counts, whoever wrote it before */
+        body.stats.pps = page->stats.pps;
+        body.stats.bps = page->stats.bps;
+        body.rate_t    = stats_now();
+        if (page->rate_t && body.rate_t > page->rate_t)
+        {
+            stats_ewma(&body.stats.pps, &body.stats.bps,
+                    body.rate_t - page->rate_t,
+                    body.stats.packets_sent - page->rate_packets,
+                    body.stats.bytes_written - page->rate_bytes);
+        }
+        body.rate_packets = body.stats.packets_sent;
+        body.rate_bytes   = body.stats.bytes_written;
+
+        memset(&body.queue, 0, sizeof (body.queue));
+#ifdef HAVE_PTHREAD
+        if (owner->tx)
+        {
+            libnet_tx_stats(owner, &body.queue);
+        }
+#endif
+
+        for (i = 0; i < PAGE_BODY_WORDS; i++)
+        {
+            __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+        }
+    }
+    else
+    {
+        __atomic_store_n(&page->stats.packets_sent,
+                l->stats.packets_sent + base->packets_sent,
+                __ATOMIC_RELAXED);
+        __atomic_store_n(&page->stats.packet_errors,
+                l->stats.packet_errors + base->packet_errors,
+                __ATOMIC_RELAXED);
+        __atomic_store_n(&page->stats.bytes_written,
+                l->stats.bytes_written + base->bytes_written,
+                __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void
+libnet_stats_page_lend(libnet_t *l, libnet_t *w)
+{
+    if (l->stats_page == NULL)
+    {
+        return;
+    }
+
+    /* l goes on counting, but only w writes the page */
+    stats_page_update(l, 1);
+    stats_copy(l, &w->stats_page_base);
+    w->stats_page       = l->stats_page;
+    w->stats_page_owner = l;
+    w->stats_page_tick  = 0;
+    l->stats_page       = NULL;
+}
+
+void
+libnet_stats_page_return(libnet_t *l, libnet_t *w)
+{
+    if (w->stats_page_owner != l)
+    {
+        return;
+    }
+
+    l->stats_page       = w->stats_page;
+    w->stats_page       = NULL;
+    w->stats_page_owner = NULL;
+}
+
+int
+libnet_stats_read(const struct libnet_stats_page *page,
+        struct libnet_stats_page *copy)
+{
+    const uint64_t *src = (const uint64_t *)&page->stats;
+    uint64_t *dst = (uint64_t *)&copy->stats;
+    uint64_t now;
+    uint32_t seq, i;
+    int tries;
+
+    if (page == NULL || copy == NULL)
+    {
+        return (-1);
+    }
+
+    /* the header is written once, before the magic */
+    memcpy(copy, page, PAGE_BODY_OFF);
+
+    for (tries = 0; tries < PAGE_READ_TRIES; tries++)
+    {
+        seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        for (i = 0; i < PAGE_BODY_WORDS; i++)
+        {
+            dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq)
+        {
+            copy->seq = seq;
+
+            /* the rates are sampled now and then, an idle sender's never */
+            now = stats_now();
+            if (copy->rate_t && now > copy->rate_t)
+            {
+                stats_ewma(&copy->stats.pps, &copy->stats.bps,
+                        now - copy->rate_t,
+                        copy->stats.packets_sent - copy->rate_packets,
+                        copy->stats.bytes_written - copy->rate_bytes);
+                copy->rate_t       = now;
+                copy->rate_packets = copy->stats.packets_sent;
+                copy->rate_bytes   = copy->stats.bytes_written;
+            }
+            return (1);
+        }
+    }
+
+    return (-1);
+}
+
+#ifdef HAVE_SHM_OPEN
+/* as much of a page path as an error message has room for */
+#define LIBNET_STATS_PATH_ERR   (LIBNET_ERRBUF_SIZE / 2)
+
+static int
+stats_page_name(char *buf, size_t len, const char *name)
+{
+    return (name && name[0] && !strchr(name, '/') &&
+            snprintf(buf, len, "%s%s", LIBNET_STATS_PAGE_PREFIX, name) <
+            (int)len);
+}
+
+int
+libnet_stats_publish(libnet_t *l, const char *name)
+{
+    struct libnet_stats_page *page;
+    char path[NAME_MAX];
+    int fd;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    /* the name stays while the page is lent to the TX thread */
+    if (l->stats_page_name)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): statistics already published as %s", __func__,
+                l->stats_page_name);
+        return (-1);
+    }
+#ifdef HAVE_PTHREAD
+    /* the page would miss what the thread writes, see libnet_tx_start() */
+    if (l->tx)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): publish before libnet_tx_start()", __func__);
+        return (-1);
+    }
+#endif
+
+    if (!stats_page_name(path, sizeof (path), name))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): invalid page name", __func__);
+        return (-1);
+    }
+
+    /* readers of a stale page keep it, this is a new one */
+    shm_unlink(path);
+    fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): shm_open(%.*s): %s", __func__, LIBNET_STATS_PATH_ERR,
+                path, strerror(errno));
+        return (-1);
+    }
+
+    /* readable by monitoring tools, whatever the umask */
+    if (fchmod(fd, 0644) == -1 ||
+        ftruncate(fd, sizeof (struct libnet_stats_page)) == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): %.*s: %s", __func__, LIBNET_STATS_PATH_ERR, path,
+                strerror(errno));
+        goto bad;
+    }
+
+    page = mmap(NULL, sizeof (*page), PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    if (page == MAP_FAILED)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): mmap(): %s", __func__, strerror(errno));
+        goto bad;
+    }
+    close(fd);
+
+    l->stats_page_name = libnet_strdup(l, path);
+    if (l->stats_page_name == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): malloc(): %s", __func__, strerror(errno));
+        munmap(page, sizeof (*page));
+        shm_unlink(path);
+        return (-1);
+    }
+
+    page->version = LIBNET_STATS_PAGE_VERSION;
+    page->pid     = (uint32_t)getpid();
+    snprintf(page->label, sizeof (page->label), "%s", l->label);
+    if (l->device)
+    {
+        snprintf(page->device, sizeof (page->device), "%s", l->device);
+    }
+    l->stats_page      = page;
+    l->stats_page_tick = 0;
+    stats_page_update(l, 1);
+
+    /* readers check the magic before anything else */
+    __atomic_store_n(&page->magic, LIBNET_STATS_PAGE_MAGIC, __ATOMIC_RELEASE);
+
+    return (1);
+
+bad:
+    close(fd);
+    shm_unlink(path);
+    return (-1);
+}
+
+int
+libnet_stats_unpublish(libnet_t *l)
+{
+    if (l == NULL || l->stats_page_name == NULL)
+    {
+        return (-1);
+    }
+    if (l->stats_page == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): the TX thread writes the page, see libnet_tx_stop()",
+                __func__);
+        return (-1);
+    }
+
+    shm_unlink(l->stats_page_name);
+    munmap(l->stats_page, sizeof (*l->stats_page));
+    libnet_free(l->stats_page_name);
+    l->stats_page      = NULL;
+    l->stats_page_name = NULL;
+
+    return (1);
+}
+
+const struct libnet_stats_page *
+libnet_stats_map(const char *name, char *errbuf)
+{
+    struct libnet_stats_page *page;
+    char path[NAME_MAX];
+    struct stat st;
+    int fd;
+
+    if (!stats_page_name(path, sizeof (path), name))
+    {
+        snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): invalid page name",
+                __func__);
+        return (NULL);
+    }
+
+    fd = shm_open(path, O_RDONLY, 0);
+    if (fd == -1)
+    {
+        snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): %s: %s", __func__,
+                name, strerror(errno));
+        return (NULL);
+    }
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof (*page))
+    {
+        snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): %s: not a statistics page",
+                __func__, name);
+        close(fd);
+        return (NULL);
+    }
+
+    page = mmap(NULL, sizeof (*page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        snprintf(errbuf, LIBNET_ERRBUF_SIZE, "%s(): mmap(): %s", __func__,
+                strerror(errno));
+        return (NULL);
+    }
+
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) !=
+            LIBNET_STATS_PAGE_MAGIC ||
+        page->version != LIBNET_STATS_PAGE_VERSION)
+    {
+        snprintf(errbuf, LIBNET_ERRBUF_SIZE,
+                "%s(): %s: not a statistics page of this version", __func__,
+                name);
+        munmap(page, sizeof (*page));
+        return (NULL);
+    }
+
+    return (page);
+}
+
+void
+libnet_stats_unmap(const struct libnet_stats_page *page)
+{
+    if (page)
+    {
+        munmap((void *)page, sizeof (*page));
+    }
+}
+
+#else   /* !HAVE_SHM_OPEN */
+
+int
+libnet_stats_publish(libnet_t *l, const char *name)
+{
+    if (l)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no shared memory support on this platform", __func__);
+    }
+    return (-1);
+}
+
+int
+libnet_stats_unpublish(libnet_t *l)
+{
+    return (-1);
+}
+
+const struct libnet_stats_page *
+libnet_stats_map(const char *name, char *errbuf)
+{
+    snprintf(errbuf, LIBNET_ERRBUF_SIZE,
+            "%s(): no shared memory support on this platform", __func__);
+    return (NULL);
+}
+
+void
+libnet_stats_unmap(const struct libnet_stats_page *page)
+{
+}
+
+#endif  /* HAVE_SHM_OPEN */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,554 @@
+/*
+ *  libnet
+ *  libnet_ts.c - kernel TX timestamps
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+#if defined(HAVE_LINUX_NET_TSTAMP_H) && defined(HAVE_LINUX_ERRQUEUE_H) && \
+    defined(HAVE_RECVMMSG)
+#include <poll.h>
+#include <time.h>
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+
+/* timestamps read from the error queue with one recvmmsg() call */
+#define LIBNET_TS_BATCH   32
+
+/* libnet_write_ts() frames waiting for their timestamps, a power of two */
+#define LIBNET_TS_PENDING 1024
+
+#define LIBNET_TS_FLAGS (SOF_TIMESTAMPING_TX_SCHED    | \
+                         SOF_TIMESTAMPING_TX_SOFTWARE | \
+                         SOF_TIMESTAMPING_SOFTWARE    | \
+                         SOF_TIMESTAMPING_OPT_ID      | \
+                         SOF_TIMESTAMPING_OPT_TSONLY)
+
+struct libnet_ts_pending
+{
+    uint32_t id;
+    uint8_t used;                       /* written, not reported yet */
+    struct timespec user;
+    struct timespec sched;
+};
+
+/*
+ *  The kernel numbers the frames a socket sends, from 0 when timestamping
+ *  is turned on (SOF_TIMESTAMPING_OPT_ID), and tags each timestamp with
+ *  that number, which is the only key a timestamp is matched by.  libnet
+ *  counts the frames sent on the socket too, in the libnet_fd_share of the
+ *  context and its clones, to know the number of a frame before it is
+ *  sent.  A write that fails may or may not have taken a number, so after
+ *  one the count is put back in step with the kernel's: the qdisc
+ *  timestamp of a frame is generated while it is sent, so once the error
+ *  queue is drained the first one to come in after the next write has
+ *  the number of that frame.
+ */
+struct libnet_ts
+{
+    libnet_ts_cb cb;
+    void *arg;
+    uint32_t frames0;                   /* fd_share->frames at frame 0 */
+    uint32_t skew;                      /* kernel's number minus ours */
+    uint32_t errors;                    /* fd_share->errors when in step */
+    uint8_t resync;                     /* out of step since an error */
+    uint8_t claim;                      /* next qdisc timestamp numbers... */
+    uint32_t claim_n;                   /* ... the frame in libnet_write_ts() */
+    struct timespec claim_user;         /* ... written at this time */
+    struct libnet_ts_stats stats;
+    struct libnet_ts_pending pending[LIBNET_TS_PENDING];
+};
+
+static uint64_t
+ts_ns(const struct timespec *a, const struct timespec *b)
+{
+    const int64_t ns = (int64_t)(b->tv_sec - a->tv_sec) * 1000000000 +
+        (b->tv_nsec - a->tv_nsec);
+
+    /* clock steps */
+    return (ns > 0 ? (uint64_t)ns : 0);
+}
+
+int
+libnet_ts_start(libnet_t *l, libnet_ts_cb cb, void *arg)
+{
+    const int flags = LIBNET_TS_FLAGS;
+    struct libnet_ts *ts;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    switch (l->injection_type)
+    {
+        case LIBNET_LINK:
+        case LIBNET_LINK_ADV:
+        case LIBNET_RAW4:
+        case LIBNET_RAW4_ADV:
+        case LIBNET_RAW6:
+        case LIBNET_RAW6_ADV:
+            break;
+        default:
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): needs a link or raw socket context", __func__);
+            return (-1);
+    }
+
+    if (l->ts)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): timestamping already on", __func__);
+        return (-1);
+    }
+
+    /* the frame count lives with the socket, whichever context writes */
+    if (libnet_fd_share(l) == -1)
+    {
+        return (-1);
+    }
+    if (__atomic_exchange_n(&l->fd_share->ts, 1, __ATOMIC_ACQ_REL))
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): timestamping already on for a clone", __func__);
+        return (-1);
+    }
+
+    ts = libnet_calloc(l, 1, sizeof (*ts));
+    if (ts == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                __func__, strerror(errno));
+        goto bad;
+    }
+
+    /*
+     *  The error queue shares the receive buffer of the socket, which for
+     *  a link context fills up with every frame on the device, so that
+     *  timestamps would be dropped.  libnet never reads, let nothing in.
+     *  The filter is the socket's, so it holds for clones too.
+     */
+    if (l->injection_type == LIBNET_LINK ||
+        l->injection_type == LIBNET_LINK_ADV)
+    {
+        struct sock_filter drop = BPF_STMT(BPF_RET | BPF_K, 0);
+        struct sock_fprog prog = { 1, &drop };
+        uint8_t junk[1];
+
+        if (setsockopt(l->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+                sizeof (prog)) == -1)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): SO_ATTACH_FILTER: %s", __func__, strerror(errno));
+            goto bad;
+        }
+        while (recv(l->fd, junk, sizeof (junk), MSG_DONTWAIT) >= 0)
+            ;
+    }
+
+    /* also restarts the frame numbering of the socket */
+    if (setsockopt(l->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags,
+            sizeof (flags)) == -1)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): SO_TIMESTAMPING: %s", __func__, strerror(errno));
+        goto bad;
+    }
+
+    ts->cb      = cb;
+    ts->arg     = arg;
+    ts->frames0 = __atomic_load_n(&l->fd_share->frames, __ATOMIC_RELAXED);
+    ts->errors  = __atomic_load_n(&l->fd_share->errors, __ATOMIC_RELAXED);
+    l->ts       = ts;
+
+    return (1);
+
+bad:
+    libnet_free(ts);
+    __atomic_store_n(&l->fd_share->ts, 0, __ATOMIC_RELEASE);
+    return (-1);
+}
+
+/* files frame n, written at user, for its timestamps */
+static struct libnet_ts_pending *
+ts_pending(struct libnet_ts *ts, uint32_t n, const struct timespec *user)
+{
+    struct libnet_ts_pending *p = &ts->pending[n & (LIBNET_TS_PENDING - 1)];
+
+    if (p->used)
+    {
+        ts->stats.lost++;
+    }
+    p->id    = n;
+    p->used  = 1;
+    p->user  = *user;
+    p->sched.tv_sec  = 0;
+    p->sched.tv_nsec = 0;
+
+    return (p);
+}
+
+int
+libnet_write_ts(libnet_t *l, uint32_t *id)
+{
+    struct libnet_ts *ts;
+    struct timespec now;
+    uint32_t n, errors;
+    int c;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    ts = l->ts;
+    if (ts == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): timestamping is off, see libnet_ts_start()", __func__);
+        return (-1);
+    }
+
+    errors = __atomic_load_n(&l->fd_share->errors, __ATOMIC_RELAXED);
+    if (errors != ts->errors)
+    {
+        ts->errors = errors;
+        ts->resync = 1;
+    }
+
+    /* software timestamps are CLOCK_REALTIME */
+    clock_gettime(CLOCK_REALTIME, &now);
+    n = __atomic_load_n(&l->fd_share->frames, __ATOMIC_RELAXED) -
+        ts->frames0 + ts->skew;
+
+    /*
+     *  Out of step, the kernel's number for this frame comes with its qdisc
+     *  timestamp, which ts_handle() files the frame under.
+     */
+    if (ts->resync)
+    {
+        libnet_ts_poll(l, 0);
+        ts->claim      = 1;
+        ts->claim_n    = n;
+        ts->claim_user = now;
+    }
+
+    c = libnet_write(l);
+    if (c == -1)
+    {
+        ts->claim = 0;
+        return (-1);
+    }
+
+    if (ts->claim)
+    {
+        libnet_ts_poll(l, 0);
+    }
+    if (ts->claim)
+    {
+        /* none came in, go on with our count */
+        ts->claim = 0;
+        ts_pending(ts, n, &now);
+    }
+    else if (ts->resync)
+    {
+        n = ts->claim_n;
+        ts->resync = 0;
+    }
+    else
+    {
+        ts_pending(ts, n, &now);
+    }
+
+    if (id)
+    {
+        *id = n;
+    }
+    return (c);
+}
+
+/* one timestamp off the error queue */
+static int
+ts_handle(libnet_t *l, struct msghdr *msg)
+{
+    struct libnet_ts *ts = l->ts;
+    const struct sock_extended_err *ee = NULL;
+    const struct scm_timestamping *tss = NULL;
+    struct libnet_ts_pending *p;
+    struct libnet_ts_report r;
+    struct cmsghdr *cm;
+
+    for (cm = CMSG_FIRSTHDR(msg); cm; cm = CMSG_NXTHDR(msg, cm))
+    {
+        if (cm->cmsg_level == SOL_SOCKET &&
+            cm->cmsg_type == SCM_TIMESTAMPING)
+        {
+            tss = (const struct scm_timestamping *)CMSG_DATA(cm);
+        }
+        /* SOL_PACKET, SOL_IP or SOL_IPV6, depending on the socket */
+        else if (cm->cmsg_len >= CMSG_LEN(sizeof (*ee)))
+        {
+            ee = (const struct sock_extended_err *)CMSG_DATA(cm);
+            if (ee->ee_origin != SO_EE_ORIGIN_TIMESTAMPING)
+            {
+                ee = NULL;
+            }
+        }
+    }
+    if (tss == NULL || ee == NULL)
+    {
+        return (0);
+    }
+
+    p = &ts->pending[ee->ee_data & (LIBNET_TS_PENDING - 1)];
+    if (!p->used || p->id != ee->ee_data)
+    {
+        p = NULL;
+    }
+
+    if (ee->ee_info == SCM_TSTAMP_SCHED)
+    {
+        /* failed writes only ever leave the kernel ahead of our count */
+        if (ts->claim && ee->ee_data - ts->claim_n < 0x80000000U)
+        {
+            ts->skew   += ee->ee_data - ts->claim_n;
+            ts->claim_n = ee->ee_data;
+            ts->claim   = 0;
+            p = ts_pending(ts, ee->ee_data, &ts->claim_user);
+        }
+        if (p)
+        {
+            p->sched = tss->ts[0];
+        }
+        return (0);
+    }
+    if (ee->ee_info != SCM_TSTAMP_SND)
+    {
+        return (0);
+    }
+
+    memset(&r, 0, sizeof (r));
+    r.id   = ee->ee_data;
+    r.sent = tss->ts[0];
+    if (p)
+    {
+        r.user  = p->user;
+        r.sched = p->sched;
+        p->used = 0;
+    }
+    else
+    {
+        ts->stats.unmatched++;
+    }
+
+    ts->stats.reports++;
+    if (r.sched.tv_sec)
+    {
+        const uint64_t queue = ts_ns(&r.sched, &r.sent);
+
+        ts->stats.queue_ns += queue;
+        libnet_stats_hist(ts->stats.queue_hist, queue);
+        if (r.user.tv_sec)
+        {
+            const uint64_t build = ts_ns(&r.user, &r.sched);
+
+            ts->stats.build_ns += build;
+            libnet_stats_hist(ts->stats.build_hist, build);
+        }
+    }
+
+    if (ts->cb)
+    {
+        ts->cb(l, &r, ts->arg);
+    }
+    return (1);
+}
+
+int
+libnet_ts_poll(libnet_t *l, int timeout_ms)
+{
+    struct mmsghdr msgs[LIBNET_TS_BATCH];
+    struct iovec iov[LIBNET_TS_BATCH];
+    char ctrl[LIBNET_TS_BATCH][256];
+    uint8_t data[64];
+    struct pollfd pfd;
+    int c, i, reported = 0;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+    if (l->ts == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): timestamping is off, see libnet_ts_start()", __func__);
+        return (-1);
+    }
+
+    /* a pending error, timestamps included, shows as POLLERR */
+    if (timeout_ms)
+    {
+        pfd.fd      = l->fd;
+        pfd.events  = 0;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeout_ms) == -1 && errno != EINTR)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): poll(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+    }
+
+    while (1)
+    {
+        /* with OPT_TSONLY there is no data, the iovec is only a formality */
+        memset(msgs, 0, sizeof (msgs));
+        for (i = 0; i < LIBNET_TS_BATCH; i++)
+        {
+            iov[i].iov_base = data;
+            iov[i].iov_len  = sizeof (data);
+            msgs[i].msg_hdr.msg_iov        = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen     = 1;
+            msgs[i].msg_hdr.msg_control    = ctrl[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof (ctrl[i]);
+        }
+
+        c = recvmmsg(l->fd, msgs, LIBNET_TS_BATCH,
+                MSG_ERRQUEUE | MSG_DONTWAIT, NULL);
+        if (c == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                break;
+            }
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): recvmmsg(): %s", __func__, strerror(errno));
+            return (-1);
+        }
+
+        for (i = 0; i < c; i++)
+        {
+            reported += ts_handle(l, &msgs[i].msg_hdr);
+        }
+        if (c < LIBNET_TS_BATCH)
+        {
+            break;
+        }
+    }
+
+    return (reported);
+}
+
+int
+libnet_ts_stats(libnet_t *l, struct libnet_ts_stats *ts)
+{
+    if (l == NULL || ts == NULL)
+    {
+        return (-1);
+    }
+    if (l->ts == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): timestamping is off, see libnet_ts_start()", __func__);
+        return (-1);
+    }
+
+    *ts = l->ts->stats;
+    return (1);
+}
+
+int
+libnet_ts_stop(libnet_t *l)
+{
+    const int flags = 0;
+
+    if (l == NULL || l->ts == NULL)
+    {
+        return (-1);
+    }
+
+    /* the socket may be shared with clones, which carry on without */
+    setsockopt(l->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof (flags));
+    if (l->injection_type == LIBNET_LINK ||
+        l->injection_type == LIBNET_LINK_ADV)
+    {
+        setsockopt(l->fd, SOL_SOCKET, SO_DETACH_FILTER, &flags,
+                sizeof (flags));
+    }
+    libnet_free(l->ts);
+    l->ts = NULL;
+    __atomic_store_n(&l->fd_share->ts, 0, __ATOMIC_RELEASE);
+
+    return (1);
+}
+
+#else   /* no SO_TIMESTAMPING */
+
+int
+libnet_ts_start(libnet_t *l, libnet_ts_cb cb, void *arg)
+{
+    if (l)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no TX timestamping on this platform", __func__);
+    }
+    return (-1);
+}
+
+int
+libnet_write_ts(libnet_t *l, uint32_t *id)
+{
+    return (libnet_ts_start(l, NULL, NULL));
+}
+
+int
+libnet_ts_poll(libnet_t *l, int timeout_ms)
+{
+    return (libnet_ts_start(l, NULL, NULL));
+}
+
+int
+libnet_ts_stats(libnet_t *l, struct libnet_ts_stats *ts)
+{
+    return (libnet_ts_start(l, NULL, NULL));
+}
+
+int
+libnet_ts_stop(libnet_t *l)
+{
+    return (-1);
+}
+
+#endif  /* SO_TIMESTAMPING */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
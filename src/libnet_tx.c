@@ -0,0 +1,587 @@
+/*
+ *  libnet
+ *  libnet_tx.c - library managed transmit thread
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "libnet_ring.h"
+
+/* frames handed to one libnet_write_batch() call */
+#define LIBNET_TX_BURST 64
+
+/* slot size when none is given, fits a VLAN tagged Ethernet frame */
+#define LIBNET_TX_FRAME_DEFAULT 2048
+
+/*
+ *  The thread writes through a clone of the context, so it never touches
+ *  the statistics, error buffer or pblocks of l, which the producers may
+ *  keep using.  The clone shares the socket of l, and writes its
+ *  statistics page meanwhile.
+ */
+struct libnet_tx
+{
+    struct libnet_ring *ring;
+    struct libnet_ring_reader rd;       /* the thread's side of the ring */
+    libnet_t *w;                        /* the thread's own writer */
+    pthread_t thread;
+    pthread_mutex_t lock;               /* only for sleeping/waking */
+    pthread_cond_t wake;                /* frames for the thread */
+    pthread_cond_t space;               /* free slots for LIBNET_TX_BLOCK */
+    int policy;                         /* LIBNET_TX_DROP or _BLOCK */
+    int sleeping;                       /* sender waits for frames */
+    uint32_t waiting;                   /* producers wait for space */
+    int stop;                           /* drain and exit */
+
+    uint64_t enqueued;
+    uint64_t dropped;
+    uint64_t blocked;
+    uint64_t sent;
+    uint64_t errors;
+    uint32_t max_used;
+};
+
+static void
+tx_wait(struct libnet_tx *tx)
+{
+    struct timespec ts;
+
+    pthread_mutex_lock(&tx->lock);
+    __atomic_store_n(&tx->sleeping, 1, __ATOMIC_SEQ_CST);
+
+    /* recheck, a producer may have committed before seeing the flag */
+    if (!libnet_ring_pending(&tx->rd) && !__atomic_load_n(&tx->stop, __ATOMIC_SEQ_CST))
+    {
+        /* the timeout is a backstop only */
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 10 * 1000 * 1000;
+        if (ts.tv_nsec >= 1000 * 1000 * 1000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000 * 1000 * 1000;
+        }
+        pthread_cond_timedwait(&tx->wake, &tx->lock, &ts);
+    }
+
+    __atomic_store_n(&tx->sleeping, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&tx->lock);
+}
+
+static void
+tx_wakeup(struct libnet_tx *tx)
+{
+    if (__atomic_load_n(&tx->sleeping, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&tx->lock);
+        pthread_cond_signal(&tx->wake);
+        pthread_mutex_unlock(&tx->lock);
+    }
+}
+
+/* wakes the producers waiting for free slots, if any */
+static void
+tx_wakeup_space(struct libnet_tx *tx)
+{
+    /* the released slots are seen before the count of waiters is read */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&tx->waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&tx->lock);
+        pthread_cond_broadcast(&tx->space);
+        pthread_mutex_unlock(&tx->lock);
+    }
+}
+
+/* sleeps until the thread has released slots */
+static void
+tx_wait_space(struct libnet_tx *tx)
+{
+    struct timespec ts;
+
+    pthread_mutex_lock(&tx->lock);
+    __atomic_add_fetch(&tx->waiting, 1, __ATOMIC_SEQ_CST);
+
+    /* recheck, the thread may have released slots before seeing us */
+    if (libnet_ring_used(tx->ring) >= tx->ring->depth)
+    {
+        /* the timeout is a backstop only */
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 10 * 1000 * 1000;
+        if (ts.tv_nsec >= 1000 * 1000 * 1000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000 * 1000 * 1000;
+        }
+        pthread_cond_timedwait(&tx->space, &tx->lock, &ts);
+    }
+
+    __atomic_sub_fetch(&tx->waiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&tx->lock);
+}
+
+static void *
+tx_main(void *arg)
+{
+    struct libnet_tx *tx = arg;
+    struct libnet_frame frames[LIBNET_TX_BURST];
+    uint32_t n, m, off, len, sent, errors;
+    uint8_t *buf;
+    int c;
+
+    for (;;)
+    {
+        /* collect what is ready, skipping slots producers gave up on */
+        for (n = 0, m = 0; n < LIBNET_TX_BURST; n++)
+        {
+            buf = libnet_ring_peek(&tx->rd, n, &len);
+            if (buf == NULL)
+            {
+                break;
+            }
+            if (len)
+            {
+                frames[m].buf = buf;
+                frames[m].len = len;
+                m++;
+            }
+        }
+
+        if (n == 0)
+        {
+            if (__atomic_load_n(&tx->stop, __ATOMIC_SEQ_CST) &&
+                !libnet_ring_pending(&tx->rd))
+            {
+                break;
+            }
+            tx_wait(tx);
+            continue;
+        }
+
+        /* a frame that fails is dropped, the rest still go out */
+        for (off = 0, sent = 0, errors = 0; off < m; )
+        {
+            c = libnet_write_batch(tx->w, &frames[off], m - off);
+            if (c < 0)
+            {
+                c = 0;
+            }
+            off += c;
+            sent += c;
+            if (off < m)
+            {
+                errors++;
+                off++;
+            }
+        }
+
+        libnet_ring_release(&tx->rd, n);
+        tx_wakeup_space(tx);
+        __atomic_fetch_add(&tx->sent, sent, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&tx->errors, errors, __ATOMIC_RELAXED);
+    }
+
+    return (NULL);
+}
+
+/* claims a slot, as the drop/block policy says, NULL if dropped */
+static uint8_t *
+tx_claim(libnet_t *l, struct libnet_tx *tx, uint64_t *pos)
+{
+    uint8_t *buf;
+    uint32_t used, max;
+    int waited = 0;
+
+    while ((buf = libnet_ring_claim(tx->ring, pos)) == NULL)
+    {
+        if (tx->policy == LIBNET_TX_DROP)
+        {
+            __atomic_fetch_add(&tx->dropped, 1, __ATOMIC_RELAXED);
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): queue full, frame dropped", __func__);
+            return (NULL);
+        }
+        if (!waited)
+        {
+            __atomic_fetch_add(&tx->blocked, 1, __ATOMIC_RELAXED);
+            waited = 1;
+        }
+        tx_wakeup(tx);
+        tx_wait_space(tx);
+    }
+
+    used = libnet_ring_used(tx->ring);
+    max = __atomic_load_n(&tx->max_used, __ATOMIC_RELAXED);
+    while (used > max && !__atomic_compare_exchange_n(&tx->max_used, &max,
+            used, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        ;
+    }
+
+    return (buf);
+}
+
+int
+libnet_tx_start(libnet_t *l, uint32_t depth, uint32_t frame_max, int policy,
+        int cpu)
+{
+    struct libnet_tx *tx;
+    size_t size;
+    int rc;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (l->tx)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): TX thread already running", __func__);
+        return (-1);
+    }
+
+    if (policy != LIBNET_TX_DROP && policy != LIBNET_TX_BLOCK)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): unknown queue policy %d", __func__, policy);
+        return (-1);
+    }
+
+    if (frame_max == 0)
+    {
+        frame_max = LIBNET_TX_FRAME_DEFAULT;
+    }
+    if (frame_max > LIBNET_MAX_PACKET + LIBNET_RING_LINE)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): frame size %u too large", __func__, frame_max);
+        return (-1);
+    }
+
+    size = libnet_ring_size(depth, frame_max);
+    if (size == 0)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): queue depth %u is not a power of two", __func__, depth);
+        return (-1);
+    }
+
+    tx = libnet_calloc(l, 1, sizeof (*tx));
+    if (tx == NULL || (tx->ring = libnet_malloc(l, size)) == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                __func__, strerror(errno));
+        libnet_free(tx);
+        return (-1);
+    }
+
+    tx->w = libnet_clone(l);
+    if (tx->w == NULL)
+    {
+        /* err msg set in libnet_clone() */
+        libnet_free(tx->ring);
+        libnet_free(tx);
+        return (-1);
+    }
+
+    tx->w->stats_timing = l->stats_timing;
+
+    libnet_ring_init(tx->ring, depth, frame_max);
+    libnet_ring_reader_init(&tx->rd, tx->ring, size, depth, frame_max);
+    tx->policy = policy;
+    pthread_mutex_init(&tx->lock, NULL);
+    pthread_cond_init(&tx->wake, NULL);
+    pthread_cond_init(&tx->space, NULL);
+
+    l->tx = tx;
+    libnet_stats_page_lend(l, tx->w);
+    rc = pthread_create(&tx->thread, NULL, tx_main, tx);
+    if (rc)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): pthread_create(): %s", __func__, strerror(rc));
+        goto bad;
+    }
+
+    if (cpu >= 0)
+    {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        rc = pthread_setaffinity_np(tx->thread, sizeof (set), &set);
+        if (rc)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): cannot pin to cpu %d: %s", __func__, cpu,
+                    strerror(rc));
+            libnet_tx_stop(l);
+            return (-1);
+        }
+#else
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): cpu pinning not supported on this platform", __func__);
+        libnet_tx_stop(l);
+        return (-1);
+#endif
+    }
+
+    return (1);
+
+bad:
+    libnet_stats_page_return(l, tx->w);
+    l->tx = NULL;
+    pthread_cond_destroy(&tx->space);
+    pthread_cond_destroy(&tx->wake);
+    pthread_mutex_destroy(&tx->lock);
+    libnet_destroy(tx->w);
+    libnet_free(tx->ring);
+    libnet_free(tx);
+    return (-1);
+}
+
+int
+libnet_enqueue(libnet_t *l, libnet_t *src)
+{
+    struct libnet_tx *tx;
+    uint32_t len = 0;
+    uint64_t pos;
+    uint8_t *buf;
+    int rc;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    tx = l->tx;
+    if (tx == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no TX thread, see libnet_tx_start()", __func__);
+        return (-1);
+    }
+
+    if (src == NULL)
+    {
+        src = l;
+    }
+
+    buf = tx_claim(l, tx, &pos);
+    if (buf == NULL)
+    {
+        return (-1);
+    }
+
+    /* coalesce straight into the slot, no copy */
+    rc = libnet_pblock_coalesce_buf(src, buf, tx->ring->frame_max, &len);
+    if (rc == -1 && src != l)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s", src->err_buf);
+    }
+    libnet_ring_commit(tx->ring, pos, rc == -1 ? 0 : len);
+    tx_wakeup(tx);
+
+    if (rc == -1)
+    {
+        return (-1);
+    }
+    __atomic_fetch_add(&tx->enqueued, 1, __ATOMIC_RELAXED);
+
+    return (1);
+}
+
+int
+libnet_enqueue_frame(libnet_t *l, const uint8_t *frame, uint32_t frame_s)
+{
+    struct libnet_tx *tx;
+    uint64_t pos;
+    uint8_t *buf;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    tx = l->tx;
+    if (tx == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no TX thread, see libnet_tx_start()", __func__);
+        return (-1);
+    }
+
+    if (frame_s == 0 || frame_s > tx->ring->frame_max)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): frame size %u out of range (1 - %u)", __func__,
+                frame_s, tx->ring->frame_max);
+        return (-1);
+    }
+
+    buf = tx_claim(l, tx, &pos);
+    if (buf == NULL)
+    {
+        return (-1);
+    }
+
+    memcpy(buf, frame, frame_s);
+    libnet_ring_commit(tx->ring, pos, frame_s);
+    tx_wakeup(tx);
+    __atomic_fetch_add(&tx->enqueued, 1, __ATOMIC_RELAXED);
+
+    return (1);
+}
+
+int
+libnet_tx_stats(libnet_t *l, struct libnet_tx_stats *ts)
+{
+    struct libnet_tx *tx;
+
+    if (l == NULL || ts == NULL)
+    {
+        return (-1);
+    }
+
+    tx = l->tx;
+    if (tx == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no TX thread, see libnet_tx_start()", __func__);
+        return (-1);
+    }
+
+    ts->enqueued = __atomic_load_n(&tx->enqueued, __ATOMIC_RELAXED);
+    ts->dropped  = __atomic_load_n(&tx->dropped, __ATOMIC_RELAXED);
+    ts->blocked  = __atomic_load_n(&tx->blocked, __ATOMIC_RELAXED);
+    ts->sent     = __atomic_load_n(&tx->sent, __ATOMIC_RELAXED);
+    ts->errors   = __atomic_load_n(&tx->errors, __ATOMIC_RELAXED);
+    ts->depth    = tx->ring->depth;
+    ts->used     = libnet_ring_used(tx->ring);
+    ts->max_used = __atomic_load_n(&tx->max_used, __ATOMIC_RELAXED);
+
+    return (1);
+}
+
+int
+libnet_tx_stop(libnet_t *l)
+{
+    struct libnet_tx *tx;
+
+    if (l == NULL || l->tx == NULL)
+    {
+        return (-1);
+    }
+
+    tx = l->tx;
+    __atomic_store_n(&tx->stop, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&tx->lock);
+    pthread_cond_signal(&tx->wake);
+    pthread_mutex_unlock(&tx->lock);
+    pthread_join(tx->thread, NULL);
+
+    /* the writes of the thread count for l from now on, the queue is gone */
+    l->tx = NULL;
+    libnet_stats_page_return(l, tx->w);
+    libnet_stats_merge(l, tx->w);
+
+    pthread_cond_destroy(&tx->space);
+    pthread_cond_destroy(&tx->wake);
+    pthread_mutex_destroy(&tx->lock);
+    libnet_destroy(tx->w);
+    libnet_free(tx->ring);
+    libnet_free(tx);
+
+    return (1);
+}
+
+#else   /* !HAVE_PTHREAD */
+
+static int
+tx_unsupported(libnet_t *l, const char *func)
+{
+    if (l)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): no thread support on this platform", func);
+    }
+    return (-1);
+}
+
+int
+libnet_tx_start(libnet_t *l, uint32_t depth, uint32_t frame_max, int policy,
+        int cpu)
+{
+    (void)depth;        /* unused */
+    (void)frame_max;    /* unused */
+    (void)policy;       /* unused */
+    (void)cpu;          /* unused */
+    return (tx_unsupported(l, __func__));
+}
+
+int
+libnet_enqueue(libnet_t *l, libnet_t *src)
+{
+    (void)src;          /* unused */
+    return (tx_unsupported(l, __func__));
+}
+
+int
+libnet_enqueue_frame(libnet_t *l, const uint8_t *frame, uint32_t frame_s)
+{
+    (void)frame;        /* unused */
+    (void)frame_s;      /* unused */
+    return (tx_unsupported(l, __func__));
+}
+
+int
+libnet_tx_stats(libnet_t *l, struct libnet_tx_stats *ts)
+{
+    (void)ts;           /* unused */
+    return (tx_unsupported(l, __func__));
+}
+
+int
+libnet_tx_stop(libnet_t *l)
+{
+    return (tx_unsupported(l, __func__));
+}
+
+#endif  /* HAVE_PTHREAD */
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,718 @@
+/*
+ *  libnet
+ *  libnet_vary.c - per-context field variation programs
+ *
+ *  Copyright (c) 2026 The libnet Developer Community.
+ *  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "common.h"
+
+/*
+ *  A variation program is a list of (ptag, offset) fields, each with its
+ *  own little state machine.  The program runs in two places:
+ *
+ *  - libnet_pblock_coalesce() calls libnet_vary_apply() before assembling
+ *    the packet, so the current values land in the pblock buffers and the
+ *    regular checksum pass covers them, and libnet_vary_step() once the
+ *    packet is assembled.  A coalesce that fails does not use up a value.
+ *
+ *  - libnet_vary_packet() patches an already coalesced packet in place.
+ *    For this, libnet_pblock_coalesce() calls libnet_vary_layout() to record
+ *    where each field ended up in the frame, and which checksums cover it,
+ *    so the checksums can be fixed up incrementally (RFC 1624) instead of
+ *    being recomputed over the whole packet.
+ */
+
+#define LIBNET_VARY_SITE_MAX    4       /* checksums covering one field */
+
+struct libnet_vary_site
+{
+    uint32_t sum;                       /* frame offset of checksum field */
+    uint32_t beg;                       /* checksummed region */
+    uint32_t end;
+    uint32_t pseudo;                    /* pseudo header addresses */
+    uint32_t pseudo_len;                /* 0 if no pseudo header */
+    int udp4;                           /* zero checksum means "none" */
+};
+
+struct libnet_vary_entry
+{
+    libnet_ptag_t ptag;                 /* pblock holding the field */
+    uint32_t offset;                    /* field offset inside the pblock */
+    struct libnet_vary_spec spec;       /* private copy, list included */
+    uint32_t cur;                       /* value for the next packet */
+    uint32_t idx;                       /* list position */
+    uint32_t hits;                      /* packets sent with cur so far */
+    uint8_t label[LIBNET_VARY_LABEL_MAX]; /* cur of LIBNET_VARY_LABEL */
+
+    /* recorded by libnet_vary_layout() */
+    uint32_t foff;                      /* field offset in the frame */
+    int unsupported;                    /* covered by a checksum we can't fix */
+    uint32_t n_site;
+    struct libnet_vary_site site[LIBNET_VARY_SITE_MAX];
+};
+
+struct libnet_vary_prog
+{
+    uint32_t n;                         /* entries in use */
+    uint32_t max;                       /* entries allocated */
+    struct libnet_vary_entry *e;
+    uint32_t frame_s;                   /* frame size at last layout, 0 if none */
+};
+
+static uint32_t
+vary_random(libnet_t *l, uint32_t min, uint32_t max)
+{
+    const uint32_t r = libnet_get_prand_r(l, LIBNET_PRu32);
+    const uint32_t span = max - min + 1;
+
+    /* span wraps to 0 for the full 32-bit range */
+    return (span ? min + r % span : r);
+}
+
+/* hostname characters, six from each random word (36^6 < 2^32) */
+static void
+vary_label(libnet_t *l, uint8_t *label, uint8_t width)
+{
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    uint32_t r = 0;
+    uint8_t i;
+
+    for (i = 0; i < width; i++)
+    {
+        if (i % 6 == 0)
+        {
+            r = libnet_get_prand_r(l, LIBNET_PRu32);
+        }
+        label[i] = (uint8_t)chars[r % 36];
+        r /= 36;
+    }
+}
+
+static uint32_t
+vary_next(libnet_t *l, struct libnet_vary_entry *e)
+{
+    const struct libnet_vary_spec *s = &e->spec;
+    const uint32_t v = e->cur;
+
+    if (++e->hits < s->every)
+    {
+        return (v);
+    }
+    e->hits = 0;
+
+    switch (s->op)
+    {
+        case LIBNET_VARY_INC:
+            e->cur = (s->max - e->cur < s->step) ? s->min : e->cur + s->step;
+            break;
+        case LIBNET_VARY_DEC:
+            e->cur = (e->cur - s->min < s->step) ? s->max : e->cur - s->step;
+            break;
+        case LIBNET_VARY_RANDOM:
+            e->cur = vary_random(l, s->min, s->max);
+            break;
+        case LIBNET_VARY_LIST:
+            if (++e->idx == s->list_n)
+            {
+                e->idx = 0;
+            }
+            e->cur = s->list[e->idx];
+            break;
+        case LIBNET_VARY_LABEL:
+            vary_label(l, e->label, s->width);
+            break;
+    }
+    return (v);
+}
+
+static void
+vary_store(uint8_t *buf, uint8_t width, uint32_t v)
+{
+    switch (width)
+    {
+        case 4:
+            *buf++ = (uint8_t)(v >> 24);
+            *buf++ = (uint8_t)(v >> 16);
+            /* fall through */
+        case 2:
+            *buf++ = (uint8_t)(v >> 8);
+            /* fall through */
+        case 1:
+            *buf = (uint8_t)v;
+            break;
+    }
+}
+
+/* writes the field's value for this packet */
+static void
+vary_put(const struct libnet_vary_entry *e, uint8_t *buf)
+{
+    if (e->spec.op == LIBNET_VARY_LABEL)
+    {
+        memcpy(buf, e->label, e->spec.width);
+        return;
+    }
+    vary_store(buf, e->spec.width, e->cur);
+}
+
+/* writes the field's value for this packet and steps it */
+static void
+vary_write(libnet_t *l, struct libnet_vary_entry *e, uint8_t *buf)
+{
+    vary_put(e, buf);
+    vary_next(l, e);
+}
+
+int
+libnet_vary_add(libnet_t *l, libnet_ptag_t ptag, uint32_t offset,
+        const struct libnet_vary_spec *spec)
+{
+    struct libnet_vary_prog *prog;
+    struct libnet_vary_entry *e;
+    uint32_t mask, i;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    if (spec == NULL)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): NULL spec", __func__);
+        return (-1);
+    }
+
+    const libnet_pblock_t *p = libnet_pblock_find(l, ptag);
+    if (p == NULL)
+    {
+        /* err msg set in libnet_pblock_find() */
+        return (-1);
+    }
+
+    mask = 0;
+    if (spec->op == LIBNET_VARY_LABEL)
+    {
+        if (spec->width < 1 || spec->width > LIBNET_VARY_LABEL_MAX)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): label width must be 1 to %d (%d)", __func__,
+                    LIBNET_VARY_LABEL_MAX, spec->width);
+            return (-1);
+        }
+    }
+    else
+    {
+        switch (spec->width)
+        {
+            case 1:
+                mask = 0xff;
+                break;
+            case 2:
+                mask = 0xffff;
+                break;
+            case 4:
+                mask = 0xffffffff;
+                break;
+            default:
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): field width must be 1, 2 or 4 (%d)", __func__,
+                        spec->width);
+                return (-1);
+        }
+    }
+
+    if (offset + spec->width > p->b_len)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): field at offset %u is outside the %u byte pblock",
+                __func__, offset, p->b_len);
+        return (-1);
+    }
+
+    switch (spec->op)
+    {
+        case LIBNET_VARY_INC:
+        case LIBNET_VARY_DEC:
+        case LIBNET_VARY_RANDOM:
+            if (spec->min > spec->max || spec->max > mask)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): bad range [%u, %u] for a %d byte field",
+                        __func__, spec->min, spec->max, spec->width);
+                return (-1);
+            }
+            break;
+        case LIBNET_VARY_LIST:
+            if (spec->list == NULL || spec->list_n == 0)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): empty value list", __func__);
+                return (-1);
+            }
+            for (i = 0; i < spec->list_n; i++)
+            {
+                if (spec->list[i] > mask)
+                {
+                    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                            "%s(): list value %u too big for a %d byte field",
+                            __func__, spec->list[i], spec->width);
+                    return (-1);
+                }
+            }
+            break;
+        case LIBNET_VARY_LABEL:
+            break;
+        default:
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): unknown variation op %d", __func__, spec->op);
+            return (-1);
+    }
+
+    prog = l->vary;
+    if (prog == NULL)
+    {
+        prog = libnet_calloc(l, 1, sizeof(*prog));
+        if (prog == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): calloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        l->vary = prog;
+    }
+
+    if (prog->n == prog->max)
+    {
+        const uint32_t max = prog->max ? prog->max * 2 : 4;
+
+        e = libnet_realloc(l, prog->e, max * sizeof(*e));
+        if (e == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): realloc(): %s",
+                    __func__, strerror(errno));
+            return (-1);
+        }
+        prog->e = e;
+        prog->max = max;
+    }
+
+    e = &prog->e[prog->n];
+    memset(e, 0, sizeof(*e));
+    e->ptag   = ptag;
+    e->offset = offset;
+    e->spec   = *spec;
+    if (e->spec.step == 0)
+    {
+        e->spec.step = 1;
+    }
+    if (e->spec.every == 0)
+    {
+        e->spec.every = 1;
+    }
+
+    switch (spec->op)
+    {
+        case LIBNET_VARY_INC:
+            e->cur = spec->min;
+            break;
+        case LIBNET_VARY_DEC:
+            e->cur = spec->max;
+            break;
+        case LIBNET_VARY_RANDOM:
+            e->cur = vary_random(l, spec->min, spec->max);
+            break;
+        case LIBNET_VARY_LIST:
+        {
+            uint32_t *list = libnet_malloc(l, spec->list_n * sizeof(*list));
+            if (list == NULL)
+            {
+                snprintf(l->err_buf, LIBNET_ERRBUF_SIZE, "%s(): malloc(): %s",
+                        __func__, strerror(errno));
+                return (-1);
+            }
+            memcpy(list, spec->list, spec->list_n * sizeof(*list));
+            e->spec.list = list;
+            e->cur = list[0];
+            break;
+        }
+        case LIBNET_VARY_LABEL:
+            vary_label(l, e->label, spec->width);
+            break;
+    }
+
+    prog->n++;
+    prog->frame_s = 0;      /* layout must be recorded again */
+
+    return (1);
+}
+
+void
+libnet_vary_clear(libnet_t *l)
+{
+    struct libnet_vary_prog *prog;
+    uint32_t i;
+
+    if (l == NULL || l->vary == NULL)
+    {
+        return;
+    }
+
+    prog = l->vary;
+    for (i = 0; i < prog->n; i++)
+    {
+        if (prog->e[i].spec.op == LIBNET_VARY_LIST)
+        {
+            libnet_free((void *)prog->e[i].spec.list);
+        }
+    }
+    libnet_free(prog->e);
+    libnet_free(prog);
+    l->vary = NULL;
+}
+
+int
+libnet_vary_apply(libnet_t *l)
+{
+    struct libnet_vary_prog * const prog = l->vary;
+    uint32_t i;
+
+    for (i = 0; i < prog->n; i++)
+    {
+        struct libnet_vary_entry * const e = &prog->e[i];
+        libnet_pblock_t * const p = libnet_pblock_find(l, e->ptag);
+
+        if (p == NULL)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): variation refers to missing ptag %d", __func__,
+                    e->ptag);
+            return (-1);
+        }
+        if (e->offset + e->spec.width > p->b_len)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): ptag %d shrunk below its varied field", __func__,
+                    e->ptag);
+            return (-1);
+        }
+        if (libnet_pblock_own(l, p) == -1)
+        {
+            /* err msg set in libnet_pblock_own() */
+            return (-1);
+        }
+        vary_put(e, p->buf + e->offset);
+    }
+    return (1);
+}
+
+void
+libnet_vary_step(libnet_t *l)
+{
+    struct libnet_vary_prog * const prog = l->vary;
+    uint32_t i;
+
+    for (i = 0; i < prog->n; i++)
+    {
+        vary_next(l, &prog->e[i]);
+    }
+}
+
+static int
+vary_overlaps(uint32_t a, uint32_t b, uint32_t beg, uint32_t end)
+{
+    return (a < end && b > beg);
+}
+
+void
+libnet_vary_layout(libnet_t *l, const uint8_t *frame, uint32_t frame_s)
+{
+    struct libnet_vary_prog * const prog = l->vary;
+    const libnet_pblock_t *p, *q, *ip;
+    uint32_t i, off, q_off, ip_off;
+
+    /* reset, then fill in from the pblock chain as it was just coalesced */
+    for (i = 0; i < prog->n; i++)
+    {
+        prog->e[i].n_site = 0;
+        prog->e[i].unsupported = 1;
+    }
+
+    /* pblocks are laid out back to front, the list head ends the frame */
+    for (off = frame_s, p = l->protocol_blocks; p; p = p->next)
+    {
+        off -= p->b_len;
+        for (i = 0; i < prog->n; i++)
+        {
+            if (prog->e[i].ptag == p->ptag)
+            {
+                prog->e[i].foff = off + prog->e[i].offset;
+                prog->e[i].unsupported = 0;
+            }
+        }
+    }
+
+    for (q_off = frame_s, q = l->protocol_blocks; q; q = q->next)
+    {
+        struct libnet_vary_site s;
+        int proto;
+
+        q_off -= q->b_len;
+        if (!(q->flags & LIBNET_PBLOCK_DO_CHECKSUM))
+        {
+            continue;
+        }
+
+        /* the IP header encapsulating q, which may be q itself */
+        ip_off = q_off;
+        for (ip = q; ip; ip = ip->next)
+        {
+            if (ip->type == LIBNET_PBLOCK_IPV4_H ||
+                ip->type == LIBNET_PBLOCK_IPV6_H)
+            {
+                break;
+            }
+            if (ip->next)
+            {
+                ip_off -= ip->next->b_len;
+            }
+        }
+
+        memset(&s, 0, sizeof(s));
+        s.beg = q_off;
+        s.end = frame_s;
+        proto = libnet_pblock_p2p(q->type);
+        switch (proto)
+        {
+            case IPPROTO_IP:
+                if (q->type != LIBNET_PBLOCK_IPV4_H)
+                {
+                    continue;   /* IPv6 has no header checksum */
+                }
+                s.sum = q_off + 10;
+                s.end = q_off + ((frame[q_off] & 0x0f) << 2);
+                break;
+            case IPPROTO_TCP:
+                s.sum = q_off + 16;
+                break;
+            case IPPROTO_UDP:
+                s.sum = q_off + 6;
+                s.udp4 = ip && ip->type == LIBNET_PBLOCK_IPV4_H;
+                break;
+            case IPPROTO_ICMP:
+            case IPPROTO_ICMPV6:
+            case IPPROTO_IGMP:
+                s.sum = q_off + 2;
+                break;
+            default:
+                s.sum = UINT32_MAX;     /* not patchable in place */
+                break;
+        }
+
+        if (ip && proto != IPPROTO_IP && proto != IPPROTO_IGMP &&
+            (proto != IPPROTO_ICMP || ip->type == LIBNET_PBLOCK_IPV6_H))
+        {
+            if (ip->type == LIBNET_PBLOCK_IPV4_H)
+            {
+                s.pseudo = ip_off + 12;     /* ip_src, ip_dst */
+                s.pseudo_len = 8;
+            }
+            else
+            {
+                s.pseudo = ip_off + 8;
+                s.pseudo_len = 32;
+            }
+        }
+
+        if (s.sum != UINT32_MAX && s.sum + 2 > frame_s)
+        {
+            continue;   /* truncated header, coalesce checksummed nothing */
+        }
+
+        for (i = 0; i < prog->n; i++)
+        {
+            struct libnet_vary_entry * const e = &prog->e[i];
+            const uint32_t a = e->foff;
+            const uint32_t b = e->foff + e->spec.width;
+
+            if (!vary_overlaps(a, b, s.beg, s.end) &&
+                !(s.pseudo_len &&
+                  vary_overlaps(a, b, s.pseudo, s.pseudo + s.pseudo_len)))
+            {
+                continue;
+            }
+            if (s.sum == UINT32_MAX || e->n_site == LIBNET_VARY_SITE_MAX)
+            {
+                e->unsupported = 1;
+                continue;
+            }
+            e->site[e->n_site++] = s;
+        }
+    }
+
+    prog->frame_s = frame_s;
+}
+
+/*
+ *  One's complement sum of the 16-bit words of [a, b), clipped to
+ *  [beg, end), with word boundaries counted from beg.
+ */
+static uint32_t
+vary_sum(const uint8_t *frame, uint32_t a, uint32_t b, uint32_t beg,
+        uint32_t end)
+{
+    uint32_t sum = 0;
+    uint32_t i;
+
+    if (a < beg)
+    {
+        a = beg;
+    }
+    if (b > end)
+    {
+        b = end;
+    }
+    if (a >= b)
+    {
+        return (0);
+    }
+    a -= (a - beg) & 1;
+    for (i = a; i < b; i += 2)
+    {
+        sum += frame[i] << 8;
+        if (i + 1 < b)
+        {
+            sum += frame[i + 1];
+        }
+    }
+
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (sum);
+}
+
+static uint32_t
+vary_site_sum(const uint8_t *frame, const struct libnet_vary_site *s,
+        uint32_t a, uint32_t b)
+{
+    uint32_t sum = vary_sum(frame, a, b, s->beg, s->end);
+
+    if (s->pseudo_len)
+    {
+        sum += vary_sum(frame, a, b, s->pseudo, s->pseudo + s->pseudo_len);
+    }
+    return (sum);
+}
+
+int
+libnet_vary_packet(libnet_t *l, uint8_t *packet, uint32_t packet_s)
+{
+    struct libnet_vary_prog *prog;
+    uint32_t old[LIBNET_VARY_SITE_MAX];
+    uint32_t i, j;
+
+    if (l == NULL)
+    {
+        return (-1);
+    }
+
+    prog = l->vary;
+    if (prog == NULL || prog->n == 0)
+    {
+        return (1);
+    }
+
+    if (prog->frame_s == 0 || prog->frame_s != packet_s)
+    {
+        snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                "%s(): packet does not match the last coalesced layout",
+                __func__);
+        return (-1);
+    }
+
+    for (i = 0; i < prog->n; i++)
+    {
+        if (prog->e[i].unsupported)
+        {
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                    "%s(): field at ptag %d offset %u can't be patched in place",
+                    __func__, prog->e[i].ptag, prog->e[i].offset);
+            return (-1);
+        }
+    }
+
+    for (i = 0; i < prog->n; i++)
+    {
+        struct libnet_vary_entry * const e = &prog->e[i];
+        const uint32_t a = e->foff;
+        const uint32_t b = e->foff + e->spec.width;
+
+        for (j = 0; j < e->n_site; j++)
+        {
+            old[j] = vary_site_sum(packet, &e->site[j], a, b);
+        }
+
+        vary_write(l, e, packet + a);
+
+        for (j = 0; j < e->n_site; j++)
+        {
+            const struct libnet_vary_site * const s = &e->site[j];
+            uint8_t * const sp = packet + s->sum;
+            const uint32_t hc = (sp[0] << 8) | sp[1];
+            uint32_t sum;
+
+            if (s->udp4 && hc == 0)
+            {
+                continue;   /* UDP checksum not in use */
+            }
+
+            /* RFC 1624: HC' = ~(~HC + ~m + m') */
+            sum = (~hc & 0xffff) + (~old[j] & 0xffff) +
+                vary_site_sum(packet, s, a, b);
+            while (sum >> 16)
+            {
+                sum = (sum & 0xffff) + (sum >> 16);
+            }
+            sum = ~sum & 0xffff;
+            if (s->udp4 && sum == 0)
+            {
+                sum = 0xffff;
+            }
+            sp[0] = (uint8_t)(sum >> 8);
+            sp[1] = (uint8_t)sum;
+        }
+    }
+    return (1);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -37,6 +37,7 @@ libnet_write(libnet_t *l)
 {
     uint32_t c;
     uint32_t len;
+    uint64_t t0;
     uint8_t *packet = NULL;
 
     if (l == NULL)
@@ -44,15 +45,25 @@ libnet_write(libnet_t *l)
         return (-1);
     }
 
-    c = libnet_pblock_coalesce(l, &packet, &len);
+#ifdef HAVE_SHM_OPEN
+    /* coalesced straight into the ring, nothing to allocate */
+    if (l->injection_type == LIBNET_SHM)
+    {
+        return (libnet_write_shm(l));
+    }
+#endif
+
+    /* the buffer is the context's, a steady send loop doesn't allocate */
+    c = libnet_pblock_coalesce_cached(l, &packet, &len);
     if (c == UINT32_MAX)
     {
-        /* err msg set in libnet_pblock_coalesce() */
+        /* err msg set in libnet_pblock_coalesce_cached() */
         return (-1);
     }
 
     /* assume error */
     c = -1;
+    t0 = libnet_stats_clock(l);
     switch (l->injection_type)
     {
         case LIBNET_RAW4:
@@ -81,34 +92,100 @@ libnet_write(libnet_t *l)
     }
 
     /* do statistics */
-    if (c == len)
+    libnet_stats_write(l, c, len, t0);
+done:
+    return (c);
+}
+
+int
+libnet_write_batch(libnet_t *l, const struct libnet_frame *frames, uint32_t n)
+{
+    uint32_t done;
+    int c;
+
+    if (l == NULL)
     {
-        l->stats.packets_sent++;
-        l->stats.bytes_written += c;
+        return (-1);
     }
-    else
+
+    switch (l->injection_type)
     {
-        l->stats.packet_errors++;
-        /*
-         *  XXX - we probably should have a way to retrieve the number of
-         *  bytes actually written (since we might have written something).
-         */
-        if (c > 0)
+#ifdef HAVE_LINK_BATCH
+        case LIBNET_LINK:
+        case LIBNET_LINK_ADV:
         {
-            l->stats.bytes_written += c;
+            uint64_t bytes = 0;
+
+            /* the sendmmsg() calls are timed in there */
+            done = libnet_write_link_batch(l, frames, n);
+            for (c = 0; c < (int)done; c++)
+            {
+                bytes += frames[c].len;
+            }
+            libnet_stats_sent(l, done, bytes);
+            if (done < n)
+            {
+                libnet_stats_error(l, errno, 0);
+            }
+            return (done);
         }
+#endif
+#ifdef HAVE_SHM_OPEN
+        case LIBNET_SHM:
+            return (libnet_write_shm_batch(l, frames, n));
+#endif
+        case LIBNET_RAW4:
+        case LIBNET_RAW4_ADV:
+        case LIBNET_RAW6:
+        case LIBNET_RAW6_ADV:
+#ifndef HAVE_LINK_BATCH
+        case LIBNET_LINK:
+        case LIBNET_LINK_ADV:
+#endif
+            break;
+        default:
+            snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                        "%s(): unsupported injection type", __func__);
+            return (0);
     }
-done:
-    /*
-     *  Restore original pointer address so free won't complain about a
-     *  modified chunk pointer.
-     */
-    if (l->aligner > 0)
+
+    for (done = 0; done < n; done++)
     {
-        packet = packet - l->aligner;
+        const uint8_t *packet = frames[done].buf;
+        const uint32_t len = frames[done].len;
+        const uint64_t t0 = libnet_stats_clock(l);
+
+        switch (l->injection_type)
+        {
+            case LIBNET_RAW4:
+            case LIBNET_RAW4_ADV:
+                if (len > LIBNET_MAX_PACKET)
+                {
+                    snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
+                            "%s(): packet is too large (%d bytes)",
+                            __func__, len);
+                    return (done);
+                }
+                c = libnet_write_raw_ipv4(l, packet, len);
+                break;
+            case LIBNET_RAW6:
+            case LIBNET_RAW6_ADV:
+                c = libnet_write_raw_ipv6(l, packet, len);
+                break;
+            default:
+                c = libnet_write_link(l, packet, len);
+                break;
+        }
+
+        /* do statistics */
+        libnet_stats_write(l, c, len, t0);
+        if (c != (int)len)
+        {
+            break;
+        }
     }
-    free(packet);
-    return (c);
+
+    return (done);
 }
 
 #if defined (__WIN32__)
@@ -283,8 +360,10 @@ libnet_write_raw_ipv4(libnet_t *l, const uint8_t *packet, uint32_t size)
     sin.sin_family  = AF_INET;
     sin.sin_addr.s_addr = ip_hdr->ip_dst.s_addr;
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const ssize_t c = sendto(l->fd, packet, size, 0, (struct sockaddr *)&sin,
             sizeof(sin));
+    LIBNET_PROBE3(write_return, __func__, c, errno);
 
 #if (LIBNET_BSD_BYTE_SWAP)
     ip_hdr->ip_len = UNFIX(ip_hdr->ip_len);
@@ -321,8 +400,10 @@ libnet_write_raw_ipv6(libnet_t *l, const uint8_t *packet, uint32_t size)
     memcpy(sin.sin6_addr.s6_addr, ip_hdr->ip_dst.libnet_s6_addr,
             sizeof(ip_hdr->ip_dst.libnet_s6_addr));
 
+    LIBNET_PROBE2(write_entry, __func__, size);
     const ssize_t c = sendto(l->fd, packet, size, 0, (struct sockaddr *)&sin,
             sizeof(sin));
+    LIBNET_PROBE3(write_return, __func__, c, errno);
     if (c != (ssize_t)size)
     {
         snprintf(l->err_buf, LIBNET_ERRBUF_SIZE,
@@ -0,0 +1,169 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/* counts calls and blocks outstanding, ctx is the counters */
+struct counts
+{
+    long calls;
+    long live;
+};
+
+static void *
+count_malloc(size_t size, void *ctx)
+{
+    struct counts *n = ctx;
+    void *p = malloc(size);
+
+    n->calls++;
+    if (p)
+        n->live++;
+    return p;
+}
+
+static void *
+count_realloc(void *ptr, size_t size, void *ctx)
+{
+    struct counts *n = ctx;
+    void *p = realloc(ptr, size);
+
+    n->calls++;
+    if (p && ptr == NULL)
+        n->live++;
+    return p;
+}
+
+static void
+count_free(void *ptr, void *ctx)
+{
+    struct counts *n = ctx;
+
+    n->live--;
+    free(ptr);
+}
+
+static void
+libnet_alloc__steady_state(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct counts n = { 0, 0 };
+    struct libnet_allocator a = { count_malloc, count_realloc, count_free, &n };
+    struct libnet_alloc_stats before, after;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t payload[46] = { 0 };
+    libnet_ptag_t eth;
+    int i;
+
+    assert_int_equal(libnet_set_allocator(&a), 1);
+
+    libnet_t *l = libnet_init(LIBNET_LINK, "lo", errbuf);
+    assert_non_null(l);
+    assert_true(n.calls > 0);
+
+    eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, payload,
+                                sizeof(payload), l, 0);
+    assert_int_not_equal(eth, (-1));
+    assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+
+    assert_int_equal(libnet_alloc_stats(l, &before), 1);
+    assert_true(before.allocs > 0);
+    assert_true(before.bytes > 0);
+
+    for (i = 0; i < 1000; i++)
+    {
+        payload[0] = (uint8_t)i;
+        eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, payload,
+                                    sizeof(payload), l, eth);
+        assert_int_not_equal(eth, (-1));
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+    }
+
+    assert_int_equal(libnet_alloc_stats(l, &after), 1);
+    assert_int_equal(after.allocs, before.allocs);
+    assert_int_equal(after.bytes, before.bytes);
+
+    libnet_destroy(l);
+    assert_int_equal(n.live, 0);
+
+    assert_int_equal(libnet_set_allocator(NULL), 1);
+}
+
+/* clones, shared pblocks, culled packets and hex_aton() all balance out */
+static void
+libnet_alloc__balanced(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct counts n = { 0, 0 };
+    struct libnet_allocator a = { count_malloc, count_realloc, count_free, &n };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *packet, *mac;
+    uint32_t packet_s;
+    libnet_ptag_t eth;
+    libnet_t *l, *c;
+    int len;
+
+    a.free_fn = NULL;
+    assert_int_equal(libnet_set_allocator(&a), (-1));
+    a.free_fn = count_free;
+    assert_int_equal(libnet_set_allocator(&a), 1);
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, NULL, 0, l, 0);
+    assert_int_not_equal(eth, (-1));
+
+    c = libnet_clone(l);
+    assert_non_null(c);
+    assert_int_not_equal(libnet_build_ethernet(enet_src, enet_dst, 0x88b5,
+                                               NULL, 0, c, eth),
+                         (-1));
+
+    assert_int_equal(libnet_adv_cull_packet(c, &packet, &packet_s), 1);
+    assert_memory_equal(packet, enet_src, sizeof(enet_src));
+    libnet_adv_free_packet(c, packet);
+
+    mac = libnet_hex_aton("01:02:03:04:05:06", &len);
+    assert_non_null(mac);
+    assert_int_equal(len, 6);
+    free(mac);
+
+    libnet_destroy(l);
+    libnet_destroy(c);
+    assert_true(n.calls > 0);
+    assert_int_equal(n.live, 0);
+
+    assert_int_equal(libnet_set_allocator(NULL), 1);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_alloc__steady_state),
+        cmocka_unit_test(libnet_alloc__balanced),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,208 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_ROUTES 100000
+
+/* ORIGIN IGP, AS_PATH <as>, NEXT_HOP 192.0.2.1 */
+static void
+test_attrs(uint8_t attrs[18], uint16_t as)
+{
+    static const uint8_t tmpl[18] = {
+        0x40, 1, 1, 0,
+        0x40, 2, 4, 2, 1, 0, 0,
+        0x40, 3, 4, 192, 0, 2, 1,
+    };
+
+    memcpy(attrs, tmpl, sizeof(tmpl));
+    attrs[9]  = (uint8_t)(as >> 8);
+    attrs[10] = (uint8_t)as;
+}
+
+/* prefix i, a /24 or a /32 out of 10/8 */
+static uint32_t
+test_prefix(uint32_t i, uint8_t *len)
+{
+    *len = i % 7 ? 24 : 32;
+    return htonl(0x0a000000 + (i << 8) + (*len == 32 ? 1 : 0));
+}
+
+static void
+libnet_bgp4_packer__pack(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t attrs[3][18], *buf, *msg, *p, *end, len;
+    uint8_t *seen = calloc(LIBNET_TEST_ROUTES, 1);
+    uint32_t buf_s, i, prefix, withdrawn, nlri_off, msg_s, prev_s = 0;
+    int sets[3], n, count = 0, last_set = -1;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+    assert_non_null(seen);
+
+    for (i = 0; i < 3; i++)
+    {
+        test_attrs(attrs[i], (uint16_t)(64512 + i));
+        sets[i] = libnet_bgp4_packer_attrs(l, attrs[i], sizeof(attrs[i]));
+        assert_int_equal(sets[i], (int)i + 1);
+    }
+    /* the same attributes, the same set */
+    assert_int_equal(libnet_bgp4_packer_attrs(l, attrs[1], sizeof(attrs[1])), sets[1]);
+
+    /* interleaved, every tenth route withdrawn */
+    for (i = 0; i < LIBNET_TEST_ROUTES; i++)
+    {
+        prefix = test_prefix(i, &len);
+        assert_int_equal(libnet_bgp4_packer_add(l, i % 10 ? sets[i % 3] :
+                                                LIBNET_BGP4_WITHDRAWN,
+                                                prefix, len), 1);
+    }
+
+    n = libnet_bgp4_packer_pack(l, &buf, &buf_s);
+    assert_true(n > 0);
+
+    for (msg = buf; msg < buf + buf_s; msg += msg_s)
+    {
+        int set = 0;
+
+        msg_s = msg[16] << 8 | msg[17];
+        assert_in_range(msg_s, LIBNET_BGP4_HEADER_H + LIBNET_BGP4_UPDATE_H,
+                        LIBNET_BGP4_MAX_MESSAGE);
+        assert_true(msg + msg_s <= buf + buf_s);
+        assert_int_equal(msg[0], 0xff);
+        assert_int_equal(msg[18], LIBNET_BGP4_UPDATE);
+
+        p = msg + LIBNET_BGP4_HEADER_H;
+        withdrawn = p[0] << 8 | p[1];
+        if (withdrawn)
+        {
+            nlri_off = 2;
+            end = p + 2 + withdrawn;
+            assert_int_equal(end[0] << 8 | end[1], 0);
+            assert_true(end + 2 == msg + msg_s);
+        }
+        else
+        {
+            assert_int_equal(p[2] << 8 | p[3], sizeof(attrs[0]));
+            for (set = 0; set < 3; set++)
+                if (memcmp(p + 4, attrs[set], sizeof(attrs[set])) == 0)
+                    break;
+            assert_true(set < 3);
+            set++;
+            nlri_off = 4 + sizeof(attrs[0]);
+            end = msg + msg_s;
+        }
+
+        /* the sets do not come back, and only their last message has room */
+        assert_true(set >= last_set);
+        if (set == last_set)
+            assert_true(prev_s + 5 > LIBNET_BGP4_MAX_MESSAGE);
+        last_set = set;
+        prev_s = msg_s;
+
+        for (p += nlri_off; p < end; p += 1 + (p[0] + 7) / 8)
+        {
+            uint32_t v = 0;
+
+            memcpy(&v, p + 1, (p[0] + 7) / 8);
+            i = (ntohl(v) - 0x0a000000) >> 8;
+            assert_true(i < LIBNET_TEST_ROUTES);
+            assert_int_equal(test_prefix(i, &len), v);
+            assert_int_equal(p[0], len);
+            assert_int_equal(set, i % 10 ? (int)(i % 3) + 1 : 0);
+            assert_int_equal(seen[i], 0);
+            seen[i] = 1;
+        }
+        assert_true(p == end);
+        count++;
+    }
+    assert_int_equal(count, n);
+    for (i = 0; i < LIBNET_TEST_ROUTES; i++)
+        assert_int_equal(seen[i], 1);
+
+    /* a message replayed through the builder comes out the same */
+    {
+        uint8_t marker[LIBNET_BGP4_MARKER_SIZE];
+        uint8_t *packet;
+        uint32_t packet_s;
+
+        memset(marker, 0xff, sizeof(marker));
+        msg_s = buf[16] << 8 | buf[17];
+        assert_int_not_equal(libnet_build_bgp4_header(marker, msg_s, LIBNET_BGP4_UPDATE,
+                                                      buf + LIBNET_BGP4_HEADER_H,
+                                                      msg_s - LIBNET_BGP4_HEADER_H,
+                                                      l, 0), (-1));
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+        assert_int_equal(packet_s, msg_s);
+        assert_memory_equal(packet, buf, msg_s);
+        libnet_adv_free_packet(l, packet);
+    }
+
+    libnet_free(buf);
+    free(seen);
+    libnet_destroy(l);
+}
+
+static void
+libnet_bgp4_packer__invalid(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t attrs[LIBNET_BGP4_MAX_MESSAGE] = { 0 };
+    uint8_t *buf;
+    uint32_t buf_s;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_bgp4_packer_pack(l, &buf, &buf_s), 0);
+    assert_null(buf);
+
+    assert_int_equal(libnet_bgp4_packer_add(l, 1, 0, 8), (-1));
+    assert_int_equal(libnet_bgp4_packer_add(l, LIBNET_BGP4_WITHDRAWN, 0, 33), (-1));
+    assert_int_equal(libnet_bgp4_packer_attrs(l, attrs, 0), (-1));
+    assert_int_equal(libnet_bgp4_packer_attrs(l, attrs, 4069), (-1));
+    assert_int_equal(libnet_bgp4_packer_attrs(l, attrs, 4068), 1);
+
+    /* the largest attributes leave room for exactly one /32 */
+    assert_int_equal(libnet_bgp4_packer_add(l, 1, htonl(0x0a000001), 32), 1);
+    assert_int_equal(libnet_bgp4_packer_add(l, 1, htonl(0x0a000002), 32), 1);
+    assert_int_equal(libnet_bgp4_packer_pack(l, &buf, &buf_s), 2);
+    assert_int_equal(buf_s, 2 * LIBNET_BGP4_MAX_MESSAGE);
+    libnet_free(buf);
+
+    libnet_bgp4_packer_free(l);
+    assert_int_equal(libnet_bgp4_packer_add(l, 1, 0, 8), (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_bgp4_packer__pack),
+        cmocka_unit_test(libnet_bgp4_packer__invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
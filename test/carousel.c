@@ -0,0 +1,204 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+#ifdef __linux__
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#endif
+// clang-format on
+
+#define LIBNET_TEST_VARIANTS 7
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+struct carousel_ptags
+{
+    libnet_ptag_t udp, ip;
+};
+
+/*
+ * Variant i has i * 3 bytes of UDP payload, so the frames have odd and even
+ * lengths and the checksums odd tails.
+ */
+static int
+carousel_build(libnet_t *l, uint32_t i, void *arg)
+{
+    static const uint8_t payload[3 * LIBNET_TEST_VARIANTS] =
+        "carousel variant data";
+    struct carousel_ptags *t = arg;
+    const uint32_t len = LIBNET_UDP_H + 3 * i;
+
+    t->udp = libnet_build_udp(1000, 53, len, 0, payload, 3 * i, l, t->udp);
+    t->ip  = libnet_build_ipv4(LIBNET_IPV4_H + len, 0, 1, 0, 64, IPPROTO_UDP,
+                               0, htonl(0xc0a80201), htonl(0xc0a80202),
+                               NULL, 0, l, t->ip);
+    return (t->udp == -1 || t->ip == -1 ? -1 : 0);
+}
+
+/* UDP/IPv4/Ethernet, with the IP ID and the source port varied */
+static libnet_t *
+carousel_context(int injection_type, const char *device,
+                 struct carousel_ptags *t)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_vary_spec spec;
+    libnet_t *l;
+
+    l = libnet_init(injection_type, device, errbuf);
+    assert_non_null(l);
+
+    t->udp = t->ip = 0;
+    assert_int_equal(carousel_build(l, 0, t), 0);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                               ETHERTYPE_IP, NULL, 0, l, 0),
+                         (-1));
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_INC;
+    spec.width = 2;
+    spec.min   = 0xfffe;
+    spec.max   = 0xffff;
+    assert_int_equal(libnet_vary_add(l, t->ip, 4, &spec), 1);
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_INC;
+    spec.width = 2;
+    spec.min   = 40000;
+    spec.max   = 40100;
+    spec.step  = 7;
+    assert_int_equal(libnet_vary_add(l, t->udp, 0, &spec), 1);
+
+    return l;
+}
+
+/* Every slab frame is what coalescing the same variant gives. */
+static void
+libnet_carousel__matches_coalesce(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct carousel_ptags ta, tb;
+    const uint8_t *frame;
+    uint8_t *packet;
+    uint32_t i, len, packet_s;
+    uintptr_t align = 0;
+
+    libnet_t *a = carousel_context(LIBNET_NONE, NULL, &ta);
+    libnet_t *b = carousel_context(LIBNET_NONE, NULL, &tb);
+
+    assert_int_equal(libnet_carousel_send(a, 1), (-1));
+    assert_int_equal(libnet_carousel_build(a, 0, carousel_build, &ta), (-1));
+    assert_int_equal(libnet_carousel_build(a, LIBNET_TEST_VARIANTS,
+                                           carousel_build, &ta), 1);
+    assert_null(libnet_carousel_frame(a, LIBNET_TEST_VARIANTS, NULL));
+
+    for (i = 0; i < LIBNET_TEST_VARIANTS; i++)
+    {
+        assert_int_equal(carousel_build(b, i, &tb), 0);
+        assert_int_equal(libnet_adv_cull_packet(b, &packet, &packet_s), 1);
+
+        frame = libnet_carousel_frame(a, i, &len);
+        assert_non_null(frame);
+        assert_int_equal(len, packet_s);
+        assert_memory_equal(frame, packet, packet_s);
+        libnet_adv_free_packet(b, packet);
+
+        /* each in its own slot, at the same offset into it */
+        if (i == 0)
+            align = (uintptr_t)frame % 64;
+        assert_int_equal((uintptr_t)frame % 64, align);
+    }
+
+    libnet_destroy(a);
+    libnet_destroy(b);
+}
+
+#ifdef __linux__
+/*
+ * Sends on the loopback device, up in the test namespace, and reads back
+ * what went out: in order, wrapping around, and going on where the last
+ * call stopped.
+ */
+static void
+libnet_carousel__send_wraps(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint32_t counts[] = { 3, 9, 2 };
+    struct sockaddr_ll sll;
+    struct carousel_ptags t;
+    socklen_t sll_s;
+    const uint8_t *frame;
+    uint8_t buf[2048];
+    uint32_t i, j, k = 0, len;
+    ssize_t c;
+    int fd;
+
+    libnet_t *l = carousel_context(LIBNET_LINK, "lo", &t);
+    assert_int_equal(libnet_carousel_build(l, LIBNET_TEST_VARIANTS,
+                                           carousel_build, &t), 1);
+
+    fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    assert_true(fd >= 0);
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family   = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex  = if_nametoindex("lo");
+    assert_int_equal(bind(fd, (struct sockaddr *)&sll, sizeof(sll)), 0);
+
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        assert_int_equal(libnet_carousel_send(l, counts[i]), counts[i]);
+
+        /* lo hands each frame back once more as received, skip those */
+        for (j = 0; j < counts[i]; )
+        {
+            sll_s = sizeof(sll);
+            c = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT,
+                         (struct sockaddr *)&sll, &sll_s);
+            assert_true(c > 0);
+            if (sll.sll_pkttype != PACKET_OUTGOING)
+                continue;
+
+            frame = libnet_carousel_frame(l, k, &len);
+            assert_int_equal(c, len);
+            assert_memory_equal(buf, frame, len);
+            k = (k + 1) % LIBNET_TEST_VARIANTS;
+            j++;
+        }
+    }
+
+    close(fd);
+    libnet_destroy(l);
+}
+#endif
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_carousel__matches_coalesce),
+#ifdef __linux__
+        cmocka_unit_test(libnet_carousel__send_wraps),
+#endif
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
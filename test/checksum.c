@@ -0,0 +1,169 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_FRAMES 21                      /* two full groups + 5 */
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/*
+ * Culls variants of a TCP or UDP over IPv4 over Ethernet packet, checksums
+ * computed the regular way, and checks that libnet_checksum_batch() arrives
+ * at the same values for copies with the checksums scrambled.
+ */
+static void
+batch_matches_coalesce(uint8_t proto, uint32_t payload_s, int vary_len)
+{
+    struct libnet_frame frames[LIBNET_TEST_FRAMES];
+    uint8_t *expect[LIBNET_TEST_FRAMES];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t payload[128];
+    libnet_ptag_t l4 = 0, ip = 0;
+    uint32_t len, i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 7 + 3);
+
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+    {
+        uint8_t *packet;
+        uint32_t packet_s;
+
+        len = payload_s + (vary_len ? i % 3 : 0);
+        if (proto == IPPROTO_TCP)
+        {
+            l4 = libnet_build_tcp(1024 + i, 80, 0x01020304 * i, 0, TH_ACK,
+                                  8192, 0, 0, LIBNET_TCP_H + len,
+                                  payload, len, l, l4);
+            len += LIBNET_TCP_H;
+        }
+        else
+        {
+            l4 = libnet_build_udp(1024 + i, 53, LIBNET_UDP_H + len, 0,
+                                  payload, len, l, l4);
+            len += LIBNET_UDP_H;
+        }
+        assert_int_not_equal(l4, (-1));
+
+        ip = libnet_build_ipv4(LIBNET_IPV4_H + len, 0, (uint16_t)(i * 4099), 0,
+                               64, proto, 0, htonl(0x0a000001 + i),
+                               htonl(0xc0a80001), NULL, 0, l, ip);
+        assert_int_not_equal(ip, (-1));
+
+        if (i == 0)
+        {
+            assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                                       ETHERTYPE_IP, NULL, 0,
+                                                       l, 0),
+                                 (-1));
+        }
+
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+
+        expect[i] = malloc(packet_s);
+        frames[i].buf = malloc(packet_s);
+        frames[i].len = packet_s;
+        assert_non_null(expect[i]);
+        assert_non_null(frames[i].buf);
+        memcpy(expect[i], packet, packet_s);
+        memcpy(frames[i].buf, packet, packet_s);
+        libnet_adv_free_packet(l, packet);
+
+        /* scramble both checksums */
+        frames[i].buf[LIBNET_ETH_H + 10] ^= 0x5a;
+        frames[i].buf[LIBNET_ETH_H + LIBNET_IPV4_H + (proto == IPPROTO_TCP ? 17 : 7)] ^= 0xa5;
+    }
+
+    assert_int_equal(libnet_checksum_batch(l, frames, LIBNET_TEST_FRAMES, LIBNET_ETH_H,
+                                           LIBNET_CSUM_IP | LIBNET_CSUM_L4),
+                     1);
+
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+    {
+        assert_memory_equal(frames[i].buf, expect[i], frames[i].len);
+        free(frames[i].buf);
+        free(expect[i]);
+    }
+
+    libnet_destroy(l);
+}
+
+static void
+libnet_checksum_batch__udp(void **state)
+{
+    (void)state;                                    /* unused */
+
+    batch_matches_coalesce(IPPROTO_UDP, 37, 0);
+}
+
+static void
+libnet_checksum_batch__tcp(void **state)
+{
+    (void)state;                                    /* unused */
+
+    batch_matches_coalesce(IPPROTO_TCP, 100, 0);
+}
+
+static void
+libnet_checksum_batch__mixed_lengths(void **state)
+{
+    (void)state;                                    /* unused */
+
+    batch_matches_coalesce(IPPROTO_UDP, 0, 1);
+    batch_matches_coalesce(IPPROTO_TCP, 1, 1);
+}
+
+static void
+libnet_checksum_batch__not_ipv4(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t buf[LIBNET_ETH_H + LIBNET_IPV4_H] = { 0 };
+    struct libnet_frame frame = { buf, sizeof(buf) };
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    buf[LIBNET_ETH_H] = 0x60;
+    assert_int_equal(libnet_checksum_batch(l, &frame, 1, LIBNET_ETH_H, LIBNET_CSUM_IP), (-1));
+
+    buf[LIBNET_ETH_H] = 0x45;
+    frame.len--;
+    assert_int_equal(libnet_checksum_batch(l, &frame, 1, LIBNET_ETH_H, LIBNET_CSUM_IP), (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_checksum_batch__udp),
+        cmocka_unit_test(libnet_checksum_batch__tcp),
+        cmocka_unit_test(libnet_checksum_batch__mixed_lengths),
+        cmocka_unit_test(libnet_checksum_batch__not_ipv4),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,177 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_CLONES 64
+#define LIBNET_TEST_SPORT  (LIBNET_ETH_H + LIBNET_IPV4_H)
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+static const uint8_t payload[] = "libnet clone";
+
+static libnet_ptag_t udp, ip;
+
+static libnet_t *
+template(void)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    udp = libnet_build_udp(1000, 53, LIBNET_UDP_H + sizeof(payload), 0,
+                           payload, sizeof(payload), l, 0);
+    assert_int_not_equal(udp, (-1));
+    ip = libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + sizeof(payload),
+                           0, 1, 0, 64, IPPROTO_UDP, 0, htonl(0xc0a80201),
+                           htonl(0xc0a80202), NULL, 0, l, 0);
+    assert_int_not_equal(ip, (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                               ETHERTYPE_IP, NULL, 0, l, 0),
+                         (-1));
+    return l;
+}
+
+static uint16_t
+sport(libnet_t *l)
+{
+    uint8_t *packet;
+    uint32_t packet_s;
+    uint16_t port;
+
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    port = packet[LIBNET_TEST_SPORT] << 8 | packet[LIBNET_TEST_SPORT + 1];
+    libnet_adv_free_packet(l, packet);
+
+    return port;
+}
+
+static void
+set_sport(libnet_t *l, uint16_t port)
+{
+    assert_int_equal(libnet_build_udp(port, 53, LIBNET_UDP_H + sizeof(payload),
+                                      0, payload, sizeof(payload), l, udp),
+                     udp);
+}
+
+static void
+libnet_clone__copy_on_write(void **state)
+{
+    (void)state;                                    /* unused */
+
+    libnet_t *c[LIBNET_TEST_CLONES];
+    uint8_t *a, *b;
+    uint32_t a_s, b_s;
+    int i;
+
+    libnet_t *l = template();
+
+    for (i = 0; i < LIBNET_TEST_CLONES; i++)
+    {
+        c[i] = libnet_clone(l);
+        assert_non_null(c[i]);
+    }
+
+    /* same packet, same buffers */
+    assert_int_equal(libnet_adv_cull_packet(l, &a, &a_s), 1);
+    assert_int_equal(libnet_adv_cull_packet(c[5], &b, &b_s), 1);
+    assert_int_equal(a_s, b_s);
+    assert_memory_equal(a, b, a_s);
+    libnet_adv_free_packet(l, a);
+    libnet_adv_free_packet(c[5], b);
+    assert_true(libnet_getpbuf(c[5], ip) != NULL);
+
+    /* a builder on one context leaves all others alone */
+    set_sport(c[1], 2001);
+    set_sport(l, 2000);
+    assert_int_equal(sport(l), 2000);
+    assert_int_equal(sport(c[0]), 1000);
+    assert_int_equal(sport(c[1]), 2001);
+    assert_int_equal(sport(c[2]), 1000);
+
+    /* also when the parent goes first */
+    libnet_destroy(l);
+    for (i = 0; i < LIBNET_TEST_CLONES; i++)
+    {
+        set_sport(c[i], 3000 + i);
+        assert_int_equal(sport(c[i]), 3000 + i);
+    }
+    for (i = 0; i < LIBNET_TEST_CLONES; i++)
+        libnet_destroy(c[i]);
+}
+
+static void *
+worker(void *arg)
+{
+    libnet_t *l = arg;
+    long bad = 0;
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        if (i % 2)
+            set_sport(l, (uint16_t)i);
+        if (sport(l) != (i % 2 ? i : (i ? i - 1 : 1000)))
+            bad++;
+    }
+    libnet_destroy(l);
+
+    return (void *)bad;
+}
+
+static void
+libnet_clone__threads(void **state)
+{
+    (void)state;                                    /* unused */
+
+    pthread_t threads[8];
+    void *bad;
+    int i;
+
+    libnet_t *l = template();
+
+    for (i = 0; i < 8; i++)
+    {
+        libnet_t *c = libnet_clone(l);
+
+        assert_non_null(c);
+        assert_int_equal(pthread_create(&threads[i], NULL, worker, c), 0);
+    }
+    for (i = 0; i < 8; i++)
+    {
+        assert_int_equal(pthread_join(threads[i], &bad), 0);
+        assert_null(bad);
+    }
+
+    assert_int_equal(sport(l), 1000);
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_clone__copy_on_write),
+        cmocka_unit_test(libnet_clone__threads),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,314 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_CONTEXTS 50
+#define LIBNET_TEST_READERS  4
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+static libnet_t *
+cq_context(int i)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char label[LIBNET_LABEL_SIZE];
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    snprintf(label, sizeof(label), "eth%d", i);
+    assert_int_equal(libnet_cq_add(l, label), 1);
+
+    return l;
+}
+
+/* threads of this process, or -1 without /proc */
+static int
+cq_threads(void)
+{
+    struct dirent *d;
+    DIR *dir;
+    int n = 0;
+
+    dir = opendir("/proc/self/task");
+    if (dir == NULL)
+        return -1;
+    while ((d = readdir(dir)) != NULL)
+    {
+        if (d->d_name[0] != '.')
+            n++;
+    }
+    closedir(dir);
+
+    return n;
+}
+
+static void
+libnet_cq__labels(void **state)
+{
+    (void)state;                                    /* unused */
+
+    libnet_t *ctx[LIBNET_TEST_CONTEXTS];
+    char label[LIBNET_LABEL_SIZE];
+    libnet_cq_iter_t it;
+    libnet_t *l;
+    int i, n;
+
+    for (i = 0; i < LIBNET_TEST_CONTEXTS; i++)
+        ctx[i] = cq_context(i);
+    assert_int_equal(libnet_cq_size(), LIBNET_TEST_CONTEXTS);
+
+    for (i = 0; i < LIBNET_TEST_CONTEXTS; i++)
+    {
+        snprintf(label, sizeof(label), "eth%d", i);
+        assert_true(libnet_cq_find_by_label(label) == ctx[i]);
+    }
+    assert_null(libnet_cq_find_by_label("eth"));
+
+    /* no duplicate contexts or labels */
+    assert_int_equal(libnet_cq_add(ctx[0], "other"), (-1));
+    l = libnet_init(LIBNET_NONE, NULL, label);
+    assert_non_null(l);
+    assert_int_equal(libnet_cq_add(l, "eth7"), (-1));
+    libnet_destroy(l);
+
+    assert_true(libnet_cq_remove_by_label("eth7") == ctx[7]);
+    assert_null(libnet_cq_find_by_label("eth7"));
+    assert_true(libnet_cq_remove(ctx[8]) == ctx[8]);
+    assert_null(libnet_cq_remove(ctx[8]));
+    assert_int_equal(libnet_cq_size(), LIBNET_TEST_CONTEXTS - 2);
+    libnet_destroy(ctx[7]);
+    libnet_destroy(ctx[8]);
+
+    for (n = 0, l = libnet_cq_iter_first(&it); l; l = libnet_cq_iter_next(&it))
+        n++;
+    libnet_cq_iter_end(&it);
+    assert_int_equal(n, LIBNET_TEST_CONTEXTS - 2);
+
+    libnet_cq_destroy();
+    assert_int_equal(libnet_cq_size(), 0);
+}
+
+static void *
+reader(void *arg)
+{
+    libnet_t *eth0 = arg;
+    libnet_cq_iter_t it;
+    libnet_t *l;
+    long bad = 0;
+    int i, seen;
+
+    for (i = 0; i < 2000; i++)
+    {
+        /* eth0 stays, the others come and go */
+        if (libnet_cq_find_by_label("eth0") != eth0)
+            bad++;
+
+        /* the others may be destroyed under us, so only compare them */
+        for (seen = 0, l = libnet_cq_iter_first(&it); l;
+             l = libnet_cq_iter_next(&it))
+        {
+            if (l == eth0)
+                seen++;
+        }
+        if (seen != 1)
+            bad++;
+    }
+
+    return (void *)bad;
+}
+
+static void
+libnet_cq__threads(void **state)
+{
+    (void)state;                                    /* unused */
+
+    pthread_t threads[LIBNET_TEST_READERS];
+    libnet_t *eth0;
+    void *bad;
+    int i;
+
+    eth0 = cq_context(0);
+    for (i = 0; i < LIBNET_TEST_READERS; i++)
+        assert_int_equal(pthread_create(&threads[i], NULL, reader, eth0), 0);
+
+    for (i = 0; i < 2000; i++)
+    {
+        libnet_t *l = cq_context(1 + i % 10);
+
+        assert_true(libnet_cq_remove(l) == l);
+        libnet_destroy(l);
+    }
+
+    for (i = 0; i < LIBNET_TEST_READERS; i++)
+    {
+        assert_int_equal(pthread_join(threads[i], &bad), 0);
+        assert_null(bad);
+    }
+
+    libnet_cq_destroy();
+}
+
+/*
+ * Nothing is held between steps: a walk may be left early, and the queue
+ * changed from within it.
+ */
+static void
+libnet_cq__iter_change(void **state)
+{
+    (void)state;                                    /* unused */
+
+    libnet_t *ctx[4];
+    libnet_cq_iter_t it;
+    libnet_t *l, *late = NULL;
+    int i, n;
+
+    /* the queue runs from the newest context to the oldest */
+    for (i = 0; i < 4; i++)
+        ctx[i] = cq_context(i);
+
+    l = libnet_cq_iter_first(&it);
+    assert_true(l == ctx[3]);
+    /* left without libnet_cq_iter_end(), the queue is not locked */
+    late = cq_context(9);
+    assert_true(libnet_cq_remove(late) == late);
+    libnet_destroy(late);
+    late = NULL;
+
+    for (n = 0, l = libnet_cq_iter_first(&it); l; l = libnet_cq_iter_next(&it))
+    {
+        if (l == ctx[2])
+        {
+            /* the current context goes, a new one comes, the walk goes on */
+            assert_true(libnet_cq_remove(l) == l);
+            late = cq_context(9);
+        }
+        assert_true(l != late);
+        n++;
+    }
+    libnet_cq_iter_end(&it);
+    assert_int_equal(n, 4);
+    assert_int_equal(libnet_cq_size(), 4);
+
+    libnet_destroy(ctx[2]);
+    libnet_cq_destroy();
+}
+
+/*
+ * Every context gets an Ethernet header with a field stepping once per
+ * coalesce, so how far it got tells how often the context was written.
+ */
+static void
+libnet_cq__write_all(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint32_t workers[] = { 0, 3, 1, LIBNET_TEST_CONTEXTS * 2 };
+    libnet_t *ctx[LIBNET_TEST_CONTEXTS];
+    struct libnet_vary_spec spec;
+    libnet_ptag_t eth;
+    uint8_t *packet;
+    uint32_t packet_s;
+    size_t i, round;
+    int n;
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_INC;
+    spec.width = 1;
+    spec.min   = 0;
+    spec.max   = 255;
+    spec.step  = 1;
+
+    assert_int_equal(libnet_cq_write_all(0), (-1));
+    n = cq_threads();
+
+    for (i = 0; i < LIBNET_TEST_CONTEXTS; i++)
+    {
+        ctx[i] = cq_context((int)i);
+        eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, NULL, 0,
+                                    ctx[i], 0);
+        assert_int_not_equal(eth, (-1));
+        assert_int_equal(libnet_vary_add(ctx[i], eth, 13, &spec), 1);
+    }
+
+    /* LIBNET_NONE contexts coalesce, but cannot write */
+    for (round = 0; round < sizeof(workers) / sizeof(workers[0]); round++)
+        assert_int_equal(libnet_cq_write_all(workers[round]), 0);
+
+    for (i = 0; i < LIBNET_TEST_CONTEXTS; i++)
+    {
+        assert_int_equal(libnet_adv_cull_packet(ctx[i], &packet, &packet_s), 1);
+        assert_int_equal(packet[13], round);
+        libnet_adv_free_packet(ctx[i], packet);
+    }
+
+    /* the pool goes with the last context */
+    for (i = 0; i < LIBNET_TEST_CONTEXTS; i++)
+    {
+        assert_true(libnet_cq_remove(ctx[i]) == ctx[i]);
+        libnet_destroy(ctx[i]);
+    }
+    assert_int_equal(cq_threads(), n);
+}
+
+static void
+libnet_cq__fanout_write(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_t *l;
+    int i;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               NULL, 0, l, 0),
+                         (-1));
+
+    assert_int_equal(libnet_cq_fanout_write(l, LIBNET_FANOUT_SRC_MAC), (-1));
+
+    /* LIBNET_NONE contexts can't write, but must all be tried */
+    for (i = 0; i < 3; i++)
+        cq_context(i);
+    assert_int_equal(libnet_cq_fanout_write(l, LIBNET_FANOUT_SRC_MAC), 0);
+    assert_non_null(strstr(libnet_geterror(libnet_cq_find_by_label("eth2")),
+                           "unsupported injection type"));
+
+    libnet_cq_destroy();
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_cq__labels),
+        cmocka_unit_test(libnet_cq__threads),
+        cmocka_unit_test(libnet_cq__iter_change),
+        cmocka_unit_test(libnet_cq__write_all),
+        cmocka_unit_test(libnet_cq__fanout_write),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
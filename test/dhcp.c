@@ -0,0 +1,130 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static void
+libnet_dhcp_options__typed(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint8_t params[] = { LIBNET_DHCP_SUBNETMASK, LIBNET_DHCP_ROUTER };
+    static const uint8_t expect[] = {
+        LIBNET_DHCP_MESSAGETYPE, 1, LIBNET_DHCP_MSGREQUEST,
+        LIBNET_DHCP_MAXMSGSIZE, 2, 0x05, 0xdc,
+        LIBNET_DHCP_LEASETIME, 4, 0x00, 0x01, 0x51, 0x80,
+        LIBNET_DHCP_DISCOVERADDR, 4, 192, 168, 1, 10,
+        LIBNET_DHCP_PARAMREQUEST, 2, LIBNET_DHCP_SUBNETMASK, LIBNET_DHCP_ROUTER,
+        LIBNET_DHCP_END,
+    };
+    struct libnet_dhcp_option opt[5];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t buf[LIBNET_BOOTP_MIN_LEN];
+    uint8_t addr[4] = { 192, 168, 1, 10 };
+    int i, n;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    memset(opt, 0, sizeof(opt));
+    opt[0].code = LIBNET_DHCP_MESSAGETYPE;
+    opt[0].num  = LIBNET_DHCP_MSGREQUEST;
+    opt[1].code = LIBNET_DHCP_MAXMSGSIZE;
+    opt[1].num  = 1500;
+    opt[2].code = LIBNET_DHCP_LEASETIME;
+    opt[2].num  = 86400;
+    opt[3].code = LIBNET_DHCP_DISCOVERADDR;
+    memcpy(&opt[3].num, addr, 4);
+    opt[4].code  = LIBNET_DHCP_PARAMREQUEST;
+    opt[4].val   = params;
+    opt[4].val_s = sizeof(params);
+
+    /* padded up to the BOOTP minimum */
+    n = libnet_dhcp_options(l, opt, 5, buf, sizeof(buf));
+    assert_int_equal(n, LIBNET_BOOTP_MIN_LEN - LIBNET_DHCPV4_H);
+    assert_memory_equal(buf, expect, sizeof(expect));
+    for (i = sizeof(expect); i < n; i++)
+        assert_int_equal(buf[i], LIBNET_DHCP_PAD);
+
+    /* no room for the padding */
+    assert_int_equal(libnet_dhcp_options(l, opt, 5, buf, sizeof(expect)), (-1));
+
+    /* a byte option out of range, a num for an option of unknown type */
+    opt[0].num = 256;
+    assert_int_equal(libnet_dhcp_options(l, opt, 1, buf, sizeof(buf)), (-1));
+    opt[0].code = LIBNET_DHCP_HOSTNAME;
+    opt[0].num  = 1;
+    assert_int_equal(libnet_dhcp_options(l, opt, 1, buf, sizeof(buf)), (-1));
+    opt[0].code = LIBNET_DHCP_END;
+    opt[0].val  = params;
+    assert_int_equal(libnet_dhcp_options(l, opt, 1, buf, sizeof(buf)), (-1));
+
+    libnet_destroy(l);
+}
+
+/* RFC 3396: a value over 255 bytes is split into several options */
+static void
+libnet_dhcp_options__long(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct libnet_dhcp_option opt;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t val[600], buf[700];
+    int i, n;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < (int)sizeof(val); i++)
+        val[i] = (uint8_t)i;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.code  = LIBNET_DHCP_VENDSPECIFIC;
+    opt.val   = val;
+    opt.val_s = sizeof(val);
+
+    n = libnet_dhcp_options(l, &opt, 1, buf, sizeof(buf));
+    assert_int_equal(n, 3 * 2 + sizeof(val) + 1);
+
+    assert_int_equal(buf[0], LIBNET_DHCP_VENDSPECIFIC);
+    assert_int_equal(buf[1], 255);
+    assert_memory_equal(buf + 2, val, 255);
+    assert_int_equal(buf[257], LIBNET_DHCP_VENDSPECIFIC);
+    assert_int_equal(buf[258], 255);
+    assert_memory_equal(buf + 259, val + 255, 255);
+    assert_int_equal(buf[514], LIBNET_DHCP_VENDSPECIFIC);
+    assert_int_equal(buf[515], 90);
+    assert_memory_equal(buf + 516, val + 510, 90);
+    assert_int_equal(buf[n - 1], LIBNET_DHCP_END);
+
+    assert_int_equal(libnet_dhcp_options(l, &opt, 1, buf, n - 1), (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_dhcp_options__typed),
+        cmocka_unit_test(libnet_dhcp_options__long),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
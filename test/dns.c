@@ -0,0 +1,225 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+static const uint8_t response[] = {
+    0x12, 0x34, 0x81, 0x80, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01,
+    /* question */
+    0x03, 'w', 'w', 'w', 0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e',
+    0x03, 'c', 'o', 'm', 0x00, 0x00, 0x01, 0x00, 0x01,
+    /* A, owner compressed against the QNAME */
+    0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2c,
+    0x00, 0x04, 0xc0, 0x00, 0x02, 0x01,
+    /* MX, owner and exchange compressed against example.com */
+    0xc0, 0x10, 0x00, 0x0f, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2c,
+    0x00, 0x09, 0x00, 0x0a, 0x04, 'm', 'a', 'i', 'l', 0xc0, 0x10,
+    /* OPT */
+    0x00, 0x00, 0x29, 0x04, 0xd0, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00,
+};
+
+static void
+dns_check(libnet_t *l, const uint8_t *expect, uint32_t expect_s)
+{
+    uint8_t *packet;
+    uint32_t packet_s;
+
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    assert_int_equal(packet_s, expect_s);
+    assert_memory_equal(packet, expect, expect_s);
+    libnet_adv_free_packet(l, packet);
+}
+
+static void
+libnet_dns__compression(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_dns_question(l, "www.example.com", LIBNET_DNS_TYPE_A,
+                                         LIBNET_DNS_CLASS_IN), 1);
+    assert_int_equal(libnet_dns_rr_a(l, LIBNET_DNS_ANSWER, "WWW.Example.COM.", 300,
+                                     htonl(0xc0000201)), 1);
+    assert_int_equal(libnet_dns_rr_mx(l, LIBNET_DNS_ANSWER, "example.com", 300, 10,
+                                      "mail.example.com"), 1);
+    assert_int_equal(libnet_dns_edns0(l, 1232, 0, 0, LIBNET_DNS_EDNS0_DO, NULL, 0), 1);
+
+    assert_int_not_equal(libnet_build_dns_message(LIBNET_UDP_DNSV4_H, 0x1234, 0x8180,
+                                                  l, 0),
+                         (-1));
+    dns_check(l, response, sizeof(response));
+
+    libnet_destroy(l);
+}
+
+static void
+libnet_dns__errors(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char label[LIBNET_DNS_MAX_LABEL + 2];
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    memset(label, 'a', sizeof(label) - 1);
+    label[sizeof(label) - 1] = '\0';
+    assert_int_equal(libnet_dns_question(l, label, 1, 1), (-1));
+    label[LIBNET_DNS_MAX_LABEL] = '\0';
+    assert_int_equal(libnet_dns_question(l, label, 1, 1), 1);
+    assert_int_equal(libnet_dns_question(l, "a..b", 1, 1), (-1));
+    assert_int_equal(libnet_dns_question(l, ".", 1, 1), 1);
+
+    /* sections in order, OPT last */
+    assert_int_equal(libnet_dns_rr_a(l, LIBNET_DNS_ADDITIONAL, "a", 0, 0), 1);
+    assert_int_equal(libnet_dns_rr_a(l, LIBNET_DNS_ANSWER, "a", 0, 0), (-1));
+    assert_int_equal(libnet_dns_question(l, "a", 1, 1), (-1));
+    assert_int_equal(libnet_dns_edns0(l, 512, 0, 0, 0, NULL, 0), 1);
+    assert_int_equal(libnet_dns_rr_a(l, LIBNET_DNS_ADDITIONAL, "a", 0, 0), (-1));
+    libnet_dns_free(l);
+
+    /* a failed record leaves nothing behind, its names included */
+    assert_int_equal(libnet_dns_question(l, "example.com", 1, 1), 1);
+    assert_int_equal(libnet_dns_rr_name(l, LIBNET_DNS_ANSWER, "x.example.com",
+                                        LIBNET_DNS_TYPE_CNAME, 0, "bad..name"),
+                     (-1));
+    assert_int_equal(libnet_dns_rr_a(l, LIBNET_DNS_ANSWER, "x.example.com", 0, 0), 1);
+    assert_int_not_equal(libnet_build_dns_message(LIBNET_UDP_DNSV4_H, 0, 0, l, 0), (-1));
+    {
+        static const uint8_t expect[] = {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+            0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00,
+            0x00, 0x01, 0x00, 0x01,
+            0x01, 'x', 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
+        };
+        dns_check(l, expect, sizeof(expect));
+    }
+
+    libnet_destroy(l);
+}
+
+static uint16_t
+udp4_verify(const uint8_t *ip)
+{
+    const uint8_t *udp = ip + LIBNET_IPV4_H;
+    const uint32_t len = udp[4] << 8 | udp[5];
+    uint32_t sum = IPPROTO_UDP + len, i;
+
+    for (i = 12; i < 20; i += 2)
+        sum += ip[i] << 8 | ip[i + 1];
+    for (i = 0; i < len; i += 2)
+        sum += udp[i] << 8 | (i + 1 < len ? udp[i + 1] : 0);
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+static void
+libnet_dns__template(void **state)
+{
+    (void)state;                                    /* unused */
+
+    const uint32_t qname = LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_UDP_H + LIBNET_UDP_DNSV4_H;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_vary_spec spec;
+    libnet_ptag_t dns;
+    uint8_t *packet;
+    uint32_t packet_s, len;
+    uint8_t prev[8];
+    int i, j, changed = 0;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_dns_template(l, LIBNET_DNS_TEMPLATE_ID), (-1));
+
+    assert_int_equal(libnet_dns_question(l, "xxxxxxxx.example.com", LIBNET_DNS_TYPE_A,
+                                         LIBNET_DNS_CLASS_IN), 1);
+    assert_int_equal(libnet_dns_edns0(l, 1232, 0, 0, 0, NULL, 0), 1);
+    dns = libnet_build_dns_message(LIBNET_UDP_DNSV4_H, 1, 0x0100, l, 0);
+    assert_int_not_equal(dns, (-1));
+    len = LIBNET_UDP_H + libnet_getpbuf_size(l, dns);
+    assert_int_not_equal(libnet_build_udp(40000, 53, len, 0, NULL, 0, l, 0), (-1));
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + len, 0, 1, 0, 64, IPPROTO_UDP,
+                                           0, htonl(0xc0000201), htonl(0xc0000202),
+                                           NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP, NULL, 0,
+                                               l, 0),
+                         (-1));
+
+    /* labels are at most 63 bytes */
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_LABEL;
+    spec.width = LIBNET_VARY_LABEL_MAX + 1;
+    assert_int_equal(libnet_vary_add(l, dns, 13, &spec), (-1));
+
+    assert_int_equal(libnet_dns_template(l, LIBNET_DNS_TEMPLATE_ID |
+                                            LIBNET_DNS_TEMPLATE_QNAME), 1);
+
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    for (i = 0; i < 100; i++)
+    {
+        memcpy(prev, packet + qname + 1, sizeof(prev));
+        if (i)
+            assert_int_equal(libnet_vary_packet(l, packet, packet_s), 1);
+
+        assert_int_equal(packet[qname], 8);
+        for (j = 1; j <= 8; j++)
+        {
+            const uint8_t c = packet[qname + j];
+            assert_true((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'));
+        }
+        assert_memory_equal(packet + qname + 9, "\x07" "example" "\x03" "com", 13);
+        assert_int_equal(udp4_verify(packet + LIBNET_ETH_H), 0xffff);
+        changed += memcmp(prev, packet + qname + 1, sizeof(prev)) != 0;
+    }
+    assert_in_range(changed, 95, 100);
+    libnet_adv_free_packet(l, packet);
+
+    /* ptags start over, the message has to be built again */
+    libnet_clear_packet(l);
+    assert_int_not_equal(libnet_build_udp(40000, 53, LIBNET_UDP_H, 0, NULL, 0, l, 0), (-1));
+    assert_int_equal(libnet_dns_template(l, LIBNET_DNS_TEMPLATE_ID), (-1));
+    libnet_clear_packet(l);
+    assert_int_equal(libnet_build_dns_message(LIBNET_UDP_DNSV4_H, 1, 0x0100, l, 0), dns);
+    assert_int_equal(libnet_dns_template(l, LIBNET_DNS_TEMPLATE_ID), 1);
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_dns__compression),
+        cmocka_unit_test(libnet_dns__errors),
+        cmocka_unit_test(libnet_dns__template),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
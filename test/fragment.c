@@ -0,0 +1,525 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_PAYLOAD 3000
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/* a source route, copied into every fragment, and a record route, not */
+static const uint8_t options[] = { 0x83, 7, 4, 10, 0, 0, 1, 0x07, 3, 4 };
+
+/*
+ * Builds a UDP datagram of LIBNET_TEST_PAYLOAD bytes with IP options over
+ * Ethernet, and returns a copy of it as written.
+ */
+static libnet_t *
+frag_context(uint8_t **packet, uint32_t *packet_s)
+{
+    static uint8_t payload[LIBNET_TEST_PAYLOAD];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *p;
+    size_t i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 13 + i / 256);
+
+    assert_int_not_equal(libnet_build_udp(1024, 53, LIBNET_UDP_H + sizeof(payload), 0,
+                                          payload, sizeof(payload), l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ipv4_options(options, sizeof(options), l, 0), (-1));
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + 12 + LIBNET_UDP_H + sizeof(payload),
+                                           0, 0x4242, 0, 64, IPPROTO_UDP, 0,
+                                           htonl(0x0a000001), htonl(0x0a000002),
+                                           NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP,
+                                               NULL, 0, l, 0),
+                         (-1));
+
+    assert_int_equal(libnet_adv_cull_packet(l, &p, packet_s), 1);
+    *packet = malloc(*packet_s);
+    assert_non_null(*packet);
+    memcpy(*packet, p, *packet_s);
+    libnet_adv_free_packet(l, p);
+
+    return l;
+}
+
+/*
+ * Checks every fragment against the datagram, and that together they
+ * cover it.  Returns the data length of the first fragment.
+ */
+static uint32_t
+check_fragments(const uint8_t *packet, uint32_t packet_s,
+                const struct libnet_frame *frames, uint32_t n, uint32_t mtu)
+{
+    const uint8_t *iph = packet + LIBNET_ETH_H;
+    const uint32_t hl = (iph[0] & 0x0f) << 2;
+    const uint32_t data = packet_s - LIBNET_ETH_H - hl;
+    uint8_t covered[LIBNET_UDP_H + LIBNET_TEST_PAYLOAD] = { 0 };
+    uint32_t i, j, first = 0, last = 0;
+
+    assert_int_equal(data, sizeof(covered));
+
+    for (i = 0; i < n; i++)
+    {
+        const uint8_t *f = frames[i].buf + LIBNET_ETH_H;
+        const uint32_t fhl = (f[0] & 0x0f) << 2;
+        const uint32_t len = f[2] << 8 | f[3];
+        const uint32_t off = ((f[6] & 0x1f) << 8 | f[7]) * 8;
+        uint32_t sum = 0;
+
+        assert_memory_equal(frames[i].buf, packet, LIBNET_ETH_H);
+        assert_int_equal(frames[i].len, LIBNET_ETH_H + len);
+        assert_true(len <= mtu);
+        assert_int_equal(f[4] << 8 | f[5], 0x4242);
+
+        /* the header checksums to zero */
+        for (j = 0; j < fhl; j += 2)
+            sum += f[j] << 8 | f[j + 1];
+        assert_int_equal(LIBNET_CKSUM_CARRY(sum), 0);
+
+        /* all options first, only the copied one after */
+        if (fhl == hl)
+        {
+            assert_int_equal(off, 0);
+            assert_int_equal(first, 0);
+            assert_memory_equal(f + LIBNET_IPV4_H, iph + LIBNET_IPV4_H, hl - LIBNET_IPV4_H);
+            first = len - fhl;
+        }
+        else
+        {
+            assert_int_equal(fhl, LIBNET_IPV4_H + 8);
+            assert_memory_equal(f + LIBNET_IPV4_H, options, 7);
+            assert_int_equal(f[LIBNET_IPV4_H + 7], 0);
+        }
+
+        assert_true(off + len - fhl <= data);
+        assert_memory_equal(f + fhl, iph + hl + off, len - fhl);
+        memset(covered + off, 1, len - fhl);
+
+        if (f[6] & 0x20)
+            assert_int_equal((len - fhl) % 8, 0);
+        else
+            last++;
+    }
+
+    assert_int_equal(last, 1);
+    for (i = 0; i < data; i++)
+        assert_int_equal(covered[i], 1);
+
+    return first;
+}
+
+static void
+libnet_fragment_ipv4__split(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct libnet_frame *frames;
+    uint8_t *packet;
+    uint32_t packet_s, n;
+
+    libnet_t *l = frag_context(&packet, &packet_s);
+
+    assert_int_equal(libnet_fragment_ipv4(l, 1500, 0, &frames, &n), 1);
+    assert_int_equal(n, 3);
+    assert_int_equal(check_fragments(packet, packet_s, frames, n, 1500), 1464);
+
+    /* in order, the offsets grow */
+    assert_int_equal(frames[1].buf[LIBNET_ETH_H + 7], 1464 / 8);
+
+    /* fits, written as it is */
+    assert_int_equal(libnet_fragment_ipv4(l, 4000, 0, &frames, &n), 1);
+    assert_int_equal(n, 1);
+    assert_int_equal(frames[0].len, packet_s);
+    assert_memory_equal(frames[0].buf, packet, packet_s);
+
+    /* there is no device to write to */
+    assert_int_equal(libnet_write_fragmented(l, 1500, 0), (-1));
+
+    free(packet);
+    libnet_destroy(l);
+}
+
+static void
+libnet_fragment_ipv4__flags(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct libnet_frame *frames;
+    uint8_t *packet;
+    uint32_t packet_s, n, i;
+
+    libnet_t *l = frag_context(&packet, &packet_s);
+
+    assert_int_equal(libnet_fragment_ipv4(l, 576, LIBNET_FRAG_TINY, &frames, &n), 1);
+    assert_int_equal(check_fragments(packet, packet_s, frames, n, 576), 8);
+
+    /* the last 8 bytes of each are the first 8 of the next */
+    assert_int_equal(libnet_fragment_ipv4(l, 576, LIBNET_FRAG_OVERLAP, &frames, &n), 1);
+    check_fragments(packet, packet_s, frames, n, 576);
+    for (i = 1; i < n; i++)
+    {
+        const uint8_t *a = frames[i - 1].buf + LIBNET_ETH_H;
+        const uint8_t *b = frames[i].buf + LIBNET_ETH_H;
+        const uint32_t end = ((a[6] & 0x1f) << 8 | a[7]) * 8 + (a[2] << 8 | a[3]) -
+                             ((a[0] & 0x0f) << 2);
+
+        assert_int_equal(((b[6] & 0x1f) << 8 | b[7]) * 8, end - 8);
+    }
+
+    assert_int_equal(libnet_fragment_ipv4(l, 576, LIBNET_FRAG_REVERSE, &frames, &n), 1);
+    check_fragments(packet, packet_s, frames, n, 576);
+    assert_int_equal(frames[0].buf[LIBNET_ETH_H + 6] & 0x20, 0);
+    assert_int_equal(frames[n - 1].buf[LIBNET_ETH_H + 7], 0);
+
+    assert_int_equal(libnet_fragment_ipv4(l, 576, LIBNET_FRAG_SHUFFLE | LIBNET_FRAG_TINY |
+                                          LIBNET_FRAG_OVERLAP, &frames, &n),
+                     1);
+    check_fragments(packet, packet_s, frames, n, 576);
+
+    /* no room for data past the copied options */
+    assert_int_equal(libnet_fragment_ipv4(l, LIBNET_IPV4_H + 12, 0, &frames, &n), (-1));
+
+    free(packet);
+    libnet_destroy(l);
+}
+
+static void
+libnet_fragment_ipv4__dont_fragment(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t payload[2000] = { 0 };
+    struct libnet_frame *frames;
+    uint32_t n;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_fragment_ipv4(l, 1500, 0, &frames, &n), (-1));
+
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + sizeof(payload), 0, 1, IP_DF,
+                                           64, IPPROTO_RAW, 0, htonl(0x0a000001),
+                                           htonl(0x0a000002), payload, sizeof(payload),
+                                           l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP,
+                                               NULL, 0, l, 0),
+                         (-1));
+    assert_int_equal(libnet_fragment_ipv4(l, 1500, 0, &frames, &n), (-1));
+
+    libnet_destroy(l);
+}
+
+/* An ID of 0 is replaced by one nonzero ID shared by all fragments. */
+static void
+libnet_fragment_ipv4__zero_id(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t payload[2000] = { 0 };
+    struct libnet_frame *frames;
+    uint32_t i, j, n, id, sum;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + sizeof(payload), 0, 0, 0,
+                                           64, IPPROTO_RAW, 0, htonl(0x0a000001),
+                                           htonl(0x0a000002), payload, sizeof(payload),
+                                           l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP,
+                                               NULL, 0, l, 0),
+                         (-1));
+    assert_int_equal(libnet_fragment_ipv4(l, 576, LIBNET_FRAG_SHUFFLE, &frames, &n), 1);
+    assert_int_equal(n, 4);
+
+    id = frames[0].buf[LIBNET_ETH_H + 4] << 8 | frames[0].buf[LIBNET_ETH_H + 5];
+    assert_int_not_equal(id, 0);
+    for (i = 0; i < n; i++)
+    {
+        const uint8_t *f = frames[i].buf + LIBNET_ETH_H;
+
+        assert_int_equal(f[4] << 8 | f[5], id);
+        for (sum = j = 0; j < LIBNET_IPV4_H; j += 2)
+            sum += f[j] << 8 | f[j + 1];
+        assert_int_equal(LIBNET_CKSUM_CARRY(sum), 0);
+    }
+
+    libnet_destroy(l);
+}
+
+/*
+ * UDP over a Destination Options header over a Hop-by-Hop Options header
+ * over IPv6 over Ethernet: only the Hop-by-Hop header is unfragmentable.
+ */
+static libnet_t *
+frag6_context(uint8_t nh, uint8_t **packet, uint32_t *packet_s)
+{
+    static const uint8_t padn[6] = { 1, 4, 0, 0, 0, 0 };
+    static uint8_t payload[LIBNET_TEST_PAYLOAD];
+    struct libnet_in6_addr src = { { { 0x20, 0x01, 0x0d, 0xb8, [15] = 1 } } };
+    struct libnet_in6_addr dst = { { { 0x20, 0x01, 0x0d, 0xb8, [15] = 2 } } };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *p;
+    size_t i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 7 + i / 256);
+
+    assert_int_not_equal(libnet_build_udp(1024, 53, LIBNET_UDP_H + sizeof(payload), 0,
+                                          payload, sizeof(payload), l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ipv6_destopts(IPPROTO_UDP, 0, padn, sizeof(padn),
+                                                    l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ipv6_hbhopts(nh, 0, padn, sizeof(padn), l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ipv6(0, 0, 16 + LIBNET_UDP_H + sizeof(payload),
+                                           IPPROTO_HOPOPTS, 64, src, dst, NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IPV6,
+                                               NULL, 0, l, 0),
+                         (-1));
+
+    assert_int_equal(libnet_adv_cull_packet(l, &p, packet_s), 1);
+    *packet = malloc(*packet_s);
+    assert_non_null(*packet);
+    memcpy(*packet, p, *packet_s);
+    libnet_adv_free_packet(l, p);
+
+    return l;
+}
+
+static void
+libnet_fragment_ipv6__split(void **state)
+{
+    (void)state;                                    /* unused */
+
+    const uint32_t unfrag = LIBNET_ETH_H + LIBNET_IPV6_H + 8;
+    uint8_t covered[8 + LIBNET_UDP_H + LIBNET_TEST_PAYLOAD] = { 0 };
+    struct libnet_frame *frames;
+    uint8_t *packet;
+    uint32_t packet_s, n, i, id = 0, last = 0;
+    int flags;
+
+    libnet_t *l = frag6_context(IPPROTO_DSTOPTS, &packet, &packet_s);
+    assert_int_equal(packet_s - unfrag, sizeof(covered));
+
+    for (flags = 0; flags <= (LIBNET_FRAG_TINY | LIBNET_FRAG_OVERLAP | LIBNET_FRAG_SHUFFLE);
+         flags = flags ? flags << 1 : 1)
+    {
+        assert_int_equal(libnet_fragment_ipv6(l, 1280, flags, &frames, &n), 1);
+        assert_in_range(n, 3, 5);
+
+        memset(covered, 0, sizeof(covered));
+        for (i = last = 0; i < n; i++)
+        {
+            const uint8_t *f = frames[i].buf;
+            const uint8_t *fh = f + unfrag;
+            const uint32_t plen = f[LIBNET_ETH_H + 4] << 8 | f[LIBNET_ETH_H + 5];
+            const uint32_t off = (fh[2] << 8 | fh[3]) & 0xfff8;
+            const uint32_t fid = (uint32_t)fh[4] << 24 | fh[5] << 16 | fh[6] << 8 | fh[7];
+            const uint32_t data = frames[i].len - unfrag - LIBNET_IPV6_FRAG_H;
+
+            assert_true(frames[i].len - LIBNET_ETH_H <= 1280);
+            assert_int_equal(plen, frames[i].len - LIBNET_ETH_H - LIBNET_IPV6_H);
+
+            /* the unfragmentable part, pointing to the Fragment header */
+            assert_memory_equal(f, packet, LIBNET_ETH_H + LIBNET_IPV6_H - 36);
+            assert_memory_equal(f + LIBNET_ETH_H + 6, packet + LIBNET_ETH_H + 6, 34);
+            assert_int_equal(f[LIBNET_ETH_H + LIBNET_IPV6_H], IPPROTO_FRAGMENT);
+            assert_memory_equal(f + LIBNET_ETH_H + LIBNET_IPV6_H + 1,
+                                packet + LIBNET_ETH_H + LIBNET_IPV6_H + 1, 7);
+
+            assert_int_equal(fh[0], IPPROTO_DSTOPTS);
+            if (i == 0)
+                id = fid;
+            assert_int_equal(fid, id);
+
+            assert_true(off + data <= sizeof(covered));
+            assert_memory_equal(fh + LIBNET_IPV6_FRAG_H, packet + unfrag + off, data);
+            memset(covered + off, 1, data);
+
+            if (fh[3] & 1)
+                assert_int_equal(data % 8, 0);
+            else
+                last++;
+        }
+        assert_int_equal(last, 1);
+        for (i = 0; i < sizeof(covered); i++)
+            assert_int_equal(covered[i], 1);
+    }
+
+    /* fits, left as it is */
+    assert_int_equal(libnet_fragment_ipv6(l, 9000, 0, &frames, &n), 1);
+    assert_int_equal(n, 1);
+    assert_int_equal(frames[0].len, packet_s);
+    assert_memory_equal(frames[0].buf, packet, packet_s);
+
+    free(packet);
+    libnet_destroy(l);
+}
+
+static void
+libnet_fragment_ipv6__already_fragment(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct libnet_frame *frames;
+    uint8_t *packet;
+    uint32_t packet_s, n;
+
+    /* a Fragment header claimed by the Hop-by-Hop header */
+    libnet_t *l = frag6_context(IPPROTO_FRAGMENT, &packet, &packet_s);
+
+    assert_int_equal(libnet_fragment_ipv6(l, 1280, 0, &frames, &n), (-1));
+    assert_int_equal(libnet_fragment_ipv4(l, 1280, 0, &frames, &n), (-1));
+
+    free(packet);
+    libnet_destroy(l);
+}
+
+/* a timestamp option, padded */
+static const uint8_t tcp_options[] = { 1, 1, 8, 10, 0, 0, 0, 1, 0, 0, 0, 2 };
+
+/*
+ * Builds TCP with options over IPv4 over Ethernet, the segment at seq with
+ * the given data, which segmentation must reproduce byte for byte.
+ */
+static libnet_t *
+seg_context(uint32_t seq, uint8_t th_flags, uint16_t id,
+            const uint8_t *data, uint32_t data_s)
+{
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint32_t len = LIBNET_TCP_H + sizeof(tcp_options) + data_s;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_not_equal(libnet_build_tcp_options(tcp_options, sizeof(tcp_options), l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_tcp(40000, 80, seq, 0x01020304, th_flags, 8192,
+                                          0, 0, len, data, data_s, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + len, 0, id, IP_DF, 64,
+                                           IPPROTO_TCP, 0, htonl(0x0a000001),
+                                           htonl(0x0a000002), NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP,
+                                               NULL, 0, l, 0),
+                         (-1));
+    return l;
+}
+
+static void
+libnet_segment_tcp__matches_build(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint8_t flags = TH_ACK | TH_PUSH | TH_FIN | TH_CWR;
+    static uint8_t data[3001];
+    struct libnet_frame *frames;
+    uint8_t *packet;
+    uint32_t n, packet_s, i, seg;
+    libnet_t *l, *expect;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)(i * 31 + 7);
+
+    /* the template payload is not part of the stream */
+    l = seg_context(0xfffffc00, flags, 0xfffe, data, 5);
+
+    assert_int_equal(libnet_segment_tcp(l, data, sizeof(data), 1000, &frames, &n), 1);
+    assert_int_equal(n, 4);
+
+    for (i = 0; i < n; i++)
+    {
+        seg = i < 3 ? 1000 : 1;
+        expect = seg_context(0xfffffc00 + i * 1000,
+                             flags & ~(i ? TH_CWR : 0) & ~(i < 3 ? TH_PUSH | TH_FIN : 0),
+                             (uint16_t)(0xfffe + i), data + i * 1000, seg);
+        assert_int_equal(libnet_adv_cull_packet(expect, &packet, &packet_s), 1);
+        assert_int_equal(frames[i].len, packet_s);
+        assert_memory_equal(frames[i].buf, packet, packet_s);
+        libnet_adv_free_packet(expect, packet);
+        libnet_destroy(expect);
+    }
+
+    /* no data, one bare segment with every flag */
+    assert_int_equal(libnet_segment_tcp(l, NULL, 0, 1000, &frames, &n), 1);
+    assert_int_equal(n, 1);
+    expect = seg_context(0xfffffc00, flags, 0xfffe, NULL, 0);
+    assert_int_equal(libnet_adv_cull_packet(expect, &packet, &packet_s), 1);
+    assert_int_equal(frames[0].len, packet_s);
+    assert_memory_equal(frames[0].buf, packet, packet_s);
+    libnet_adv_free_packet(expect, packet);
+    libnet_destroy(expect);
+
+    assert_int_equal(libnet_segment_tcp(l, data, sizeof(data), 0xffff, &frames, &n), (-1));
+    libnet_destroy(l);
+}
+
+static void
+libnet_segment_tcp__not_tcp(void **state)
+{
+    (void)state;                                    /* unused */
+
+    struct libnet_frame *frames;
+    uint8_t *packet, data[8] = { 0 };
+    uint32_t packet_s, n;
+
+    libnet_t *l = frag_context(&packet, &packet_s);
+
+    assert_int_equal(libnet_segment_tcp(l, data, sizeof(data), 536, &frames, &n), (-1));
+    assert_int_equal(libnet_write_segmented(l, data, sizeof(data), 536), (-1));
+
+    free(packet);
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_fragment_ipv4__split),
+        cmocka_unit_test(libnet_fragment_ipv4__flags),
+        cmocka_unit_test(libnet_fragment_ipv4__dont_fragment),
+        cmocka_unit_test(libnet_fragment_ipv4__zero_id),
+        cmocka_unit_test(libnet_fragment_ipv6__split),
+        cmocka_unit_test(libnet_fragment_ipv6__already_fragment),
+        cmocka_unit_test(libnet_segment_tcp__matches_build),
+        cmocka_unit_test(libnet_segment_tcp__not_tcp),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
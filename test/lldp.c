@@ -0,0 +1,189 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x01, 0x80, 0xc2, 0x00, 0x00, 0x0e };
+static const uint8_t org_spec[9] = { 0x00, 0x12, 0x0f, 0x01, 0x03, 0xc0, 0x36, 0x00, 0x10 };
+
+/* chassis, port, TTL, org_spec, as in sample/lldp.c */
+static void
+lldp_tlvs(struct libnet_lldp_tlv *tlv, const char *port, uint16_t ttl)
+{
+    memset(tlv, 0, 4 * sizeof(*tlv));
+    tlv[0].type    = LIBNET_LLDP_CHASSIS_ID;
+    tlv[0].subtype = LIBNET_LLDP_CHASSIS_ID_SUBTYPE_MAC;
+    tlv[0].val     = enet_src;
+    tlv[0].val_s   = sizeof(enet_src);
+    tlv[1].type    = LIBNET_LLDP_PORT_ID;
+    tlv[1].subtype = LIBNET_LLDP_PORT_ID_SUBTYPE_IF_NAME;
+    tlv[1].val     = port;
+    tlv[1].val_s   = strlen(port);
+    tlv[2].type    = LIBNET_LLDP_TTL;
+    tlv[2].num     = ttl;
+    tlv[3].type    = LIBNET_LLDP_ORG_SPEC;
+    tlv[3].val     = org_spec;
+    tlv[3].val_s   = sizeof(org_spec);
+}
+
+static void
+cull(libnet_t *l, uint8_t **packet, uint32_t *packet_s)
+{
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                               LIBNET_LLDP_ETH_TYPE, NULL, 0,
+                                               l, 0),
+                         (-1));
+    assert_int_equal(libnet_adv_cull_packet(l, packet, packet_s), 1);
+}
+
+/* One pblock from libnet_build_lldp(), same bytes as one per TLV. */
+static void
+libnet_build_lldp__matches_tlv_builders(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const char port[] = "Ethernet1/7";
+    struct libnet_lldp_tlv tlv[4];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *packet, *expect;
+    uint32_t packet_s, expect_s;
+
+    libnet_t *a = libnet_init(LIBNET_NONE, NULL, errbuf);
+    libnet_t *b = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(a);
+    assert_non_null(b);
+
+    lldp_tlvs(tlv, port, 120);
+    assert_int_not_equal(libnet_build_lldp(tlv, 4, a, 0), (-1));
+    cull(a, &packet, &packet_s);
+
+    assert_int_not_equal(libnet_build_lldp_end(b, 0), (-1));
+    assert_int_not_equal(libnet_build_lldp_org_spec(org_spec, sizeof(org_spec),
+                                                    b, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_lldp_ttl(htons(120), b, 0), (-1));
+    assert_int_not_equal(libnet_build_lldp_port(LIBNET_LLDP_PORT_ID_SUBTYPE_IF_NAME,
+                                                (const uint8_t *)port,
+                                                strlen(port), b, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_lldp_chassis(LIBNET_LLDP_CHASSIS_ID_SUBTYPE_MAC,
+                                                   enet_src, sizeof(enet_src),
+                                                   b, 0),
+                         (-1));
+    cull(b, &expect, &expect_s);
+
+    assert_int_equal(packet_s, expect_s);
+    assert_memory_equal(packet, expect, packet_s);
+
+    /* End of LLDPDU is added, not given; the TTL is 2 bytes */
+    tlv[3].type = LIBNET_LLDP_END_LLDPDU;
+    assert_int_equal(libnet_build_lldp(tlv, 4, a, 0), (-1));
+    tlv[3].type  = LIBNET_LLDP_TTL;
+    tlv[3].val_s = 3;
+    assert_int_equal(libnet_build_lldp(tlv + 3, 1, a, 0), (-1));
+
+    libnet_adv_free_packet(a, packet);
+    libnet_adv_free_packet(b, expect);
+    libnet_destroy(a);
+    libnet_destroy(b);
+}
+
+/*
+ * Patching the port and TTL of one template gives the same LLDPDUs as
+ * building each anew, and does not allocate.
+ */
+static void
+libnet_lldp_patch__ports(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const char *ports[] = { "Ethernet1/1", "Ethernet1/2", "Ethernet1/48",
+                                   "e0", "Ethernet1/3", "port-channel-with-a-long-name" };
+    struct libnet_alloc_stats before, after;
+    struct libnet_lldp_tlv tlv[4];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint8_t *packet, *expect;
+    uint32_t packet_s, expect_s;
+    libnet_ptag_t lldp, eth;
+    size_t i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    lldp_tlvs(tlv, ports[0], 120);
+    lldp = libnet_build_lldp(tlv, 4, l, 0);
+    assert_int_not_equal(lldp, (-1));
+    eth = libnet_build_ethernet(enet_dst, enet_src, LIBNET_LLDP_ETH_TYPE,
+                                NULL, 0, l, 0);
+    assert_int_not_equal(eth, (-1));
+
+    assert_int_equal(libnet_lldp_patch(l, eth, (const uint8_t *)"x", 1, 1), (-1));
+    assert_int_equal(libnet_lldp_patch(l, lldp, NULL, 0, 1), (-1));
+
+    for (i = 0; i < LIBNET_TEST_ARRAY_LENGTH(ports); i++)
+    {
+        libnet_alloc_stats(l, &before);
+        assert_int_equal(libnet_lldp_patch(l, lldp, (const uint8_t *)ports[i],
+                                           strlen(ports[i]), (uint16_t)(100 + i)),
+                         1);
+        libnet_alloc_stats(l, &after);
+        assert_int_equal(after.allocs, before.allocs);
+
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+
+        libnet_t *b = libnet_init(LIBNET_NONE, NULL, errbuf);
+        assert_non_null(b);
+        lldp_tlvs(tlv, ports[i], (uint16_t)(100 + i));
+        assert_int_not_equal(libnet_build_lldp(tlv, 4, b, 0), (-1));
+        cull(b, &expect, &expect_s);
+
+        assert_int_equal(packet_s, expect_s);
+        assert_memory_equal(packet, expect, packet_s);
+
+        libnet_adv_free_packet(l, packet);
+        libnet_adv_free_packet(b, expect);
+        libnet_destroy(b);
+    }
+
+    /* a rebuild through the ptag keeps the buffer too */
+    lldp_tlvs(tlv, ports[1], 120);
+    libnet_alloc_stats(l, &before);
+    assert_int_equal(libnet_build_lldp(tlv, 4, l, lldp), lldp);
+    libnet_alloc_stats(l, &after);
+    assert_int_equal(after.allocs, before.allocs);
+
+    /* the ptags are about to be reused */
+    libnet_clear_packet(l);
+    assert_int_equal(libnet_lldp_patch(l, lldp, (const uint8_t *)"x", 1, 1), (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_build_lldp__matches_tlv_builders),
+        cmocka_unit_test(libnet_lldp_patch__ports),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
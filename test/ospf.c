@@ -0,0 +1,241 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x01, 0x00, 0x5e, 0x00, 0x00, 0x05 };
+
+/* A correct Fletcher checksum brings both sums over the LSA, age left out, to 0. */
+static bool
+lsa_valid(const uint8_t *lsa, uint32_t len)
+{
+    uint32_t c0 = 0, c1 = 0, i;
+
+    for (i = 2; i < len; i++)
+    {
+        c0 = (c0 + lsa[i]) % 255;
+        c1 = (c1 + c0) % 255;
+    }
+
+    return c0 == 0 && c1 == 0 && (lsa[18] << 8 | lsa[19]) == (int)len;
+}
+
+static void
+libnet_ospf_lsa_cksum__valid(void **state)
+{
+    (void)state;                                    /* unused */
+
+    /* short, odd, around the AVX2 block and past the deferred modulo */
+    static const uint32_t lens[] = { 20, 21, 28, 33, 64, 100, 1456, 5794,
+                                     5795, 12000, 65535 };
+    uint8_t *lsa = malloc(65535);
+    uint32_t i, j;
+
+    assert_non_null(lsa);
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        for (j = 0; j < lens[i]; j++)
+            lsa[j] = (uint8_t)(j * 131 + i + 0xfe);
+        lsa[18] = (uint8_t)(lens[i] >> 8);
+        lsa[19] = (uint8_t)lens[i];
+
+        libnet_ospf_lsa_cksum(lsa, lens[i]);
+        assert_true(lsa_valid(lsa, lens[i]));
+    }
+
+    /* all 0xff: the sums are 0 mod 255 with or without the checksum */
+    memset(lsa, 0xff, 64);
+    lsa[18] = 0;
+    lsa[19] = 64;
+    libnet_ospf_lsa_cksum(lsa, 64);
+    assert_true(lsa_valid(lsa, 64));
+
+    assert_int_equal(libnet_ospf_lsa_cksum(lsa, 19), 0);
+    free(lsa);
+}
+
+/* An LSA built with a zero checksum gets it filled in on coalescing. */
+static void
+libnet_build_ospfv2_lsa__checksum(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    const uint32_t lsa_s = LIBNET_OSPF_LSA_H + LIBNET_OSPF_LS_NET_H;
+    uint8_t *packet, *lsa;
+    uint32_t packet_s;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_not_equal(libnet_build_ospfv2_lsa_net(0xffffff00, 0x01010101,
+                                                     NULL, 0, l, 0), (-1));
+    assert_int_not_equal(libnet_build_ospfv2_lsa(1, 0, LIBNET_LS_TYPE_NET,
+                                                 0xc0a80101, 0x01010101,
+                                                 0x80000001, 0, lsa_s, NULL, 0,
+                                                 l, 0), (-1));
+    assert_int_not_equal(libnet_build_ospfv2_lsu(1, NULL, 0, l, 0), (-1));
+    assert_int_not_equal(libnet_build_ospfv2(LIBNET_OSPF_LSU_H + lsa_s,
+                                             LIBNET_OSPF_LSU, htonl(0x01010101),
+                                             0, 0, 0, NULL, 0, l, 0), (-1));
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_OSPF_H +
+                                           LIBNET_OSPF_LSU_H + lsa_s, 0, 1, 0,
+                                           1, IPPROTO_OSPF, 0,
+                                           htonl(0xc0a80101),
+                                           htonl(0xe0000005), NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP,
+                                               NULL, 0, l, 0), (-1));
+
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    assert_int_equal(packet_s, LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_OSPF_H +
+                               LIBNET_OSPF_LSU_H + lsa_s);
+
+    lsa = packet + LIBNET_ETH_H + LIBNET_IPV4_H + LIBNET_OSPF_H + LIBNET_OSPF_LSU_H;
+    assert_int_not_equal(lsa[16] << 8 | lsa[17], 0);
+    assert_true(lsa_valid(lsa, lsa_s));
+
+    libnet_adv_free_packet(l, packet);
+    libnet_destroy(l);
+}
+
+/* Checks every LSU of the LSDB, returns the number of LSAs. */
+static uint32_t
+lsdb_check(libnet_t *l, int n, uint32_t mtu, uint32_t seq)
+{
+    const uint32_t room = mtu - LIBNET_IPV4_H - LIBNET_OSPF_H -
+                          LIBNET_OSPF_AUTH_H - LIBNET_OSPF_LSU_H;
+    libnet_ptag_t lsu = 0;
+    uint32_t lsas = 0, packet_s, off, num, len;
+    uint8_t *packet, *p;
+    int i, size;
+
+    libnet_clear_packet(l);
+    for (i = 0; i < n; i++)
+    {
+        size = libnet_lsdb_lsu_size(l, i);
+        assert_in_range(size, LIBNET_OSPF_LSU_H + LIBNET_OSPF_LSA_H,
+                        LIBNET_OSPF_LSU_H + room);
+
+        lsu = libnet_build_ospfv2_lsdb_lsu(i, l, lsu);
+        assert_int_not_equal(lsu, (-1));
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+        assert_int_equal(packet_s, size);
+
+        num = (uint32_t)packet[0] << 24 | packet[1] << 16 | packet[2] << 8 | packet[3];
+        for (off = LIBNET_OSPF_LSU_H; num; num--, off += len)
+        {
+            p = packet + off;
+            len = p[18] << 8 | p[19];
+            assert_true(off + len <= packet_s);
+            assert_true(lsa_valid(p, len));
+            assert_int_equal((uint32_t)p[12] << 24 | p[13] << 16 | p[14] << 8 | p[15], seq);
+            lsas++;
+        }
+        assert_int_equal(off, packet_s);
+
+        libnet_adv_free_packet(l, packet);
+    }
+    assert_int_equal(libnet_lsdb_lsu_size(l, n), (-1));
+
+    return lsas;
+}
+
+static void
+libnet_lsdb__pack(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_lsdb_spec spec;
+    int n;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    memset(&spec, 0, sizeof(spec));
+    spec.routers   = 2000;
+    spec.links     = 4;
+    spec.networks  = 3000;
+    spec.attached  = 3;
+    spec.summaries = 20000;
+    spec.router_id = 0x0a000001;
+    spec.prefix    = 0xac100000;
+    spec.opts      = LIBNET_OPT_EBIT;
+
+    n = libnet_lsdb_build(l, &spec);
+    assert_true(n > 1);
+    assert_int_equal(lsdb_check(l, n, 1500, 0x80000001), 25000);
+
+    assert_int_equal(libnet_lsdb_refresh(l), 1);
+    assert_int_equal(lsdb_check(l, n, 1500, 0x80000002), 25000);
+
+    /* a smaller MTU takes more LSUs */
+    spec.mtu = 576;
+    assert_true(libnet_lsdb_build(l, &spec) > n);
+
+    libnet_destroy(l);
+}
+
+static void
+libnet_lsdb__invalid(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_lsdb_spec spec;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_build_ospfv2_lsdb_lsu(0, l, 0), (-1));
+    assert_int_equal(libnet_lsdb_refresh(l), (-1));
+
+    memset(&spec, 0, sizeof(spec));
+    spec.summaries = 10;
+    assert_int_equal(libnet_lsdb_build(l, &spec), (-1));    /* no routers */
+
+    spec.routers = 10;
+    spec.links   = 200;                                     /* > 1452 bytes */
+    assert_int_equal(libnet_lsdb_build(l, &spec), (-1));
+
+    spec.links    = 1;
+    spec.networks = UINT32_MAX - 5;                         /* wraps to 14 */
+    assert_int_equal(libnet_lsdb_build(l, &spec), (-1));
+
+    spec.networks = 0;
+    spec.seq      = 0x7fffffff;
+    assert_int_equal(libnet_lsdb_build(l, &spec), 1);
+    assert_int_equal(libnet_lsdb_refresh(l), (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_ospf_lsa_cksum__valid),
+        cmocka_unit_test(libnet_build_ospfv2_lsa__checksum),
+        cmocka_unit_test(libnet_lsdb__pack),
+        cmocka_unit_test(libnet_lsdb__invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
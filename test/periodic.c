@@ -0,0 +1,178 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/* an Ethernet frame whose first payload word counts the sends */
+static int
+counting_stream(libnet_t *l, uint32_t interval, uint32_t jitter, uint32_t first)
+{
+    static const uint8_t payload[46] = { 0 };
+    int id;
+
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    id = libnet_periodic_add(l, interval, jitter, first);
+    assert_true(id >= 0);
+    libnet_clear_packet(l);
+
+    assert_int_equal(libnet_periodic_patch(l, id, LIBNET_ETH_H, 4, 1, 0), 1);
+    return id;
+}
+
+static uint32_t
+sends(libnet_t *l, int id)
+{
+    const uint8_t *f = libnet_periodic_frame(l, id, NULL);
+
+    assert_non_null(f);
+    f += LIBNET_ETH_H;
+    return (uint32_t)f[0] << 24 | f[1] << 16 | f[2] << 8 | f[3];
+}
+
+/* Intervals on every level of the wheel fire on time, and only then. */
+static void
+libnet_periodic__schedule(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    uint64_t t, fired = 0;
+    int a, b, c, d;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_periodic_next(l), (-1));
+    assert_int_equal(libnet_periodic_dispatch(l, 0), (-1));
+
+    /* the longest interval has to fit the wheel */
+    assert_int_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5, NULL, 0,
+                                           l, 0) == -1, 0);
+    assert_int_equal(libnet_periodic_add(l, UINT32_MAX, UINT32_MAX - 1, 0), (-1));
+    assert_int_equal(libnet_periodic_add(l, 0x80000000, 0x7fffffff, 0), 0);
+    assert_int_equal(libnet_periodic_remove(l, 0), 1);
+    libnet_clear_packet(l);
+
+    a = counting_stream(l, 10, 0, 0);
+    b = counting_stream(l, 300, 0, 5);
+    c = counting_stream(l, 70000, 0, 0);
+    d = counting_stream(l, 3, 1, 0);
+
+    /* the clock need not start at 0 */
+    for (t = 1000000; t <= 1000000 + 140000; t++)
+    {
+        fired += libnet_periodic_dispatch(l, t);
+    }
+
+    assert_int_equal(sends(l, a), 14001);
+    assert_int_equal(sends(l, b), 467);             /* 5, 305, ... 139805 */
+    assert_int_equal(sends(l, c), 3);
+    assert_in_range(sends(l, d), 140000 / 4, 140000 / 2 + 1);
+    assert_int_equal(fired, sends(l, a) + sends(l, b) + sends(l, c) + sends(l, d));
+
+    /* a stream behind fires once, then keeps its interval */
+    assert_int_equal(libnet_periodic_remove(l, c), 1);
+    assert_int_equal(libnet_periodic_remove(l, d), 1);
+    assert_int_equal(libnet_periodic_remove(l, d), (-1));
+    t += 1000;
+    assert_int_equal(libnet_periodic_dispatch(l, t), 2);
+    assert_int_equal(libnet_periodic_dispatch(l, t + 9), 0);
+    assert_int_equal(libnet_periodic_dispatch(l, t + 10), 1);
+    assert_int_equal(libnet_periodic_next(l), t + 20);
+
+    /* ids are reused */
+    assert_int_equal(counting_stream(l, 10, 0, 0), d);
+    assert_int_equal(counting_stream(l, 10, 0, 0), c);
+
+    libnet_destroy(l);
+}
+
+/* Stepping IP ID and a UDP payload word gives what the builders give. */
+static void
+libnet_periodic__checksums(void **state)
+{
+    (void)state;                                    /* unused */
+
+    uint8_t payload[20] = { 0 };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t udp = 0, ip = 0, eth = 0;
+    uint8_t *packet;
+    uint32_t packet_s, len, i;
+    const uint8_t *f;
+    int id = -1;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < 300; i++)
+    {
+        payload[2] = (uint8_t)((0xfff0 + i * 7) >> 8);
+        payload[3] = (uint8_t)(0xfff0 + i * 7);
+        udp = libnet_build_udp(1985, 1985, LIBNET_UDP_H + sizeof(payload), 0,
+                               payload, sizeof(payload), l, udp);
+        ip = libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + sizeof(payload),
+                               0, (uint16_t)(0xff00 + i), 0, 1, IPPROTO_UDP, 0,
+                               htonl(0x0a000001), htonl(0xe0000002), NULL, 0,
+                               l, ip);
+        eth = libnet_build_ethernet(enet_dst, enet_src, ETHERTYPE_IP, NULL, 0,
+                                    l, eth);
+        assert_int_not_equal(eth, (-1));
+
+        if (i == 0)
+        {
+            id = libnet_periodic_add(l, 1, 0, 0);
+            assert_true(id >= 0);
+            assert_int_equal(libnet_periodic_patch(l, id, LIBNET_ETH_H + 4, 2, 1,
+                                                   LIBNET_ETH_H + 10), 1);
+            assert_int_equal(libnet_periodic_patch(l, id, LIBNET_ETH_H + 30, 3, 7,
+                                                   LIBNET_ETH_H + 26), (-1));
+            assert_int_equal(libnet_periodic_patch(l, id, LIBNET_ETH_H + 30, 2, 7,
+                                                   LIBNET_ETH_H + 26), 1);
+            /* overlapping its checksum, past the end */
+            assert_int_equal(libnet_periodic_patch(l, id, LIBNET_ETH_H + 9, 2, 1,
+                                                   LIBNET_ETH_H + 10), (-1));
+            assert_int_equal(libnet_periodic_patch(l, id, 60, 4, 1, 0), (-1));
+        }
+
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+        f = libnet_periodic_frame(l, id, &len);
+        assert_int_equal(len, packet_s);
+        assert_memory_equal(f, packet, len);
+        libnet_adv_free_packet(l, packet);
+
+        assert_int_equal(libnet_periodic_dispatch(l, i), 1);
+    }
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_periodic__schedule),
+        cmocka_unit_test(libnet_periodic__checksums),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
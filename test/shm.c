@@ -0,0 +1,524 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+#include "libnet_ring.h"
+// clang-format on
+
+#define LIBNET_TEST_DEPTH 4
+#define LIBNET_TEST_FRAMES 100000
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/* What libnet-txd does on start, for one ring */
+static struct libnet_ring *
+ring_create(const char *name, size_t *size, struct libnet_ring_reader *rd)
+{
+    struct libnet_ring *r;
+    char path[64];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+    *size = libnet_ring_size(LIBNET_TEST_DEPTH, 128);
+
+    fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    assert_int_not_equal(fd, (-1));
+    assert_int_equal(ftruncate(fd, (off_t)*size), 0);
+    r = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert_true(r != MAP_FAILED);
+    close(fd);
+
+    libnet_ring_init(r, LIBNET_TEST_DEPTH, 128);
+    assert_int_equal(libnet_ring_reader_init(rd, r, *size, LIBNET_TEST_DEPTH, 128), 1);
+    return r;
+}
+
+static void
+libnet_shm__write(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[32], path[64];
+    uint8_t payload[46] = { 0 };
+    struct libnet_ring_reader rd;
+    struct libnet_ring *r;
+    struct libnet_stats ls;
+    libnet_ptag_t eth = 0;
+    uint8_t *frame;
+    uint32_t len;
+    size_t size;
+    int i;
+
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+
+    /* no daemon, no ring */
+    assert_null(libnet_init(LIBNET_SHM, name, errbuf));
+    assert_null(libnet_init(LIBNET_SHM, "a/b", errbuf));
+
+    r = ring_create(name, &size, &rd);
+    libnet_t *l = libnet_init(LIBNET_SHM, name, errbuf);
+    assert_non_null(l);
+
+    for (i = 0; i < LIBNET_TEST_DEPTH; i++)
+    {
+        payload[0] = (uint8_t)i;
+        eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, payload,
+                                    sizeof(payload), l, eth);
+        assert_int_not_equal(eth, (-1));
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+    }
+
+    /* the ring is full now */
+    assert_int_equal(libnet_write(l), (-1));
+    libnet_stats(l, &ls);
+    assert_int_equal(ls.packets_sent, LIBNET_TEST_DEPTH);
+    assert_int_equal(ls.packet_errors, 1);
+
+    /* the consumer sees the frames in order */
+    assert_int_equal(libnet_ring_pending(&rd), LIBNET_TEST_DEPTH);
+    for (i = 0; i < LIBNET_TEST_DEPTH; i++)
+    {
+        frame = libnet_ring_peek(&rd, i, &len);
+        assert_non_null(frame);
+        assert_int_equal(len, LIBNET_ETH_H + sizeof(payload));
+        assert_memory_equal(frame, enet_dst, 6);
+        assert_int_equal(frame[LIBNET_ETH_H], i);
+    }
+    libnet_ring_release(&rd, LIBNET_TEST_DEPTH);
+    assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+
+    libnet_destroy(l);
+    munmap(r, size);
+    shm_unlink(path);
+}
+
+struct page_reader
+{
+    const struct libnet_stats_page *page;
+    int stop;
+    long reads;
+    long torn;                                      /* inconsistent copies */
+};
+
+static void *
+page_reader(void *arg)
+{
+    struct page_reader *pr = arg;
+    struct libnet_stats_page s;
+    int64_t last = 0;
+
+    while (!__atomic_load_n(&pr->stop, __ATOMIC_RELAXED))
+    {
+        if (libnet_stats_read(pr->page, &s) != 1)
+            continue;
+        /* every frame is the same size, and counts only go up */
+        if (s.stats.bytes_written != s.stats.packets_sent * 60 ||
+            s.stats.packets_sent < last)
+            pr->torn++;
+        last = s.stats.packets_sent;
+        __atomic_add_fetch(&pr->reads, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/* A reader racing the writer only ever sees consistent copies. */
+static void
+libnet_shm__stats_page(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[32], path[64];
+    uint8_t payload[46] = { 0 };
+    struct libnet_stats_page s;
+    struct page_reader pr;
+    struct libnet_ring_reader rd;
+    struct libnet_ring *r;
+    pthread_t reader;
+    size_t size;
+    int i;
+
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+
+    r = ring_create(name, &size, &rd);
+    libnet_t *l = libnet_init(LIBNET_SHM, name, errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+
+    assert_null(libnet_stats_map(name, errbuf));
+    assert_int_equal(libnet_stats_publish(l, "a/b"), (-1));
+    assert_int_equal(libnet_stats_publish(l, name), 1);
+    assert_int_equal(libnet_stats_publish(l, name), (-1));
+
+    memset(&pr, 0, sizeof(pr));
+    pr.page = libnet_stats_map(name, errbuf);
+    assert_non_null(pr.page);
+    assert_int_equal(libnet_stats_read(pr.page, &s), 1);
+    assert_string_equal(s.device, name);
+    assert_int_equal(s.pid, getpid());
+    assert_int_equal(s.stats.packets_sent, 0);
+
+    assert_int_equal(pthread_create(&reader, NULL, page_reader, &pr), 0);
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+    {
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+        libnet_ring_release(&rd, 1);
+    }
+    /* a reader racing every write may not have got a copy yet */
+    while (__atomic_load_n(&pr.reads, __ATOMIC_RELAXED) == 0)
+        sched_yield();
+    __atomic_store_n(&pr.stop, 1, __ATOMIC_RELAXED);
+    assert_int_equal(pthread_join(reader, NULL), 0);
+    assert_true(pr.reads > 0);
+    assert_int_equal(pr.torn, 0);
+
+    /* the counts are current, the rest as of the last full update */
+    assert_int_equal(libnet_stats_read(pr.page, &s), 1);
+    assert_int_equal(s.stats.packets_sent, LIBNET_TEST_FRAMES);
+    assert_int_equal(s.stats.coalesces,
+                     LIBNET_TEST_FRAMES - LIBNET_TEST_FRAMES % 64);
+
+    /* unpublished, the page is gone for new readers */
+    libnet_destroy(l);
+    assert_null(libnet_stats_map(name, errbuf));
+    libnet_stats_unmap(pr.page);
+
+    munmap(r, size);
+    shm_unlink(path);
+}
+
+/*
+ * While a TX thread runs, it keeps the page of its context up to date, and
+ * the rates a reader gets go down once nothing is sent any more.
+ */
+static void
+libnet_shm__stats_page_tx(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[32], path[64];
+    uint8_t payload[46] = { 0 };
+    uint8_t frame[60] = { 0 };
+    struct libnet_stats_page s, t;
+    const struct libnet_stats_page *page;
+    struct libnet_ring_reader rd;
+    struct libnet_ring *r;
+    size_t size;
+    int i;
+
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+
+    r = ring_create(name, &size, &rd);
+    libnet_t *l = libnet_init(LIBNET_SHM, name, errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    assert_int_equal(libnet_stats_publish(l, name), 1);
+    page = libnet_stats_map(name, errbuf);
+    assert_non_null(page);
+
+    for (i = 0; i < 2; i++)
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+    libnet_ring_release(&rd, 2);
+
+    assert_int_equal(libnet_tx_start(l, 8, 128, LIBNET_TX_BLOCK, -1), 1);
+    assert_int_equal(libnet_stats_publish(l, "other"), (-1));
+    assert_int_equal(libnet_stats_unpublish(l), (-1));
+    for (i = 0; i < 3; i++)
+        assert_int_equal(libnet_enqueue_frame(l, frame, sizeof(frame)), 1);
+
+    /* no libnet_tx_stop(), the thread's writes show up as they happen */
+    for (i = 0; i < 10000000; i++)
+    {
+        assert_int_equal(libnet_stats_read(page, &s), 1);
+        if (s.stats.packets_sent == 5)
+            break;
+        sched_yield();
+    }
+    assert_int_equal(s.stats.packets_sent, 5);
+    assert_int_equal(s.stats.bytes_written, 5 * 60);
+    assert_int_equal(s.queue.depth, 8);
+    assert_true(s.stats.pps > 0);
+
+    usleep(50 * 1000);
+    assert_int_equal(libnet_stats_read(page, &t), 1);
+    assert_true(t.stats.pps < s.stats.pps);
+    assert_true(t.stats.bps < s.stats.bps);
+
+    /* the page is the context's again */
+    assert_int_equal(libnet_tx_stop(l), 1);
+    assert_int_equal(libnet_stats_read(page, &s), 1);
+    assert_int_equal(s.stats.packets_sent, 5);
+    assert_int_equal(s.queue.depth, 0);
+    assert_int_equal(libnet_stats_unpublish(l), 1);
+
+    libnet_stats_unmap(page);
+    libnet_destroy(l);
+    munmap(r, size);
+    shm_unlink(path);
+}
+
+/*
+ * A producer that claims a slot and never commits it, as if it died, holds
+ * up the frames behind it only until the consumer gives up on the slot.
+ */
+static void
+libnet_shm__stalled(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[32], path[64];
+    uint8_t payload[46] = { 0 };
+    struct libnet_ring_reader rd;
+    struct libnet_ring *r;
+    libnet_ptag_t eth = 0;
+    uint64_t pos;
+    uint8_t *frame;
+    uint32_t len;
+    size_t size;
+    int i;
+
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+
+    r = ring_create(name, &size, &rd);
+    libnet_t *l = libnet_init(LIBNET_SHM, name, errbuf);
+    assert_non_null(l);
+
+    assert_non_null(libnet_ring_claim(r, &pos));
+    for (i = 1; i < LIBNET_TEST_DEPTH; i++)
+    {
+        payload[0] = (uint8_t)i;
+        eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, payload,
+                                    sizeof(payload), l, eth);
+        assert_int_not_equal(eth, (-1));
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+    }
+
+    /* nothing to drain, and the slot is only given up on after 10 */
+    assert_int_equal(libnet_ring_pending(&rd), LIBNET_TEST_DEPTH);
+    assert_null(libnet_ring_peek(&rd, 0, &len));
+    assert_int_equal(libnet_ring_skip(&rd, 100, 10), 0);
+    assert_int_equal(libnet_ring_skip(&rd, 105, 10), 0);
+    assert_int_equal(libnet_ring_skip(&rd, 110, 10), 1);
+    assert_int_equal(rd.skipped, 1);
+
+    /* the frames behind it go out */
+    assert_int_equal(libnet_ring_pending(&rd), LIBNET_TEST_DEPTH - 1);
+    for (i = 0; i < LIBNET_TEST_DEPTH - 1; i++)
+    {
+        frame = libnet_ring_peek(&rd, i, &len);
+        assert_non_null(frame);
+        assert_int_equal(len, LIBNET_ETH_H + sizeof(payload));
+        assert_int_equal(frame[LIBNET_ETH_H], i + 1);
+    }
+    libnet_ring_release(&rd, LIBNET_TEST_DEPTH - 1);
+
+    /* too late, the slot is someone else's now */
+    assert_int_equal(libnet_ring_commit(r, pos, 60), 0);
+    assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+    assert_int_equal(libnet_ring_skip(&rd, 200, 10), 0);
+    frame = libnet_ring_peek(&rd, 0, &len);
+    assert_non_null(frame);
+    assert_int_equal(frame[LIBNET_ETH_H], LIBNET_TEST_DEPTH - 1);
+    libnet_ring_release(&rd, 1);
+    assert_int_equal(libnet_ring_pending(&rd), 0);
+
+    libnet_destroy(l);
+    munmap(r, size);
+    shm_unlink(path);
+}
+
+/*
+ * A producer scribbling over the ring header and a slot cannot make the
+ * consumer look outside the ring, or take a frame longer than a slot.
+ */
+static void
+libnet_shm__corrupt(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[32], path[64];
+    uint8_t payload[46] = { 0 };
+    struct libnet_ring_reader rd;
+    struct libnet_ring_slot *s;
+    struct libnet_ring *r;
+    uint8_t *frame;
+    uint32_t len;
+    size_t size;
+    int i;
+
+    snprintf(name, sizeof(name), "test-%d", (int)getpid());
+    snprintf(path, sizeof(path), "%s%s", LIBNET_RING_PREFIX, name);
+
+    r = ring_create(name, &size, &rd);
+    assert_int_equal(libnet_ring_reader_init(&rd, r, size - 1, LIBNET_TEST_DEPTH, 128), (-1));
+    assert_int_equal(libnet_ring_reader_init(&rd, r, size, LIBNET_TEST_DEPTH, 128), 1);
+
+    libnet_t *l = libnet_init(LIBNET_SHM, name, errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    for (i = 0; i < 2; i++)
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+
+    /* what a hostile producer may write */
+    s = (struct libnet_ring_slot *)(r + 1);
+    s->len   = 0xfffffff0;
+    r->depth = 0x80000000;
+    r->stride = 0xfffffff0;
+    r->tail  = 12345;
+    r->head  = UINT64_MAX;
+
+    assert_int_equal(libnet_ring_pending(&rd), LIBNET_TEST_DEPTH);
+
+    frame = libnet_ring_peek(&rd, 0, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, 0);
+    assert_int_equal(rd.refused, 1);
+
+    frame = libnet_ring_peek(&rd, 1, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, LIBNET_ETH_H + sizeof(payload));
+    assert_true(frame + len <= (uint8_t *)r + size);
+
+    assert_null(libnet_ring_peek(&rd, 2, &len));
+    assert_null(libnet_ring_peek(&rd, LIBNET_TEST_DEPTH + 5, &len));
+    libnet_ring_release(&rd, 2);
+    assert_int_equal(rd.tail, 2);
+
+    libnet_destroy(l);
+    munmap(r, size);
+    shm_unlink(path);
+}
+
+/*
+ * A fan-out stamps the addresses set for each context.  Rings get none from
+ * their name, whatever it is.  The first ring has some set, the other none
+ * and must get the packet as built, not what was stamped for the context
+ * before it.
+ */
+static void
+libnet_shm__fanout(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint8_t src_mac[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    char name[2][32], path[2][64];
+    struct libnet_ring_reader rd[2];
+    struct libnet_ring *r[2];
+    libnet_t *l, *c[2];
+    uint8_t *packet, *frame;
+    uint32_t packet_s, len, sum;
+    size_t size[2];
+    int i;
+
+    /* the newest context is first in the queue */
+    for (i = 1; i >= 0; i--)
+    {
+        snprintf(name[i], sizeof(name[i]), "test-%d-%d", (int)getpid(), i);
+        r[i] = ring_create(name[i], &size[i], &rd[i]);
+        c[i] = libnet_init(LIBNET_SHM, name[i], errbuf);
+        assert_non_null(c[i]);
+        assert_int_equal(libnet_cq_add(c[i], name[i]), 1);
+        snprintf(path[i], sizeof(path[i]), "%s%s", LIBNET_RING_PREFIX, name[i]);
+    }
+    assert_int_equal(libnet_cq_set_addrs("none", LIBNET_FANOUT_SRC_IP, NULL,
+                                         htonl(0x7f000001)), (-1));
+    assert_int_equal(libnet_cq_set_addrs(name[0], LIBNET_FANOUT_SRC_MAC, NULL,
+                                         0), (-1));
+    assert_int_equal(libnet_cq_set_addrs(name[0], LIBNET_FANOUT_SRC_MAC |
+                                         LIBNET_FANOUT_SRC_IP, src_mac,
+                                         htonl(0x7f000001)), 1);
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_udp(1024, 53, LIBNET_UDP_H, 0, NULL, 0,
+                                          l, 0), (-1));
+    assert_int_not_equal(libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H, 0,
+                                           1, 0, 64, IPPROTO_UDP, 0,
+                                           htonl(0x0a000001),
+                                           htonl(0x0a000002), NULL, 0, l, 0),
+                         (-1));
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                               ETHERTYPE_IP, NULL, 0, l, 0),
+                         (-1));
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+
+    assert_int_equal(libnet_cq_fanout_write(l, LIBNET_FANOUT_SRC_MAC |
+                                               LIBNET_FANOUT_SRC_IP), 2);
+
+    /* the addresses set, with a good header checksum */
+    frame = libnet_ring_peek(&rd[0], 0, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, packet_s);
+    assert_memory_equal(frame + 6, src_mac, 6);
+    assert_int_equal(frame[LIBNET_ETH_H + 12], 127);
+    for (sum = 0, i = 0; i < LIBNET_IPV4_H; i += 2)
+        sum += (frame[LIBNET_ETH_H + i] << 8) | frame[LIBNET_ETH_H + i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    assert_int_equal(sum, 0xffff);
+
+    /* the other: as built */
+    frame = libnet_ring_peek(&rd[1], 0, &len);
+    assert_non_null(frame);
+    assert_int_equal(len, packet_s);
+    assert_memory_equal(frame, packet, packet_s);
+
+    libnet_adv_free_packet(l, packet);
+    libnet_destroy(l);
+    libnet_cq_destroy();
+    for (i = 0; i < 2; i++)
+    {
+        munmap(r[i], size[i]);
+        shm_unlink(path[i]);
+    }
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_shm__write),
+        cmocka_unit_test(libnet_shm__stats_page),
+        cmocka_unit_test(libnet_shm__stats_page_tx),
+        cmocka_unit_test(libnet_shm__stalled),
+        cmocka_unit_test(libnet_shm__corrupt),
+        cmocka_unit_test(libnet_shm__fanout),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
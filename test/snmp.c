@@ -0,0 +1,217 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint32_t sys_descr[] = { 1, 3, 6, 1, 2, 1, 1, 1, 0 };
+
+/* the single pblock of a context, as built */
+static void
+snmp_check(libnet_t *l, const uint8_t *expect, uint32_t expect_s)
+{
+    uint8_t *packet;
+    uint32_t packet_s;
+
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    assert_int_equal(packet_s, expect_s);
+    assert_memory_equal(packet, expect, expect_s);
+    libnet_adv_free_packet(l, packet);
+}
+
+/* Back to front encoding must agree with the front to back encoders. */
+static void
+libnet_asn1__reverse_matches_forward(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const int32_t ints[] = { 0, 1, 127, 128, 255, 256, -1, -128, -129,
+                                    0x7fffffff, (int32_t)0x80000000 };
+    static const uint32_t uints[] = { 0, 127, 128, 0xffff, 0x800000, 0xffffffff };
+    static const oid objid[] = { 1, 3, 6, 1, 4, 1, 2021, 268435456, 127, 128 };
+    uint8_t fwd[512], rev[512], string[300];
+    uint8_t *f, *r;
+    int f_s, r_s;
+    size_t i;
+
+    for (i = 0; i < sizeof(ints) / sizeof(ints[0]); i++)
+    {
+        f_s = sizeof(fwd);
+        r_s = sizeof(rev);
+        f = libnet_build_asn1_int(fwd, &f_s, ASN_INTEGER, &ints[i], sizeof(int32_t));
+        r = libnet_build_asn1_rint(rev + sizeof(rev), &r_s, ASN_INTEGER, ints[i]);
+        assert_true(f != NULL && r != NULL);
+        assert_int_equal(f - fwd, rev + sizeof(rev) - r);
+        assert_memory_equal(fwd, r, f - fwd);
+    }
+
+    for (i = 0; i < sizeof(uints) / sizeof(uints[0]); i++)
+    {
+        f_s = sizeof(fwd);
+        r_s = sizeof(rev);
+        f = libnet_build_asn1_uint(fwd, &f_s, ASN_INTEGER, &uints[i], sizeof(uint32_t));
+        r = libnet_build_asn1_ruint(rev + sizeof(rev), &r_s, ASN_INTEGER, uints[i]);
+        assert_true(f != NULL && r != NULL);
+        assert_int_equal(f - fwd, rev + sizeof(rev) - r);
+        assert_memory_equal(fwd, r, f - fwd);
+    }
+
+    f_s = sizeof(fwd);
+    r_s = sizeof(rev);
+    f = libnet_build_asn1_objid(fwd, &f_s, ASN_OBJECT_ID, (oid *)objid, 10);
+    r = libnet_build_asn1_robjid(rev + sizeof(rev), &r_s, ASN_OBJECT_ID, objid, 10);
+    assert_true(f != NULL && r != NULL);
+    assert_int_equal(f - fwd, rev + sizeof(rev) - r);
+    assert_memory_equal(fwd, r, f - fwd);
+
+    /* long form lengths */
+    memset(string, 'x', sizeof(string));
+    f_s = sizeof(fwd);
+    r_s = sizeof(rev);
+    f = libnet_build_asn1_string(fwd, &f_s, ASN_OCTET_STR, string, sizeof(string));
+    r = libnet_build_asn1_rstring(rev + sizeof(rev), &r_s, ASN_OCTET_STR, string, sizeof(string));
+    assert_true(f != NULL && r != NULL);
+    assert_int_equal(f - fwd, 304);
+    assert_int_equal(r_s, (int)sizeof(rev) - 304);
+    assert_memory_equal(fwd, r, 304);
+
+    /* Counter64 with the top bit set takes a leading zero */
+    r_s = sizeof(rev);
+    r = libnet_build_asn1_ruint(rev + sizeof(rev), &r_s, 0x46, UINT64_MAX);
+    assert_true(r != NULL);
+    assert_int_equal(rev + sizeof(rev) - r, 11);
+    assert_int_equal(r[1], 9);
+    assert_int_equal(r[2], 0);
+
+    /* and nothing is written that does not fit */
+    r_s = 2;
+    assert_true(libnet_build_asn1_rint(rev + sizeof(rev), &r_s, ASN_INTEGER, 256) == NULL);
+}
+
+static void
+libnet_build_snmp__get(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint8_t expect[] = {
+        0x30, 0x26, 0x02, 0x01, 0x00, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c',
+        0xa0, 0x19, 0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00,
+        0x30, 0x0e, 0x30, 0x0c, 0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01,
+        0x01, 0x01, 0x00, 0x05, 0x00,
+    };
+    static const uint8_t response[] = {
+        0x30, 0x29, 0x02, 0x01, 0x01, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c',
+        0xa2, 0x1c, 0x02, 0x01, 0x01, 0x02, 0x01, 0x00, 0x02, 0x01, 0x00,
+        0x30, 0x11, 0x30, 0x0f, 0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01,
+        0x01, 0x01, 0x00, 0x04, 0x03, 'l', 'n', 't',
+    };
+    struct libnet_snmp_varbind vb;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t ptag;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    memset(&vb, 0, sizeof(vb));
+    vb.name   = sys_descr;
+    vb.name_n = 9;
+    vb.type   = ASN_NULL;
+
+    ptag = libnet_build_snmp(LIBNET_SNMP_VERSION_1, (const uint8_t *)"public", 6,
+                             LIBNET_SNMP_GET, 1, 0, 0, &vb, 1, NULL, 0, l, 0);
+    assert_int_not_equal(ptag, (-1));
+    snmp_check(l, expect, sizeof(expect));
+
+    /* the answer, in place */
+    vb.type  = ASN_OCTET_STR;
+    vb.val   = "lnt";
+    vb.val_s = 3;
+    assert_int_equal(libnet_build_snmp(LIBNET_SNMP_VERSION_2C, (const uint8_t *)"public", 6,
+                                       LIBNET_SNMP_RESPONSE, 1, 0, 0, &vb, 1, NULL, 0,
+                                       l, ptag),
+                     ptag);
+    snmp_check(l, response, sizeof(response));
+
+    /* v1 traps have a builder of their own, and unknown types are refused */
+    assert_int_equal(libnet_build_snmp(LIBNET_SNMP_VERSION_1, NULL, 0, LIBNET_SNMP_TRAP,
+                                       1, 0, 0, &vb, 1, NULL, 0, l, 0),
+                     (-1));
+    vb.type = 0x99;
+    assert_int_equal(libnet_build_snmp(LIBNET_SNMP_VERSION_1, NULL, 0, LIBNET_SNMP_GET,
+                                       1, 0, 0, &vb, 1, NULL, 0, l, 0),
+                     (-1));
+
+    libnet_destroy(l);
+}
+
+static void
+libnet_build_snmp__trap(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint32_t enterprise[] = { 1, 3, 6, 1, 4, 1, 8072 };
+    static const uint8_t expect[] = {
+        0x30, 0x3a, 0x02, 0x01, 0x00, 0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c',
+        0xa4, 0x2d, 0x06, 0x07, 0x2b, 0x06, 0x01, 0x04, 0x01, 0xbf, 0x08,
+        0x40, 0x04, 0x0a, 0x00, 0x00, 0x01, 0x02, 0x01, 0x03, 0x02, 0x01, 0x00,
+        0x43, 0x03, 0x01, 0xe2, 0x40,
+        0x30, 0x11, 0x30, 0x0f, 0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01,
+        0x01, 0x01, 0x00, 0x41, 0x03, 0x00, 0x80, 0x00,
+    };
+    struct libnet_snmp_varbind vb[LIBNET_SNMP_MAX_MESSAGE / 8];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    size_t i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    memset(vb, 0, sizeof(vb));
+    vb[0].name   = sys_descr;
+    vb[0].name_n = 9;
+    vb[0].type   = LIBNET_SNMP_COUNTER32;
+    vb[0].num    = 0x8000;
+
+    assert_int_not_equal(libnet_build_snmp_trap((const uint8_t *)"public", 6,
+                                                enterprise, 7, htonl(0x0a000001),
+                                                LIBNET_SNMP_LINKUP, 0, 123456,
+                                                vb, 1, NULL, 0, l, 0),
+                         (-1));
+    snmp_check(l, expect, sizeof(expect));
+
+    /* far too many varbinds */
+    for (i = 1; i < sizeof(vb) / sizeof(vb[0]); i++)
+        vb[i] = vb[0];
+    assert_int_equal(libnet_build_snmp_trap((const uint8_t *)"public", 6,
+                                            enterprise, 7, 0, LIBNET_SNMP_LINKUP,
+                                            0, 0, vb, sizeof(vb) / sizeof(vb[0]),
+                                            NULL, 0, l, 0),
+                     (-1));
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_asn1__reverse_matches_forward),
+        cmocka_unit_test(libnet_build_snmp__get),
+        cmocka_unit_test(libnet_build_snmp__trap),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
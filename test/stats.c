@@ -0,0 +1,147 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/*
+ * Writes on a LIBNET_NONE context fail without reaching the wire, which
+ * leaves the error counters, and with timing on, the assembly times.
+ */
+static void
+libnet_stats_ex__errors(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_stats_ex xs;
+    uint8_t payload[46] = { 0 };
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_stats_ex(NULL, &xs), (-1));
+    assert_int_equal(libnet_stats_ex(l, NULL), (-1));
+
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+
+    for (i = 0; i < 10; i++)
+        assert_int_equal(libnet_write(l), (-1));
+
+    assert_int_equal(libnet_stats_ex(l, &xs), 1);
+    assert_int_equal(xs.packets_sent, 0);
+    assert_int_equal(xs.packet_errors, 0);          /* never written */
+    assert_int_equal(xs.coalesces, 10);
+    assert_int_equal(xs.coalesce_ns, 0);            /* timing is off */
+    assert_int_equal(xs.syscalls, 0);
+
+    libnet_stats_timing(l, 1);
+    for (i = 0; i < 10; i++)
+        libnet_write(l);
+
+    assert_int_equal(libnet_stats_ex(l, &xs), 1);
+    assert_int_equal(xs.coalesces, 20);
+    assert_true(xs.coalesce_ns > 0);
+
+    libnet_destroy(l);
+}
+
+/*
+ * Sends on the loopback device, up in the test namespace, with timing on:
+ * every write is a timed system call and the rates pick up.
+ */
+static void
+libnet_stats_ex__loopback(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_stats_ex xs;
+    struct libnet_stats ls;
+    struct timespec ts = { 0, 10000000 };
+    struct libnet_frame frames[8];
+    uint8_t payload[46] = { 0 };
+    uint64_t hist = 0;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_LINK, "lo", errbuf);
+    assert_non_null(l);
+
+    libnet_stats_timing(l, 1);
+    assert_int_equal(libnet_stats_ex(l, &xs), 1);
+    assert_true(xs.pps == 0.0);
+
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    for (i = 0; i < 100; i++)
+        assert_int_equal(libnet_write(l), LIBNET_ETH_H + sizeof(payload));
+
+    for (i = 0; i < 8; i++)
+    {
+        frames[i].buf = payload;
+        frames[i].len = sizeof(payload);
+    }
+    assert_int_equal(libnet_write_batch(l, frames, 8), 8);
+
+    nanosleep(&ts, NULL);
+    assert_int_equal(libnet_stats_ex(l, &xs), 1);
+    assert_int_equal(xs.packets_sent, 108);
+    assert_int_equal(xs.packet_errors, 0);
+    assert_true(xs.syscalls >= 101 && xs.syscall_ns > 0);
+    for (i = 0; i < LIBNET_STATS_HIST; i++)
+        hist += xs.syscall_hist[i];
+    assert_int_equal(hist, xs.syscalls);
+    assert_true(xs.pps > 0.0 && xs.bps > xs.pps);
+
+    libnet_stats(l, &ls);
+    assert_int_equal(ls.packets_sent, xs.packets_sent);
+    assert_int_equal(ls.bytes_written, xs.bytes_written);
+
+    /* a frame larger than the device MTU */
+    {
+        uint8_t big[70000] = { 0 };
+
+        frames[0].buf = big;
+        frames[0].len = sizeof(big);
+        assert_int_equal(libnet_write_batch(l, frames, 1), 0);
+    }
+    assert_int_equal(libnet_stats_ex(l, &xs), 1);
+    assert_int_equal(xs.packet_errors, 1);
+    assert_int_equal(xs.err_msgsize, 1);
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_stats_ex__errors),
+        cmocka_unit_test(libnet_stats_ex__loopback),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
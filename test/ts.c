@@ -0,0 +1,249 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+// clang-format on
+
+#define LIBNET_TEST_FRAMES 16
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+struct reports
+{
+    int n;
+    int in_order;                                   /* user <= sched <= sent */
+    uint32_t ids[LIBNET_TEST_FRAMES];
+};
+
+static int
+ts_le(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec ||
+           (a->tv_sec == b->tv_sec && a->tv_nsec <= b->tv_nsec);
+}
+
+static void
+on_report(libnet_t *l, const struct libnet_ts_report *r, void *arg)
+{
+    struct reports *rs = arg;
+
+    (void)l;                                        /* unused */
+
+    if (rs->n < LIBNET_TEST_FRAMES)
+        rs->ids[rs->n] = r->id;
+    rs->n++;
+    if (!ts_le(&r->user, &r->sched) || !ts_le(&r->sched, &r->sent))
+        rs->in_order = 0;
+}
+
+/*
+ * Frames sent on the loopback device, up in the test namespace, come back
+ * with a qdisc and a driver timestamp each.
+ */
+static void
+libnet_ts__loopback(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_ts_stats ts;
+    struct reports rs = { 0, 1, { 0 } };
+    uint8_t payload[46] = { 0 };
+    uint64_t hist = 0;
+    uint32_t id;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_LINK, "lo", errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_write_ts(l, &id), (-1));
+    assert_int_equal(libnet_ts_poll(l, 0), (-1));
+
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    assert_int_equal(libnet_ts_start(l, on_report, &rs), 1);
+    assert_int_equal(libnet_ts_start(l, on_report, &rs), (-1));
+
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+    {
+        assert_int_equal(libnet_write_ts(l, &id), LIBNET_ETH_H + sizeof(payload));
+        assert_int_equal(id, i);
+    }
+
+    for (i = 0; i < 100 && rs.n < LIBNET_TEST_FRAMES; i++)
+        assert_true(libnet_ts_poll(l, 10) >= 0);
+
+    assert_int_equal(rs.n, LIBNET_TEST_FRAMES);
+    assert_true(rs.in_order);
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+        assert_int_equal(rs.ids[i], i);
+
+    assert_int_equal(libnet_ts_stats(l, &ts), 1);
+    assert_int_equal(ts.reports, LIBNET_TEST_FRAMES);
+    assert_int_equal(ts.lost, 0);
+    assert_int_equal(ts.unmatched, 0);
+    for (i = 0; i < LIBNET_STATS_HIST; i++)
+        hist += ts.build_hist[i];
+    assert_int_equal(hist, LIBNET_TEST_FRAMES);
+
+    assert_int_equal(libnet_ts_stop(l), 1);
+    assert_int_equal(libnet_ts_stop(l), (-1));
+
+    libnet_destroy(l);
+}
+
+/*
+ * A clone shares the socket, and so its numbering: the frames the clone
+ * writes take numbers and come back unmatched.
+ */
+static void
+libnet_ts__clone(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_ts_stats ts;
+    struct reports rs = { 0, 1, { 0 } };
+    uint8_t payload[46] = { 0 };
+    uint32_t id;
+    libnet_t *c;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_LINK, "lo", errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    c = libnet_clone(l);
+    assert_non_null(c);
+
+    assert_int_equal(libnet_ts_start(l, on_report, &rs), 1);
+    assert_int_equal(libnet_ts_start(c, NULL, NULL), (-1));
+
+    for (i = 0; i < 2; i++)
+    {
+        assert_int_equal(libnet_write(c), LIBNET_ETH_H + sizeof(payload));
+        assert_int_equal(libnet_write_ts(l, &id), LIBNET_ETH_H + sizeof(payload));
+        assert_int_equal(id, 2 * i + 1);
+    }
+
+    for (i = 0; i < 100 && rs.n < 4; i++)
+        assert_true(libnet_ts_poll(l, 10) >= 0);
+    assert_int_equal(rs.n, 4);
+    assert_int_equal(libnet_ts_stats(l, &ts), 1);
+    assert_int_equal(ts.unmatched, 2);
+    assert_int_equal(ts.lost, 0);
+
+    /* the clone may take over */
+    assert_int_equal(libnet_ts_stop(l), 1);
+    assert_int_equal(libnet_ts_start(c, NULL, NULL), 1);
+    assert_int_equal(libnet_ts_stop(c), 1);
+
+    libnet_destroy(c);
+    libnet_destroy(l);
+}
+
+/*
+ * A frame the kernel numbers behind libnet's back puts the counts out of
+ * step.  After the next write error the numbers are taken from the kernel
+ * again, and the frames that follow are matched.
+ */
+static void
+libnet_ts__resync(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static uint8_t big[70000];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_ts_stats ts;
+    struct sockaddr_ll sll;
+    struct libnet_frame frame = { big, sizeof(big) };
+    struct reports rs = { 0, 1, { 0 } };
+    uint8_t payload[46] = { 0 };
+    uint8_t *packet;
+    uint32_t packet_s, id;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_LINK, "lo", errbuf);
+    assert_non_null(l);
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src, 0x88b5,
+                                               payload, sizeof(payload), l, 0),
+                         (-1));
+    assert_int_equal(libnet_ts_start(l, on_report, &rs), 1);
+
+    assert_int_equal(libnet_write_ts(l, &id), LIBNET_ETH_H + sizeof(payload));
+    assert_int_equal(id, 0);
+
+    /* number 1, unknown to libnet */
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family  = AF_PACKET;
+    sll.sll_ifindex = if_nametoindex("lo");
+    assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+    assert_int_equal(sendto(libnet_getfd(l), packet, packet_s, 0,
+                            (struct sockaddr *)&sll, sizeof(sll)),
+                     (ssize_t)packet_s);
+    libnet_adv_free_packet(l, packet);
+
+    assert_int_equal(libnet_write_batch(l, &frame, 1), 0);  /* EMSGSIZE */
+
+    for (i = 0; i < 3; i++)
+    {
+        assert_int_equal(libnet_write_ts(l, &id), LIBNET_ETH_H + sizeof(payload));
+        assert_int_equal(id, 2 + i);
+    }
+
+    for (i = 0; i < 100 && rs.n < 5; i++)
+        assert_true(libnet_ts_poll(l, 10) >= 0);
+    assert_int_equal(rs.n, 5);
+    assert_true(rs.in_order);
+    assert_int_equal(libnet_ts_stats(l, &ts), 1);
+    assert_int_equal(ts.unmatched, 1);
+    assert_int_equal(ts.lost, 0);
+
+    assert_int_equal(libnet_ts_stop(l), 1);
+    libnet_destroy(l);
+}
+
+static void
+libnet_ts__needs_socket(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+    assert_int_equal(libnet_ts_start(l, NULL, NULL), (-1));
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_ts__loopback),
+        cmocka_unit_test(libnet_ts__clone),
+        cmocka_unit_test(libnet_ts__resync),
+        cmocka_unit_test(libnet_ts__needs_socket),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
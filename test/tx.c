@@ -0,0 +1,144 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_PRODUCERS 4
+#define LIBNET_TEST_FRAMES    5000                  /* per producer */
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+static void *
+producer(void *arg)
+{
+    libnet_t *tx = arg;
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    libnet_ptag_t eth = 0;
+    uint8_t payload[46] = { 0 };
+    long failed = 0;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    if (l == NULL)
+        return (void *)-1L;
+
+    for (i = 0; i < LIBNET_TEST_FRAMES; i++)
+    {
+        payload[0] = (uint8_t)i;
+        eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, payload,
+                                    sizeof(payload), l, eth);
+        if (eth == -1 || libnet_enqueue(tx, l) != 1)
+            failed++;
+    }
+
+    libnet_destroy(l);
+    return (void *)failed;
+}
+
+/*
+ * Several producers feed one TX thread.  The context is of the LIBNET_NONE
+ * type, so every write fails, but each frame must be accounted for once.
+ */
+static void
+libnet_tx__producers(void **state)
+{
+    (void)state;                                    /* unused */
+
+    pthread_t threads[LIBNET_TEST_PRODUCERS];
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_tx_stats ts;
+    void *failed;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_tx_start(l, 100, 0, LIBNET_TX_BLOCK, -1), (-1));
+    assert_int_equal(libnet_tx_start(l, 64, 0, LIBNET_TX_BLOCK, -1), 1);
+    assert_int_equal(libnet_tx_start(l, 64, 0, LIBNET_TX_BLOCK, -1), (-1));
+
+    for (i = 0; i < LIBNET_TEST_PRODUCERS; i++)
+        assert_int_equal(pthread_create(&threads[i], NULL, producer, l), 0);
+    for (i = 0; i < LIBNET_TEST_PRODUCERS; i++)
+    {
+        assert_int_equal(pthread_join(threads[i], &failed), 0);
+        assert_null(failed);
+    }
+
+    /* the thread catches up eventually */
+    for (i = 0; i < 10000000; i++)
+    {
+        assert_int_equal(libnet_tx_stats(l, &ts), 1);
+        if (ts.sent + ts.errors == ts.enqueued)
+            break;
+        sched_yield();
+    }
+    assert_int_equal(ts.enqueued, LIBNET_TEST_PRODUCERS * LIBNET_TEST_FRAMES);
+    assert_int_equal(ts.errors, ts.enqueued);
+    assert_int_equal(ts.dropped, 0);
+    assert_int_equal(ts.used, 0);
+
+    assert_int_equal(libnet_tx_stop(l), 1);
+    assert_int_equal(libnet_tx_stats(l, &ts), (-1));
+
+    libnet_destroy(l);
+}
+
+static void
+libnet_tx__stats(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_tx_stats ts;
+    uint8_t frame[60] = { 0 };
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    assert_int_equal(libnet_enqueue_frame(l, frame, sizeof(frame)), (-1));
+    assert_int_equal(libnet_tx_start(l, 8, 128, LIBNET_TX_DROP, -1), 1);
+    assert_int_equal(libnet_enqueue_frame(l, frame, 129), (-1));
+
+    for (i = 0; i < 100; i++)
+        libnet_enqueue_frame(l, frame, sizeof(frame));
+
+    assert_int_equal(libnet_tx_stats(l, &ts), 1);
+    assert_int_equal(ts.depth, 8);
+    assert_int_equal(ts.enqueued + ts.dropped, 100);
+    assert_in_range(ts.max_used, 1, 8);
+
+    /* stopping drains the queue */
+    assert_int_equal(libnet_tx_stop(l), 1);
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_tx__producers),
+        cmocka_unit_test(libnet_tx__stats),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -0,0 +1,182 @@
+// clang-format off
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <libnet.h>
+// clang-format on
+
+#define LIBNET_TEST_ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+static const uint8_t enet_src[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const uint8_t enet_dst[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+/* Builds UDP/IPv4/Ethernet with a sport and an IP ID variation. */
+static libnet_t *
+vary_context(void)
+{
+    static const uint32_t ids[] = { 0x1234, 0xffff, 0, 7 };
+    static const uint8_t payload[] = "libnet field variation";
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_vary_spec spec;
+    libnet_ptag_t udp, ip;
+    libnet_t *l;
+
+    l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    udp = libnet_build_udp(1000, 53, LIBNET_UDP_H + sizeof(payload), 0,
+                           payload, sizeof(payload), l, 0);
+    assert_int_not_equal(udp, (-1));
+
+    ip = libnet_build_ipv4(LIBNET_IPV4_H + LIBNET_UDP_H + sizeof(payload),
+                           0, 1, 0, 64, IPPROTO_UDP, 0,
+                           htonl(0xc0a80201), htonl(0xc0a80202),
+                           NULL, 0, l, 0);
+    assert_int_not_equal(ip, (-1));
+
+    assert_int_not_equal(libnet_build_ethernet(enet_dst, enet_src,
+                                               ETHERTYPE_IP, NULL, 0, l, 0),
+                         (-1));
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_INC;
+    spec.width = 2;
+    spec.min   = 65530;
+    spec.max   = 65535;
+    spec.step  = 3;
+    assert_int_equal(libnet_vary_add(l, udp, 0, &spec), 1);
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op     = LIBNET_VARY_LIST;
+    spec.width  = 2;
+    spec.every  = 2;
+    spec.list   = ids;
+    spec.list_n = LIBNET_TEST_ARRAY_LENGTH(ids);
+    assert_int_equal(libnet_vary_add(l, ip, 4, &spec), 1);
+
+    return l;
+}
+
+static void
+libnet_vary__sequence(void **state)
+{
+    (void)state;                                    /* unused */
+
+    static const uint16_t sports[] = { 65530, 65533, 65530, 65533 };
+    static const uint16_t ids[]    = { 0x1234, 0x1234, 0xffff, 0xffff };
+    libnet_t *l = vary_context();
+    uint8_t *packet, small[8];
+    uint32_t packet_s;
+    size_t i;
+
+    /* a packet that could not be assembled does not use up a value */
+    assert_int_equal(libnet_pblock_coalesce_buf(l, small, sizeof(small), &packet_s), (-1));
+
+    for (i = 0; i < LIBNET_TEST_ARRAY_LENGTH(sports); i++)
+    {
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+        assert_int_equal(packet[LIBNET_ETH_H + 4] << 8 | packet[LIBNET_ETH_H + 5], ids[i]);
+        assert_int_equal(packet[LIBNET_ETH_H + LIBNET_IPV4_H] << 8 |
+                         packet[LIBNET_ETH_H + LIBNET_IPV4_H + 1], sports[i]);
+        libnet_adv_free_packet(l, packet);
+    }
+
+    libnet_destroy(l);
+}
+
+/* Patching one culled packet must give the same bytes as culling anew. */
+static void
+libnet_vary__packet_matches_cull(void **state)
+{
+    (void)state;                                    /* unused */
+
+    libnet_t *a = vary_context();
+    libnet_t *b = vary_context();
+    uint8_t *packet, *expect;
+    uint32_t packet_s, expect_s;
+    int i;
+
+    assert_int_equal(libnet_adv_cull_packet(a, &packet, &packet_s), 1);
+
+    for (i = 0; i < 20; i++)
+    {
+        if (i)
+            assert_int_equal(libnet_vary_packet(a, packet, packet_s), 1);
+
+        assert_int_equal(libnet_adv_cull_packet(b, &expect, &expect_s), 1);
+        assert_int_equal(packet_s, expect_s);
+        assert_memory_equal(packet, expect, packet_s);
+        libnet_adv_free_packet(b, expect);
+    }
+
+    libnet_adv_free_packet(a, packet);
+    libnet_destroy(a);
+    libnet_destroy(b);
+}
+
+static void
+libnet_vary__random_in_range(void **state)
+{
+    (void)state;                                    /* unused */
+
+    char errbuf[LIBNET_ERRBUF_SIZE];
+    struct libnet_vary_spec spec;
+    libnet_ptag_t eth;
+    uint8_t *packet;
+    uint32_t packet_s;
+    int i;
+
+    libnet_t *l = libnet_init(LIBNET_NONE, NULL, errbuf);
+    assert_non_null(l);
+
+    eth = libnet_build_ethernet(enet_dst, enet_src, 0x88b5, NULL, 0, l, 0);
+    assert_int_not_equal(eth, (-1));
+
+    memset(&spec, 0, sizeof(spec));
+    spec.op    = LIBNET_VARY_RANDOM;
+    spec.width = 1;
+    spec.min   = 10;
+    spec.max   = 20;
+    assert_int_equal(libnet_vary_add(l, eth, 11, &spec), 1);
+
+    /* A field running past the pblock, or a value wider than the field */
+    spec.width = 2;
+    assert_int_equal(libnet_vary_add(l, eth, LIBNET_ETH_H - 1, &spec), (-1));
+    spec.width = 1;
+    spec.max   = 256;
+    assert_int_equal(libnet_vary_add(l, eth, 0, &spec), (-1));
+
+    for (i = 0; i < 100; i++)
+    {
+        assert_int_equal(libnet_adv_cull_packet(l, &packet, &packet_s), 1);
+        assert_in_range(packet[11], 10, 20);
+        libnet_adv_free_packet(l, packet);
+    }
+
+    libnet_destroy(l);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(libnet_vary__sequence),
+        cmocka_unit_test(libnet_vary__packet_matches_cull),
+        cmocka_unit_test(libnet_vary__random_in_range),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+/**
+ * Local Variables:
+ *  indent-tabs-mode: nil
+ *  c-file-style: "stroustrup"
+ * End:
+ */
@@ -64,7 +64,7 @@ goto msvcbuild
 @set MT=mt /nologo
 @mkdir %OBJDIR% %LIBDIR%
 
-%CC% /I..\include /I%PCAPINC% libnet_a*.c libnet_build_*.c libnet_c*.c libnet_dll.c libnet_error.c libnet_i*.c libnet_link_win32.c libnet_p*.c libnet_raw.c libnet_resolve.c libnet_version.c libnet_write.c
+%CC% /I..\include /I%PCAPINC% libnet_a*.c libnet_bgp_pack.c libnet_build_*.c libnet_c*.c libnet_dll.c libnet_error.c libnet_fragment.c libnet_i*.c libnet_link_win32.c libnet_lsdb.c libnet_p*.c libnet_raw.c libnet_resolve.c libnet_stats.c libnet_ts.c libnet_vary.c libnet_version.c libnet_write.c
 if %errorlevel% == 0 goto :link
 @echo "Failed building, error %errorlevel%"
 exit /b %errorlevel%